@@ -4,67 +4,118 @@
 
 #include "d3dx12.h"
 #include "Helper.h"
+#include "JobSystem.h"
+#include "PipelineCache.h"
+#include "FileWatcher.h"
+#include "GpuProfiler.h"
+#include "D3D12Conversion.h"
+#include "CpuProfiler.h"
+#include "FrameStatistics.h"
+#include "CapturingDevice.h"
+#include "Hash.h"
 
 #include <d3dcompiler.h>
 #include <chrono>
+#include <vector>
+#include <algorithm>
 
 namespace
 {
+	/// Identifies a pipeline state in command stream captures by its shader variants.
+	std::string GetPipelineStateName(const std::vector<ShaderCache::ShaderDesc>& shaders)
+	{
+		std::string name;
+		for (const auto& shader : shaders)
+			name += (name.empty() ? "" : " ") + shader.GetVariantName();
+		return name;
+	}
+
 	void OutputDXError(ID3DBlob* errorMessages)
 	{
 		if (errorMessages)
 		{
-			std::cout << static_cast<char*>(errorMessages->GetBufferPointer()) << std::endl;
+			std::cerr << static_cast<char*>(errorMessages->GetBufferPointer()) << std::endl;
 			errorMessages->Release();
 		}
 		if (errorMessages)
 			errorMessages->Release();
 	}
+
+	UINT GetCompileFlags()
+	{
+#ifdef _DEBUG
+		// Enable better shader debugging with the graphics debugging tools.
+		return D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+		return 0;
+#endif
+	}
 }
 
-Application::Application() :
+Application::Application(const Configuration& _configuration) :
+	configuration(_configuration),
+	jobSystem(new JobSystem()),
+	backgroundJobSystem(new JobSystem()),
 	window(new Window(1280, 720, L"testerata!")),
-	device(new D3D12Device(*window)),
-	frameQueueIndex(0)
+	device(new D3D12Device(*window, _configuration.numBackbuffers)),
+	timeSinceShaderFileCheck(0.0f),
+	lastFrameMilliseconds(0.0),
+	running(true)
 {
-	// Create a command allocator for every inflight-frame
-	for (int i = 0; i < D3D12Device::MAX_FRAMES_INFLIGHT; ++i)
-	{
-		if (FAILED(device->GetD3D12Device()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator[i]))))
-			CRITICAL_ERROR("Failed to create command list allocator.");
-	}
-	// Create the command list.
-	if (FAILED(device->GetD3D12Device()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator[frameQueueIndex].Get(), pso.Get(), IID_PPV_ARGS(&commandList))))
-		CRITICAL_ERROR("Failed to create command list");
-	commandList->Close();
+	auto startupBegin = std::chrono::high_resolution_clock::now();
+
+	frameStatistics.reset(new FrameStatistics(1024, configuration.frameBudgetMilliseconds));
 
 	CreateRootSignature();
+	shaderCache.reset(new ShaderCache(ShaderCache::GetDefaultPath(), *backgroundJobSystem));
+	if (!shaderArchiveFile.Open(GetShaderArchivePath()) || !shaderArchive.Open(shaderArchiveFile.GetData(), shaderArchiveFile.GetSize()))
+		std::cerr << "No valid shader archive found, shaders are compiled from source." << std::endl;
+	pipelineCache.reset(new PipelineCache(device->GetD3D12Device(), PipelineCache::GetDefaultPath()));
 	CreatePSO();
-	CreateVertexBuffer();
-	CreateTextures();
-
-	// Configure viewport and scissor rect.
-	viewport.TopLeftX = 0.0f;
-	viewport.TopLeftY = 0.0f;
-	viewport.Width = static_cast<float>(window->GetWidth());
-	viewport.Height = static_cast<float>(window->GetHeight());
-	viewport.MinDepth = 0.0f;
-	viewport.MaxDepth = 1.0f;
-	scissorRect.left = 0;
-	scissorRect.top = 0;
-	scissorRect.right = static_cast<LONG>(window->GetWidth());
-	scissorRect.bottom = static_cast<LONG>(window->GetHeight());
+	if (configuration.gpuTextureGeneration)
+		CreateGenerationPipeline();
+
+	// Watch all shader sources for hot-reload.
+	shaderFileWatcher.reset(new FileWatcher());
+	for (const auto& shader : GetShaderDescs(configuration))
+		shaderFileWatcher->AddFile(shader.filename);
+	if (configuration.gpuTextureGeneration)
+		shaderFileWatcher->AddFile(GetGenerationShaderDesc().filename);
+
+	renderer.reset(new Renderer(configuration, *device, *jobSystem, ToRenderHandle(rootSignature.Get()), ToRenderHandle(pso.Get()),
+								ToRenderHandle(generationRootSignature.Get()), ToRenderHandle(generationPso.Get())));
+	if (CapturingDevice* capturingDevice = renderer->GetCapturingDevice())
+	{
+		capturingDevice->SetPipelineStateName(ToRenderHandle(pso.Get()), GetPipelineStateName(GetShaderDescs(configuration)));
+		capturingDevice->SetRootSignatureHash(ToRenderHandle(rootSignature.Get()), HashBytes(rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize()));
+		if (configuration.gpuTextureGeneration)
+		{
+			capturingDevice->SetPipelineStateName(ToRenderHandle(generationPso.Get()), GetPipelineStateName({ GetGenerationShaderDesc() }));
+			capturingDevice->SetRootSignatureHash(ToRenderHandle(generationRootSignature.Get()),
+													HashBytes(generationRootSignatureBlob->GetBufferPointer(), generationRootSignatureBlob->GetBufferSize()));
+		}
+	}
+
+	auto startupEnd = std::chrono::high_resolution_clock::now();
+	const ShaderCache::Statistics& shaderCacheStatistics = shaderCache->GetStatistics();
+	std::cerr << "Shader cache: " << shaderCacheStatistics.numHits << " hits, " << shaderCacheStatistics.numMisses << " misses, " <<
+		shaderCacheStatistics.preprocessTimeInSeconds * 1000.0 << " ms preprocessing, " << shaderCacheStatistics.compileTimeInSeconds * 1000.0 << " ms compiling" << std::endl;
+	std::cerr << "Pipeline cache: " << pipelineCache->GetNumHits() << " hits, " << pipelineCache->GetNumMisses() << " misses" << std::endl;
+	std::cerr << "Startup took " << std::chrono::duration_cast<std::chrono::microseconds>(startupEnd - startupBegin).count() / 1000.0 << " ms" << std::endl;
 }
 
 Application::~Application()
 {
+	// The reload job uses the caches and the device.
+	if (shaderReloadJob)
+		backgroundJobSystem->Wait(shaderReloadJob);
 }
 
 void Application::CreateRootSignature()
 {	
 	D3D12_DESCRIPTOR_RANGE ranges[1];
 	ranges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-	ranges[0].NumDescriptors = 1;
+	ranges[0].NumDescriptors = configuration.textureBinding == Renderer::TextureBinding::Bindless ? UINT_MAX : 1; // UINT_MAX makes the range unbounded.
 	ranges[0].BaseShaderRegister = 0;
 	ranges[0].RegisterSpace = 0;
 	ranges[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
@@ -72,16 +123,16 @@ void Application::CreateRootSignature()
 
 
 	D3D12_ROOT_PARAMETER rootParameters[2];
-	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // Would also be possible to create a shader resource view right away, since we have only one texture. But for practicing we use a table.
-	rootParameters[0].DescriptorTable.NumDescriptorRanges = 1;
-	rootParameters[0].DescriptorTable.pDescriptorRanges = ranges;
-	rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+	rootParameters[Renderer::TEXTURE_TABLE_ROOT_PARAMETER].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // Would also be possible to create a shader resource view right away, since we have only one texture. But for practicing we use a table.
+	rootParameters[Renderer::TEXTURE_TABLE_ROOT_PARAMETER].DescriptorTable.NumDescriptorRanges = 1;
+	rootParameters[Renderer::TEXTURE_TABLE_ROOT_PARAMETER].DescriptorTable.pDescriptorRanges = ranges;
+	rootParameters[Renderer::TEXTURE_TABLE_ROOT_PARAMETER].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 
-	rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
-	rootParameters[1].Constants.ShaderRegister = 0;
-	rootParameters[1].Constants.RegisterSpace = 0;
-	rootParameters[1].Constants.Num32BitValues = 1;
-	rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+	rootParameters[Renderer::DRAW_ID_ROOT_PARAMETER].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	rootParameters[Renderer::DRAW_ID_ROOT_PARAMETER].Constants.ShaderRegister = 0;
+	rootParameters[Renderer::DRAW_ID_ROOT_PARAMETER].Constants.RegisterSpace = 0;
+	rootParameters[Renderer::DRAW_ID_ROOT_PARAMETER].Constants.Num32BitValues = 1;
+	rootParameters[Renderer::DRAW_ID_ROOT_PARAMETER].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
 
 
 	D3D12_STATIC_SAMPLER_DESC sampler = {};
@@ -107,52 +158,144 @@ void Application::CreateRootSignature()
 	rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
 
-	ComPtr<ID3DBlob> signature;
 	ComPtr<ID3DBlob> error;
-	if (FAILED(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error)))
+	if (FAILED(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &rootSignatureBlob, &error)))
 	{
 		OutputDXError(error.Get());
 		CRITICAL_ERROR("Failed to serialize root signature.");
 	}
-	if (FAILED(device->GetD3D12Device()->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature))))
+	if (FAILED(device->GetD3D12Device()->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&rootSignature))))
 		CRITICAL_ERROR("Failed to createroot signature");
 }
 
-void Application::CreatePSO()
+std::vector<ShaderCache::ShaderDesc> Application::GetShaderDescs(const Configuration& configuration)
 {
-	ComPtr<ID3DBlob> vertexShader, pixelShader;
+	ShaderCache::ShaderDesc vertexShaderDesc;
+	vertexShaderDesc.filename = "shaders.hlsl";
+	vertexShaderDesc.entryPoint = "VSMain";
+	vertexShaderDesc.profile = "vs_5_0";
+	vertexShaderDesc.compileFlags = GetCompileFlags();
+
+	// Shader variants are selected via defines.
+	if (configuration.textureBinding == Renderer::TextureBinding::TextureArray)
+		vertexShaderDesc.defines.push_back(std::make_pair("TEXTURE_ARRAY", "1"));
+	else if (configuration.textureBinding == Renderer::TextureBinding::Bindless)
+	{
+		vertexShaderDesc.defines.push_back(std::make_pair("BINDLESS", "1"));
+		// Indexing into unbounded resource arrays requires shader model 5.1
+		vertexShaderDesc.profile = "vs_5_1";
+	}
 
-#ifdef _DEBUG
-	// Enable better shader debugging with the graphics debugging tools.
-	UINT compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#else
-	UINT compileFlags = 0;
-#endif
+	ShaderCache::ShaderDesc pixelShaderDesc = vertexShaderDesc;
+	pixelShaderDesc.entryPoint = "PSMain";
+	pixelShaderDesc.profile = configuration.textureBinding == Renderer::TextureBinding::Bindless ? "ps_5_1" : "ps_5_0";
 
-	ID3D10Blob* errorMessages;
-	if (FAILED(D3DCompileFromFile(L"shaders.hlsl", nullptr, nullptr, "VSMain", "vs_5_0", compileFlags, 0, &vertexShader, &errorMessages)))
-	{
-		if (errorMessages)
-		{
-			std::cout << static_cast<char*>(errorMessages->GetBufferPointer()) << std::endl;
-			errorMessages->Release();
-		}
-		if (errorMessages)
-			errorMessages->Release();
+	std::vector<ShaderCache::ShaderDesc> shaders;
+	shaders.push_back(vertexShaderDesc);
+	shaders.push_back(pixelShaderDesc);
+	return shaders;
+}
 
-		CRITICAL_ERROR("Failed to compile vertex shader.");
+ShaderCache::ShaderDesc Application::GetGenerationShaderDesc()
+{
+	ShaderCache::ShaderDesc computeShaderDesc;
+	computeShaderDesc.filename = "proceduraltexture.hlsl";
+	computeShaderDesc.entryPoint = "CSMain";
+	computeShaderDesc.profile = "cs_5_0";
+	computeShaderDesc.compileFlags = GetCompileFlags();
+	return computeShaderDesc;
+}
+
+bool Application::FindArchivedShader(const ShaderCache::ShaderDesc& shader, D3D12_SHADER_BYTECODE& outBytecode) const
+{
+	if (!shaderArchive.IsOpen())
+		return false;
+
+	// Only reads and hashes the sources, compiling is left to the fallback if the archive is stale.
+	const void* bytecode;
+	size_t size;
+	uint64_t contentKey;
+	if (ComputeShaderContentKey(shader.filename, shader.GetVariantName(), shader.compileFlags, contentKey))
+	{
+		if (!shaderArchive.Find(shader.GetVariantName(), contentKey, bytecode, size))
+			return false;
 	}
-	if (FAILED(D3DCompileFromFile(L"shaders.hlsl", nullptr, nullptr, "PSMain", "ps_5_0", compileFlags, 0, &pixelShader, &errorMessages)))
+	else if (!shaderArchive.Find(shader.GetVariantName(), bytecode, size))
+		return false;
+
+	outBytecode = { bytecode, size };
+	return true;
+}
+
+std::string Application::GetShaderArchivePath()
+{
+	return GetExecutableDirectory() + "shaders.shaderarchive";
+}
+
+bool Application::BuildShaderArchive(const std::string& path)
+{
+	JobSystem jobSystem;
+	ShaderCache shaderCache(ShaderCache::GetDefaultPath(), jobSystem);
+	ShaderArchiveWriter archive;
+
+	// All shader variants that can be selected at startup.
+	const Renderer::TextureBinding textureBindings[] = { Renderer::TextureBinding::DescriptorTablePerDraw, Renderer::TextureBinding::TextureArray, Renderer::TextureBinding::Bindless };
+	for (Renderer::TextureBinding textureBinding : textureBindings)
 	{
-		if (errorMessages)
+		Configuration configuration;
+		configuration.textureBinding = textureBinding;
+		std::vector<ShaderCache::ShaderDesc> shaders = GetShaderDescs(configuration);
+
+		std::vector<ComPtr<ID3DBlob>> shaderBytecode;
+		if (!shaderCache.Compile(shaders, shaderBytecode))
+			return false;
+		for (size_t i = 0; i < shaders.size(); ++i)
 		{
-			std::cout << static_cast<char*>(errorMessages->GetBufferPointer()) << std::endl;
-			errorMessages->Release();
+			uint64_t contentKey;
+			if (!ComputeShaderContentKey(shaders[i].filename, shaders[i].GetVariantName(), shaders[i].compileFlags, contentKey))
+				return false;
+			archive.Add(shaders[i].GetVariantName(), contentKey, shaderBytecode[i]->GetBufferPointer(), shaderBytecode[i]->GetBufferSize());
 		}
-		if (errorMessages)
-			errorMessages->Release();
+	}
+
+	std::vector<ShaderCache::ShaderDesc> generationShaders(1, GetGenerationShaderDesc());
+	std::vector<ComPtr<ID3DBlob>> generationShaderBytecode;
+	uint64_t generationContentKey;
+	if (!shaderCache.Compile(generationShaders, generationShaderBytecode) ||
+		!ComputeShaderContentKey(generationShaders[0].filename, generationShaders[0].GetVariantName(), generationShaders[0].compileFlags, generationContentKey))
+		return false;
+	archive.Add(generationShaders[0].GetVariantName(), generationContentKey, generationShaderBytecode[0]->GetBufferPointer(), generationShaderBytecode[0]->GetBufferSize());
 
-		CRITICAL_ERROR("Failed to compile pixel shader.");
+	if (!archive.Save(path))
+	{
+		std::cerr << "Failed to write shader archive " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void Application::CreatePSO()
+{
+	if (!CreatePipelineState(true, pso))
+		CRITICAL_ERROR("Failed to create PSO.");
+}
+
+bool Application::CreatePipelineState(bool useShaderArchive, ComPtr<ID3D12PipelineState>& outPso)
+{
+	std::vector<ShaderCache::ShaderDesc> shaders = GetShaderDescs(configuration);
+	D3D12_SHADER_BYTECODE vertexShader = {};
+	D3D12_SHADER_BYTECODE pixelShader = {};
+
+	// Take the precompiled shaders straight from the mapped archive if possible, otherwise compile.
+	std::vector<ComPtr<ID3DBlob>> shaderBytecode;
+	if (!useShaderArchive || !FindArchivedShader(shaders[0], vertexShader) || !FindArchivedShader(shaders[1], pixelShader))
+	{
+		// Both shaders are compiled in parallel if they are not in the cache.
+		if (!shaderCache->Compile(shaders, shaderBytecode))
+			return false;
+		shaderCache->Save();
+		vertexShader = { shaderBytecode[0]->GetBufferPointer(), shaderBytecode[0]->GetBufferSize() };
+		pixelShader = { shaderBytecode[1]->GetBufferPointer(), shaderBytecode[1]->GetBufferSize() };
 	}
 
 	// Define the vertex input layout.
@@ -165,8 +308,8 @@ void Application::CreatePSO()
 	// Describe and create the graphics pipeline state object (PSO).
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
 	psoDesc.pRootSignature = rootSignature.Get();
-	psoDesc.VS = { reinterpret_cast<UINT8*>(vertexShader->GetBufferPointer()), vertexShader->GetBufferSize() };
-	psoDesc.PS = { reinterpret_cast<UINT8*>(pixelShader->GetBufferPointer()), pixelShader->GetBufferSize() };
+	psoDesc.VS = vertexShader;
+	psoDesc.PS = pixelShader;
 	psoDesc.DS;
 	psoDesc.HS;
 	psoDesc.GS;
@@ -184,250 +327,264 @@ void Application::CreatePSO()
 	psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
 	psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
 	psoDesc.SampleDesc.Count = 1;
-	psoDesc.CachedPSO;
-	
-	if(FAILED(device->GetD3D12Device()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pso))))
-		CRITICAL_ERROR("Failed to PSO.");
+	psoDesc.CachedPSO; // Filled by the pipeline cache.
+
+	if (!pipelineCache->CreateGraphicsPipelineState(psoDesc, rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize(), outPso))
+	{
+		std::cerr << "Failed to create PSO." << std::endl;
+		return false;
+	}
+	pipelineCache->Save();
+	return true;
 }
 
-void Application::CreateVertexBuffer()
+void Application::CreateGenerationPipeline()
 {
-	struct Vertex
-	{
-		float position[2];
-		float texcoord[2];
-	};
+	D3D12_DESCRIPTOR_RANGE range;
+	range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+	range.NumDescriptors = 1;
+	range.BaseShaderRegister = 0;
+	range.RegisterSpace = 0;
+	range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+	// Compute shaders only see parameters that are visible to all stages.
+	D3D12_ROOT_PARAMETER rootParameters[2];
+	rootParameters[Renderer::GENERATION_TABLE_ROOT_PARAMETER].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	rootParameters[Renderer::GENERATION_TABLE_ROOT_PARAMETER].DescriptorTable.NumDescriptorRanges = 1;
+	rootParameters[Renderer::GENERATION_TABLE_ROOT_PARAMETER].DescriptorTable.pDescriptorRanges = &range;
+	rootParameters[Renderer::GENERATION_TABLE_ROOT_PARAMETER].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+	rootParameters[Renderer::GENERATION_SEED_ROOT_PARAMETER].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	rootParameters[Renderer::GENERATION_SEED_ROOT_PARAMETER].Constants.ShaderRegister = 0;
+	rootParameters[Renderer::GENERATION_SEED_ROOT_PARAMETER].Constants.RegisterSpace = 0;
+	rootParameters[Renderer::GENERATION_SEED_ROOT_PARAMETER].Constants.Num32BitValues = 1;
+	rootParameters[Renderer::GENERATION_SEED_ROOT_PARAMETER].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+	D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.NumParameters = 2;
+	rootSignatureDesc.pParameters = rootParameters;
+	rootSignatureDesc.NumStaticSamplers = 0;
+	rootSignatureDesc.pStaticSamplers = nullptr;
+	rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
 
-	// Define the geometry for a quad.
-	float screenAspectRatio = static_cast<float>(window->GetWidth()) / window->GetHeight();
-	Vertex quadVertices[] =
+	ComPtr<ID3DBlob> error;
+	if (FAILED(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &generationRootSignatureBlob, &error)))
 	{
-		{ { -0.25f, -0.25f * screenAspectRatio }, { 0.0f, 0.0f } },
-		{ { -0.25f, 0.25f * screenAspectRatio },{ 0.0f, 1.0f } },
-		{ { 0.25f, -0.25f * screenAspectRatio },{ 1.0f, 0.0f } },
-		{ { 0.25f, 0.25f * screenAspectRatio },{ 1.0f, 1.0f } }
-	};
+		OutputDXError(error.Get());
+		CRITICAL_ERROR("Failed to serialize texture generation root signature.");
+	}
+	if (FAILED(device->GetD3D12Device()->CreateRootSignature(0, generationRootSignatureBlob->GetBufferPointer(), generationRootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&generationRootSignature))))
+		CRITICAL_ERROR("Failed to create texture generation root signature.");
 
-	const unsigned int vertexBufferSize = sizeof(quadVertices);
+	if (!CreateGenerationPipelineState(true, generationPso))
+		CRITICAL_ERROR("Failed to create texture generation PSO.");
+}
 
-	// Create an upload heap for the
-	ComPtr<ID3D12Resource> uploadHeap;
-	if (FAILED(device->GetD3D12Device()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
-																&CD3DX12_RESOURCE_DESC::Buffer(sizeof(quadVertices)), D3D12_RESOURCE_STATE_GENERIC_READ, // D3D12_RESOURCE_STATE_GENERIC_READ is the only possible for D3D12_HEAP_TYPE_UPLOAD.
-																nullptr, IID_PPV_ARGS(&uploadHeap))))
+bool Application::CreateGenerationPipelineState(bool useShaderArchive, ComPtr<ID3D12PipelineState>& outPso)
+{
+	// Like the graphics shaders, taken from the archive if possible.
+	std::vector<ShaderCache::ShaderDesc> shaders(1, GetGenerationShaderDesc());
+	D3D12_SHADER_BYTECODE computeShader = {};
+	std::vector<ComPtr<ID3DBlob>> shaderBytecode;
+	if (!useShaderArchive || !FindArchivedShader(shaders[0], computeShader))
 	{
-		CRITICAL_ERROR("Failed to create upload heap.");
+		if (!shaderCache->Compile(shaders, shaderBytecode))
+			return false;
+		shaderCache->Save();
+		computeShader = { shaderBytecode[0]->GetBufferPointer(), shaderBytecode[0]->GetBufferSize() };
 	}
 
-	// Copy the triangle data to the vertex buffer.
-	UINT8* pVertexDataBegin;
-	if (FAILED(uploadHeap->Map(0, nullptr, reinterpret_cast<void**>(&pVertexDataBegin))))
-		CRITICAL_ERROR("Failed to map vertex buffer");
-	memcpy(pVertexDataBegin, quadVertices, sizeof(quadVertices));
-	uploadHeap->Unmap(0, nullptr);
-
-	// Create vertex buffer.
-	if (FAILED(device->GetD3D12Device()->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
-																&CD3DX12_RESOURCE_DESC::Buffer(sizeof(quadVertices)), D3D12_RESOURCE_STATE_COPY_DEST,
-																nullptr, IID_PPV_ARGS(&vertexBuffer))))
+	D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+	psoDesc.pRootSignature = generationRootSignature.Get();
+	psoDesc.CS = computeShader;
+	if (!pipelineCache->CreateComputePipelineState(psoDesc, generationRootSignatureBlob->GetBufferPointer(), generationRootSignatureBlob->GetBufferSize(), outPso))
 	{
-		CRITICAL_ERROR("Failed to create vertex buffer.");
+		std::cerr << "Failed to create texture generation PSO." << std::endl;
+		return false;
 	}
+	pipelineCache->Save();
+	return true;
+}
 
-	// Copy over and wait until its done.
-	commandList->Reset(commandAllocator[0].Get(), nullptr);
-	commandList->CopyResource(vertexBuffer.Get(), uploadHeap.Get());
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(vertexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
-	commandList->Close();
-	ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
-	device->GetDirectCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-	device->WaitForIdleGPU();
-
-	// Initialize the vertex buffer view.
-	vertexBufferView.BufferLocation = vertexBuffer->GetGPUVirtualAddress();
-	vertexBufferView.StrideInBytes = sizeof(Vertex);
-	vertexBufferView.SizeInBytes = vertexBufferSize;
+void Application::Update(float lastFrameTimeInSeconds)
+{
+	PROFILE_SCOPE("Update");
+	UpdateShaderHotReload(lastFrameTimeInSeconds);
 }
 
-void Application::CreateTextures()
+void Application::UpdateShaderHotReload(float lastFrameTimeInSeconds)
 {
-	D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc;
-	descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	descriptorHeapDesc.NumDescriptors = numTextures;
-	descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	descriptorHeapDesc.NodeMask = 1;
-	if (FAILED(device->GetD3D12Device()->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&textureDescriptorHeap))))
-		CRITICAL_ERROR("Failed to create texture descriptor heap.");
-	auto descriptorHandle = textureDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-
-
-	// Would also be easy possible to place all textures into the same heap, but I do not see the advantes of that yet.
-
-	const unsigned int textureSize = 16;
-	char textureData[textureSize * textureSize * 4];
-
-	// Texture desc, used by all textures
-	D3D12_RESOURCE_DESC textureDesc = {};
-	textureDesc.MipLevels = 1;
-	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	textureDesc.Width = textureSize;
-	textureDesc.Height = textureSize;
-	textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-	textureDesc.DepthOrArraySize = 1;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-
-
-	ComPtr<ID3D12Resource> textureUploadHeap;
-	D3D12_SUBRESOURCE_DATA subresourceData = {};
-	subresourceData.pData = textureData;
-	subresourceData.RowPitch = textureSize * 4;
-	subresourceData.SlicePitch = subresourceData.RowPitch * textureSize;
-
-	// Create the texture.
-	for (unsigned int tex = 0; tex < numTextures; ++tex)
+	if (shaderReloadJob)
 	{
-		// Create texture
-		if (FAILED(device->GetD3D12Device()->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
-			&textureDesc, D3D12_RESOURCE_STATE_COPY_DEST,
-			nullptr, IID_PPV_ARGS(&textures[tex]))))
-		{
-			CRITICAL_ERROR("Failed to create texture");
-		}
-
-		// Create Upload buffer. Creating it outside the loop would make it impossible to use the GetRequiredIntermediateSize helper function
-		if (tex == 0)
+		// Never wait for the compilation, just check again next frame.
+		if (!backgroundJobSystem->IsFinished(shaderReloadJob))
+			return;
+		shaderReloadJob.reset();
+
+		// Update is called between frames, so all command lists of the next frame use the new PSOs.
+		// On failure the old PSOs stay active.
+		if (reloadedPso)
 		{
-			const UINT64 uploadBufferSize = GetRequiredIntermediateSize(textures[0].Get(), 0, 1);
-			if (FAILED(device->GetD3D12Device()->CreateCommittedResource(
-				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-				D3D12_HEAP_FLAG_NONE,
-				&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
-				D3D12_RESOURCE_STATE_GENERIC_READ, // D3D12_RESOURCE_STATE_GENERIC_READ is the only possible for D3D12_HEAP_TYPE_UPLOAD.
-				nullptr,
-				IID_PPV_ARGS(&textureUploadHeap))))
+			// The old PSOs may still be used by frames in flight.
+			device->DeferRelease(pso, 0);
+			pso = reloadedPso;
+			reloadedPso.Reset();
+			renderer->SetPipelineState(ToRenderHandle(pso.Get()));
+			if (CapturingDevice* capturingDevice = renderer->GetCapturingDevice())
+				capturingDevice->SetPipelineStateName(ToRenderHandle(pso.Get()), GetPipelineStateName(GetShaderDescs(configuration)));
+			if (reloadedGenerationPso)
 			{
-				CRITICAL_ERROR("Failed to create upload heap for textures");
+				device->DeferRelease(generationPso, 0);
+				generationPso = reloadedGenerationPso;
+				reloadedGenerationPso.Reset();
+				renderer->SetGenerationPipelineState(ToRenderHandle(generationPso.Get()));
+				if (CapturingDevice* capturingDevice = renderer->GetCapturingDevice())
+					capturingDevice->SetPipelineStateName(ToRenderHandle(generationPso.Get()), GetPipelineStateName({ GetGenerationShaderDesc() }));
 			}
+			std::cerr << "Shaders reloaded." << std::endl;
 		}
-
-
-		// Create the GPU upload buffer.
-		for (unsigned int j = 0; j < sizeof(textureData); ++j)
-			textureData[j] = static_cast<unsigned char>(rand() % 255);
-
-		// Copy over and wait until its done.
-		commandList->Reset(commandAllocator[0].Get(), nullptr);
-		//commandList->CopyResource(textures[i].Get(), textureUploadHeap.Get());
-		UpdateSubresources(commandList.Get(), textures[tex].Get(), textureUploadHeap.Get(), 0, 0, 1, &subresourceData);
-		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(textures[tex].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-		commandList->Close();
-		ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
-		device->GetDirectCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-		device->WaitForIdleGPU();
-
-		// Describe and create a SRV for the texture.
-		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		srvDesc.Format = textureDesc.Format;
-		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MipLevels = 1;
-		device->GetD3D12Device()->CreateShaderResourceView(textures[tex].Get(), &srvDesc, descriptorHandle);
-
-		descriptorHandle.ptr += device->GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		else
+			std::cerr << "Shader reload failed, keeping the previous shaders." << std::endl;
 	}
-}
 
-void Application::PopulateCommandList()
-{
-	// Should be completely save now to reset this command allocator.
-	if (FAILED(commandAllocator[frameQueueIndex]->Reset()))
-		CRITICAL_ERROR("Failed to reset the command allocator.");
-	// Restart command queue with new command allocator (last frame a different was used)
-	if(FAILED(commandList->Reset(commandAllocator[frameQueueIndex].Get(), pso.Get())))
-		CRITICAL_ERROR("Failed to reset the command list.");
-
-	// Set necessary state.
-	commandList->SetGraphicsRootSignature(rootSignature.Get());
-	commandList->RSSetViewports(1, &viewport);
-	commandList->RSSetScissorRects(1, &scissorRect);
-
-	// Indicate that the back buffer will be used as a render target.
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(device->GetCurrentSwapChainBuffer(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
-	auto rtvDesc = device->GetCurrentSwapChainBufferRTVDesc();
-	commandList->OMSetRenderTargets(1, &rtvDesc, FALSE, nullptr);
-
-	// Record commands.
-	const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
-	commandList->ClearRenderTargetView(rtvDesc, clearColor, 0, nullptr);
-	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
-	ID3D12DescriptorHeap* descriptorHeaps[] = { textureDescriptorHeap.Get() };
-	commandList->SetDescriptorHeaps(1, descriptorHeaps);
-
-	auto textureDescHandle = textureDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-	for (int i = 0; i < numTextures; ++i)
+	// Polling the file system every frame is not necessary.
+	const float shaderFileCheckInterval = 0.5f;
+	timeSinceShaderFileCheck += lastFrameTimeInSeconds;
+	if (timeSinceShaderFileCheck < shaderFileCheckInterval)
+		return;
+	timeSinceShaderFileCheck = 0.0f;
+
+	if (shaderFileWatcher->PollChanges())
 	{
-		commandList->SetGraphicsRootDescriptorTable(0, textureDescHandle);
-		commandList->SetGraphicsRoot32BitConstant(1, i, 0);
-		commandList->DrawInstanced(4, 1, 0, 0);
-		textureDescHandle.ptr += device->GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		// The archive holds the shaders of the last build, so the reload always goes through the shader cache.
+		// All pipelines are recreated, the ones whose sources did not change are shader and pipeline cache hits.
+		shaderReloadJob = backgroundJobSystem->Schedule([this]() {
+			if (!CreatePipelineState(false, reloadedPso) ||
+				(configuration.gpuTextureGeneration && !CreateGenerationPipelineState(false, reloadedGenerationPso)))
+			{
+				reloadedPso.Reset();
+				reloadedGenerationPso.Reset();
+			}
+		});
 	}
-
-	// Indicate that the back buffer will now be used to present.
-	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(device->GetCurrentSwapChainBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
-
-	if (FAILED(commandList->Close()))
-		CRITICAL_ERROR("Failed to close the command list.");
 }
 
-void Application::Update(float lastFrameTimeInSeconds)
+void Application::Render()
 {
+	renderer->Render();
 }
 
-void Application::Render()
+void Application::Run()
 {
-	// Record all the commands we need to render the scene into the command list.
-	PopulateCommandList();
-
-	// Execute the command list.
-	ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
-	device->GetDirectCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	// Formatting and setting the caption costs allocations and a syscall, so it is only done a few times per second.
+	const float captionUpdateInterval = 0.25f;
+	float timeSinceCaptionUpdate = 0.0f;
 
-	// Present the frame.
-	device->Present();
-
-	device->WaitForFreeInflightFrame();
-	frameQueueIndex = (frameQueueIndex + 1) % D3D12Device::MAX_FRAMES_INFLIGHT;
+	while (RunFrame())
+	{
+		timeSinceCaptionUpdate += static_cast<float>(lastFrameMilliseconds / 1000.0);
+		if (timeSinceCaptionUpdate >= captionUpdateInterval)
+		{
+			UpdateCaption();
+			timeSinceCaptionUpdate = 0.0f;
+		}
+	}
 }
 
-void Application::Run()
+bool Application::RunFrame()
 {
-	auto messageFunc = std::bind(&Application::OnWindowMessage, this, std::placeholders::_1);
+	auto begin = std::chrono::high_resolution_clock::now(); // should be as good as QueryPerformanceCounter in VS2015
 
-	running = true;
-	float lastFrameTimeInSeconds = 0.0f;
+	// In latency mode this is where the CPU waits, so that messages and Update see the latest input.
+	renderer->BeginFrame();
 
-	while (running)
 	{
-		auto begin = std::chrono::high_resolution_clock::now(); // should be as good as QueryPerformanceCounter in VS2015
-		
-		window->ReceiveMessages(messageFunc);
-		Update(lastFrameTimeInSeconds);
-		Render();
-
-		auto end = std::chrono::high_resolution_clock::now();
-		long long duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
-		lastFrameTimeInSeconds = static_cast<float>(duration / 1000.0 / 1000.0 / 1000.0);
-		window->SetCaption(std::to_wstring(device->GetNumFramesInFlight()) + L" frames in-flight --- " + 
-			std::to_wstring(duration / 1000.0 / 1000.0) + L" ms -- " + std::to_wstring(1.0f / lastFrameTimeInSeconds) + L" fps");
+		PROFILE_SCOPE("ReceiveMessages");
+		window->ReceiveMessages([this](MSG message) { OnWindowMessage(message); });
 	}
+	if (!running)
+		return false;
+	Update(static_cast<float>(lastFrameMilliseconds / 1000.0));
+	Render();
+
+	auto end = std::chrono::high_resolution_clock::now();
+	lastFrameMilliseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000.0 / 1000.0;
+	frameStatistics->AddFrame(lastFrameMilliseconds);
+	return running;
+}
+
+void Application::UpdateCaption()
+{
+	GpuTimingStatistics::Summary gpuDrawTime = {};
+	renderer->GetGpuProfiler().GetStatistics().GetSummary("Draws", gpuDrawTime);
+	double averageFrameTime = frameStatistics->GetAverage();
+	window->SetCaption(std::to_wstring(device->GetNumFramesInFlight()) + L"/" + std::to_wstring(device->GetMaxFramesInFlight()) + L" frames in-flight (" +
+		(device->GetFramePacingMode() == FramePacingMode::Latency ? L"latency" : L"throughput") + L") --- " +
+		std::to_wstring(averageFrameTime) + L" ms avg -- " + std::to_wstring(averageFrameTime > 0.0 ? 1000.0 / averageFrameTime : 0.0) + L" fps -- " +
+		std::to_wstring(frameStatistics->GetPercentile(50.0)) + L" / " + std::to_wstring(frameStatistics->GetPercentile(95.0)) + L" / " +
+		std::to_wstring(frameStatistics->GetPercentile(99.0)) + L" ms p50/p95/p99 -- " +
+		std::to_wstring(frameStatistics->GetNumFramesOverBudget()) + L" over budget -- " +
+		std::to_wstring(renderer->GetLastFrameTimings().recordingMilliseconds) + L" ms recording -- " + std::to_wstring(gpuDrawTime.avgMilliseconds) + L" ms GPU draws");
 }
 
 void Application::OnWindowMessage(MSG message)
 {
 	if (message.message == WM_QUIT)
 		running = false;
+
+	// F3 dumps the frame times.
+	if (message.message == WM_KEYDOWN && message.wParam == VK_F3)
+	{
+		std::string csvPath = GetExecutableDirectory() + "frametimes.csv";
+		std::string jsonPath = GetExecutableDirectory() + "frametimes.json";
+		if (frameStatistics->WriteCsv(csvPath) && frameStatistics->WriteJson(jsonPath))
+			std::cerr << "Wrote frame times to " << csvPath << " and " << jsonPath << std::endl;
+		else
+			std::cerr << "Failed to write frame times." << std::endl;
+	}
+
+	// F4 starts capturing commands, pressing it again saves all frames rendered in between.
+	CapturingDevice* capturingDevice = renderer->GetCapturingDevice();
+	if (message.message == WM_KEYDOWN && message.wParam == VK_F4 && capturingDevice)
+	{
+		if (!capturingDevice->IsCapturing())
+		{
+			capturingDevice->StartCapture();
+			std::cerr << "Started command capture" << std::endl;
+		}
+		else
+		{
+			capturingDevice->StopCapture();
+			std::string capturePath = GetExecutableDirectory() + "capture.cmdstream";
+			if (capturingDevice->GetCommandStream().Save(capturePath))
+				std::cerr << "Wrote " << capturingDevice->GetCommandStream().GetNumFrames() << " captured frames to " << capturePath << std::endl;
+			else
+				std::cerr << "Failed to write command capture to " << capturePath << std::endl;
+		}
+	}
+
+	// F5 switches between throughput and latency frame pacing, F6 cycles through the number of frames in flight.
+	if (message.message == WM_KEYDOWN && message.wParam == VK_F5)
+		device->SetFramePacingMode(device->GetFramePacingMode() == FramePacingMode::Throughput ? FramePacingMode::Latency : FramePacingMode::Throughput);
+	if (message.message == WM_KEYDOWN && message.wParam == VK_F6)
+		device->SetMaxFramesInFlight(device->GetMaxFramesInFlight() % RenderDevice::MAX_FRAMES_INFLIGHT + 1);
+
+	// F7 streams in a new set of textures.
+	if (message.message == WM_KEYDOWN && message.wParam == VK_F7)
+	{
+		if (renderer->StreamTextures())
+			std::cerr << "Streaming " << renderer->GetConfiguration().numTextures << " textures" << std::endl;
+	}
+
+#ifdef CPU_PROFILER
+	// F2 dumps the recent CPU markers of all threads.
+	if (message.message == WM_KEYDOWN && message.wParam == VK_F2)
+	{
+		std::string tracePath = GetExecutableDirectory() + "cputrace.json";
+		if (CpuProfiler::WriteChromeTrace(tracePath))
+			std::cerr << "Wrote CPU trace to " << tracePath << std::endl;
+		else
+			std::cerr << "Failed to write CPU trace to " << tracePath << std::endl;
+	}
+#endif
 }
\ No newline at end of file
@@ -1,53 +1,105 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <Windows.h>
 #include "D3D12Device.h"
+#include "ShaderCache.h"
+#include "ShaderArchive.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+#include "Renderer.h"
 
 
 class Window;
 class D3D12Device;
+class FileWatcher;
+class PipelineCache;
+class FrameStatistics;
 
 class Application
 {
 public:
-	Application();
+	/// Runtime options are the ones of the renderer.
+	typedef Renderer::Configuration Configuration;
+
+	Application(const Configuration& configuration);
 	~Application();
 
 	void Update(float lastFrameTimeInSeconds);
 	void Render();
 
+	/// Runs frames until the window is closed.
 	void Run();
+	/// Runs a single frame. Returns false once the application was asked to quit.
+	bool RunFrame();
+
+	Renderer& GetRenderer()							{ return *renderer; }
+	const Renderer& GetRenderer() const				{ return *renderer; }
+	const Configuration& GetConfiguration() const	{ return configuration; }
+	/// CPU time of the last frame, including message handling and Update.
+	double GetLastFrameMilliseconds() const			{ return lastFrameMilliseconds; }
+
+	/// Compiles all shader variants and packs them into a shader archive. Does not need a window or device.
+	static bool BuildShaderArchive(const std::string& path);
+	/// Shader archive that is loaded at startup. Next to the executable.
+	static std::string GetShaderArchivePath();
 
 private:
 	void CreateRootSignature();
 	void CreatePSO();
-	void CreateVertexBuffer();
-	void CreateTextures();
-
-	void PopulateCommandList();
+	/// Compiles the shaders if necessary and creates a PSO with them. Returns false on failure, errors are written to std::cerr.
+	/// Thread safe with respect to rendering, as long as there are no other concurrent users of shaderCache and pipelineCache.
+	bool CreatePipelineState(bool useShaderArchive, ComPtr<ID3D12PipelineState>& outPso);
+	/// Vertex and pixel shader for the given configuration.
+	static std::vector<ShaderCache::ShaderDesc> GetShaderDescs(const Configuration& configuration);
+	/// Root signature and PSO of the texture generation compute shader, see Configuration::gpuTextureGeneration.
+	void CreateGenerationPipeline();
+	/// Like CreatePipelineState for the texture generation compute shader. Needs generationRootSignature.
+	bool CreateGenerationPipelineState(bool useShaderArchive, ComPtr<ID3D12PipelineState>& outPso);
+	static ShaderCache::ShaderDesc GetGenerationShaderDesc();
+	/// Takes a shader from the archive if it was built from the current source. If the source is not available, the archive is trusted.
+	bool FindArchivedShader(const ShaderCache::ShaderDesc& shader, D3D12_SHADER_BYTECODE& outBytecode) const;
+
+	/// Shows the frame statistics in the window caption.
+	void UpdateCaption();
+
+	/// Starts a background recompile if a shader file changed and swaps in the new PSO once it is ready.
+	void UpdateShaderHotReload(float lastFrameTimeInSeconds);
 
 	void OnWindowMessage(MSG message);
 
+	const Configuration configuration;
+
+	std::unique_ptr<JobSystem> jobSystem;
+	/// Runs shader compilation. Separate from jobSystem, since waiting on recording jobs could otherwise pick up long running compile jobs on the render thread.
+	std::unique_ptr<JobSystem> backgroundJobSystem;
+
 	std::unique_ptr<Window> window;
 	std::unique_ptr<D3D12Device> device;
 
-	D3D12_VIEWPORT viewport;
-	D3D12_RECT scissorRect;
-
+	ComPtr<ID3DBlob> rootSignatureBlob;	///< Serialized rootSignature.
 	ComPtr<ID3D12RootSignature> rootSignature;
+	MappedFile shaderArchiveFile;
+	ShaderArchiveReader shaderArchive;	///< Points into shaderArchiveFile.
+	std::unique_ptr<ShaderCache> shaderCache;
+	std::unique_ptr<PipelineCache> pipelineCache;
 	ComPtr<ID3D12PipelineState> pso;
-
-	unsigned int frameQueueIndex;
-	ComPtr<ID3D12CommandAllocator> commandAllocator[D3D12Device::MAX_FRAMES_INFLIGHT];
-	ComPtr<ID3D12GraphicsCommandList> commandList;
-
-	ComPtr<ID3D12Resource> vertexBuffer;
-	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
-
-	static const unsigned int numTextures = 1000;
-	ComPtr<ID3D12Resource> textures[numTextures];
-	ComPtr<ID3D12DescriptorHeap> textureDescriptorHeap;
+	/// Only with Configuration::gpuTextureGeneration.
+	ComPtr<ID3DBlob> generationRootSignatureBlob;
+	ComPtr<ID3D12RootSignature> generationRootSignature;
+	ComPtr<ID3D12PipelineState> generationPso;
+
+	/// Shader hot-reload. The watcher is only polled while no reload job is running.
+	std::unique_ptr<FileWatcher> shaderFileWatcher;
+	float timeSinceShaderFileCheck;
+	JobSystem::JobHandle shaderReloadJob;
+	ComPtr<ID3D12PipelineState> reloadedPso;	///< Written by shaderReloadJob, null if the reload failed.
+	ComPtr<ID3D12PipelineState> reloadedGenerationPso;	///< Written by shaderReloadJob, only with Configuration::gpuTextureGeneration.
+
+	std::unique_ptr<Renderer> renderer;
+	double lastFrameMilliseconds;
+	std::unique_ptr<FrameStatistics> frameStatistics;
 
 	bool running;
 };
@@ -0,0 +1,600 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "CapturingDevice.h"
+#include "CommandStreamPlayer.h"
+#include "ProceduralTexture.h"
+#include "Helper.h"
+#ifdef _WIN32
+	#include "Application.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+	const char* GetName(Renderer::TextureBinding textureBinding)
+	{
+		switch (textureBinding)
+		{
+		case Renderer::TextureBinding::DescriptorTablePerDraw:
+			return "table";
+		case Renderer::TextureBinding::TextureArray:
+			return "array";
+		case Renderer::TextureBinding::Bindless:
+			return "bindless";
+		}
+		return "unknown";
+	}
+
+	const char* GetName(Renderer::DrawSubmission drawSubmission)
+	{
+		switch (drawSubmission)
+		{
+		case Renderer::DrawSubmission::DrawPerTexture:
+			return "perdraw";
+		case Renderer::DrawSubmission::Instanced:
+			return "instanced";
+		case Renderer::DrawSubmission::ExecuteIndirect:
+			return "indirect";
+		}
+		return "unknown";
+	}
+}
+
+Benchmark::Settings::Settings() :
+	mode(Mode::Frames),
+	numWarmupFrames(100),
+	numMeasuredFrames(1000),
+#ifdef _WIN32
+	headless(false),
+#else
+	headless(true),
+#endif
+	streamTexturesInterval(0)
+{
+}
+
+Benchmark::Benchmark(const Settings& _settings) :
+	settings(_settings),
+	memoryStatistics(),
+	totalSeconds(0.0),
+	hasNullDeviceStatistics(false),
+	nullDeviceStatistics(),
+	textureGenerationBytesPerFrame(0),
+	textureGeneratorsMatch(false),
+	emptyJobsPerSecond(0.0),
+	emptyJobStealRate(0.0),
+	scheduleWaitMicroseconds(0.0)
+{
+}
+
+bool Benchmark::Run()
+{
+	bool completed;
+	if (settings.mode == Mode::TextureGeneration)
+		completed = RunTextureGeneration();
+	else if (settings.mode == Mode::JobSystem)
+		completed = RunJobSystem();
+	else if (settings.mode == Mode::RecordingThreads)
+		completed = RunRecordingThreads();
+	else if (!settings.replayPath.empty())
+		completed = RunReplay();
+	else
+	{
+		Renderer::Configuration configuration = settings.configuration;
+		configuration.captureCommands = !settings.capturePath.empty();
+		completed = RunRenderer(configuration);
+	}
+
+	// Partial results are written nevertheless.
+	return WriteResults() && completed;
+}
+
+bool Benchmark::RunRenderer(const Renderer::Configuration& configuration)
+{
+	bool completed;
+	if (settings.headless)
+	{
+		NullDevice device(1280, 720, configuration.numBackbuffers);
+		JobSystem jobSystem;
+		Renderer renderer(configuration, device, jobSystem, device.CreateRootSignature(), device.CreatePipelineState(),
+							device.CreateRootSignature(), device.CreatePipelineState());
+		unsigned int frame = 0;
+		completed = RunFrames([this, &renderer, &frame]() { StreamTextures(renderer, ++frame); renderer.Render(); return true; },
+								[&renderer]() -> const Renderer::FrameTimings& { return renderer.GetLastFrameTimings(); }, renderer.GetCapturingDevice());
+		memoryStatistics = renderer.GetMemoryStatistics();
+		hasNullDeviceStatistics = true;
+		nullDeviceStatistics = device.GetStatistics();
+	}
+	else
+	{
+#ifdef _WIN32
+		Application application(configuration);
+		Renderer& renderer = application.GetRenderer();
+		unsigned int frame = 0;
+		completed = RunFrames([this, &application, &renderer, &frame]() { StreamTextures(renderer, ++frame); return application.RunFrame(); },
+								[&renderer]() -> const Renderer::FrameTimings& { return renderer.GetLastFrameTimings(); }, renderer.GetCapturingDevice());
+		memoryStatistics = renderer.GetMemoryStatistics();
+#else
+		std::cerr << "Only headless benchmarks are supported on this platform." << std::endl;
+		return false;
+#endif
+	}
+	return completed;
+}
+
+bool Benchmark::RunRecordingThreads()
+{
+	const unsigned int numRecordingThreads[] = { 1, 2, 4, 8, 16 };
+	for (unsigned int numThreads : numRecordingThreads)
+	{
+		Renderer::Configuration configuration = settings.configuration;
+		configuration.numRecordingThreads = numThreads;
+		configuration.captureCommands = false;
+
+		recordingMilliseconds.clear();
+		submitMilliseconds.clear();
+		waitMilliseconds.clear();
+		frameMilliseconds.clear();
+		bool completed = RunRenderer(configuration);
+
+		RecordingThreadsResult result = { numThreads, Summarize(recordingMilliseconds), Summarize(frameMilliseconds),
+											hasNullDeviceStatistics ? nullDeviceStatistics.numValidationErrors : 0 };
+		recordingThreadsResults.push_back(result);
+		if (!completed)
+			return false;
+	}
+	return true;
+}
+
+bool Benchmark::RunReplay()
+{
+	CommandStream stream;
+	if (!stream.Load(settings.replayPath))
+	{
+		std::cerr << "Failed to load command stream " << settings.replayPath << std::endl;
+		return false;
+	}
+	if (stream.GetNumFrames() == 0)
+	{
+		std::cerr << "Command stream " << settings.replayPath << " contains no frames." << std::endl;
+		return false;
+	}
+
+	NullDevice device(1280, 720, settings.configuration.numBackbuffers);
+	device.SetMaxFramesInFlight(settings.configuration.numFramesInFlight);
+	device.SetFramePacingMode(settings.configuration.framePacing);
+	std::vector<RenderHandle> handles = CommandStreamPlayer::CreateNullDeviceHandles(device, stream);
+	CommandStreamPlayer player(device, stream, handles);
+	auto replayFrame = [&player]() {
+		if (player.ReplayFrame())
+			return true;
+		if (player.HasError())
+		{
+			std::cerr << "Command stream is invalid." << std::endl;
+			return false;
+		}
+		player.Rewind();
+		return player.ReplayFrame();
+	};
+	bool completed = RunFrames(replayFrame, [&player]() -> const Renderer::FrameTimings& { return player.GetLastFrameTimings(); }, nullptr);
+
+	memoryStatistics.textureMemoryCommitted = device.GetTextureMemoryCommitted();
+	memoryStatistics.textureMemoryUsed = device.GetTextureMemoryUsed();
+	memoryStatistics.uploadRingUsed = device.GetUploadRingUsedSize();
+	memoryStatistics.pendingReleaseBytes = device.GetDeferredReleaseStatistics().pendingBytes;
+	memoryStatistics.maxReleaseLatencyMilliseconds = device.GetDeferredReleaseStatistics().maxReleaseLatencyMilliseconds;
+	hasNullDeviceStatistics = true;
+	nullDeviceStatistics = device.GetStatistics();
+	return completed;
+}
+
+bool Benchmark::RunTextureGeneration()
+{
+	// Same layout as the renderer's textures in upload memory, including the row padding.
+	TextureDesc textureDesc = {};
+	textureDesc.width = Renderer::TEXTURE_SIZE;
+	textureDesc.height = Renderer::TEXTURE_SIZE;
+	textureDesc.arraySize = 1;
+	textureDesc.format = TextureFormat::R8G8B8A8_UNORM;
+	TextureFootprint footprint;
+	NullDevice(1, 1, 2).GetTextureFootprint(textureDesc, footprint);
+
+	const unsigned int numTextures = settings.configuration.numTextures;
+	const size_t textureStride = static_cast<size_t>(AlignUp(footprint.totalSize, TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+	std::vector<uint8_t> data(textureStride * numTextures);
+	textureGenerationBytesPerFrame = footprint.rowSizeInBytes * footprint.numRows * numTextures;
+
+	JobSystem jobSystem;
+	auto measure = [this, numTextures](const char* name, const std::function<void(unsigned int, unsigned int)>& generateTextures) {
+		for (unsigned int frame = 0; frame < settings.numWarmupFrames; ++frame)
+			generateTextures(0, numTextures);
+		auto begin = std::chrono::high_resolution_clock::now();
+		for (unsigned int frame = 0; frame < settings.numMeasuredFrames; ++frame)
+			generateTextures(0, numTextures);
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000.0 / 1000.0 / 1000.0;
+		TextureGeneratorResult result = { name, seconds > 0.0 ? textureGenerationBytesPerFrame * settings.numMeasuredFrames / seconds / 1000.0 / 1000.0 / 1000.0 : 0.0 };
+		textureGeneratorResults.push_back(result);
+	};
+
+	// What the renderer did before ProceduralTexture: one rand() call per byte, serialized by the C runtime's global state.
+	measure("rand", [&data, &footprint, textureStride](unsigned int begin, unsigned int end) {
+		for (unsigned int tex = begin; tex < end; ++tex)
+		{
+			for (uint32_t row = 0; row < footprint.numRows; ++row)
+			{
+				uint8_t* rowData = data.data() + tex * textureStride + row * footprint.rowPitch;
+				for (uint64_t j = 0; j < footprint.rowSizeInBytes; ++j)
+					rowData[j] = static_cast<unsigned char>(rand() % 255);
+			}
+		}
+	});
+
+	auto generateScalar = [&data, &footprint, textureStride](unsigned int begin, unsigned int end) {
+		for (unsigned int tex = begin; tex < end; ++tex)
+			ProceduralTexture::GenerateScalar(tex, footprint.width, footprint.height, data.data() + tex * textureStride, footprint.rowPitch);
+	};
+	auto generateVectorized = [&data, &footprint, textureStride](unsigned int begin, unsigned int end) {
+		for (unsigned int tex = begin; tex < end; ++tex)
+			ProceduralTexture::Generate(tex, footprint.width, footprint.height, data.data() + tex * textureStride, footprint.rowPitch);
+	};
+
+	// The scalar generator's content is the reference for the others.
+	generateScalar(0, numTextures);
+	std::vector<uint8_t> reference = data;
+	measure("scalar", generateScalar);
+
+	std::fill(data.begin(), data.end(), static_cast<uint8_t>(0));
+	measure("vectorized", generateVectorized);
+	textureGeneratorsMatch = data == reference;
+
+	// Split over jobs like Renderer::GenerateTextureData.
+	std::fill(data.begin(), data.end(), static_cast<uint8_t>(0));
+	measure("parallel", [&jobSystem, &generateVectorized](unsigned int begin, unsigned int end) {
+		jobSystem.ParallelFor(begin, end, Renderer::NUM_TEXTURES_PER_GENERATION_JOB, generateVectorized);
+	});
+	textureGeneratorsMatch = textureGeneratorsMatch && data == reference;
+
+	if (!textureGeneratorsMatch)
+		std::cerr << "Vectorized texture generation does not match the scalar reference." << std::endl;
+	return textureGeneratorsMatch;
+}
+
+bool Benchmark::RunJobSystem()
+{
+	// Returns the average seconds of a frame, after running the warmup frames.
+	auto measure = [this](const std::function<void()>& runFrame) {
+		for (unsigned int frame = 0; frame < settings.numWarmupFrames; ++frame)
+			runFrame();
+		auto begin = std::chrono::high_resolution_clock::now();
+		for (unsigned int frame = 0; frame < settings.numMeasuredFrames; ++frame)
+			runFrame();
+		auto end = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000.0 / 1000.0 / 1000.0;
+		return settings.numMeasuredFrames > 0 ? seconds / settings.numMeasuredFrames : 0.0;
+	};
+	auto getStealRate = [](const JobSystem& jobSystem) {
+		return jobSystem.GetNumExecutedJobs() > 0 ? static_cast<double>(jobSystem.GetNumStolenJobs()) / jobSystem.GetNumExecutedJobs() : 0.0;
+	};
+
+	// Only scheduling costs, since the jobs do nothing. All are scheduled from this thread, the workers steal from each other's queues.
+	{
+		const unsigned int numEmptyJobs = 10000;
+		JobSystem jobSystem;
+		std::vector<JobSystem::JobHandle> jobs;
+		jobs.reserve(numEmptyJobs);
+		double seconds = measure([&jobSystem, &jobs, numEmptyJobs]() {
+			for (unsigned int i = 0; i < numEmptyJobs; ++i)
+				jobs.push_back(jobSystem.Schedule([]() {}));
+			for (const JobSystem::JobHandle& job : jobs)
+				jobSystem.Wait(job);
+			jobs.clear();
+		});
+		emptyJobsPerSecond = seconds > 0.0 ? numEmptyJobs / seconds : 0.0;
+		emptyJobStealRate = getStealRate(jobSystem);
+
+		// Round trip of a single job, i.e. the latency of handing work to the workers.
+		const unsigned int numRoundTrips = 100;
+		seconds = measure([&jobSystem, numRoundTrips]() {
+			for (unsigned int i = 0; i < numRoundTrips; ++i)
+				jobSystem.Wait(jobSystem.Schedule([]() {}));
+		});
+		scheduleWaitMicroseconds = seconds / numRoundTrips * 1000.0 * 1000.0;
+	}
+
+	// The same work with 1, 2, 4, ... workers, up to one per hardware thread. The calling thread works as well while it waits.
+	const unsigned int numElements = 1 << 18;
+	const unsigned int grainSize = 1024;
+	std::vector<uint32_t> output(numElements);
+	auto work = [&output](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			uint32_t value = i;
+			for (unsigned int round = 0; round < 16; ++round)
+				value = ProceduralTexture::Hash(value);
+			output[i] = value;
+		}
+	};
+	const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	for (unsigned int numWorkers = 1; ; numWorkers *= 2)
+	{
+		JobSystem jobSystem(numWorkers);
+		double seconds = measure([&jobSystem, &work, numElements, grainSize]() { jobSystem.ParallelFor(0, numElements, grainSize, work); });
+		ParallelForResult result = { numWorkers, seconds * 1000.0, 1.0, getStealRate(jobSystem) };
+		if (!parallelForResults.empty() && result.milliseconds > 0.0)
+			result.speedup = parallelForResults.front().milliseconds / result.milliseconds;
+		parallelForResults.push_back(result);
+		if (numWorkers * 2 > hardwareThreads)
+			break;
+	}
+	return true;
+}
+
+void Benchmark::StreamTextures(Renderer& renderer, unsigned int frame) const
+{
+	if (settings.streamTexturesInterval > 0 && frame % settings.streamTexturesInterval == 0)
+		renderer.StreamTextures();
+}
+
+bool Benchmark::RunFrames(const std::function<bool()>& runFrame, const std::function<const Renderer::FrameTimings&()>& getLastFrameTimings, CapturingDevice* capturingDevice)
+{
+	for (unsigned int frame = 0; frame < settings.numWarmupFrames; ++frame)
+	{
+		if (!runFrame())
+		{
+			std::cerr << "Application quit during warmup." << std::endl;
+			return false;
+		}
+	}
+
+	recordingMilliseconds.reserve(settings.numMeasuredFrames);
+	submitMilliseconds.reserve(settings.numMeasuredFrames);
+	waitMilliseconds.reserve(settings.numMeasuredFrames);
+	frameMilliseconds.reserve(settings.numMeasuredFrames);
+
+	if (capturingDevice)
+		capturingDevice->StartCapture();
+
+	bool quitEarly = false;
+	auto begin = std::chrono::high_resolution_clock::now();
+	auto frameBegin = begin;
+	for (unsigned int frame = 0; frame < settings.numMeasuredFrames; ++frame)
+	{
+		if (!runFrame())
+		{
+			quitEarly = true;
+			break;
+		}
+		auto frameEnd = std::chrono::high_resolution_clock::now();
+		const Renderer::FrameTimings& timings = getLastFrameTimings();
+		recordingMilliseconds.push_back(timings.recordingMilliseconds);
+		submitMilliseconds.push_back(timings.submitMilliseconds);
+		waitMilliseconds.push_back(timings.waitMilliseconds);
+		frameMilliseconds.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(frameEnd - frameBegin).count() / 1000.0 / 1000.0);
+		frameBegin = frameEnd;
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	totalSeconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000.0 / 1000.0 / 1000.0;
+
+	if (capturingDevice)
+	{
+		capturingDevice->StopCapture();
+		const CommandStream& stream = capturingDevice->GetCommandStream();
+		if (!stream.Save(settings.capturePath))
+		{
+			std::cerr << "Failed to write command stream to " << settings.capturePath << std::endl;
+			return false;
+		}
+		std::cerr << "Captured " << stream.GetNumFrames() << " frames (" << stream.GetData().size() / 1024 << " KB) to " << settings.capturePath << std::endl;
+	}
+
+	if (quitEarly)
+		std::cerr << "Application quit after " << frameMilliseconds.size() << " measured frames." << std::endl;
+	return !quitEarly;
+}
+
+bool Benchmark::WriteResults() const
+{
+	if (settings.outputPath.empty())
+	{
+		WriteJson(std::cout);
+		return true;
+	}
+
+	std::ofstream file(settings.outputPath);
+	if (file)
+		WriteJson(file);
+	if (!file)
+	{
+		std::cerr << "Failed to write benchmark results to " << settings.outputPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+Benchmark::Summary Benchmark::Summarize(std::vector<double> samples)
+{
+	Summary summary = {};
+	if (samples.empty())
+		return summary;
+
+	// Nearest rank percentiles.
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&samples](double p) {
+		size_t rank = static_cast<size_t>(p / 100.0 * samples.size() + 0.5);
+		return samples[rank > 0 ? (rank < samples.size() ? rank - 1 : samples.size() - 1) : 0];
+	};
+
+	double sum = 0.0;
+	for (double sample : samples)
+		sum += sample;
+
+	summary.minMilliseconds = samples.front();
+	summary.avgMilliseconds = sum / samples.size();
+	summary.p50Milliseconds = percentile(50.0);
+	summary.p95Milliseconds = percentile(95.0);
+	summary.p99Milliseconds = percentile(99.0);
+	summary.maxMilliseconds = samples.back();
+	return summary;
+}
+
+void Benchmark::WriteSummary(std::ostream& stream, const char* name, const Summary& summary, const char* indentation)
+{
+	stream << indentation << "\"" << name << "\": { \"min\": " << summary.minMilliseconds << ", \"avg\": " << summary.avgMilliseconds <<
+		", \"p50\": " << summary.p50Milliseconds << ", \"p95\": " << summary.p95Milliseconds << ", \"p99\": " << summary.p99Milliseconds <<
+		", \"max\": " << summary.maxMilliseconds << " }";
+}
+
+void Benchmark::WriteJson(std::ostream& stream) const
+{
+	stream << "{\n";
+	WriteConfiguration(stream);
+	switch (settings.mode)
+	{
+	case Mode::Frames:
+		WriteFrameResults(stream);
+		break;
+	case Mode::RecordingThreads:
+		WriteRecordingThreadsResults(stream);
+		break;
+	case Mode::TextureGeneration:
+		WriteTextureGenerationResults(stream);
+		break;
+	case Mode::JobSystem:
+		WriteJobSystemResults(stream);
+		break;
+	}
+	stream << "\n";
+	stream << "}\n";
+}
+
+void Benchmark::WriteConfiguration(std::ostream& stream) const
+{
+	const Renderer::Configuration& configuration = settings.configuration;
+
+	stream << "\t\"configuration\": {\n";
+	stream << "\t\t\"numTextures\": " << configuration.numTextures << ",\n";
+	stream << "\t\t\"textureBinding\": \"" << GetName(configuration.textureBinding) << "\",\n";
+	stream << "\t\t\"drawSubmission\": \"" << GetName(configuration.drawSubmission) << "\",\n";
+	stream << "\t\t\"indirectCountBuffer\": " << (configuration.indirectCountBuffer ? "true" : "false") << ",\n";
+	stream << "\t\t\"numRecordingThreads\": " << configuration.numRecordingThreads << ",\n";
+	stream << "\t\t\"numFramesInFlight\": " << configuration.numFramesInFlight << ",\n";
+	stream << "\t\t\"framePacing\": \"" << (configuration.framePacing == FramePacingMode::Latency ? "latency" : "throughput") << "\",\n";
+	stream << "\t\t\"numBackbuffers\": " << configuration.numBackbuffers << ",\n";
+	stream << "\t\t\"copyQueueUploads\": " << (configuration.copyQueueUploads ? "true" : "false") << ",\n";
+	stream << "\t\t\"gpuTextureGeneration\": " << (configuration.gpuTextureGeneration ? "true" : "false") << "\n";
+	stream << "\t}";
+}
+
+void Benchmark::WriteFrameResults(std::ostream& stream) const
+{
+	stream << ",\n";
+	stream << "\t\"headless\": " << (settings.headless ? "true" : "false") << ",\n";
+	stream << "\t\"replay\": " << (settings.replayPath.empty() ? "false" : "true") << ",\n";
+	stream << "\t\"streamTexturesInterval\": " << settings.streamTexturesInterval << ",\n";
+	stream << "\t\"numWarmupFrames\": " << settings.numWarmupFrames << ",\n";
+	stream << "\t\"numMeasuredFrames\": " << frameMilliseconds.size() << ",\n";
+	stream << "\t\"totalSeconds\": " << totalSeconds << ",\n";
+
+	// All timings in milliseconds per frame.
+	stream << "\t\"cpuTimings\": {\n";
+	WriteSummary(stream, "recording", Summarize(recordingMilliseconds));
+	stream << ",\n";
+	WriteSummary(stream, "submit", Summarize(submitMilliseconds));
+	stream << ",\n";
+	WriteSummary(stream, "wait", Summarize(waitMilliseconds));
+	stream << ",\n";
+	WriteSummary(stream, "frame", Summarize(frameMilliseconds));
+	stream << "\n\t},\n";
+
+	stream << "\t\"memory\": {\n";
+	stream << "\t\t\"textureMemoryCommitted\": " << memoryStatistics.textureMemoryCommitted << ",\n";
+	stream << "\t\t\"textureMemoryUsed\": " << memoryStatistics.textureMemoryUsed << ",\n";
+	stream << "\t\t\"uploadRingUsed\": " << memoryStatistics.uploadRingUsed << ",\n";
+	stream << "\t\t\"pendingReleaseBytes\": " << memoryStatistics.pendingReleaseBytes << ",\n";
+	stream << "\t\t\"maxReleaseLatencyMilliseconds\": " << memoryStatistics.maxReleaseLatencyMilliseconds << "\n";
+	stream << "\t}";
+
+	// Counters of everything the renderer asked the device to do, over all frames including startup.
+	if (hasNullDeviceStatistics)
+	{
+		stream << ",\n\t\"nullDevice\": {\n";
+		stream << "\t\t\"numDrawCalls\": " << nullDeviceStatistics.numDrawCalls << ",\n";
+		stream << "\t\t\"numIndirectDraws\": " << nullDeviceStatistics.numIndirectDraws << ",\n";
+		stream << "\t\t\"numDispatches\": " << nullDeviceStatistics.numDispatches << ",\n";
+		stream << "\t\t\"numBarriers\": " << nullDeviceStatistics.numBarriers << ",\n";
+		stream << "\t\t\"numDescriptorWrites\": " << nullDeviceStatistics.numDescriptorWrites << ",\n";
+		stream << "\t\t\"numDescriptorTableBinds\": " << nullDeviceStatistics.numDescriptorTableBinds << ",\n";
+		stream << "\t\t\"numCopies\": " << nullDeviceStatistics.numCopies << ",\n";
+		stream << "\t\t\"numBytesCopied\": " << nullDeviceStatistics.numBytesCopied << ",\n";
+		stream << "\t\t\"numBytesUploaded\": " << nullDeviceStatistics.numBytesUploaded << ",\n";
+		stream << "\t\t\"numExecutedCommandLists\": " << nullDeviceStatistics.numExecutedCommandLists << ",\n";
+		stream << "\t\t\"numExecutedCopyCommandLists\": " << nullDeviceStatistics.numExecutedCopyCommandLists << ",\n";
+		stream << "\t\t\"numPresents\": " << nullDeviceStatistics.numPresents << ",\n";
+		stream << "\t\t\"numValidationErrors\": " << nullDeviceStatistics.numValidationErrors << "\n";
+		stream << "\t}";
+	}
+}
+
+void Benchmark::WriteRecordingThreadsResults(std::ostream& stream) const
+{
+	// Timings in milliseconds per frame, for each number of recording threads.
+	stream << ",\n\t\"headless\": " << (settings.headless ? "true" : "false") << ",\n";
+	stream << "\t\"numWarmupFrames\": " << settings.numWarmupFrames << ",\n";
+	stream << "\t\"numMeasuredFrames\": " << settings.numMeasuredFrames << ",\n";
+	stream << "\t\"recordingThreads\": [\n";
+	for (size_t i = 0; i < recordingThreadsResults.size(); ++i)
+	{
+		const RecordingThreadsResult& result = recordingThreadsResults[i];
+		stream << "\t\t{\n";
+		stream << "\t\t\t\"numRecordingThreads\": " << result.numRecordingThreads << ",\n";
+		WriteSummary(stream, "recording", result.recording, "\t\t\t");
+		stream << ",\n";
+		WriteSummary(stream, "frame", result.frame, "\t\t\t");
+		stream << ",\n";
+		stream << "\t\t\t\"numValidationErrors\": " << result.numValidationErrors << "\n";
+		stream << (i + 1 < recordingThreadsResults.size() ? "\t\t},\n" : "\t\t}\n");
+	}
+	stream << "\t]";
+}
+
+void Benchmark::WriteTextureGenerationResults(std::ostream& stream) const
+{
+	// Throughput of the CPU texture generators, counting texel bytes without row padding.
+	stream << ",\n\t\"textureGeneration\": {\n";
+	stream << "\t\t\"numWarmupFrames\": " << settings.numWarmupFrames << ",\n";
+	stream << "\t\t\"numMeasuredFrames\": " << settings.numMeasuredFrames << ",\n";
+	stream << "\t\t\"bytesPerFrame\": " << textureGenerationBytesPerFrame << ",\n";
+	stream << "\t\t\"generatorsMatch\": " << (textureGeneratorsMatch ? "true" : "false") << ",\n";
+	stream << "\t\t\"gigabytesPerSecond\": { ";
+	for (size_t i = 0; i < textureGeneratorResults.size(); ++i)
+		stream << (i > 0 ? ", " : "") << "\"" << textureGeneratorResults[i].name << "\": " << textureGeneratorResults[i].gigabytesPerSecond;
+	stream << " }\n";
+	stream << "\t}";
+}
+
+void Benchmark::WriteJobSystemResults(std::ostream& stream) const
+{
+	stream << ",\n\t\"jobSystem\": {\n";
+	stream << "\t\t\"numWarmupFrames\": " << settings.numWarmupFrames << ",\n";
+	stream << "\t\t\"numMeasuredFrames\": " << settings.numMeasuredFrames << ",\n";
+	stream << "\t\t\"emptyJobsPerSecond\": " << emptyJobsPerSecond << ",\n";
+	stream << "\t\t\"emptyJobStealRate\": " << emptyJobStealRate << ",\n";
+	stream << "\t\t\"scheduleWaitMicroseconds\": " << scheduleWaitMicroseconds << ",\n";
+	stream << "\t\t\"parallelFor\": [\n";
+	for (size_t i = 0; i < parallelForResults.size(); ++i)
+	{
+		const ParallelForResult& result = parallelForResults[i];
+		stream << "\t\t\t{ \"numWorkers\": " << result.numWorkers << ", \"milliseconds\": " << result.milliseconds <<
+			", \"speedup\": " << result.speedup << ", \"stealRate\": " << result.stealRate << " }" << (i + 1 < parallelForResults.size() ? ",\n" : "\n");
+	}
+	stream << "\t\t]\n";
+	stream << "\t}";
+}
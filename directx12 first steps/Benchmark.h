@@ -0,0 +1,136 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Renderer.h"
+#include "NullDevice.h"
+
+class CapturingDevice;
+
+/// Runs an Application (or a headless Renderer on a NullDevice, or a captured CommandStream) with a fixed configuration for a fixed number of frames and reports CPU timings and memory counters as JSON.
+/// Alternatively sweeps the number of recording threads, or measures only the CPU texture generators or the JobSystem, see Mode.
+///
+/// Warmup frames are run first and excluded from the results, so that shader compilation, pipeline creation and caches settling do not skew them.
+class Benchmark
+{
+public:
+	/// What is measured.
+	enum class Mode
+	{
+		Frames,				///< Renders or replays frames and reports frame timings, memory and device counters.
+		/// Renders the frames once for each of 1, 2, 4, 8 and 16 Configuration::numRecordingThreads and reports the recording and frame timings of each.
+		/// Does not capture.
+		RecordingThreads,
+		TextureGeneration,	///< Generates the content of Configuration::numTextures textures once per frame with each CPU texture generator and reports their throughput.
+		JobSystem			///< Schedules and waits for empty jobs and runs a ParallelFor with increasing numbers of workers, once per frame each. Reports throughput, scaling and steals.
+	};
+
+	struct Settings
+	{
+		Settings();
+
+		Mode mode;
+		Renderer::Configuration configuration;
+		unsigned int numWarmupFrames;
+		unsigned int numMeasuredFrames;
+		std::string outputPath;	///< JSON results are written here. Empty writes to std::cout, all diagnostics go to std::cerr.
+		/// Renders on a NullDevice without window and GPU, measuring only the CPU side. Always true on platforms other than Windows.
+		bool headless;
+		/// If not empty, the measured frames are captured and saved to this path as a CommandStream.
+		std::string capturePath;
+		/// If not empty, replays the CommandStream at this path on a NullDevice instead of rendering, looping it as often as needed.
+		/// Measures decoding and submission without the renderer's recording.
+		std::string replayPath;
+		/// If not 0, Renderer::StreamTextures is called every this many frames, to measure what streaming costs the frames.
+		unsigned int streamTexturesInterval;
+	};
+
+	Benchmark(const Settings& settings);
+
+	/// Runs all frames and writes the results. Returns false if the application quit early or the results could not be written.
+	bool Run();
+
+	void WriteJson(std::ostream& stream) const;
+
+private:
+	/// Min, max, mean and percentiles of one timing over all measured frames.
+	struct Summary
+	{
+		double minMilliseconds;
+		double avgMilliseconds;
+		double p50Milliseconds;
+		double p95Milliseconds;
+		double p99Milliseconds;
+		double maxMilliseconds;
+	};
+
+	/// Runs warmup and measured frames. runFrame returns false if the application quit.
+	/// If capturingDevice is not null, the measured frames are captured and saved to Settings::capturePath.
+	bool RunFrames(const std::function<bool()>& runFrame, const std::function<const Renderer::FrameTimings&()>& getLastFrameTimings, CapturingDevice* capturingDevice);
+	bool RunReplay();
+	/// Renders with the given configuration, in the Application or headless.
+	bool RunRenderer(const Renderer::Configuration& configuration);
+	bool RunRecordingThreads();
+	/// Returns false if the vectorized generators do not produce the same content as the scalar one.
+	bool RunTextureGeneration();
+	bool RunJobSystem();
+	/// Starts streaming textures if frame is a multiple of Settings::streamTexturesInterval.
+	void StreamTextures(Renderer& renderer, unsigned int frame) const;
+	bool WriteResults() const;
+
+	/// Throughput of one way to generate texture content on the CPU.
+	struct TextureGeneratorResult
+	{
+		const char* name;
+		double gigabytesPerSecond;
+	};
+
+	/// Timings of a Mode::RecordingThreads run.
+	struct RecordingThreadsResult
+	{
+		unsigned int numRecordingThreads;
+		Summary recording;
+		Summary frame;
+		uint64_t numValidationErrors;	///< Of the NullDevice, 0 if not headless.
+	};
+
+	/// ParallelFor over the same work with a given number of workers.
+	struct ParallelForResult
+	{
+		unsigned int numWorkers;
+		double milliseconds;	///< Average per ParallelFor.
+		double speedup;			///< Compared to a single worker.
+		double stealRate;		///< Fraction of the executed jobs that were stolen.
+	};
+
+	static Summary Summarize(std::vector<double> samples);
+	static void WriteSummary(std::ostream& stream, const char* name, const Summary& summary, const char* indentation = "\t\t");
+	/// Sections of the JSON results. All but the configuration are only written in their Mode.
+	void WriteConfiguration(std::ostream& stream) const;
+	void WriteFrameResults(std::ostream& stream) const;
+	void WriteRecordingThreadsResults(std::ostream& stream) const;
+	void WriteTextureGenerationResults(std::ostream& stream) const;
+	void WriteJobSystemResults(std::ostream& stream) const;
+
+	const Settings settings;
+
+	std::vector<double> recordingMilliseconds;
+	std::vector<double> submitMilliseconds;
+	std::vector<double> waitMilliseconds;
+	std::vector<double> frameMilliseconds;
+	Renderer::MemoryStatistics memoryStatistics;
+	double totalSeconds;
+	bool hasNullDeviceStatistics;
+	NullDevice::Statistics nullDeviceStatistics;
+	std::vector<RecordingThreadsResult> recordingThreadsResults;
+	std::vector<TextureGeneratorResult> textureGeneratorResults;
+	uint64_t textureGenerationBytesPerFrame;
+	bool textureGeneratorsMatch;									///< All generators but the old rand() loop produce the same content.
+	double emptyJobsPerSecond;			///< Many jobs scheduled at once, then waited for.
+	double emptyJobStealRate;
+	double scheduleWaitMicroseconds;	///< A single job scheduled and waited for right away.
+	std::vector<ParallelForResult> parallelForResults;
+};
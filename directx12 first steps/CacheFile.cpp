@@ -0,0 +1,125 @@
+#include "CacheFile.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <fstream>
+
+CacheFile::CacheFile(Format _format) :
+	format(_format)
+{
+}
+
+bool CacheFile::Load(const std::string& path)
+{
+	entries.clear();
+
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return false;
+	std::streamoff fileSize = file.tellg();
+	if (fileSize <= 0)
+		return false;
+	std::vector<uint8_t> content(static_cast<size_t>(fileSize));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(content.data()), fileSize))
+		return false;
+
+	return Deserialize(content.data(), content.size());
+}
+
+bool CacheFile::Save(const std::string& path) const
+{
+	std::vector<uint8_t> content = Serialize();
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+	file.write(reinterpret_cast<const char*>(content.data()), content.size());
+	return static_cast<bool>(file);
+}
+
+bool CacheFile::Deserialize(const uint8_t* data, size_t size)
+{
+	entries.clear();
+
+	Header header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != MAGIC || header.version != VERSION || header.format != static_cast<uint32_t>(format))
+		return false;
+	if (header.contentSize != size - sizeof(header))
+		return false;
+
+	const uint8_t* content = data + sizeof(header);
+	if (HashBytes(content, static_cast<size_t>(header.contentSize)) != header.checksum)
+		return false;
+
+	size_t offset = 0;
+	for (uint32_t i = 0; i < header.numEntries; ++i)
+	{
+		EntryHeader entryHeader;
+		if (header.contentSize - offset < sizeof(entryHeader))
+		{
+			entries.clear();
+			return false;
+		}
+		memcpy(&entryHeader, content + offset, sizeof(entryHeader));
+		offset += sizeof(entryHeader);
+
+		if (header.contentSize - offset < entryHeader.size)
+		{
+			entries.clear();
+			return false;
+		}
+		entries[entryHeader.key].assign(content + offset, content + offset + entryHeader.size);
+		offset += static_cast<size_t>(entryHeader.size);
+	}
+
+	return true;
+}
+
+std::vector<uint8_t> CacheFile::Serialize() const
+{
+	size_t contentSize = 0;
+	for (const auto& entry : entries)
+		contentSize += sizeof(EntryHeader) + entry.second.size();
+
+	std::vector<uint8_t> data(sizeof(Header) + contentSize);
+	uint8_t* content = data.data() + sizeof(Header);
+
+	size_t offset = 0;
+	for (const auto& entry : entries)
+	{
+		EntryHeader entryHeader;
+		entryHeader.key = entry.first;
+		entryHeader.size = entry.second.size();
+		memcpy(content + offset, &entryHeader, sizeof(entryHeader));
+		offset += sizeof(entryHeader);
+		if (!entry.second.empty())
+			memcpy(content + offset, entry.second.data(), entry.second.size());
+		offset += entry.second.size();
+	}
+
+	Header header;
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.format = static_cast<uint32_t>(format);
+	header.numEntries = static_cast<uint32_t>(entries.size());
+	header.contentSize = contentSize;
+	header.checksum = HashBytes(content, contentSize);
+	memcpy(data.data(), &header, sizeof(header));
+
+	return data;
+}
+
+const std::vector<uint8_t>* CacheFile::Find(uint64_t key) const
+{
+	auto entry = entries.find(key);
+	return entry != entries.end() ? &entry->second : nullptr;
+}
+
+void CacheFile::Store(uint64_t key, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	entries[key].assign(bytes, bytes + size);
+}
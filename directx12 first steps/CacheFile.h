@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/// Binary container for the on-disk pipeline and shader caches.
+///
+/// Stores blobs by a 64bit key. A header with magic number, version, format and a checksum over the content is used to reject
+/// files that were written by a different version, for a different format, or that are corrupted.
+/// Independent of D3D12 and Windows.
+class CacheFile
+{
+public:
+	/// What kind of blobs the file contains. Files of a different format are rejected on load.
+	enum class Format : uint32_t
+	{
+		PipelineLibrary = 1,	///< A single serialized ID3D12PipelineLibrary.
+		CachedBlobs = 2,		///< One ID3D12PipelineState cached blob per pipeline.
+		ShaderBytecode = 3		///< Compiled shaders.
+	};
+
+	CacheFile(Format format);
+
+	/// Replaces the content with the content of the given file.
+	/// Returns false and leaves the content empty if the file does not exist, is stale or corrupt.
+	bool Load(const std::string& path);
+	bool Save(const std::string& path) const;
+
+	/// Same as Load/Save but in memory.
+	bool Deserialize(const uint8_t* data, size_t size);
+	std::vector<uint8_t> Serialize() const;
+
+	/// Returns nullptr if there is no entry with the given key.
+	const std::vector<uint8_t>* Find(uint64_t key) const;
+	void Store(uint64_t key, const void* data, size_t size);
+	void Clear()			{ entries.clear(); }
+
+	Format GetFormat() const	{ return format; }
+	size_t GetNumEntries() const	{ return entries.size(); }
+
+	static const uint32_t MAGIC = 0x48434244; // "DBCH"
+	static const uint32_t VERSION = 1;
+
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format;
+		uint32_t numEntries;
+		uint64_t contentSize;	///< Size of everything after the header.
+		uint64_t checksum;		///< Hash of everything after the header.
+	};
+	struct EntryHeader
+	{
+		uint64_t key;
+		uint64_t size;
+	};
+
+	Format format;
+	std::map<uint64_t, std::vector<uint8_t>> entries;
+};
@@ -0,0 +1,363 @@
+#include "CapturingCommandList.h"
+#include "CapturingDevice.h"
+
+typedef CommandStream::Opcode Opcode;
+typedef CommandStream::HandleKind HandleKind;
+
+CapturingCommandList::CapturingCommandList(CapturingDevice& _device, std::unique_ptr<RenderCommandList> _commandList) :
+	device(_device),
+	commandList(std::move(_commandList)),
+	captured(false),
+	writer(commands),
+	lastHandle(INVALID_RENDER_HANDLE),
+	lastHandleIndex(0)
+{
+}
+
+void CapturingCommandList::WriteHandle(RenderHandle handle, HandleKind kind)
+{
+	if (handle == INVALID_RENDER_HANDLE)
+	{
+		writer.WriteUInt(0);
+		return;
+	}
+
+	if (handle != lastHandle)
+	{
+		auto existing = handleIndices.find(handle);
+		if (existing == handleIndices.end())
+		{
+			CommandStream::HandleInfo info;
+			info.kind = kind;
+			info.initialState = ResourceState::Common;
+			info.count = 0;
+			info.rootSignatureHash = 0;
+			info.textureDesc = {};
+			info.bufferSize = 0;
+			existing = handleIndices.insert(std::make_pair(handle, static_cast<uint32_t>(handles.size()))).first;
+			handles.push_back(handle);
+			handleInfos.push_back(info);
+		}
+		lastHandle = handle;
+		lastHandleIndex = existing->second;
+	}
+
+	// Barriers only know that it is a resource, any other use is more specific.
+	CommandStream::HandleInfo& info = handleInfos[lastHandleIndex];
+	if (info.kind == HandleKind::Resource)
+		info.kind = kind;
+	writer.WriteUInt(lastHandleIndex + 1);
+}
+
+void CapturingCommandList::WriteHandle(RenderHandle handle, HandleKind kind, unsigned int usedIndex)
+{
+	WriteHandle(handle, kind);
+	if (handle != INVALID_RENDER_HANDLE && handleInfos[lastHandleIndex].count <= usedIndex)
+		handleInfos[lastHandleIndex].count = usedIndex + 1;
+}
+
+bool CapturingCommandList::Reset(unsigned int frameQueueIndex, RenderHandle pipelineState)
+{
+	captured = device.IsCapturing();
+	if (captured)
+	{
+		commands.clear();
+		handles.clear();
+		handleInfos.clear();
+		handleIndices.clear();
+		lastHandle = INVALID_RENDER_HANDLE;
+
+		writer.WriteOpcode(Opcode::Reset);
+		writer.WriteUInt(frameQueueIndex);
+		WriteHandle(pipelineState, HandleKind::PipelineState);
+	}
+	return commandList->Reset(frameQueueIndex, pipelineState);
+}
+
+bool CapturingCommandList::Close()
+{
+	if (captured)
+		writer.WriteOpcode(Opcode::Close);
+	return commandList->Close();
+}
+
+void CapturingCommandList::SetPipelineState(RenderHandle pipelineState)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetPipelineState);
+		WriteHandle(pipelineState, HandleKind::PipelineState);
+	}
+	commandList->SetPipelineState(pipelineState);
+}
+
+void CapturingCommandList::SetGraphicsRootSignature(RenderHandle rootSignature)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetGraphicsRootSignature);
+		WriteHandle(rootSignature, HandleKind::RootSignature);
+	}
+	commandList->SetGraphicsRootSignature(rootSignature);
+}
+
+void CapturingCommandList::SetViewport(const Viewport& viewport)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetViewport);
+		writer.WriteFloat(viewport.topLeftX);
+		writer.WriteFloat(viewport.topLeftY);
+		writer.WriteFloat(viewport.width);
+		writer.WriteFloat(viewport.height);
+		writer.WriteFloat(viewport.minDepth);
+		writer.WriteFloat(viewport.maxDepth);
+	}
+	commandList->SetViewport(viewport);
+}
+
+void CapturingCommandList::SetScissorRect(const ScissorRect& scissorRect)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetScissorRect);
+		writer.WriteInt(scissorRect.left);
+		writer.WriteInt(scissorRect.top);
+		writer.WriteInt(scissorRect.right);
+		writer.WriteInt(scissorRect.bottom);
+	}
+	commandList->SetScissorRect(scissorRect);
+}
+
+void CapturingCommandList::ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::ResourceBarriers);
+		writer.WriteUInt(numBarriers);
+		for (unsigned int i = 0; i < numBarriers; ++i)
+		{
+			bool firstUse = handleIndices.find(barriers[i].resource) == handleIndices.end();
+			WriteHandle(barriers[i].resource, HandleKind::Resource);
+			// The state before the first barrier is the state replay needs to create the resource in.
+			if (firstUse && barriers[i].resource != INVALID_RENDER_HANDLE)
+				handleInfos[lastHandleIndex].initialState = barriers[i].before;
+			writer.WriteUInt(static_cast<uint64_t>(barriers[i].before));
+			writer.WriteUInt(static_cast<uint64_t>(barriers[i].after));
+		}
+	}
+	commandList->ResourceBarriers(barriers, numBarriers);
+}
+
+void CapturingCommandList::SetRenderTarget(RenderHandle renderTargetView)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetRenderTarget);
+		WriteHandle(renderTargetView, HandleKind::BackbufferRenderTargetView);
+	}
+	commandList->SetRenderTarget(renderTargetView);
+}
+
+void CapturingCommandList::ClearRenderTarget(RenderHandle renderTargetView, const float color[4])
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::ClearRenderTarget);
+		WriteHandle(renderTargetView, HandleKind::BackbufferRenderTargetView);
+		for (int i = 0; i < 4; ++i)
+			writer.WriteFloat(color[i]);
+	}
+	commandList->ClearRenderTarget(renderTargetView, color);
+}
+
+void CapturingCommandList::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetPrimitiveTopology);
+		writer.WriteUInt(static_cast<uint64_t>(topology));
+	}
+	commandList->SetPrimitiveTopology(topology);
+}
+
+void CapturingCommandList::SetVertexBuffer(const VertexBufferView& view)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetVertexBuffer);
+		WriteHandle(view.buffer, HandleKind::Buffer);
+		writer.WriteUInt(view.sizeInBytes);
+		writer.WriteUInt(view.strideInBytes);
+	}
+	commandList->SetVertexBuffer(view);
+}
+
+void CapturingCommandList::SetDescriptorHeap(RenderHandle descriptorHeap)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetDescriptorHeap);
+		WriteHandle(descriptorHeap, HandleKind::DescriptorHeap);
+	}
+	commandList->SetDescriptorHeap(descriptorHeap);
+}
+
+void CapturingCommandList::SetGraphicsRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetGraphicsRootDescriptorTable);
+		writer.WriteUInt(rootParameterIndex);
+		WriteHandle(descriptorHeap, HandleKind::DescriptorHeap, firstDescriptor);
+		writer.WriteUInt(firstDescriptor);
+	}
+	commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, descriptorHeap, firstDescriptor);
+}
+
+void CapturingCommandList::SetGraphicsRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetGraphicsRoot32BitConstant);
+		writer.WriteUInt(rootParameterIndex);
+		writer.WriteUInt(value);
+		writer.WriteUInt(destOffsetIn32BitValues);
+	}
+	commandList->SetGraphicsRoot32BitConstant(rootParameterIndex, value, destOffsetIn32BitValues);
+}
+
+void CapturingCommandList::DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::DrawInstanced);
+		writer.WriteUInt(vertexCountPerInstance);
+		writer.WriteUInt(instanceCount);
+		writer.WriteUInt(startVertexLocation);
+		writer.WriteUInt(startInstanceLocation);
+	}
+	commandList->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+}
+
+void CapturingCommandList::ExecuteIndirect(RenderHandle commandSignature, uint32_t maxCommandCount, RenderHandle argumentBuffer, uint64_t argumentBufferOffset,
+											RenderHandle countBuffer, uint64_t countBufferOffset)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::ExecuteIndirect);
+		WriteHandle(commandSignature, HandleKind::CommandSignature);
+		writer.WriteUInt(maxCommandCount);
+		WriteHandle(argumentBuffer, HandleKind::Buffer);
+		writer.WriteUInt(argumentBufferOffset);
+		WriteHandle(countBuffer, HandleKind::Buffer);
+		writer.WriteUInt(countBufferOffset);
+	}
+	commandList->ExecuteIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset, countBuffer, countBufferOffset);
+}
+
+void CapturingCommandList::SetComputeRootSignature(RenderHandle rootSignature)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetComputeRootSignature);
+		WriteHandle(rootSignature, HandleKind::RootSignature);
+	}
+	commandList->SetComputeRootSignature(rootSignature);
+}
+
+void CapturingCommandList::SetComputeRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetComputeRootDescriptorTable);
+		writer.WriteUInt(rootParameterIndex);
+		WriteHandle(descriptorHeap, HandleKind::DescriptorHeap, firstDescriptor);
+		writer.WriteUInt(firstDescriptor);
+	}
+	commandList->SetComputeRootDescriptorTable(rootParameterIndex, descriptorHeap, firstDescriptor);
+}
+
+void CapturingCommandList::SetComputeRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::SetComputeRoot32BitConstant);
+		writer.WriteUInt(rootParameterIndex);
+		writer.WriteUInt(value);
+		writer.WriteUInt(destOffsetIn32BitValues);
+	}
+	commandList->SetComputeRoot32BitConstant(rootParameterIndex, value, destOffsetIn32BitValues);
+}
+
+void CapturingCommandList::Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::Dispatch);
+		writer.WriteUInt(threadGroupCountX);
+		writer.WriteUInt(threadGroupCountY);
+		writer.WriteUInt(threadGroupCountZ);
+	}
+	commandList->Dispatch(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+}
+
+void CapturingCommandList::CopyBufferRegion(RenderHandle destBuffer, uint64_t destOffset, RenderHandle sourceBuffer, uint64_t sourceOffset, uint64_t numBytes)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::CopyBufferRegion);
+		WriteHandle(destBuffer, HandleKind::Buffer);
+		writer.WriteUInt(destOffset);
+		WriteHandle(sourceBuffer, HandleKind::UploadBuffer);
+		writer.WriteUInt(sourceOffset);
+		writer.WriteUInt(numBytes);
+	}
+	commandList->CopyBufferRegion(destBuffer, destOffset, sourceBuffer, sourceOffset, numBytes);
+}
+
+void CapturingCommandList::CopyBufferToTexture(RenderHandle destTexture, unsigned int destSubresource, RenderHandle sourceBuffer, const TextureFootprint& sourceFootprint)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::CopyBufferToTexture);
+		WriteHandle(destTexture, HandleKind::Texture);
+		writer.WriteUInt(destSubresource);
+		WriteHandle(sourceBuffer, HandleKind::UploadBuffer);
+		writer.WriteUInt(sourceFootprint.offset);
+		writer.WriteUInt(static_cast<uint64_t>(sourceFootprint.format));
+		writer.WriteUInt(sourceFootprint.width);
+		writer.WriteUInt(sourceFootprint.height);
+		writer.WriteUInt(sourceFootprint.rowPitch);
+		writer.WriteUInt(sourceFootprint.numRows);
+		writer.WriteUInt(sourceFootprint.rowSizeInBytes);
+		writer.WriteUInt(sourceFootprint.totalSize);
+	}
+	commandList->CopyBufferToTexture(destTexture, destSubresource, sourceBuffer, sourceFootprint);
+}
+
+void CapturingCommandList::WriteTimestamp(RenderHandle queryHeap, unsigned int queryIndex)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::WriteTimestamp);
+		WriteHandle(queryHeap, HandleKind::QueryHeap, queryIndex);
+		writer.WriteUInt(queryIndex);
+	}
+	commandList->WriteTimestamp(queryHeap, queryIndex);
+}
+
+void CapturingCommandList::ResolveTimestamps(RenderHandle queryHeap, unsigned int firstQuery, unsigned int numQueries, RenderHandle destBuffer, uint64_t destOffset)
+{
+	if (captured)
+	{
+		writer.WriteOpcode(Opcode::ResolveTimestamps);
+		WriteHandle(queryHeap, HandleKind::QueryHeap, numQueries > 0 ? firstQuery + numQueries - 1 : firstQuery);
+		writer.WriteUInt(firstQuery);
+		writer.WriteUInt(numQueries);
+		// Readback buffers are sized in queries as well, so that replay can create them.
+		WriteHandle(destBuffer, HandleKind::ReadbackBuffer, static_cast<unsigned int>((destOffset + numQueries * sizeof(uint64_t) + sizeof(uint64_t) - 1) / sizeof(uint64_t)) - 1);
+		writer.WriteUInt(destOffset);
+	}
+	commandList->ResolveTimestamps(queryHeap, firstQuery, numQueries, destBuffer, destOffset);
+}
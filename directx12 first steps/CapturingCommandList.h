@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "RenderCommandList.h"
+#include "CommandStream.h"
+
+class CapturingDevice;
+
+/// Forwards all calls to a command list of the wrapped device and encodes them for a CommandStream while the device is capturing.
+///
+/// Whether a recording is captured is decided on Reset, so lists that were reset before the capture started are not part of it.
+/// Handles are collected in a list-local table that the CapturingDevice maps to stream slots on execution.
+/// Independent of D3D12 and Windows.
+class CapturingCommandList : public RenderCommandList
+{
+public:
+	CapturingCommandList(CapturingDevice& device, std::unique_ptr<RenderCommandList> commandList);
+
+	bool Reset(unsigned int frameQueueIndex, RenderHandle pipelineState) override;
+	bool Close() override;
+
+	void SetPipelineState(RenderHandle pipelineState) override;
+	void SetGraphicsRootSignature(RenderHandle rootSignature) override;
+	void SetViewport(const Viewport& viewport) override;
+	void SetScissorRect(const ScissorRect& scissorRect) override;
+	void ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers) override;
+	void SetRenderTarget(RenderHandle renderTargetView) override;
+	void ClearRenderTarget(RenderHandle renderTargetView, const float color[4]) override;
+
+	void SetPrimitiveTopology(PrimitiveTopology topology) override;
+	void SetVertexBuffer(const VertexBufferView& view) override;
+	void SetDescriptorHeap(RenderHandle descriptorHeap) override;
+	void SetGraphicsRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) override;
+	void SetGraphicsRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) override;
+
+	void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
+	void ExecuteIndirect(RenderHandle commandSignature, uint32_t maxCommandCount, RenderHandle argumentBuffer, uint64_t argumentBufferOffset,
+						RenderHandle countBuffer, uint64_t countBufferOffset) override;
+
+	void SetComputeRootSignature(RenderHandle rootSignature) override;
+	void SetComputeRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) override;
+	void SetComputeRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) override;
+	void Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) override;
+
+	void CopyBufferRegion(RenderHandle destBuffer, uint64_t destOffset, RenderHandle sourceBuffer, uint64_t sourceOffset, uint64_t numBytes) override;
+	void CopyBufferToTexture(RenderHandle destTexture, unsigned int destSubresource, RenderHandle sourceBuffer, const TextureFootprint& sourceFootprint) override;
+
+	void WriteTimestamp(RenderHandle queryHeap, unsigned int queryIndex) override;
+	void ResolveTimestamps(RenderHandle queryHeap, unsigned int firstQuery, unsigned int numQueries, RenderHandle destBuffer, uint64_t destOffset) override;
+
+
+	RenderCommandList& GetWrappedCommandList()								{ return *commandList; }
+
+	/// True if the last recording happened while the device was capturing.
+	bool IsCaptured() const													{ return captured; }
+	const std::vector<uint8_t>& GetCommands() const						{ return commands; }
+	/// Handles of the wrapped device by local index, with their usage.
+	const std::vector<RenderHandle>& GetHandles() const					{ return handles; }
+	const std::vector<CommandStream::HandleInfo>& GetHandleInfos() const	{ return handleInfos; }
+
+private:
+	/// Writes the local index + 1 of the handle, 0 for INVALID_RENDER_HANDLE.
+	void WriteHandle(RenderHandle handle, CommandStream::HandleKind kind);
+	/// Records the number of used descriptors or queries of a heap.
+	void WriteHandle(RenderHandle handle, CommandStream::HandleKind kind, unsigned int usedIndex);
+
+	CapturingDevice& device;
+	std::unique_ptr<RenderCommandList> commandList;
+
+	bool captured;
+	std::vector<uint8_t> commands;
+	CommandStreamWriter writer;
+	std::vector<RenderHandle> handles;
+	std::vector<CommandStream::HandleInfo> handleInfos;
+	std::unordered_map<RenderHandle, uint32_t> handleIndices;
+	RenderHandle lastHandle;	///< Most lookups are for the same handle as the previous one, e.g. the descriptor heap of every draw.
+	uint32_t lastHandleIndex;
+};
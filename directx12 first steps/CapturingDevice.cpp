@@ -0,0 +1,348 @@
+#include "CapturingDevice.h"
+#include "CapturingCommandList.h"
+
+CapturingDevice::CapturingDevice(RenderDevice& _device) :
+	device(_device),
+	capturing(false)
+{
+}
+
+void CapturingDevice::StartCapture()
+{
+	commandStream.Clear();
+	slots.clear();
+	pendingViews.clear();
+	copyFenceValues.clear();
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		pendingUploads.clear();
+		pendingCopyUploads.clear();
+	}
+	capturing.store(true, std::memory_order_relaxed);
+}
+
+void CapturingDevice::StopCapture()
+{
+	capturing.store(false, std::memory_order_relaxed);
+}
+
+std::unique_ptr<RenderCommandList> CapturingDevice::CreateCommandList()
+{
+	std::unique_ptr<RenderCommandList> commandList = device.CreateCommandList();
+	if (!commandList)
+		return nullptr;
+	return std::unique_ptr<RenderCommandList>(new CapturingCommandList(*this, std::move(commandList)));
+}
+
+std::unique_ptr<RenderCommandList> CapturingDevice::CreateCopyCommandList()
+{
+	std::unique_ptr<RenderCommandList> commandList = device.CreateCopyCommandList();
+	if (!commandList)
+		return nullptr;
+	return std::unique_ptr<RenderCommandList>(new CapturingCommandList(*this, std::move(commandList)));
+}
+
+bool CapturingDevice::AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	if (!device.AllocateUploadMemory(size, alignment, outAllocation))
+		return false;
+	if (IsCapturing())
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		pendingUploads.push_back({ outAllocation, size, alignment });
+	}
+	return true;
+}
+
+bool CapturingDevice::AllocateCopyUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	if (!device.AllocateCopyUploadMemory(size, alignment, outAllocation))
+		return false;
+	if (IsCapturing())
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		pendingCopyUploads.push_back({ outAllocation, size, alignment });
+	}
+	return true;
+}
+
+RenderHandle CapturingDevice::CreateBuffer(uint64_t size, ResourceState initialState)
+{
+	RenderHandle buffer = device.CreateBuffer(size, initialState);
+	if (buffer != INVALID_RENDER_HANDLE)
+		objectInfos[buffer].bufferSize = size;
+	return buffer;
+}
+
+RenderHandle CapturingDevice::CreateTexture(const TextureDesc& desc, ResourceState initialState)
+{
+	RenderHandle texture = device.CreateTexture(desc, initialState);
+	if (texture != INVALID_RENDER_HANDLE)
+		objectInfos[texture].textureDesc = desc;
+	return texture;
+}
+
+RenderHandle CapturingDevice::CreateIndirectDrawSignature(RenderHandle rootSignature, unsigned int drawIDRootParameterIndex)
+{
+	RenderHandle commandSignature = device.CreateIndirectDrawSignature(rootSignature, drawIDRootParameterIndex);
+	if (commandSignature != INVALID_RENDER_HANDLE)
+		commandSignatureRootSignatures[commandSignature] = rootSignature;
+	return commandSignature;
+}
+
+void CapturingDevice::CreateTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc)
+{
+	device.CreateTextureView(descriptorHeap, descriptorIndex, texture, desc);
+	RememberTextureView(descriptorHeap, descriptorIndex, texture, desc, false);
+}
+
+void CapturingDevice::CreateTextureUnorderedAccessView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc)
+{
+	device.CreateTextureUnorderedAccessView(descriptorHeap, descriptorIndex, texture, desc);
+	RememberTextureView(descriptorHeap, descriptorIndex, texture, desc, true);
+}
+
+void CapturingDevice::RememberTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc, bool unorderedAccess)
+{
+	DescriptorView view = { texture, desc, unorderedAccess };
+	descriptorViews[descriptorHeap][descriptorIndex] = view;
+	// Heaps without a slot get all their views once they are used.
+	if (IsCapturing() && slots.count(descriptorHeap) > 0)
+		pendingViews.push_back({ descriptorHeap, descriptorIndex, view });
+}
+
+void CapturingDevice::AddTextureView(uint32_t descriptorHeapSlot, unsigned int descriptorIndex, const DescriptorView& view)
+{
+	CommandStream::HandleInfo textureInfo = {};
+	textureInfo.kind = CommandStream::HandleKind::Texture;
+	textureInfo.initialState = ResourceState::Common;
+
+	CommandStream::TextureView streamView;
+	streamView.descriptorHeapSlot = descriptorHeapSlot;
+	streamView.descriptorIndex = descriptorIndex;
+	streamView.textureSlot = GetSlot(view.texture, textureInfo);
+	streamView.desc = view.desc;
+	commandStream.AddTextureView(streamView, view.unorderedAccess);
+
+	// Replay needs a heap that holds the view, even if no list uses the descriptor.
+	CommandStream::HandleInfo& heapInfo = commandStream.GetHandle(descriptorHeapSlot);
+	if (heapInfo.count <= descriptorIndex)
+		heapInfo.count = descriptorIndex + 1;
+}
+
+RenderHandle CapturingDevice::GetCurrentBackbuffer()
+{
+	RenderHandle backbuffer = device.GetCurrentBackbuffer();
+	std::lock_guard<std::mutex> lock(backbufferMutex);
+	backbuffers.insert(backbuffer);
+	return backbuffer;
+}
+
+RenderHandle CapturingDevice::GetCurrentBackbufferRenderTargetView()
+{
+	RenderHandle renderTargetView = device.GetCurrentBackbufferRenderTargetView();
+	std::lock_guard<std::mutex> lock(backbufferMutex);
+	backbufferRenderTargetViews.insert(renderTargetView);
+	return renderTargetView;
+}
+
+uint32_t CapturingDevice::GetSlot(RenderHandle handle, const CommandStream::HandleInfo& info)
+{
+	auto existing = slots.find(handle);
+	if (existing != slots.end())
+	{
+		CommandStream::HandleInfo& slotInfo = commandStream.GetHandle(existing->second);
+		if (slotInfo.kind == CommandStream::HandleKind::Resource)
+			slotInfo.kind = info.kind;
+		if (slotInfo.count < info.count)
+			slotInfo.count = info.count;
+		if (slotInfo.initialState == ResourceState::Common)
+			slotInfo.initialState = info.initialState;
+		return existing->second;
+	}
+
+	// All back buffers are replayed as the current back buffer, so they share a slot with the first one that was seen.
+	CommandStream::HandleInfo slotInfo = info;
+	bool isBackbuffer;
+	bool isBackbufferRenderTargetView;
+	{
+		std::lock_guard<std::mutex> lock(backbufferMutex);
+		isBackbuffer = backbuffers.count(handle) > 0;
+		isBackbufferRenderTargetView = backbufferRenderTargetViews.count(handle) > 0;
+	}
+	if (isBackbuffer || isBackbufferRenderTargetView)
+	{
+		slotInfo.kind = isBackbuffer ? CommandStream::HandleKind::Backbuffer : CommandStream::HandleKind::BackbufferRenderTargetView;
+		for (const auto& slot : slots)
+		{
+			if (commandStream.GetHandle(slot.second).kind == slotInfo.kind)
+			{
+				slots[handle] = slot.second;
+				return slot.second;
+			}
+		}
+	}
+
+	auto objectInfo = objectInfos.find(handle);
+	if (objectInfo != objectInfos.end())
+	{
+		slotInfo.pipelineStateName = objectInfo->second.pipelineStateName;
+		slotInfo.rootSignatureHash = objectInfo->second.rootSignatureHash;
+		slotInfo.textureDesc = objectInfo->second.textureDesc;
+		slotInfo.bufferSize = objectInfo->second.bufferSize;
+		// Resources that are only seen in barriers are known to be textures or buffers nevertheless.
+		if (slotInfo.kind == CommandStream::HandleKind::Resource && slotInfo.textureDesc.width > 0)
+			slotInfo.kind = CommandStream::HandleKind::Texture;
+		else if (slotInfo.kind == CommandStream::HandleKind::Resource && slotInfo.bufferSize > 0)
+			slotInfo.kind = CommandStream::HandleKind::Buffer;
+	}
+	// The root signature's hash may have been set after the command signature was created.
+	auto commandSignatureRootSignature = commandSignatureRootSignatures.find(handle);
+	if (commandSignatureRootSignature != commandSignatureRootSignatures.end())
+	{
+		auto rootSignatureInfo = objectInfos.find(commandSignatureRootSignature->second);
+		if (rootSignatureInfo != objectInfos.end())
+			slotInfo.rootSignatureHash = rootSignatureInfo->second.rootSignatureHash;
+	}
+
+	uint32_t slot = commandStream.AddHandle(slotInfo);
+	slots[handle] = slot;
+
+	if (slotInfo.kind == CommandStream::HandleKind::DescriptorHeap)
+	{
+		auto views = descriptorViews.find(handle);
+		if (views != descriptorViews.end())
+		{
+			for (const auto& view : views->second)
+				AddTextureView(slot, view.first, view.second);
+		}
+	}
+	return slot;
+}
+
+void CapturingDevice::UnwrapCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists)
+{
+	wrappedCommandLists.resize(numCommandLists);
+	for (unsigned int i = 0; i < numCommandLists; ++i)
+		wrappedCommandLists[i] = &static_cast<CapturingCommandList*>(commandLists[i])->GetWrappedCommandList();
+}
+
+void CapturingDevice::AddPendingUploadsAndViews(std::vector<PendingUpload>& uploads, bool copyQueue)
+{
+	CommandStream::HandleInfo uploadBufferInfo = {};
+	uploadBufferInfo.kind = CommandStream::HandleKind::UploadBuffer;
+	uploadBufferInfo.initialState = ResourceState::Common;
+
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		for (const PendingUpload& upload : uploads)
+		{
+			CommandStream::UploadData uploadData;
+			uploadData.slot = GetSlot(upload.allocation.buffer, uploadBufferInfo);
+			uploadData.copyQueue = copyQueue;
+			uploadData.offset = upload.allocation.offset;
+			uploadData.alignment = upload.alignment;
+			uploadData.data = upload.allocation.cpuAddress;
+			uploadData.size = static_cast<size_t>(upload.size);
+			commandStream.AddUploadData(uploadData);
+		}
+		uploads.clear();
+	}
+
+	// Views of heaps that got their slot meanwhile have been added with the heap.
+	for (const PendingView& pendingView : pendingViews)
+	{
+		auto slot = slots.find(pendingView.descriptorHeap);
+		if (slot != slots.end())
+			AddTextureView(slot->second, pendingView.descriptorIndex, pendingView.view);
+	}
+	pendingViews.clear();
+}
+
+uint32_t CapturingDevice::AddCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists, bool copyQueue)
+{
+	AddPendingUploadsAndViews(copyQueue ? pendingCopyUploads : pendingUploads, copyQueue);
+
+	// Lists that were recorded before the capture started are not part of it.
+	uint32_t numCapturedLists = 0;
+	for (unsigned int i = 0; i < numCommandLists; ++i)
+	{
+		const CapturingCommandList* commandList = static_cast<const CapturingCommandList*>(commandLists[i]);
+		if (!commandList->IsCaptured())
+			continue;
+
+		const std::vector<RenderHandle>& handles = commandList->GetHandles();
+		listSlots.resize(handles.size());
+		for (size_t handle = 0; handle < handles.size(); ++handle)
+			listSlots[handle] = GetSlot(handles[handle], commandList->GetHandleInfos()[handle]);
+		if (copyQueue)
+			commandStream.AddCopyCommandList(listSlots.data(), static_cast<uint32_t>(listSlots.size()), commandList->GetCommands().data(), commandList->GetCommands().size());
+		else
+			commandStream.AddCommandList(listSlots.data(), static_cast<uint32_t>(listSlots.size()), commandList->GetCommands().data(), commandList->GetCommands().size());
+		++numCapturedLists;
+	}
+	return numCapturedLists;
+}
+
+void CapturingDevice::ExecuteCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists)
+{
+	UnwrapCommandLists(commandLists, numCommandLists);
+	device.ExecuteCommandLists(wrappedCommandLists.data(), numCommandLists);
+
+	if (!IsCapturing())
+		return;
+	uint32_t numCapturedLists = AddCommandLists(commandLists, numCommandLists, false);
+	if (numCapturedLists > 0)
+		commandStream.AddExecute(numCapturedLists);
+}
+
+uint64_t CapturingDevice::ExecuteCopyCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists)
+{
+	UnwrapCommandLists(commandLists, numCommandLists);
+	uint64_t copyFenceValue = device.ExecuteCopyCommandLists(wrappedCommandLists.data(), numCommandLists);
+
+	if (!IsCapturing())
+		return copyFenceValue;
+	uint32_t numCapturedLists = AddCommandLists(commandLists, numCommandLists, true);
+	if (numCapturedLists > 0)
+	{
+		uint32_t copySubmission = commandStream.AddExecuteCopy(numCapturedLists);
+		copyFenceValues.resize(copySubmission + 1);
+		copyFenceValues[copySubmission] = copyFenceValue;
+	}
+	return copyFenceValue;
+}
+
+void CapturingDevice::QueueWaitForCopy(uint64_t copyFenceValue)
+{
+	device.QueueWaitForCopy(copyFenceValue);
+	if (!IsCapturing())
+		return;
+
+	// The latest captured submission that the wait covers, the fence values grow with every submission.
+	for (size_t copySubmission = copyFenceValues.size(); copySubmission > 0; --copySubmission)
+	{
+		if (copyFenceValues[copySubmission - 1] <= copyFenceValue)
+		{
+			commandStream.AddQueueWaitForCopy(static_cast<uint32_t>(copySubmission - 1));
+			return;
+		}
+	}
+}
+
+void CapturingDevice::Present()
+{
+	device.Present();
+	if (IsCapturing())
+		commandStream.AddPresent();
+}
+
+void CapturingDevice::ReleaseObject(RenderHandle handle)
+{
+	device.ReleaseObject(handle);
+	// The wrapped device may hand out the same handle for a new object, which must not end up in the old slot.
+	slots.erase(handle);
+	objectInfos.erase(handle);
+	commandSignatureRootSignatures.erase(handle);
+	descriptorViews.erase(handle);
+}
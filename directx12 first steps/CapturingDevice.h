@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "CommandStream.h"
+
+/// RenderDevice that forwards to another device and captures the executed command lists and presents into a CommandStream.
+///
+/// Start and stop capturing between frames. While not capturing, the only overhead is one extra virtual call per command.
+/// Direct and copy lists are captured, along with what they read from the CPU side: Upload memory is snapshotted when the next list of its queue
+/// is submitted, so it needs to be written by then. Texture views are recorded when their descriptor heap is first used in a captured list, and
+/// again whenever they are recreated during the capture.
+/// Independent of D3D12 and Windows.
+class CapturingDevice : public RenderDevice
+{
+public:
+	CapturingDevice(RenderDevice& device);
+
+	/// Clears the stream and captures everything recorded from now on.
+	void StartCapture();
+	void StopCapture();
+	bool IsCapturing() const												{ return capturing.load(std::memory_order_relaxed); }
+	/// Stream of the last or current capture. Only valid to read while not capturing.
+	const CommandStream& GetCommandStream() const							{ return commandStream; }
+
+	/// Pipeline states and root signatures are not created via RenderDevice, so their creator tells what they were made of.
+	/// Recorded in the slots of the stream, see CommandStream::HandleInfo. Call it before the object is used in a captured frame.
+	void SetPipelineStateName(RenderHandle pipelineState, const std::string& name)	{ objectInfos[pipelineState].pipelineStateName = name; }
+	void SetRootSignatureHash(RenderHandle rootSignature, uint64_t hash)				{ objectInfos[rootSignature].rootSignatureHash = hash; }
+
+
+	void BeginFrame() override												{ device.BeginFrame(); }
+	void Present() override;
+	unsigned int GetNumFramesInFlight() override							{ return device.GetNumFramesInFlight(); }
+	void WaitForFreeInflightFrame() override								{ device.WaitForFreeInflightFrame(); }
+	void WaitForIdleGPU() override											{ device.WaitForIdleGPU(); }
+
+	void SetMaxFramesInFlight(unsigned int numFrames) override				{ device.SetMaxFramesInFlight(numFrames); }
+	unsigned int GetMaxFramesInFlight() const override						{ return device.GetMaxFramesInFlight(); }
+	void SetFramePacingMode(FramePacingMode mode) override					{ device.SetFramePacingMode(mode); }
+	FramePacingMode GetFramePacingMode() const override						{ return device.GetFramePacingMode(); }
+
+	uint64_t GetLastSignaledFenceValue() const override						{ return device.GetLastSignaledFenceValue(); }
+	uint64_t GetCompletedFenceValue() const override						{ return device.GetCompletedFenceValue(); }
+
+	/// Returns a CapturingCommandList.
+	std::unique_ptr<RenderCommandList> CreateCommandList() override;
+	/// Only accepts lists created by this device.
+	void ExecuteCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists) override;
+
+	/// Returns a CapturingCommandList.
+	std::unique_ptr<RenderCommandList> CreateCopyCommandList() override;
+	/// Only accepts lists created by this device.
+	uint64_t ExecuteCopyCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists) override;
+	/// Waits for copy submissions that were made before the capture started are not recorded, replay has nothing to wait for.
+	void QueueWaitForCopy(uint64_t copyFenceValue) override;
+	void WaitForCopy(uint64_t copyFenceValue) override					{ device.WaitForCopy(copyFenceValue); }
+	uint64_t GetCompletedCopyFenceValue() const override					{ return device.GetCompletedCopyFenceValue(); }
+
+	unsigned int GetBackbufferWidth() const override						{ return device.GetBackbufferWidth(); }
+	unsigned int GetBackbufferHeight() const override						{ return device.GetBackbufferHeight(); }
+	RenderHandle GetCurrentBackbuffer() override;
+	RenderHandle GetCurrentBackbufferRenderTargetView() override;
+
+	/// Remembers the allocation, its content is captured on the next ExecuteCommandLists.
+	bool AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation) override;
+	uint64_t GetUploadRingUsedSize() const override							{ return device.GetUploadRingUsedSize(); }
+	/// Remembers the allocation, its content is captured on the next ExecuteCopyCommandLists.
+	bool AllocateCopyUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation) override;
+
+	/// Remembers the size for the buffer's slot.
+	RenderHandle CreateBuffer(uint64_t size, ResourceState initialState) override;
+	RenderHandle CreateReadbackBuffer(uint64_t size) override											{ return device.CreateReadbackBuffer(size); }
+	const void* MapReadbackBuffer(RenderHandle buffer, uint64_t readBegin, uint64_t readEnd) override	{ return device.MapReadbackBuffer(buffer, readBegin, readEnd); }
+	void UnmapReadbackBuffer(RenderHandle buffer) override												{ device.UnmapReadbackBuffer(buffer); }
+
+	/// Remembers the desc for the texture's slot.
+	RenderHandle CreateTexture(const TextureDesc& desc, ResourceState initialState) override;
+	void GetTextureFootprint(const TextureDesc& desc, TextureFootprint& outFootprint) override			{ device.GetTextureFootprint(desc, outFootprint); }
+	uint64_t GetTextureMemoryCommitted() const override					{ return device.GetTextureMemoryCommitted(); }
+	uint64_t GetTextureMemoryUsed() const override						{ return device.GetTextureMemoryUsed(); }
+
+	RenderHandle CreateDescriptorHeap(unsigned int numDescriptors) override	{ return device.CreateDescriptorHeap(numDescriptors); }
+	/// Views are remembered per descriptor, see the class description.
+	void CreateTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc) override;
+	void CreateTextureUnorderedAccessView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc) override;
+
+	/// Remembers the root signature, its hash goes into the command signature's slot.
+	RenderHandle CreateIndirectDrawSignature(RenderHandle rootSignature, unsigned int drawIDRootParameterIndex) override;
+
+	RenderHandle CreateTimestampQueryHeap(unsigned int numQueries) override	{ return device.CreateTimestampQueryHeap(numQueries); }
+	uint64_t GetTimestampFrequency() override								{ return device.GetTimestampFrequency(); }
+
+	/// The handle may be reused by a new object, which then gets a new slot.
+	void ReleaseObject(RenderHandle handle) override;
+	const DeferredReleaseQueue::Statistics& GetDeferredReleaseStatistics() const override	{ return device.GetDeferredReleaseStatistics(); }
+
+private:
+	struct PendingUpload
+	{
+		UploadAllocation allocation;
+		uint64_t size;
+		uint64_t alignment;
+	};
+
+	struct DescriptorView
+	{
+		RenderHandle texture;
+		TextureDesc desc;
+		bool unorderedAccess;
+	};
+
+	struct PendingView
+	{
+		RenderHandle descriptorHeap;
+		unsigned int descriptorIndex;
+		DescriptorView view;
+	};
+
+	/// Returns the stream slot of a handle of the wrapped device, adding or refining it with the usage seen by a command list.
+	/// Adding a descriptor heap adds the texture views it contains.
+	uint32_t GetSlot(RenderHandle handle, const CommandStream::HandleInfo& info);
+	void AddTextureView(uint32_t descriptorHeapSlot, unsigned int descriptorIndex, const DescriptorView& view);
+	void RememberTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc, bool unorderedAccess);
+	/// Adds the contents of the pending uploads of the queue and the pending views, which the lists that are about to be added may read.
+	void AddPendingUploadsAndViews(std::vector<PendingUpload>& uploads, bool copyQueue);
+	/// Adds a block for every list that was captured, returns their number.
+	uint32_t AddCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists, bool copyQueue);
+	/// Unwraps the lists into wrappedCommandLists.
+	void UnwrapCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists);
+
+	RenderDevice& device;
+
+	std::atomic<bool> capturing;
+	CommandStream commandStream;
+	std::unordered_map<RenderHandle, uint32_t> slots;
+	/// What objects were created from, copied into their slot when it is added. Only the fields beyond kind, initialState and count are used.
+	std::unordered_map<RenderHandle, CommandStream::HandleInfo> objectInfos;
+	std::unordered_map<RenderHandle, RenderHandle> commandSignatureRootSignatures;
+	/// Current view of every descriptor, by descriptor heap and index.
+	std::unordered_map<RenderHandle, std::unordered_map<unsigned int, DescriptorView>> descriptorViews;
+	/// Views created during the capture in heaps that already have a slot.
+	std::vector<PendingView> pendingViews;
+
+	/// Upload allocations made during the capture whose content is not captured yet. Guarded by uploadMutex, since worker threads allocate as well.
+	std::mutex uploadMutex;
+	std::vector<PendingUpload> pendingUploads;
+	std::vector<PendingUpload> pendingCopyUploads;
+	/// Copy fence value of every captured copy submission, by submission index.
+	std::vector<uint64_t> copyFenceValues;
+
+	/// Back buffers are collected as the renderer asks for them. Guarded by backbufferMutex, since worker threads ask as well.
+	std::mutex backbufferMutex;
+	std::unordered_set<RenderHandle> backbuffers;
+	std::unordered_set<RenderHandle> backbufferRenderTargetViews;
+
+	std::vector<RenderCommandList*> wrappedCommandLists;	///< Scratch space for ExecuteCommandLists.
+	std::vector<uint32_t> listSlots;						///< Scratch space for ExecuteCommandLists.
+};
@@ -0,0 +1,916 @@
+#include "CommandStream.h"
+#include "RenderCommandList.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const char* GetName(ResourceState state)
+	{
+		switch (state)
+		{
+		case ResourceState::Common:
+			return "Common";
+		case ResourceState::Present:
+			return "Present";
+		case ResourceState::RenderTarget:
+			return "RenderTarget";
+		case ResourceState::CopyDest:
+			return "CopyDest";
+		case ResourceState::PixelShaderResource:
+			return "PixelShaderResource";
+		case ResourceState::VertexAndConstantBuffer:
+			return "VertexAndConstantBuffer";
+		case ResourceState::IndirectArgument:
+			return "IndirectArgument";
+		case ResourceState::UnorderedAccess:
+			return "UnorderedAccess";
+		}
+		return "Unknown";
+	}
+
+	void WriteTextureDesc(CommandStreamWriter& writer, const TextureDesc& desc)
+	{
+		writer.WriteUInt(desc.width);
+		writer.WriteUInt(desc.height);
+		writer.WriteUInt(desc.arraySize);
+		writer.WriteUInt(static_cast<uint64_t>(desc.format));
+		writer.WriteUInt(desc.allowUnorderedAccess ? 1 : 0);
+	}
+
+	void ReadTextureDesc(CommandStreamReader& reader, TextureDesc& outDesc)
+	{
+		outDesc.width = static_cast<uint32_t>(reader.ReadUInt());
+		outDesc.height = static_cast<uint32_t>(reader.ReadUInt());
+		outDesc.arraySize = static_cast<uint32_t>(reader.ReadUInt());
+		if (reader.ReadUInt() > static_cast<uint64_t>(TextureFormat::R8G8B8A8_UNORM))
+			reader.SetError();
+		outDesc.format = TextureFormat::R8G8B8A8_UNORM;
+		outDesc.allowUnorderedAccess = reader.ReadUInt() != 0;
+	}
+
+	/// Prints every call as a line of text. Handles are expected to be slot + 1.
+	class DisassemblingCommandList : public RenderCommandList
+	{
+	public:
+		DisassemblingCommandList(std::ostream& _stream) : stream(_stream) {}
+
+		bool Reset(unsigned int frameQueueIndex, RenderHandle pipelineState) override
+		{
+			stream << "\tReset frame " << frameQueueIndex << " pso " << Handle(pipelineState) << "\n";
+			return true;
+		}
+		bool Close() override
+		{
+			stream << "\tClose\n";
+			return true;
+		}
+
+		void SetPipelineState(RenderHandle pipelineState) override
+		{
+			stream << "\tSetPipelineState " << Handle(pipelineState) << "\n";
+		}
+		void SetGraphicsRootSignature(RenderHandle rootSignature) override
+		{
+			stream << "\tSetGraphicsRootSignature " << Handle(rootSignature) << "\n";
+		}
+		void SetViewport(const Viewport& viewport) override
+		{
+			stream << "\tSetViewport " << viewport.topLeftX << " " << viewport.topLeftY << " " << viewport.width << " " << viewport.height << " " <<
+				viewport.minDepth << " " << viewport.maxDepth << "\n";
+		}
+		void SetScissorRect(const ScissorRect& scissorRect) override
+		{
+			stream << "\tSetScissorRect " << scissorRect.left << " " << scissorRect.top << " " << scissorRect.right << " " << scissorRect.bottom << "\n";
+		}
+		void ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers) override
+		{
+			stream << "\tResourceBarriers " << numBarriers << "\n";
+			for (unsigned int i = 0; i < numBarriers; ++i)
+				stream << "\t\t" << Handle(barriers[i].resource) << " " << GetName(barriers[i].before) << " -> " << GetName(barriers[i].after) << "\n";
+		}
+		void SetRenderTarget(RenderHandle renderTargetView) override
+		{
+			stream << "\tSetRenderTarget " << Handle(renderTargetView) << "\n";
+		}
+		void ClearRenderTarget(RenderHandle renderTargetView, const float color[4]) override
+		{
+			stream << "\tClearRenderTarget " << Handle(renderTargetView) << " " << color[0] << " " << color[1] << " " << color[2] << " " << color[3] << "\n";
+		}
+
+		void SetPrimitiveTopology(PrimitiveTopology topology) override
+		{
+			stream << "\tSetPrimitiveTopology " << (topology == PrimitiveTopology::TriangleList ? "TriangleList" : "TriangleStrip") << "\n";
+		}
+		void SetVertexBuffer(const VertexBufferView& view) override
+		{
+			stream << "\tSetVertexBuffer " << Handle(view.buffer) << " size " << view.sizeInBytes << " stride " << view.strideInBytes << "\n";
+		}
+		void SetDescriptorHeap(RenderHandle descriptorHeap) override
+		{
+			stream << "\tSetDescriptorHeap " << Handle(descriptorHeap) << "\n";
+		}
+		void SetGraphicsRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) override
+		{
+			stream << "\tSetGraphicsRootDescriptorTable " << rootParameterIndex << " " << Handle(descriptorHeap) << " " << firstDescriptor << "\n";
+		}
+		void SetGraphicsRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) override
+		{
+			stream << "\tSetGraphicsRoot32BitConstant " << rootParameterIndex << " " << value << " " << destOffsetIn32BitValues << "\n";
+		}
+
+		void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override
+		{
+			stream << "\tDrawInstanced " << vertexCountPerInstance << " " << instanceCount << " " << startVertexLocation << " " << startInstanceLocation << "\n";
+		}
+		void ExecuteIndirect(RenderHandle commandSignature, uint32_t maxCommandCount, RenderHandle argumentBuffer, uint64_t argumentBufferOffset,
+							RenderHandle countBuffer, uint64_t countBufferOffset) override
+		{
+			stream << "\tExecuteIndirect " << Handle(commandSignature) << " max " << maxCommandCount << " arguments " << Handle(argumentBuffer) << "+" << argumentBufferOffset <<
+				" count " << Handle(countBuffer) << "+" << countBufferOffset << "\n";
+		}
+
+		void SetComputeRootSignature(RenderHandle rootSignature) override
+		{
+			stream << "\tSetComputeRootSignature " << Handle(rootSignature) << "\n";
+		}
+		void SetComputeRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) override
+		{
+			stream << "\tSetComputeRootDescriptorTable " << rootParameterIndex << " " << Handle(descriptorHeap) << " " << firstDescriptor << "\n";
+		}
+		void SetComputeRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) override
+		{
+			stream << "\tSetComputeRoot32BitConstant " << rootParameterIndex << " " << value << " " << destOffsetIn32BitValues << "\n";
+		}
+		void Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) override
+		{
+			stream << "\tDispatch " << threadGroupCountX << " " << threadGroupCountY << " " << threadGroupCountZ << "\n";
+		}
+
+		void CopyBufferRegion(RenderHandle destBuffer, uint64_t destOffset, RenderHandle sourceBuffer, uint64_t sourceOffset, uint64_t numBytes) override
+		{
+			stream << "\tCopyBufferRegion " << Handle(destBuffer) << "+" << destOffset << " <- " << Handle(sourceBuffer) << "+" << sourceOffset << " " << numBytes << " bytes\n";
+		}
+		void CopyBufferToTexture(RenderHandle destTexture, unsigned int destSubresource, RenderHandle sourceBuffer, const TextureFootprint& sourceFootprint) override
+		{
+			stream << "\tCopyBufferToTexture " << Handle(destTexture) << "[" << destSubresource << "] <- " << Handle(sourceBuffer) << "+" << sourceFootprint.offset << " " <<
+				sourceFootprint.width << "x" << sourceFootprint.height << " pitch " << sourceFootprint.rowPitch << "\n";
+		}
+
+		void WriteTimestamp(RenderHandle queryHeap, unsigned int queryIndex) override
+		{
+			stream << "\tWriteTimestamp " << Handle(queryHeap) << "[" << queryIndex << "]\n";
+		}
+		void ResolveTimestamps(RenderHandle queryHeap, unsigned int firstQuery, unsigned int numQueries, RenderHandle destBuffer, uint64_t destOffset) override
+		{
+			stream << "\tResolveTimestamps " << Handle(queryHeap) << "[" << firstQuery << ", " << firstQuery + numQueries << ") -> " << Handle(destBuffer) << "+" << destOffset << "\n";
+		}
+
+	private:
+		static std::string Handle(RenderHandle handle)
+		{
+			return handle == INVALID_RENDER_HANDLE ? "null" : "#" + std::to_string(handle - 1);
+		}
+
+		std::ostream& stream;
+	};
+}
+
+void CommandStreamWriter::WriteFloat(float value)
+{
+	uint8_t bytes[sizeof(float)];
+	memcpy(bytes, &value, sizeof(float));
+	data.insert(data.end(), bytes, bytes + sizeof(float));
+}
+
+uint8_t CommandStreamReader::ReadByte()
+{
+	if (position >= size)
+	{
+		error = true;
+		return 0;
+	}
+	return data[position++];
+}
+
+uint64_t CommandStreamReader::ReadUInt()
+{
+	uint64_t value = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7)
+	{
+		uint8_t byte = ReadByte();
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return value;
+	}
+	error = true;
+	return 0;
+}
+
+float CommandStreamReader::ReadFloat()
+{
+	const uint8_t* bytes = ReadBytes(sizeof(float));
+	float value = 0.0f;
+	if (bytes)
+		memcpy(&value, bytes, sizeof(float));
+	return value;
+}
+
+const uint8_t* CommandStreamReader::ReadBytes(size_t numBytes)
+{
+	if (size - position < numBytes || position > size)
+	{
+		error = true;
+		return nullptr;
+	}
+	const uint8_t* bytes = data + position;
+	position += numBytes;
+	return bytes;
+}
+
+CommandStream::CommandStream() :
+	numFrames(0),
+	numCopySubmissions(0)
+{
+}
+
+void CommandStream::Clear()
+{
+	handles.clear();
+	data.clear();
+	numFrames = 0;
+	numCopySubmissions = 0;
+}
+
+uint32_t CommandStream::AddHandle(const HandleInfo& info)
+{
+	handles.push_back(info);
+	return static_cast<uint32_t>(handles.size() - 1);
+}
+
+void CommandStream::AddCommandList(const uint32_t* slots, uint32_t numSlots, const uint8_t* commands, size_t size)
+{
+	AddCommandListBlock(Opcode::CommandList, slots, numSlots, commands, size);
+}
+
+void CommandStream::AddCopyCommandList(const uint32_t* slots, uint32_t numSlots, const uint8_t* commands, size_t size)
+{
+	AddCommandListBlock(Opcode::CopyCommandList, slots, numSlots, commands, size);
+}
+
+void CommandStream::AddCommandListBlock(Opcode opcode, const uint32_t* slots, uint32_t numSlots, const uint8_t* commands, size_t size)
+{
+	CommandStreamWriter writer(data);
+	writer.WriteOpcode(opcode);
+	writer.WriteUInt(numSlots);
+	for (uint32_t i = 0; i < numSlots; ++i)
+		writer.WriteUInt(slots[i]);
+	writer.WriteUInt(size);
+	data.insert(data.end(), commands, commands + size);
+}
+
+void CommandStream::AddExecute(uint32_t numCommandLists)
+{
+	CommandStreamWriter writer(data);
+	writer.WriteOpcode(Opcode::Execute);
+	writer.WriteUInt(numCommandLists);
+}
+
+uint32_t CommandStream::AddExecuteCopy(uint32_t numCommandLists)
+{
+	CommandStreamWriter writer(data);
+	writer.WriteOpcode(Opcode::ExecuteCopy);
+	writer.WriteUInt(numCommandLists);
+	return numCopySubmissions++;
+}
+
+void CommandStream::AddQueueWaitForCopy(uint32_t copySubmission)
+{
+	CommandStreamWriter writer(data);
+	writer.WriteOpcode(Opcode::QueueWaitForCopy);
+	writer.WriteUInt(copySubmission);
+}
+
+void CommandStream::AddPresent()
+{
+	CommandStreamWriter writer(data);
+	writer.WriteOpcode(Opcode::Present);
+	++numFrames;
+}
+
+void CommandStream::AddUploadData(const UploadData& uploadData)
+{
+	CommandStreamWriter writer(data);
+	writer.WriteOpcode(Opcode::UploadData);
+	writer.WriteUInt(uploadData.slot);
+	writer.WriteUInt(uploadData.copyQueue ? 1 : 0);
+	writer.WriteUInt(uploadData.offset);
+	writer.WriteUInt(uploadData.alignment);
+	writer.WriteUInt(uploadData.size);
+	writer.WriteBytes(uploadData.data, uploadData.size);
+}
+
+void CommandStream::AddTextureView(const TextureView& view, bool unorderedAccess)
+{
+	CommandStreamWriter writer(data);
+	writer.WriteOpcode(unorderedAccess ? Opcode::TextureUnorderedAccessView : Opcode::TextureView);
+	writer.WriteUInt(view.descriptorHeapSlot);
+	writer.WriteUInt(view.descriptorIndex);
+	writer.WriteUInt(view.textureSlot);
+	WriteTextureDesc(writer, view.desc);
+}
+
+bool CommandStream::Load(const std::string& path)
+{
+	Clear();
+
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return false;
+	std::streamoff fileSize = file.tellg();
+	if (fileSize <= 0)
+		return false;
+	std::vector<uint8_t> content(static_cast<size_t>(fileSize));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(content.data()), fileSize))
+		return false;
+
+	return Deserialize(content.data(), content.size());
+}
+
+bool CommandStream::Save(const std::string& path) const
+{
+	std::vector<uint8_t> content = Serialize();
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+	file.write(reinterpret_cast<const char*>(content.data()), content.size());
+	return static_cast<bool>(file);
+}
+
+std::vector<uint8_t> CommandStream::Serialize() const
+{
+	// The handle table is a varint stream as well, followed by the command data.
+	std::vector<uint8_t> content;
+	CommandStreamWriter writer(content);
+	for (const HandleInfo& handle : handles)
+	{
+		writer.WriteUInt(static_cast<uint64_t>(handle.kind));
+		writer.WriteUInt(static_cast<uint64_t>(handle.initialState));
+		writer.WriteUInt(handle.count);
+		// Only what the kind can have.
+		if (handle.kind == HandleKind::PipelineState)
+		{
+			writer.WriteUInt(handle.pipelineStateName.size());
+			writer.WriteBytes(handle.pipelineStateName.data(), handle.pipelineStateName.size());
+		}
+		else if (handle.kind == HandleKind::RootSignature || handle.kind == HandleKind::CommandSignature)
+			writer.WriteUInt(handle.rootSignatureHash);
+		else if (handle.kind == HandleKind::Texture)
+			WriteTextureDesc(writer, handle.textureDesc);
+		else if (handle.kind == HandleKind::Buffer || handle.kind == HandleKind::Resource)
+			writer.WriteUInt(handle.bufferSize);
+	}
+	content.insert(content.end(), data.begin(), data.end());
+
+	Header header;
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.numHandles = static_cast<uint32_t>(handles.size());
+	header.numFrames = numFrames;
+	header.contentSize = content.size();
+	header.checksum = HashBytes(content.data(), content.size());
+
+	std::vector<uint8_t> serialized(sizeof(header) + content.size());
+	memcpy(serialized.data(), &header, sizeof(header));
+	if (!content.empty())
+		memcpy(serialized.data() + sizeof(header), content.data(), content.size());
+	return serialized;
+}
+
+bool CommandStream::Deserialize(const uint8_t* serialized, size_t size)
+{
+	Clear();
+
+	Header header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, serialized, sizeof(header));
+	if (header.magic != MAGIC || header.version != VERSION)
+		return false;
+	if (header.contentSize != size - sizeof(header))
+		return false;
+
+	const uint8_t* content = serialized + sizeof(header);
+	if (HashBytes(content, static_cast<size_t>(header.contentSize)) != header.checksum)
+		return false;
+
+	CommandStreamReader reader(content, static_cast<size_t>(header.contentSize));
+	handles.resize(header.numHandles);
+	for (HandleInfo& handle : handles)
+	{
+		uint64_t kind = reader.ReadUInt();
+		uint64_t initialState = reader.ReadUInt();
+		handle.count = static_cast<uint32_t>(reader.ReadUInt());
+		if (kind > static_cast<uint64_t>(HandleKind::QueryHeap) || initialState > static_cast<uint64_t>(ResourceState::UnorderedAccess) || reader.HasError())
+		{
+			Clear();
+			return false;
+		}
+		handle.kind = static_cast<HandleKind>(kind);
+		handle.initialState = static_cast<ResourceState>(initialState);
+		handle.rootSignatureHash = 0;
+		handle.textureDesc = {};
+		handle.bufferSize = 0;
+
+		if (handle.kind == HandleKind::PipelineState)
+		{
+			uint64_t nameLength = reader.ReadUInt();
+			const uint8_t* name = nameLength <= header.contentSize ? reader.ReadBytes(static_cast<size_t>(nameLength)) : nullptr;
+			if (name)
+				handle.pipelineStateName.assign(reinterpret_cast<const char*>(name), static_cast<size_t>(nameLength));
+			else
+				reader.SetError();
+		}
+		else if (handle.kind == HandleKind::RootSignature || handle.kind == HandleKind::CommandSignature)
+			handle.rootSignatureHash = reader.ReadUInt();
+		else if (handle.kind == HandleKind::Texture)
+			ReadTextureDesc(reader, handle.textureDesc);
+		else if (handle.kind == HandleKind::Buffer || handle.kind == HandleKind::Resource)
+			handle.bufferSize = reader.ReadUInt();
+		if (reader.HasError())
+		{
+			Clear();
+			return false;
+		}
+	}
+
+	data.assign(content + reader.GetPosition(), content + header.contentSize);
+	numFrames = header.numFrames;
+	return true;
+}
+
+bool CommandStream::DecodeCommandList(const uint8_t* commands, size_t size, const RenderHandle* handles, uint32_t numHandles, RenderCommandList& target,
+										BufferMapper* bufferMapper)
+{
+	CommandStreamReader reader(commands, size);
+	// Local index 0 is the invalid handle.
+	auto readHandleIndex = [&reader, numHandles]() -> uint64_t {
+		uint64_t index = reader.ReadUInt();
+		if (index > numHandles)
+		{
+			reader.SetError();
+			return 0;
+		}
+		return index;
+	};
+	auto readHandle = [&readHandleIndex, handles]() -> RenderHandle {
+		uint64_t index = readHandleIndex();
+		return index == 0 ? INVALID_RENDER_HANDLE : handles[index - 1];
+	};
+	// Buffers are always followed by their offset.
+	auto readBuffer = [&reader, &readHandleIndex, handles, bufferMapper](RenderHandle& outBuffer, uint64_t& outOffset) {
+		uint64_t index = readHandleIndex();
+		outBuffer = index == 0 ? INVALID_RENDER_HANDLE : handles[index - 1];
+		outOffset = reader.ReadUInt();
+		if (bufferMapper && index != 0 && !reader.HasError())
+			bufferMapper->MapBuffer(static_cast<uint32_t>(index - 1), outBuffer, outOffset);
+	};
+	auto readUInt32 = [&reader]() { return static_cast<uint32_t>(reader.ReadUInt()); };
+
+	std::vector<ResourceBarrier> barriers;
+	while (!reader.IsAtEnd() && !reader.HasError())
+	{
+		switch (reader.ReadOpcode())
+		{
+		case Opcode::Reset:
+		{
+			unsigned int frameQueueIndex = readUInt32();
+			RenderHandle pipelineState = readHandle();
+			if (!reader.HasError())
+				target.Reset(frameQueueIndex, pipelineState);
+			break;
+		}
+		case Opcode::Close:
+			target.Close();
+			break;
+
+		case Opcode::SetPipelineState:
+		{
+			RenderHandle pipelineState = readHandle();
+			if (!reader.HasError())
+				target.SetPipelineState(pipelineState);
+			break;
+		}
+		case Opcode::SetGraphicsRootSignature:
+		{
+			RenderHandle rootSignature = readHandle();
+			if (!reader.HasError())
+				target.SetGraphicsRootSignature(rootSignature);
+			break;
+		}
+		case Opcode::SetViewport:
+		{
+			Viewport viewport;
+			viewport.topLeftX = reader.ReadFloat();
+			viewport.topLeftY = reader.ReadFloat();
+			viewport.width = reader.ReadFloat();
+			viewport.height = reader.ReadFloat();
+			viewport.minDepth = reader.ReadFloat();
+			viewport.maxDepth = reader.ReadFloat();
+			if (!reader.HasError())
+				target.SetViewport(viewport);
+			break;
+		}
+		case Opcode::SetScissorRect:
+		{
+			ScissorRect scissorRect;
+			scissorRect.left = static_cast<int32_t>(reader.ReadInt());
+			scissorRect.top = static_cast<int32_t>(reader.ReadInt());
+			scissorRect.right = static_cast<int32_t>(reader.ReadInt());
+			scissorRect.bottom = static_cast<int32_t>(reader.ReadInt());
+			if (!reader.HasError())
+				target.SetScissorRect(scissorRect);
+			break;
+		}
+		case Opcode::ResourceBarriers:
+		{
+			uint32_t numBarriers = readUInt32();
+			barriers.clear();
+			for (uint32_t i = 0; i < numBarriers && !reader.HasError(); ++i)
+			{
+				ResourceBarrier barrier;
+				barrier.resource = readHandle();
+				uint64_t before = reader.ReadUInt();
+				uint64_t after = reader.ReadUInt();
+				if (before > static_cast<uint64_t>(ResourceState::UnorderedAccess) || after > static_cast<uint64_t>(ResourceState::UnorderedAccess))
+					return false;
+				barrier.before = static_cast<ResourceState>(before);
+				barrier.after = static_cast<ResourceState>(after);
+				barriers.push_back(barrier);
+			}
+			if (!reader.HasError())
+				target.ResourceBarriers(barriers.data(), numBarriers);
+			break;
+		}
+		case Opcode::SetRenderTarget:
+		{
+			RenderHandle renderTargetView = readHandle();
+			if (!reader.HasError())
+				target.SetRenderTarget(renderTargetView);
+			break;
+		}
+		case Opcode::ClearRenderTarget:
+		{
+			RenderHandle renderTargetView = readHandle();
+			float color[4];
+			for (float& component : color)
+				component = reader.ReadFloat();
+			if (!reader.HasError())
+				target.ClearRenderTarget(renderTargetView, color);
+			break;
+		}
+
+		case Opcode::SetPrimitiveTopology:
+		{
+			uint64_t topology = reader.ReadUInt();
+			if (topology > static_cast<uint64_t>(PrimitiveTopology::TriangleStrip))
+				return false;
+			if (!reader.HasError())
+				target.SetPrimitiveTopology(static_cast<PrimitiveTopology>(topology));
+			break;
+		}
+		case Opcode::SetVertexBuffer:
+		{
+			VertexBufferView view;
+			view.buffer = readHandle();
+			view.sizeInBytes = readUInt32();
+			view.strideInBytes = readUInt32();
+			if (!reader.HasError())
+				target.SetVertexBuffer(view);
+			break;
+		}
+		case Opcode::SetDescriptorHeap:
+		{
+			RenderHandle descriptorHeap = readHandle();
+			if (!reader.HasError())
+				target.SetDescriptorHeap(descriptorHeap);
+			break;
+		}
+		case Opcode::SetGraphicsRootDescriptorTable:
+		{
+			unsigned int rootParameterIndex = readUInt32();
+			RenderHandle descriptorHeap = readHandle();
+			unsigned int firstDescriptor = readUInt32();
+			if (!reader.HasError())
+				target.SetGraphicsRootDescriptorTable(rootParameterIndex, descriptorHeap, firstDescriptor);
+			break;
+		}
+		case Opcode::SetGraphicsRoot32BitConstant:
+		{
+			unsigned int rootParameterIndex = readUInt32();
+			uint32_t value = readUInt32();
+			unsigned int destOffsetIn32BitValues = readUInt32();
+			if (!reader.HasError())
+				target.SetGraphicsRoot32BitConstant(rootParameterIndex, value, destOffsetIn32BitValues);
+			break;
+		}
+
+		case Opcode::DrawInstanced:
+		{
+			uint32_t vertexCountPerInstance = readUInt32();
+			uint32_t instanceCount = readUInt32();
+			uint32_t startVertexLocation = readUInt32();
+			uint32_t startInstanceLocation = readUInt32();
+			if (!reader.HasError())
+				target.DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+			break;
+		}
+		case Opcode::ExecuteIndirect:
+		{
+			RenderHandle commandSignature = readHandle();
+			uint32_t maxCommandCount = readUInt32();
+			RenderHandle argumentBuffer;
+			uint64_t argumentBufferOffset;
+			readBuffer(argumentBuffer, argumentBufferOffset);
+			RenderHandle countBuffer;
+			uint64_t countBufferOffset;
+			readBuffer(countBuffer, countBufferOffset);
+			if (!reader.HasError())
+				target.ExecuteIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset, countBuffer, countBufferOffset);
+			break;
+		}
+
+		case Opcode::SetComputeRootSignature:
+		{
+			RenderHandle rootSignature = readHandle();
+			if (!reader.HasError())
+				target.SetComputeRootSignature(rootSignature);
+			break;
+		}
+		case Opcode::SetComputeRootDescriptorTable:
+		{
+			unsigned int rootParameterIndex = readUInt32();
+			RenderHandle descriptorHeap = readHandle();
+			unsigned int firstDescriptor = readUInt32();
+			if (!reader.HasError())
+				target.SetComputeRootDescriptorTable(rootParameterIndex, descriptorHeap, firstDescriptor);
+			break;
+		}
+		case Opcode::SetComputeRoot32BitConstant:
+		{
+			unsigned int rootParameterIndex = readUInt32();
+			uint32_t value = readUInt32();
+			unsigned int destOffsetIn32BitValues = readUInt32();
+			if (!reader.HasError())
+				target.SetComputeRoot32BitConstant(rootParameterIndex, value, destOffsetIn32BitValues);
+			break;
+		}
+		case Opcode::Dispatch:
+		{
+			uint32_t threadGroupCountX = readUInt32();
+			uint32_t threadGroupCountY = readUInt32();
+			uint32_t threadGroupCountZ = readUInt32();
+			if (!reader.HasError())
+				target.Dispatch(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+			break;
+		}
+
+		case Opcode::CopyBufferRegion:
+		{
+			RenderHandle destBuffer;
+			uint64_t destOffset;
+			readBuffer(destBuffer, destOffset);
+			RenderHandle sourceBuffer;
+			uint64_t sourceOffset;
+			readBuffer(sourceBuffer, sourceOffset);
+			uint64_t numBytes = reader.ReadUInt();
+			if (!reader.HasError())
+				target.CopyBufferRegion(destBuffer, destOffset, sourceBuffer, sourceOffset, numBytes);
+			break;
+		}
+		case Opcode::CopyBufferToTexture:
+		{
+			RenderHandle destTexture = readHandle();
+			unsigned int destSubresource = readUInt32();
+			RenderHandle sourceBuffer;
+			TextureFootprint footprint;
+			readBuffer(sourceBuffer, footprint.offset);
+			uint64_t format = reader.ReadUInt();
+			if (format > static_cast<uint64_t>(TextureFormat::R8G8B8A8_UNORM))
+				return false;
+			footprint.format = static_cast<TextureFormat>(format);
+			footprint.width = readUInt32();
+			footprint.height = readUInt32();
+			footprint.rowPitch = readUInt32();
+			footprint.numRows = readUInt32();
+			footprint.rowSizeInBytes = reader.ReadUInt();
+			footprint.totalSize = reader.ReadUInt();
+			if (!reader.HasError())
+				target.CopyBufferToTexture(destTexture, destSubresource, sourceBuffer, footprint);
+			break;
+		}
+
+		case Opcode::WriteTimestamp:
+		{
+			RenderHandle queryHeap = readHandle();
+			unsigned int queryIndex = readUInt32();
+			if (!reader.HasError())
+				target.WriteTimestamp(queryHeap, queryIndex);
+			break;
+		}
+		case Opcode::ResolveTimestamps:
+		{
+			RenderHandle queryHeap = readHandle();
+			unsigned int firstQuery = readUInt32();
+			unsigned int numQueries = readUInt32();
+			RenderHandle destBuffer;
+			uint64_t destOffset;
+			readBuffer(destBuffer, destOffset);
+			if (!reader.HasError())
+				target.ResolveTimestamps(queryHeap, firstQuery, numQueries, destBuffer, destOffset);
+			break;
+		}
+
+		default:
+			// Top level opcodes can not appear within a command list.
+			return false;
+		}
+	}
+	return !reader.HasError();
+}
+
+bool CommandStream::ReadCommandList(CommandStreamReader& reader, uint32_t numSlots, std::vector<uint32_t>& outSlots, const uint8_t*& outCommands, size_t& outSize)
+{
+	uint64_t numLocalHandles = reader.ReadUInt();
+	if (numLocalHandles > numSlots)
+		return false;
+	outSlots.resize(static_cast<size_t>(numLocalHandles));
+	for (uint32_t& slot : outSlots)
+	{
+		uint64_t value = reader.ReadUInt();
+		if (value >= numSlots)
+			return false;
+		slot = static_cast<uint32_t>(value);
+	}
+	uint64_t size = reader.ReadUInt();
+	outCommands = reader.ReadBytes(static_cast<size_t>(size));
+	outSize = static_cast<size_t>(size);
+	return outCommands != nullptr && !reader.HasError();
+}
+
+bool CommandStream::ReadUploadData(CommandStreamReader& reader, uint32_t numSlots, UploadData& outUploadData)
+{
+	uint64_t slot = reader.ReadUInt();
+	outUploadData.slot = static_cast<uint32_t>(slot);
+	outUploadData.copyQueue = reader.ReadUInt() != 0;
+	outUploadData.offset = reader.ReadUInt();
+	outUploadData.alignment = reader.ReadUInt();
+	uint64_t size = reader.ReadUInt();
+	outUploadData.size = static_cast<size_t>(size);
+	outUploadData.data = size == outUploadData.size ? reader.ReadBytes(outUploadData.size) : nullptr;
+	// Alignments need to be powers of two.
+	bool validAlignment = outUploadData.alignment != 0 && (outUploadData.alignment & (outUploadData.alignment - 1)) == 0;
+	return slot < numSlots && validAlignment && outUploadData.data != nullptr && !reader.HasError();
+}
+
+bool CommandStream::ReadTextureView(CommandStreamReader& reader, uint32_t numSlots, TextureView& outView)
+{
+	uint64_t descriptorHeapSlot = reader.ReadUInt();
+	outView.descriptorIndex = static_cast<uint32_t>(reader.ReadUInt());
+	uint64_t textureSlot = reader.ReadUInt();
+	ReadTextureDesc(reader, outView.desc);
+	outView.descriptorHeapSlot = static_cast<uint32_t>(descriptorHeapSlot);
+	outView.textureSlot = static_cast<uint32_t>(textureSlot);
+	return descriptorHeapSlot < numSlots && textureSlot < numSlots && !reader.HasError();
+}
+
+bool CommandStream::Disassemble(std::ostream& stream) const
+{
+	stream << "Command stream version " << VERSION << ", " << numFrames << " frames, " << handles.size() << " handles\n";
+	for (size_t slot = 0; slot < handles.size(); ++slot)
+	{
+		const HandleInfo& handle = handles[slot];
+		stream << "#" << slot << " " << GetName(handle.kind);
+		if (handle.count > 0)
+			stream << " count " << handle.count;
+		stream << " initial " << ::GetName(handle.initialState);
+		if (handle.kind == HandleKind::PipelineState && !handle.pipelineStateName.empty())
+			stream << " shaders " << handle.pipelineStateName;
+		else if ((handle.kind == HandleKind::RootSignature || handle.kind == HandleKind::CommandSignature) && handle.rootSignatureHash != 0)
+			stream << " rootsignature " << std::hex << handle.rootSignatureHash << std::dec;
+		else if (handle.kind == HandleKind::Texture && handle.textureDesc.width > 0)
+		{
+			stream << " " << handle.textureDesc.width << "x" << handle.textureDesc.height << "x" << handle.textureDesc.arraySize;
+			if (handle.textureDesc.allowUnorderedAccess)
+				stream << " uav";
+		}
+		else if (handle.kind == HandleKind::Buffer && handle.bufferSize > 0)
+			stream << " size " << handle.bufferSize;
+		stream << "\n";
+	}
+
+	DisassemblingCommandList disassembler(stream);
+	std::vector<RenderHandle> localHandles;
+	CommandStreamReader reader(data.data(), data.size());
+	uint32_t frame = 0;
+	stream << "Frame 0\n";
+	while (!reader.IsAtEnd() && !reader.HasError())
+	{
+		Opcode opcode = reader.ReadOpcode();
+		switch (opcode)
+		{
+		case Opcode::CommandList:
+		case Opcode::CopyCommandList:
+		{
+			bool copyList = opcode == Opcode::CopyCommandList;
+			std::vector<uint32_t> slots;
+			const uint8_t* commands;
+			size_t size;
+			if (!ReadCommandList(reader, static_cast<uint32_t>(handles.size()), slots, commands, size))
+				return false;
+
+			// Local indices are disassembled as slots.
+			localHandles.resize(slots.size());
+			for (size_t i = 0; i < slots.size(); ++i)
+				localHandles[i] = slots[i] + 1;
+			stream << (copyList ? "CopyCommandList\n" : "CommandList\n");
+			if (!DecodeCommandList(commands, size, localHandles.data(), static_cast<uint32_t>(localHandles.size()), disassembler))
+				return false;
+			break;
+		}
+		case Opcode::Execute:
+			stream << "Execute " << reader.ReadUInt() << "\n";
+			break;
+		case Opcode::ExecuteCopy:
+			stream << "ExecuteCopy " << reader.ReadUInt() << "\n";
+			break;
+		case Opcode::QueueWaitForCopy:
+			stream << "QueueWaitForCopy " << reader.ReadUInt() << "\n";
+			break;
+		case Opcode::UploadData:
+		{
+			UploadData uploadData;
+			if (!ReadUploadData(reader, static_cast<uint32_t>(handles.size()), uploadData))
+				return false;
+			stream << "UploadData #" << uploadData.slot << "+" << uploadData.offset << " " << uploadData.size << " bytes";
+			if (uploadData.copyQueue)
+				stream << " copy";
+			stream << "\n";
+			break;
+		}
+		case Opcode::TextureView:
+		case Opcode::TextureUnorderedAccessView:
+		{
+			TextureView view;
+			if (!ReadTextureView(reader, static_cast<uint32_t>(handles.size()), view))
+				return false;
+			stream << (opcode == Opcode::TextureView ? "TextureView" : "TextureUnorderedAccessView") << " #" << view.descriptorHeapSlot << "[" << view.descriptorIndex << "] <- #" << view.textureSlot << " "
+				<< view.desc.width << "x" << view.desc.height << "x" << view.desc.arraySize << "\n";
+			break;
+		}
+		case Opcode::Present:
+			stream << "Present\n";
+			if (++frame < numFrames)
+				stream << "Frame " << frame << "\n";
+			break;
+		default:
+			return false;
+		}
+	}
+	return !reader.HasError();
+}
+
+const char* CommandStream::GetName(HandleKind kind)
+{
+	switch (kind)
+	{
+	case HandleKind::Resource:
+		return "Resource";
+	case HandleKind::Buffer:
+		return "Buffer";
+	case HandleKind::UploadBuffer:
+		return "UploadBuffer";
+	case HandleKind::ReadbackBuffer:
+		return "ReadbackBuffer";
+	case HandleKind::Texture:
+		return "Texture";
+	case HandleKind::Backbuffer:
+		return "Backbuffer";
+	case HandleKind::BackbufferRenderTargetView:
+		return "BackbufferRenderTargetView";
+	case HandleKind::PipelineState:
+		return "PipelineState";
+	case HandleKind::RootSignature:
+		return "RootSignature";
+	case HandleKind::DescriptorHeap:
+		return "DescriptorHeap";
+	case HandleKind::CommandSignature:
+		return "CommandSignature";
+	case HandleKind::QueryHeap:
+		return "QueryHeap";
+	}
+	return "Unknown";
+}
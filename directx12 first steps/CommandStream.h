@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "RenderTypes.h"
+
+class RenderCommandList;
+class CommandStreamReader;
+
+/// Compact binary recording of frames: the commands of all executed direct and copy command lists in submission order, plus presents.
+///
+/// Every command is an opcode byte followed by its arguments as LEB128 varints (floats as raw 4 bytes), so typical commands take 2-5 bytes.
+/// Handles are only meaningful in the process that captured them, so they are not stored directly. Instead every distinct object gets a
+/// slot with a description of how it was used, and the replaying side maps slots to objects of its own device (see CommandStreamPlayer).
+/// Slots also record what their object was created from, as far as the capturing side knows it (see CapturingDevice), so that disassemblies
+/// of two captures show shader, root signature and texture changes and replay can create objects of the same size.
+/// Everything the submitted commands read that was written by the CPU is part of the stream as well: upload memory contents and the texture
+/// views in descriptor heaps. What the GPU wrote into resources before the capture started is not, replay starts with the replaying device's content.
+/// All back buffers share one slot per kind, since replay always renders to the replaying device's current back buffer.
+///
+/// Top level layout of the data: CommandList and CopyCommandList blocks, each followed eventually by an Execute or ExecuteCopy that submits the
+/// preceding blocks, Presents, and the device calls the following submissions depend on: UploadData, TextureView, TextureUnorderedAccessView
+/// and QueueWaitForCopy. A command list block starts with the list's local handle table (slot indices), its commands refer to handles by local index + 1.
+///
+/// Independent of D3D12 and Windows.
+class CommandStream
+{
+public:
+	enum class Opcode : uint8_t
+	{
+		// RenderCommandList commands, in the order of the interface.
+		Reset,
+		Close,
+		SetPipelineState,
+		SetGraphicsRootSignature,
+		SetViewport,
+		SetScissorRect,
+		ResourceBarriers,
+		SetRenderTarget,
+		ClearRenderTarget,
+		SetPrimitiveTopology,
+		SetVertexBuffer,
+		SetDescriptorHeap,
+		SetGraphicsRootDescriptorTable,
+		SetGraphicsRoot32BitConstant,
+		DrawInstanced,
+		ExecuteIndirect,
+		SetComputeRootSignature,
+		SetComputeRootDescriptorTable,
+		SetComputeRoot32BitConstant,
+		Dispatch,
+		CopyBufferRegion,
+		CopyBufferToTexture,
+		WriteTimestamp,
+		ResolveTimestamps,
+
+		// Top level.
+		CommandList,				///< Local handle table and size of the commands that follow.
+		Execute,					///< Number of preceding command lists that are executed together.
+		Present,
+		CopyCommandList,			///< Same as CommandList, for the copy queue.
+		ExecuteCopy,				///< Number of preceding copy command lists that are executed together.
+		QueueWaitForCopy,			///< The direct queue waits for the copy submission with this index, counted from the start of the stream.
+		UploadData,					///< Content of upload memory, see UploadData.
+		TextureView,				///< See TextureView.
+		TextureUnorderedAccessView	///< See TextureView.
+	};
+
+	/// What a slot was used as. Determines what the replaying side needs to create for it.
+	enum class HandleKind : uint8_t
+	{
+		Resource,					///< Only seen in barriers, buffer or texture.
+		Buffer,
+		UploadBuffer,				///< Upload memory, see RenderDevice::AllocateUploadMemory.
+		ReadbackBuffer,
+		Texture,
+		Backbuffer,
+		BackbufferRenderTargetView,
+		PipelineState,
+		RootSignature,
+		DescriptorHeap,
+		CommandSignature,
+		QueryHeap
+	};
+
+	struct HandleInfo
+	{
+		HandleKind kind;
+		ResourceState initialState;	///< Before-state of the first barrier on this resource.
+		uint32_t count;				///< Descriptors or queries that are used, size in uint64_t for readback buffers, 0 for other kinds.
+		std::string pipelineStateName;	///< PipelineState: names of its shader variants, empty if unknown.
+		uint64_t rootSignatureHash;		///< RootSignature, and the root signature a CommandSignature was created for: hash of the serialized root signature, 0 if unknown.
+		TextureDesc textureDesc;		///< Texture: the desc it was created with, all zero if unknown.
+		uint64_t bufferSize;			///< Buffer: the size it was created with, 0 if unknown.
+	};
+
+	/// CPU written content of upload memory, snapshotted when the lists that use it were submitted.
+	struct UploadData
+	{
+		uint32_t slot;			///< Upload buffer.
+		bool copyQueue;			///< Allocated with RenderDevice::AllocateCopyUploadMemory instead of AllocateUploadMemory.
+		uint64_t offset;		///< Offset of the allocation within the upload buffer.
+		uint64_t alignment;		///< Alignment the allocation was made with.
+		const uint8_t* data;
+		size_t size;
+	};
+
+	/// A call to RenderDevice::CreateTextureView or CreateTextureUnorderedAccessView.
+	struct TextureView
+	{
+		uint32_t descriptorHeapSlot;
+		uint32_t descriptorIndex;
+		uint32_t textureSlot;
+		TextureDesc desc;
+	};
+
+	/// Lets the replaying side move the buffer ranges commands refer to, see DecodeCommandList.
+	class BufferMapper
+	{
+	public:
+		virtual ~BufferMapper() {}
+
+		/// Called for every buffer argument that comes with an offset. localHandle indexes the handles passed to DecodeCommandList.
+		virtual void MapBuffer(uint32_t localHandle, RenderHandle& buffer, uint64_t& offset) = 0;
+	};
+
+	static const uint32_t MAGIC = 0x53444D43; // "CMDS"
+	static const uint32_t VERSION = 4;
+
+	CommandStream();
+
+	/// Replaces the content with the content of the given file.
+	/// Returns false and leaves the stream empty if the file does not exist, was written by a different version or is corrupt.
+	bool Load(const std::string& path);
+	bool Save(const std::string& path) const;
+
+	/// Same as Load/Save but in memory.
+	bool Deserialize(const uint8_t* data, size_t size);
+	std::vector<uint8_t> Serialize() const;
+
+	void Clear();
+
+	/// Returns the new slot.
+	uint32_t AddHandle(const HandleInfo& info);
+	HandleInfo& GetHandle(uint32_t slot)							{ return handles[slot]; }
+	const std::vector<HandleInfo>& GetHandles() const				{ return handles; }
+
+	/// Appends a command list block. slots maps the list's local handle indices to slots of this stream.
+	void AddCommandList(const uint32_t* slots, uint32_t numSlots, const uint8_t* commands, size_t size);
+	void AddCopyCommandList(const uint32_t* slots, uint32_t numSlots, const uint8_t* commands, size_t size);
+	void AddExecute(uint32_t numCommandLists);
+	/// Returns the index of the copy submission.
+	uint32_t AddExecuteCopy(uint32_t numCommandLists);
+	void AddQueueWaitForCopy(uint32_t copySubmission);
+	void AddPresent();
+	void AddUploadData(const UploadData& uploadData);
+	void AddTextureView(const TextureView& view, bool unorderedAccess);
+
+	const std::vector<uint8_t>& GetData() const						{ return data; }
+	uint32_t GetNumFrames() const									{ return numFrames; }
+
+	/// Writes one line per command. Handles are written as slots, so that the output of two captures can be diffed.
+	/// Returns false if the data is invalid.
+	bool Disassemble(std::ostream& stream) const;
+
+	/// Decodes the commands of a command list block and calls them on target.
+	/// handles maps local handle indices to handles of the target's device. Buffers with an offset go through bufferMapper if it is not nullptr.
+	/// Returns false if the commands are invalid.
+	static bool DecodeCommandList(const uint8_t* commands, size_t size, const RenderHandle* handles, uint32_t numHandles, RenderCommandList& target,
+								BufferMapper* bufferMapper = nullptr);
+	/// Reads the rest of a CommandList or CopyCommandList block after its opcode. Returns false if the block is invalid or refers to slots >= numSlots.
+	static bool ReadCommandList(CommandStreamReader& reader, uint32_t numSlots, std::vector<uint32_t>& outSlots, const uint8_t*& outCommands, size_t& outSize);
+	/// Read the rest of the respective record after its opcode. outUploadData.data points into the reader's data.
+	/// Return false if the record is invalid or refers to slots >= numSlots.
+	static bool ReadUploadData(CommandStreamReader& reader, uint32_t numSlots, UploadData& outUploadData);
+	static bool ReadTextureView(CommandStreamReader& reader, uint32_t numSlots, TextureView& outView);
+
+	static const char* GetName(HandleKind kind);
+
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numHandles;
+		uint32_t numFrames;
+		uint64_t contentSize;	///< Size of everything after the header.
+		uint64_t checksum;		///< Hash of everything after the header.
+	};
+
+	void AddCommandListBlock(Opcode opcode, const uint32_t* slots, uint32_t numSlots, const uint8_t* commands, size_t size);
+
+	std::vector<HandleInfo> handles;
+	std::vector<uint8_t> data;
+	uint32_t numFrames;
+	uint32_t numCopySubmissions;
+};
+
+/// Appends opcodes and arguments in the encoding of CommandStream.
+class CommandStreamWriter
+{
+public:
+	CommandStreamWriter(std::vector<uint8_t>& _data) : data(_data) {}
+
+	void WriteOpcode(CommandStream::Opcode opcode)	{ data.push_back(static_cast<uint8_t>(opcode)); }
+	void WriteUInt(uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			data.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		data.push_back(static_cast<uint8_t>(value));
+	}
+	/// Zigzag encoded, so that small negative values stay small.
+	void WriteInt(int64_t value)					{ WriteUInt((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+	void WriteFloat(float value);
+	void WriteBytes(const void* bytes, size_t numBytes)	{ data.insert(data.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + numBytes); }
+
+private:
+	std::vector<uint8_t>& data;
+};
+
+/// Reads opcodes and arguments in the encoding of CommandStream. Reads past the end or overlong varints set the error flag and return 0.
+class CommandStreamReader
+{
+public:
+	CommandStreamReader(const uint8_t* _data, size_t _size) : data(_data), size(_size), position(0), error(false) {}
+
+	CommandStream::Opcode ReadOpcode()				{ return static_cast<CommandStream::Opcode>(ReadByte()); }
+	uint64_t ReadUInt();
+	int64_t ReadInt()								{ uint64_t value = ReadUInt(); return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+	float ReadFloat();
+	/// Returns a pointer to the next numBytes and skips them, nullptr if there are not as many bytes left.
+	const uint8_t* ReadBytes(size_t numBytes);
+
+	/// Marks the data as invalid, e.g. if a value is out of range.
+	void SetError()									{ error = true; }
+
+	bool IsAtEnd() const							{ return position >= size; }
+	bool HasError() const							{ return error; }
+	size_t GetPosition() const						{ return position; }
+
+private:
+	uint8_t ReadByte();
+
+	const uint8_t* data;
+	size_t size;
+	size_t position;
+	bool error;
+};
@@ -0,0 +1,472 @@
+#include "CommandStreamPlayer.h"
+#include "RenderDevice.h"
+#include "RenderCommandList.h"
+#include "NullDevice.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	/// Only follows the barriers of decoded command lists. Handles are slots + 1.
+	class BarrierTracker : public RenderCommandList
+	{
+	public:
+		BarrierTracker(std::vector<ResourceState>& _states) : states(_states) {}
+
+		bool Reset(unsigned int, RenderHandle) override	{ return true; }
+		bool Close() override							{ return true; }
+
+		void SetPipelineState(RenderHandle) override {}
+		void SetGraphicsRootSignature(RenderHandle) override {}
+		void SetViewport(const Viewport&) override {}
+		void SetScissorRect(const ScissorRect&) override {}
+		void ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers) override
+		{
+			for (unsigned int i = 0; i < numBarriers; ++i)
+			{
+				if (barriers[i].resource != INVALID_RENDER_HANDLE && barriers[i].resource <= states.size())
+					states[barriers[i].resource - 1] = barriers[i].after;
+			}
+		}
+		void SetRenderTarget(RenderHandle) override {}
+		void ClearRenderTarget(RenderHandle, const float[4]) override {}
+
+		void SetPrimitiveTopology(PrimitiveTopology) override {}
+		void SetVertexBuffer(const VertexBufferView&) override {}
+		void SetDescriptorHeap(RenderHandle) override {}
+		void SetGraphicsRootDescriptorTable(unsigned int, RenderHandle, unsigned int) override {}
+		void SetGraphicsRoot32BitConstant(unsigned int, uint32_t, unsigned int) override {}
+
+		void DrawInstanced(uint32_t, uint32_t, uint32_t, uint32_t) override {}
+		void ExecuteIndirect(RenderHandle, uint32_t, RenderHandle, uint64_t, RenderHandle, uint64_t) override {}
+
+		void SetComputeRootSignature(RenderHandle) override {}
+		void SetComputeRootDescriptorTable(unsigned int, RenderHandle, unsigned int) override {}
+		void SetComputeRoot32BitConstant(unsigned int, uint32_t, unsigned int) override {}
+		void Dispatch(uint32_t, uint32_t, uint32_t) override {}
+
+		void CopyBufferRegion(RenderHandle, uint64_t, RenderHandle, uint64_t, uint64_t) override {}
+		void CopyBufferToTexture(RenderHandle, unsigned int, RenderHandle, const TextureFootprint&) override {}
+
+		void WriteTimestamp(RenderHandle, unsigned int) override {}
+		void ResolveTimestamps(RenderHandle, unsigned int, unsigned int, RenderHandle, uint64_t) override {}
+
+	private:
+		std::vector<ResourceState>& states;
+	};
+
+	class NullDeviceHandleFactory : public CommandStreamPlayer::HandleFactory
+	{
+	public:
+		NullDeviceHandleFactory(NullDevice& _device) : device(_device) {}
+
+		RenderHandle CreatePipelineState(const CommandStream::HandleInfo&) override	{ return device.CreatePipelineState(); }
+		RenderHandle CreateRootSignature(const CommandStream::HandleInfo&) override	{ return device.CreateRootSignature(); }
+
+	private:
+		NullDevice& device;
+	};
+}
+
+CommandStreamPlayer::CommandStreamPlayer(RenderDevice& _device, const CommandStream& _stream, const std::vector<RenderHandle>& _handles) :
+	device(_device),
+	stream(_stream),
+	handles(_handles),
+	position(0),
+	error(false),
+	uploadRangeMapper(*this)
+{
+	lastFrameTimings = {};
+	if (handles.size() < stream.GetHandles().size())
+	{
+		std::cerr << "Command stream needs " << stream.GetHandles().size() << " handles, got " << handles.size() << std::endl;
+		error = true;
+		return;
+	}
+	FindRestoreBarriers();
+}
+
+void CommandStreamPlayer::FindRestoreBarriers()
+{
+	const std::vector<CommandStream::HandleInfo>& infos = stream.GetHandles();
+	const uint32_t numSlots = static_cast<uint32_t>(infos.size());
+	std::vector<ResourceState> states(numSlots);
+	for (uint32_t slot = 0; slot < numSlots; ++slot)
+		states[slot] = infos[slot].initialState;
+	// Like in ReplayFrame, commands after the last present are not replayed.
+	std::vector<ResourceState> presentedStates = states;
+	BarrierTracker tracker(states);
+
+	const std::vector<uint8_t>& data = stream.GetData();
+	CommandStreamReader reader(data.data(), data.size());
+	while (!reader.IsAtEnd() && !error)
+	{
+		switch (reader.ReadOpcode())
+		{
+		case CommandStream::Opcode::CommandList:
+		case CommandStream::Opcode::CopyCommandList:
+		{
+			const uint8_t* commands;
+			size_t size;
+			if (!CommandStream::ReadCommandList(reader, numSlots, slots, commands, size))
+			{
+				error = true;
+				break;
+			}
+			localHandles.resize(slots.size());
+			for (size_t i = 0; i < slots.size(); ++i)
+				localHandles[i] = static_cast<RenderHandle>(slots[i]) + 1;
+			if (!CommandStream::DecodeCommandList(commands, size, localHandles.data(), static_cast<uint32_t>(localHandles.size()), tracker))
+				error = true;
+			break;
+		}
+		case CommandStream::Opcode::Execute:
+		case CommandStream::Opcode::ExecuteCopy:
+		case CommandStream::Opcode::QueueWaitForCopy:
+			reader.ReadUInt();
+			error = reader.HasError();
+			break;
+		case CommandStream::Opcode::Present:
+			presentedStates = states;
+			break;
+		case CommandStream::Opcode::UploadData:
+		{
+			CommandStream::UploadData uploadData;
+			error = !CommandStream::ReadUploadData(reader, numSlots, uploadData);
+			break;
+		}
+		case CommandStream::Opcode::TextureView:
+		case CommandStream::Opcode::TextureUnorderedAccessView:
+		{
+			CommandStream::TextureView view;
+			error = !CommandStream::ReadTextureView(reader, numSlots, view);
+			break;
+		}
+		default:
+			error = true;
+			break;
+		}
+	}
+
+	// Back buffers are transitioned by every frame anyways, they are only balanced per frame.
+	for (uint32_t slot = 0; slot < numSlots; ++slot)
+	{
+		CommandStream::HandleKind kind = infos[slot].kind;
+		if (kind == CommandStream::HandleKind::Backbuffer || kind == CommandStream::HandleKind::BackbufferRenderTargetView || presentedStates[slot] == infos[slot].initialState)
+			continue;
+		ResourceBarrier barrier = { handles[slot], presentedStates[slot], infos[slot].initialState };
+		restoreBarriers.push_back(barrier);
+	}
+}
+
+CommandStreamPlayer::~CommandStreamPlayer()
+{
+	// The command lists may still be in use.
+	device.WaitForIdleGPU();
+}
+
+void CommandStreamPlayer::Rewind()
+{
+	position = 0;
+	pendingCommandLists.clear();
+	pendingCopyCommandLists.clear();
+	copyFenceValues.clear();
+	uploadRanges.clear();
+	if (restoreBarriers.empty() || error)
+		return;
+
+	if (!restoreCommandList)
+	{
+		restoreCommandList = device.CreateCommandList();
+		if (!restoreCommandList)
+		{
+			error = true;
+			return;
+		}
+	}
+	// Rewinding is rare, so the list does not get an allocator per frame and waits for the GPU instead.
+	device.WaitForIdleGPU();
+	if (!restoreCommandList->Reset(0, INVALID_RENDER_HANDLE))
+	{
+		error = true;
+		return;
+	}
+	restoreCommandList->ResourceBarriers(restoreBarriers.data(), static_cast<unsigned int>(restoreBarriers.size()));
+	if (!restoreCommandList->Close())
+	{
+		error = true;
+		return;
+	}
+	RenderCommandList* commandLists[] = { restoreCommandList.get() };
+	device.ExecuteCommandLists(commandLists, 1);
+}
+
+RenderHandle CommandStreamPlayer::GetReplayHandle(uint32_t slot)
+{
+	CommandStream::HandleKind kind = stream.GetHandles()[slot].kind;
+	if (kind == CommandStream::HandleKind::Backbuffer)
+		return device.GetCurrentBackbuffer();
+	if (kind == CommandStream::HandleKind::BackbufferRenderTargetView)
+		return device.GetCurrentBackbufferRenderTargetView();
+	return handles[slot];
+}
+
+void CommandStreamPlayer::UploadRangeMapper::MapBuffer(uint32_t localHandle, RenderHandle& buffer, uint64_t& offset)
+{
+	uint32_t slot = player.slots[localHandle];
+	// Newest first, the upload rings of the capture may have handed out the same range twice within a frame.
+	for (auto range = player.uploadRanges.rbegin(); range != player.uploadRanges.rend(); ++range)
+	{
+		if (range->slot == slot && offset >= range->captureOffset && offset - range->captureOffset < range->size)
+		{
+			buffer = range->buffer;
+			offset = range->replayOffset + (offset - range->captureOffset);
+			return;
+		}
+	}
+}
+
+bool CommandStreamPlayer::DecodeCommandList(CommandStreamReader& reader, bool copyQueue)
+{
+	const uint8_t* commands;
+	size_t size;
+	if (!CommandStream::ReadCommandList(reader, static_cast<uint32_t>(stream.GetHandles().size()), slots, commands, size))
+		return false;
+
+	localHandles.resize(slots.size());
+	for (size_t i = 0; i < slots.size(); ++i)
+		localHandles[i] = GetReplayHandle(slots[i]);
+
+	std::vector<std::unique_ptr<RenderCommandList>>& pool = copyQueue ? copyCommandLists : commandLists;
+	std::vector<RenderCommandList*>& pending = copyQueue ? pendingCopyCommandLists : pendingCommandLists;
+	size_t listIndex = pending.size();
+	if (listIndex == pool.size())
+	{
+		pool.push_back(copyQueue ? device.CreateCopyCommandList() : device.CreateCommandList());
+		if (!pool.back())
+		{
+			pool.pop_back();
+			return false;
+		}
+	}
+	if (!CommandStream::DecodeCommandList(commands, size, localHandles.data(), static_cast<uint32_t>(localHandles.size()), *pool[listIndex], &uploadRangeMapper))
+		return false;
+	pending.push_back(pool[listIndex].get());
+	return true;
+}
+
+bool CommandStreamPlayer::ReplayUploadData(CommandStreamReader& reader)
+{
+	CommandStream::UploadData uploadData;
+	if (!CommandStream::ReadUploadData(reader, static_cast<uint32_t>(stream.GetHandles().size()), uploadData))
+		return false;
+
+	UploadAllocation allocation;
+	bool allocated = uploadData.copyQueue ? device.AllocateCopyUploadMemory(uploadData.size, uploadData.alignment, allocation)
+										: device.AllocateUploadMemory(uploadData.size, uploadData.alignment, allocation);
+	if (!allocated)
+	{
+		std::cerr << "Could not allocate " << uploadData.size << " bytes of upload memory for replay" << std::endl;
+		return false;
+	}
+	memcpy(allocation.cpuAddress, uploadData.data, uploadData.size);
+
+	UploadRange range = { uploadData.slot, uploadData.offset, uploadData.size, allocation.buffer, allocation.offset };
+	uploadRanges.push_back(range);
+	return true;
+}
+
+bool CommandStreamPlayer::ReplayFrame()
+{
+	if (error)
+		return false;
+
+	const std::vector<uint8_t>& data = stream.GetData();
+	CommandStreamReader reader(data.data() + position, data.size() - position);
+	const uint32_t numSlots = static_cast<uint32_t>(stream.GetHandles().size());
+
+	lastFrameTimings = {};
+	if (reader.IsAtEnd())
+		return false;
+
+	auto beginFrameBegin = std::chrono::high_resolution_clock::now();
+	device.BeginFrame();
+	auto beginFrameEnd = std::chrono::high_resolution_clock::now();
+	lastFrameTimings.waitMilliseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(beginFrameEnd - beginFrameBegin).count() / 1000.0 / 1000.0;
+
+	while (!reader.IsAtEnd())
+	{
+		CommandStream::Opcode opcode = reader.ReadOpcode();
+		switch (opcode)
+		{
+		case CommandStream::Opcode::CommandList:
+		case CommandStream::Opcode::CopyCommandList:
+		case CommandStream::Opcode::UploadData:
+		case CommandStream::Opcode::TextureView:
+		case CommandStream::Opcode::TextureUnorderedAccessView:
+		{
+			auto recordBegin = std::chrono::high_resolution_clock::now();
+			if (opcode == CommandStream::Opcode::UploadData)
+				error = !ReplayUploadData(reader);
+			else if (opcode == CommandStream::Opcode::TextureView || opcode == CommandStream::Opcode::TextureUnorderedAccessView)
+			{
+				CommandStream::TextureView view;
+				error = !CommandStream::ReadTextureView(reader, numSlots, view);
+				if (!error && opcode == CommandStream::Opcode::TextureView)
+					device.CreateTextureView(handles[view.descriptorHeapSlot], view.descriptorIndex, GetReplayHandle(view.textureSlot), view.desc);
+				else if (!error)
+					device.CreateTextureUnorderedAccessView(handles[view.descriptorHeapSlot], view.descriptorIndex, GetReplayHandle(view.textureSlot), view.desc);
+			}
+			else
+				error = !DecodeCommandList(reader, opcode == CommandStream::Opcode::CopyCommandList);
+			if (error)
+				return false;
+			auto recordEnd = std::chrono::high_resolution_clock::now();
+			lastFrameTimings.recordingMilliseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(recordEnd - recordBegin).count() / 1000.0 / 1000.0;
+			break;
+		}
+
+		case CommandStream::Opcode::Execute:
+		case CommandStream::Opcode::ExecuteCopy:
+		{
+			bool copyQueue = opcode == CommandStream::Opcode::ExecuteCopy;
+			std::vector<RenderCommandList*>& pending = copyQueue ? pendingCopyCommandLists : pendingCommandLists;
+			uint64_t numCommandLists = reader.ReadUInt();
+			if (reader.HasError() || numCommandLists != pending.size())
+			{
+				error = true;
+				return false;
+			}
+			auto submitBegin = std::chrono::high_resolution_clock::now();
+			if (copyQueue)
+				copyFenceValues.push_back(device.ExecuteCopyCommandLists(pending.data(), static_cast<unsigned int>(pending.size())));
+			else
+				device.ExecuteCommandLists(pending.data(), static_cast<unsigned int>(pending.size()));
+			auto submitEnd = std::chrono::high_resolution_clock::now();
+			lastFrameTimings.submitMilliseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(submitEnd - submitBegin).count() / 1000.0 / 1000.0;
+			pending.clear();
+			break;
+		}
+
+		case CommandStream::Opcode::QueueWaitForCopy:
+		{
+			uint64_t copySubmission = reader.ReadUInt();
+			if (reader.HasError() || copySubmission >= copyFenceValues.size())
+			{
+				error = true;
+				return false;
+			}
+			device.QueueWaitForCopy(copyFenceValues[static_cast<size_t>(copySubmission)]);
+			break;
+		}
+
+		case CommandStream::Opcode::Present:
+		{
+			auto submitBegin = std::chrono::high_resolution_clock::now();
+			device.Present();
+			auto submitEnd = std::chrono::high_resolution_clock::now();
+			device.WaitForFreeInflightFrame();
+			auto waitEnd = std::chrono::high_resolution_clock::now();
+			lastFrameTimings.submitMilliseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(submitEnd - submitBegin).count() / 1000.0 / 1000.0;
+			lastFrameTimings.waitMilliseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(waitEnd - submitEnd).count() / 1000.0 / 1000.0;
+			// Upload memory is only valid within the frame it was allocated in.
+			uploadRanges.clear();
+			position += reader.GetPosition();
+			return true;
+		}
+
+		default:
+			error = true;
+			return false;
+		}
+	}
+
+	// Commands after the last present are dropped, they do not form a complete frame.
+	position = data.size();
+	return false;
+}
+
+std::vector<RenderHandle> CommandStreamPlayer::CreateHandles(RenderDevice& device, const CommandStream& stream, HandleFactory& factory)
+{
+	const std::vector<CommandStream::HandleInfo>& infos = stream.GetHandles();
+	std::vector<RenderHandle> handles;
+	handles.reserve(infos.size());
+	RenderHandle commandSignatureRootSignature = INVALID_RENDER_HANDLE;
+	for (const CommandStream::HandleInfo& info : infos)
+	{
+		RenderHandle handle = INVALID_RENDER_HANDLE;
+		switch (info.kind)
+		{
+		case CommandStream::HandleKind::Resource:
+		case CommandStream::HandleKind::Buffer:
+			handle = device.CreateBuffer(info.bufferSize, info.initialState);
+			break;
+		case CommandStream::HandleKind::UploadBuffer:
+		{
+			// Commands are moved to the upload memory of their UploadData records, this only stands in for ranges without one.
+			UploadAllocation allocation;
+			if (device.AllocateUploadMemory(1, 1, allocation))
+				handle = allocation.buffer;
+			break;
+		}
+		case CommandStream::HandleKind::ReadbackBuffer:
+			handle = device.CreateReadbackBuffer(info.count * sizeof(uint64_t));
+			break;
+		case CommandStream::HandleKind::Texture:
+		{
+			// Same size as in the capture if it is known, so the texture memory matches.
+			TextureDesc desc = { 1, 1, 1, TextureFormat::R8G8B8A8_UNORM, false };
+			if (info.textureDesc.width > 0)
+				desc = info.textureDesc;
+			handle = device.CreateTexture(desc, info.initialState);
+			break;
+		}
+		case CommandStream::HandleKind::Backbuffer:
+		case CommandStream::HandleKind::BackbufferRenderTargetView:
+			// Resolved during replay.
+			break;
+		case CommandStream::HandleKind::PipelineState:
+			handle = factory.CreatePipelineState(info);
+			break;
+		case CommandStream::HandleKind::RootSignature:
+			handle = factory.CreateRootSignature(info);
+			break;
+		case CommandStream::HandleKind::DescriptorHeap:
+			handle = device.CreateDescriptorHeap(info.count);
+			break;
+		case CommandStream::HandleKind::CommandSignature:
+		{
+			RenderHandle rootSignature = INVALID_RENDER_HANDLE;
+			for (size_t slot = 0; slot < handles.size() && info.rootSignatureHash != 0; ++slot)
+			{
+				if (infos[slot].kind == CommandStream::HandleKind::RootSignature && infos[slot].rootSignatureHash == info.rootSignatureHash)
+				{
+					rootSignature = handles[slot];
+					break;
+				}
+			}
+			if (rootSignature == INVALID_RENDER_HANDLE)
+			{
+				if (commandSignatureRootSignature == INVALID_RENDER_HANDLE)
+					commandSignatureRootSignature = factory.CreateRootSignature(info);
+				rootSignature = commandSignatureRootSignature;
+			}
+			handle = device.CreateIndirectDrawSignature(rootSignature, Renderer::DRAW_ID_ROOT_PARAMETER);
+			break;
+		}
+		case CommandStream::HandleKind::QueryHeap:
+			handle = device.CreateTimestampQueryHeap(info.count);
+			break;
+		}
+		handles.push_back(handle);
+	}
+	return handles;
+}
+
+std::vector<RenderHandle> CommandStreamPlayer::CreateNullDeviceHandles(NullDevice& device, const CommandStream& stream)
+{
+	NullDeviceHandleFactory factory(device);
+	return CreateHandles(device, stream, factory);
+}
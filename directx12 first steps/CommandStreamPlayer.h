@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CommandStream.h"
+#include "Renderer.h"
+
+class RenderDevice;
+class RenderCommandList;
+class NullDevice;
+
+/// Replays a CommandStream frame by frame on any RenderDevice.
+///
+/// Submission is the same as in the captured run: The same lists are executed together on the same queues, presents happen at the same points and
+/// the player calls BeginFrame and WaitForFreeInflightFrame around each frame like the Renderer. Only recording is replaced by decoding.
+/// Upload memory contents are copied into upload memory of the replaying device and the buffer ranges of the commands are moved there.
+/// Independent of D3D12 and Windows.
+class CommandStreamPlayer
+{
+public:
+	/// handles maps every slot of the stream to an object of the device and needs to stay alive as long as the player.
+	/// Slots of the back buffer kinds are ignored, they always refer to the device's current back buffer.
+	CommandStreamPlayer(RenderDevice& device, const CommandStream& stream, const std::vector<RenderHandle>& handles);
+	~CommandStreamPlayer();
+
+	/// Replays everything up to and including the next present.
+	/// Returns false at the end of the stream or if the stream is invalid, see HasError.
+	bool ReplayFrame();
+	/// Continues with the first frame. Call it at the end of the stream, it transitions all resources back to the states the first frame expects.
+	void Rewind();
+
+	bool HasError() const									{ return error; }
+	/// Same meaning as for the Renderer, recording is the time spent decoding into command lists, copying upload memory and creating views.
+	const Renderer::FrameTimings& GetLastFrameTimings() const	{ return lastFrameTimings; }
+
+	/// Creates the objects that RenderDevice has no creation functions for.
+	class HandleFactory
+	{
+	public:
+		virtual ~HandleFactory() {}
+
+		/// The slot's pipelineStateName tells which shaders it was made of, if known.
+		virtual RenderHandle CreatePipelineState(const CommandStream::HandleInfo& info) = 0;
+		/// The slot's rootSignatureHash tells which root signature it was, if known.
+		virtual RenderHandle CreateRootSignature(const CommandStream::HandleInfo& info) = 0;
+	};
+
+	/// Creates an object for every slot of the stream. Buffers and textures get the size recorded in their slot, if known.
+	/// Command signatures are created for the root signature slot with the same hash, or for a new root signature from the factory.
+	static std::vector<RenderHandle> CreateHandles(RenderDevice& device, const CommandStream& stream, HandleFactory& factory);
+	/// CreateHandles with placeholder pipeline states and root signatures.
+	static std::vector<RenderHandle> CreateNullDeviceHandles(NullDevice& device, const CommandStream& stream);
+
+private:
+	/// Upload memory of a UploadData record.
+	struct UploadRange
+	{
+		uint32_t slot;
+		uint64_t captureOffset;
+		uint64_t size;
+		RenderHandle buffer;
+		uint64_t replayOffset;
+	};
+
+	/// Moves buffer ranges of the decoded commands into the upload ranges of the current frame.
+	class UploadRangeMapper : public CommandStream::BufferMapper
+	{
+	public:
+		UploadRangeMapper(const CommandStreamPlayer& _player) : player(_player) {}
+		void MapBuffer(uint32_t localHandle, RenderHandle& buffer, uint64_t& offset) override;
+
+	private:
+		const CommandStreamPlayer& player;
+	};
+
+	/// Finds the states the frames of the stream leave the resources in and the barriers that undo them.
+	void FindRestoreBarriers();
+	/// Returns the handle of the slot, back buffer slots resolve to the current back buffer.
+	RenderHandle GetReplayHandle(uint32_t slot);
+	/// Decodes a CommandList or CopyCommandList block into the next list of the pool. Returns false on failure.
+	bool DecodeCommandList(CommandStreamReader& reader, bool copyQueue);
+	/// Copies the content of an UploadData record into new upload memory. Returns false on failure.
+	bool ReplayUploadData(CommandStreamReader& reader);
+
+	RenderDevice& device;
+	const CommandStream& stream;
+	const std::vector<RenderHandle>& handles;
+
+	size_t position;	///< Read position within the stream's data.
+	bool error;
+
+	/// Lists are reused by their position within an Execute, like the renderer's main and worker lists.
+	std::vector<std::unique_ptr<RenderCommandList>> commandLists;
+	std::vector<RenderCommandList*> pendingCommandLists;
+	std::vector<std::unique_ptr<RenderCommandList>> copyCommandLists;
+	std::vector<RenderCommandList*> pendingCopyCommandLists;
+	std::vector<uint32_t> slots;
+	std::vector<RenderHandle> localHandles;
+
+	/// Copy fence value of every replayed copy submission, by submission index.
+	std::vector<uint64_t> copyFenceValues;
+	/// Upload memory of the current frame.
+	std::vector<UploadRange> uploadRanges;
+	UploadRangeMapper uploadRangeMapper;
+
+	/// Captures with one-time transitions, e.g. of resources uploaded on the copy queue, need them undone before the stream can loop.
+	std::vector<ResourceBarrier> restoreBarriers;
+	std::unique_ptr<RenderCommandList> restoreCommandList;
+
+	Renderer::FrameTimings lastFrameTimings;
+};
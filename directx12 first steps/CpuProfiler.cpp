@@ -0,0 +1,126 @@
+#include "CpuProfiler.h"
+
+#include <fstream>
+#include <iomanip>
+
+std::mutex CpuProfiler::ringsMutex;
+std::vector<std::unique_ptr<CpuProfiler::ThreadRing>> CpuProfiler::rings;
+const std::chrono::high_resolution_clock::time_point CpuProfiler::epoch = std::chrono::high_resolution_clock::now();
+
+namespace
+{
+	void WriteJsonString(std::ostream& stream, const char* string)
+	{
+		stream << '"';
+		for (const char* c = string; *c != '\0'; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				stream << '\\';
+			stream << *c;
+		}
+		stream << '"';
+	}
+}
+
+int64_t CpuProfiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - epoch).count();
+}
+
+CpuProfiler::ThreadRing& CpuProfiler::GetThreadRing()
+{
+	thread_local ThreadRing* threadRing = nullptr;
+	if (!threadRing)
+	{
+		std::unique_ptr<ThreadRing> newRing(new ThreadRing());
+		newRing->numWrittenEvents = 0;
+		for (Event& event : newRing->events)
+			event.sequence = 0;
+
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		newRing->threadIndex = static_cast<unsigned int>(rings.size());
+		threadRing = newRing.get();
+		rings.push_back(std::move(newRing));
+	}
+	return *threadRing;
+}
+
+void CpuProfiler::Record(const char* name, int64_t beginNanoseconds, int64_t endNanoseconds)
+{
+	ThreadRing& ring = GetThreadRing();
+	uint64_t eventIndex = ring.numWrittenEvents.load(std::memory_order_relaxed);
+	Event& event = ring.events[eventIndex % EVENTS_PER_THREAD];
+	// Marks the slot as being written before any field changes. The fence keeps the field stores from moving before the sequence store.
+	event.sequence.store(2 * eventIndex + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	event.name.store(name, std::memory_order_relaxed);
+	event.begin.store(beginNanoseconds, std::memory_order_relaxed);
+	event.end.store(endNanoseconds, std::memory_order_relaxed);
+	event.sequence.store(2 * eventIndex + 2, std::memory_order_release);
+	// Publishes the event to readers.
+	ring.numWrittenEvents.store(eventIndex + 1, std::memory_order_release);
+}
+
+void CpuProfiler::WriteChromeTrace(std::ostream& stream)
+{
+	std::lock_guard<std::mutex> lock(ringsMutex);
+
+	// Microseconds with nanosecond precision, the default precision would cut off long timestamps.
+	std::ios::fmtflags previousFlags = stream.flags();
+	std::streamsize previousPrecision = stream.precision();
+	stream << std::fixed << std::setprecision(3);
+
+	stream << "{\"traceEvents\":[";
+	bool firstEvent = true;
+	for (const auto& ring : rings)
+	{
+		uint64_t numWrittenEvents = ring->numWrittenEvents.load(std::memory_order_acquire);
+		uint64_t firstEventIndex = numWrittenEvents > EVENTS_PER_THREAD ? numWrittenEvents - EVENTS_PER_THREAD : 0;
+		for (uint64_t eventIndex = firstEventIndex; eventIndex < numWrittenEvents; ++eventIndex)
+		{
+			// The slot needs to hold this event, completely written, before and after reading the fields.
+			// Otherwise the owning thread wrapped around to it in the meantime and the values might be torn.
+			const Event& event = ring->events[eventIndex % EVENTS_PER_THREAD];
+			const uint64_t completeSequence = 2 * eventIndex + 2;
+			if (event.sequence.load(std::memory_order_acquire) != completeSequence)
+				continue;
+			const char* name = event.name.load(std::memory_order_relaxed);
+			int64_t begin = event.begin.load(std::memory_order_relaxed);
+			int64_t end = event.end.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (event.sequence.load(std::memory_order_relaxed) != completeSequence)
+				continue;
+
+			// Complete events, timestamps are in microseconds.
+			stream << (firstEvent ? "\n" : ",\n") << "{\"name\":";
+			WriteJsonString(stream, name);
+			stream << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << ring->threadIndex <<
+				",\"ts\":" << begin / 1000.0 << ",\"dur\":" << (end - begin) / 1000.0 << "}";
+			firstEvent = false;
+		}
+	}
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	stream.flags(previousFlags);
+	stream.precision(previousPrecision);
+}
+
+bool CpuProfiler::WriteChromeTrace(const std::string& path)
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+	WriteChromeTrace(file);
+	return static_cast<bool>(file);
+}
+
+void CpuProfiler::Clear()
+{
+	std::lock_guard<std::mutex> lock(ringsMutex);
+	for (const auto& ring : rings)
+	{
+		ring->numWrittenEvents = 0;
+		for (Event& event : ring->events)
+			event.sequence = 0;
+	}
+}
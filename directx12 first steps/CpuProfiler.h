@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Define DISABLE_CPU_PROFILER to compile all PROFILE_SCOPE markers to nothing.
+#ifndef DISABLE_CPU_PROFILER
+	#define CPU_PROFILER
+#endif
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef CPU_PROFILER
+	/// Measures the CPU time until the end of the enclosing block. Name needs to be a string literal.
+	#define PROFILE_SCOPE(name) CpuProfiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+	#define PROFILE_SCOPE(name) do {} while(false)
+#endif
+
+/// Records scoped CPU markers of all threads and exports them as Chrome trace JSON (chrome://tracing, Perfetto).
+///
+/// Every thread writes into its own ring of the most recent events, recording a scope is a clock read at its begin and end plus a single
+/// ring write without any locks. Only the first scope of a thread takes a lock to register the thread's ring.
+/// Export may run concurrently to recording, events that are overwritten while they are read are skipped. For this every event carries a
+/// sequence number that is odd while it is written, like a seqlock.
+///
+/// Independent of D3D12 and Windows.
+class CpuProfiler
+{
+public:
+	/// Events per thread. Older events are overwritten.
+	static const unsigned int EVENTS_PER_THREAD = 16 * 1024;
+
+	class Scope
+	{
+	public:
+		Scope(const char* _name) : name(_name), begin(CpuProfiler::Now()) {}
+		~Scope() { CpuProfiler::Record(name, begin, CpuProfiler::Now()); }
+
+	private:
+		Scope(const Scope&);
+		Scope& operator = (const Scope&);
+
+		const char* name;
+		int64_t begin;
+	};
+
+	/// Nanoseconds since the profiler's epoch.
+	static int64_t Now();
+
+	/// Adds a finished scope to the calling thread's ring. Name needs to stay alive as long as the profiler.
+	static void Record(const char* name, int64_t beginNanoseconds, int64_t endNanoseconds);
+
+	/// Writes all events that are currently in the rings as Chrome trace JSON.
+	static void WriteChromeTrace(std::ostream& stream);
+	/// Returns false if the file could not be written.
+	static bool WriteChromeTrace(const std::string& path);
+
+	/// Drops all events recorded so far. Must not be called while other threads record.
+	static void Clear();
+
+private:
+	/// Fields are atomics so that a concurrent export can read them. Relaxed accesses compile to plain moves on x86 and x64.
+	struct Event
+	{
+		/// 2 * event index + 1 while the fields are written, 2 * event index + 2 once they are complete.
+		std::atomic<uint64_t> sequence;
+		std::atomic<const char*> name;
+		std::atomic<int64_t> begin;
+		std::atomic<int64_t> end;
+	};
+
+	/// Written only by the owning thread.
+	struct ThreadRing
+	{
+		unsigned int threadIndex;
+		std::atomic<uint64_t> numWrittenEvents;
+		Event events[EVENTS_PER_THREAD];
+	};
+
+	static ThreadRing& GetThreadRing();
+
+	/// Rings of all threads that ever recorded an event. Outlive their threads so that their events can still be exported.
+	static std::mutex ringsMutex;
+	static std::vector<std::unique_ptr<ThreadRing>> rings;
+	static const std::chrono::high_resolution_clock::time_point epoch;
+};
@@ -0,0 +1,193 @@
+#include "D3D12CommandList.h"
+
+#include "d3dx12.h"
+#include "D3D12Conversion.h"
+
+bool D3D12CommandList::Create(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type)
+{
+	for (auto& commandAllocator : commandAllocators)
+	{
+		if (FAILED(device->CreateCommandAllocator(type, IID_PPV_ARGS(&commandAllocator))))
+			return false;
+	}
+	if (FAILED(device->CreateCommandList(0, type, commandAllocators[0].Get(), nullptr, IID_PPV_ARGS(&commandList))))
+		return false;
+	commandList->Close();
+
+	descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	cachedDescriptorHeap = INVALID_RENDER_HANDLE;
+	cachedDescriptorHeapStart.ptr = 0;
+	return true;
+}
+
+bool D3D12CommandList::Reset(unsigned int frameQueueIndex, RenderHandle pipelineState)
+{
+	// A released heap's address may be reused by a new heap between recordings, so the cache only lives as long as one recording.
+	cachedDescriptorHeap = INVALID_RENDER_HANDLE;
+	cachedDescriptorHeapStart.ptr = 0;
+
+	ID3D12CommandAllocator* allocator = commandAllocators[frameQueueIndex].Get();
+	return SUCCEEDED(allocator->Reset()) && SUCCEEDED(commandList->Reset(allocator, FromRenderHandle<ID3D12PipelineState>(pipelineState)));
+}
+
+bool D3D12CommandList::Close()
+{
+	return SUCCEEDED(commandList->Close());
+}
+
+void D3D12CommandList::SetPipelineState(RenderHandle pipelineState)
+{
+	commandList->SetPipelineState(FromRenderHandle<ID3D12PipelineState>(pipelineState));
+}
+
+void D3D12CommandList::SetGraphicsRootSignature(RenderHandle rootSignature)
+{
+	commandList->SetGraphicsRootSignature(FromRenderHandle<ID3D12RootSignature>(rootSignature));
+}
+
+void D3D12CommandList::SetViewport(const Viewport& viewport)
+{
+	D3D12_VIEWPORT d3d12Viewport = { viewport.topLeftX, viewport.topLeftY, viewport.width, viewport.height, viewport.minDepth, viewport.maxDepth };
+	commandList->RSSetViewports(1, &d3d12Viewport);
+}
+
+void D3D12CommandList::SetScissorRect(const ScissorRect& scissorRect)
+{
+	D3D12_RECT rect = { scissorRect.left, scissorRect.top, scissorRect.right, scissorRect.bottom };
+	commandList->RSSetScissorRects(1, &rect);
+}
+
+void D3D12CommandList::ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers)
+{
+	// Converted in small batches on the stack, the application never issues many barriers at once except for texture creation.
+	const unsigned int batchSize = 64;
+	D3D12_RESOURCE_BARRIER d3d12Barriers[batchSize];
+	for (unsigned int batchBegin = 0; batchBegin < numBarriers; batchBegin += batchSize)
+	{
+		unsigned int numBatchBarriers = numBarriers - batchBegin < batchSize ? numBarriers - batchBegin : batchSize;
+		for (unsigned int i = 0; i < numBatchBarriers; ++i)
+		{
+			const ResourceBarrier& barrier = barriers[batchBegin + i];
+			d3d12Barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(FromRenderHandle<ID3D12Resource>(barrier.resource),
+											ToD3D12ResourceState(barrier.before), ToD3D12ResourceState(barrier.after));
+		}
+		commandList->ResourceBarrier(numBatchBarriers, d3d12Barriers);
+	}
+}
+
+void D3D12CommandList::SetRenderTarget(RenderHandle renderTargetView)
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE rtvDesc = ToCPUDescriptorHandle(renderTargetView);
+	commandList->OMSetRenderTargets(1, &rtvDesc, FALSE, nullptr);
+}
+
+void D3D12CommandList::ClearRenderTarget(RenderHandle renderTargetView, const float color[4])
+{
+	commandList->ClearRenderTargetView(ToCPUDescriptorHandle(renderTargetView), color, 0, nullptr);
+}
+
+void D3D12CommandList::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	commandList->IASetPrimitiveTopology(ToD3D12PrimitiveTopology(topology));
+}
+
+void D3D12CommandList::SetVertexBuffer(const VertexBufferView& view)
+{
+	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+	vertexBufferView.BufferLocation = FromRenderHandle<ID3D12Resource>(view.buffer)->GetGPUVirtualAddress();
+	vertexBufferView.SizeInBytes = view.sizeInBytes;
+	vertexBufferView.StrideInBytes = view.strideInBytes;
+	commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+}
+
+void D3D12CommandList::SetDescriptorHeap(RenderHandle descriptorHeap)
+{
+	ID3D12DescriptorHeap* descriptorHeaps[] = { FromRenderHandle<ID3D12DescriptorHeap>(descriptorHeap) };
+	commandList->SetDescriptorHeaps(1, descriptorHeaps);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE D3D12CommandList::GetDescriptorTable(RenderHandle descriptorHeap, unsigned int firstDescriptor)
+{
+	if (descriptorHeap != cachedDescriptorHeap)
+	{
+		cachedDescriptorHeapStart = FromRenderHandle<ID3D12DescriptorHeap>(descriptorHeap)->GetGPUDescriptorHandleForHeapStart();
+		cachedDescriptorHeap = descriptorHeap;
+	}
+	D3D12_GPU_DESCRIPTOR_HANDLE table = cachedDescriptorHeapStart;
+	table.ptr += static_cast<UINT64>(firstDescriptor) * descriptorSize;
+	return table;
+}
+
+void D3D12CommandList::SetGraphicsRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor)
+{
+	commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, GetDescriptorTable(descriptorHeap, firstDescriptor));
+}
+
+void D3D12CommandList::SetGraphicsRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues)
+{
+	commandList->SetGraphicsRoot32BitConstant(rootParameterIndex, value, destOffsetIn32BitValues);
+}
+
+void D3D12CommandList::DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+{
+	commandList->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+}
+
+void D3D12CommandList::ExecuteIndirect(RenderHandle commandSignature, uint32_t maxCommandCount, RenderHandle argumentBuffer, uint64_t argumentBufferOffset,
+										RenderHandle countBuffer, uint64_t countBufferOffset)
+{
+	commandList->ExecuteIndirect(FromRenderHandle<ID3D12CommandSignature>(commandSignature), maxCommandCount,
+								FromRenderHandle<ID3D12Resource>(argumentBuffer), argumentBufferOffset,
+								FromRenderHandle<ID3D12Resource>(countBuffer), countBufferOffset);
+}
+
+void D3D12CommandList::SetComputeRootSignature(RenderHandle rootSignature)
+{
+	commandList->SetComputeRootSignature(FromRenderHandle<ID3D12RootSignature>(rootSignature));
+}
+
+void D3D12CommandList::SetComputeRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor)
+{
+	commandList->SetComputeRootDescriptorTable(rootParameterIndex, GetDescriptorTable(descriptorHeap, firstDescriptor));
+}
+
+void D3D12CommandList::SetComputeRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues)
+{
+	commandList->SetComputeRoot32BitConstant(rootParameterIndex, value, destOffsetIn32BitValues);
+}
+
+void D3D12CommandList::Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ)
+{
+	commandList->Dispatch(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+}
+
+void D3D12CommandList::CopyBufferRegion(RenderHandle destBuffer, uint64_t destOffset, RenderHandle sourceBuffer, uint64_t sourceOffset, uint64_t numBytes)
+{
+	commandList->CopyBufferRegion(FromRenderHandle<ID3D12Resource>(destBuffer), destOffset, FromRenderHandle<ID3D12Resource>(sourceBuffer), sourceOffset, numBytes);
+}
+
+void D3D12CommandList::CopyBufferToTexture(RenderHandle destTexture, unsigned int destSubresource, RenderHandle sourceBuffer, const TextureFootprint& sourceFootprint)
+{
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT placedFootprint;
+	placedFootprint.Offset = sourceFootprint.offset;
+	placedFootprint.Footprint.Format = ToDXGIFormat(sourceFootprint.format);
+	placedFootprint.Footprint.Width = sourceFootprint.width;
+	placedFootprint.Footprint.Height = sourceFootprint.height;
+	placedFootprint.Footprint.Depth = 1;
+	placedFootprint.Footprint.RowPitch = sourceFootprint.rowPitch;
+
+	CD3DX12_TEXTURE_COPY_LOCATION copyDest(FromRenderHandle<ID3D12Resource>(destTexture), destSubresource);
+	CD3DX12_TEXTURE_COPY_LOCATION copySource(FromRenderHandle<ID3D12Resource>(sourceBuffer), placedFootprint);
+	commandList->CopyTextureRegion(&copyDest, 0, 0, 0, &copySource, nullptr);
+}
+
+void D3D12CommandList::WriteTimestamp(RenderHandle queryHeap, unsigned int queryIndex)
+{
+	commandList->EndQuery(FromRenderHandle<ID3D12QueryHeap>(queryHeap), D3D12_QUERY_TYPE_TIMESTAMP, queryIndex);
+}
+
+void D3D12CommandList::ResolveTimestamps(RenderHandle queryHeap, unsigned int firstQuery, unsigned int numQueries, RenderHandle destBuffer, uint64_t destOffset)
+{
+	commandList->ResolveQueryData(FromRenderHandle<ID3D12QueryHeap>(queryHeap), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, numQueries,
+								FromRenderHandle<ID3D12Resource>(destBuffer), destOffset);
+}
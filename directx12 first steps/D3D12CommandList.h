@@ -0,0 +1,65 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "RenderCommandList.h"
+#include "RenderDevice.h"
+
+using namespace Microsoft::WRL;
+
+/// RenderCommandList on top of an ID3D12GraphicsCommandList with one allocator per in-flight frame.
+/// Lists of type D3D12_COMMAND_LIST_TYPE_COPY only support the copy commands.
+class D3D12CommandList : public RenderCommandList
+{
+public:
+	/// Returns false if the allocators or the list could not be created. The list is closed afterwards.
+	bool Create(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type);
+
+	bool Reset(unsigned int frameQueueIndex, RenderHandle pipelineState) override;
+	bool Close() override;
+
+	void SetPipelineState(RenderHandle pipelineState) override;
+	void SetGraphicsRootSignature(RenderHandle rootSignature) override;
+	void SetViewport(const Viewport& viewport) override;
+	void SetScissorRect(const ScissorRect& scissorRect) override;
+	void ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers) override;
+	void SetRenderTarget(RenderHandle renderTargetView) override;
+	void ClearRenderTarget(RenderHandle renderTargetView, const float color[4]) override;
+
+	void SetPrimitiveTopology(PrimitiveTopology topology) override;
+	void SetVertexBuffer(const VertexBufferView& view) override;
+	void SetDescriptorHeap(RenderHandle descriptorHeap) override;
+	void SetGraphicsRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) override;
+	void SetGraphicsRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) override;
+
+	void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
+	void ExecuteIndirect(RenderHandle commandSignature, uint32_t maxCommandCount, RenderHandle argumentBuffer, uint64_t argumentBufferOffset,
+						RenderHandle countBuffer, uint64_t countBufferOffset) override;
+
+	void SetComputeRootSignature(RenderHandle rootSignature) override;
+	void SetComputeRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) override;
+	void SetComputeRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) override;
+	void Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) override;
+
+	void CopyBufferRegion(RenderHandle destBuffer, uint64_t destOffset, RenderHandle sourceBuffer, uint64_t sourceOffset, uint64_t numBytes) override;
+	void CopyBufferToTexture(RenderHandle destTexture, unsigned int destSubresource, RenderHandle sourceBuffer, const TextureFootprint& sourceFootprint) override;
+
+	void WriteTimestamp(RenderHandle queryHeap, unsigned int queryIndex) override;
+	void ResolveTimestamps(RenderHandle queryHeap, unsigned int firstQuery, unsigned int numQueries, RenderHandle destBuffer, uint64_t destOffset) override;
+
+	ID3D12GraphicsCommandList* GetD3D12CommandList() const	{ return commandList.Get(); }
+
+private:
+	/// GPU handle of the given descriptor, see cachedDescriptorHeap.
+	D3D12_GPU_DESCRIPTOR_HANDLE GetDescriptorTable(RenderHandle descriptorHeap, unsigned int firstDescriptor);
+
+	ComPtr<ID3D12CommandAllocator> commandAllocators[RenderDevice::MAX_FRAMES_INFLIGHT];
+	ComPtr<ID3D12GraphicsCommandList> commandList;
+
+	unsigned int descriptorSize;
+	/// Start of the last heap used for a descriptor table. Querying it is a call into the runtime, tables are usually set many times per heap.
+	/// Handles are object pointers that can be reused for new heaps, so Reset clears the cache.
+	RenderHandle cachedDescriptorHeap;
+	D3D12_GPU_DESCRIPTOR_HANDLE cachedDescriptorHeapStart;
+};
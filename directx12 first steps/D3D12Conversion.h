@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <d3d12.h>
+
+#include "RenderTypes.h"
+
+// Conversions between the backend independent render types and their D3D12 counterparts.
+
+/// D3D12 objects are referred to by their interface pointer.
+template<typename T>
+inline RenderHandle ToRenderHandle(T* object)
+{
+	return static_cast<RenderHandle>(reinterpret_cast<uintptr_t>(object));
+}
+
+template<typename T>
+inline T* FromRenderHandle(RenderHandle handle)
+{
+	return reinterpret_cast<T*>(static_cast<uintptr_t>(handle));
+}
+
+/// Descriptors are referred to by their CPU handle.
+inline RenderHandle ToRenderHandle(D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
+{
+	return static_cast<RenderHandle>(descriptor.ptr);
+}
+
+inline D3D12_CPU_DESCRIPTOR_HANDLE ToCPUDescriptorHandle(RenderHandle handle)
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE descriptor;
+	descriptor.ptr = static_cast<SIZE_T>(handle);
+	return descriptor;
+}
+
+inline D3D12_RESOURCE_STATES ToD3D12ResourceState(ResourceState state)
+{
+	switch (state)
+	{
+	case ResourceState::Present:
+		return D3D12_RESOURCE_STATE_PRESENT;
+	case ResourceState::RenderTarget:
+		return D3D12_RESOURCE_STATE_RENDER_TARGET;
+	case ResourceState::CopyDest:
+		return D3D12_RESOURCE_STATE_COPY_DEST;
+	case ResourceState::PixelShaderResource:
+		return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	case ResourceState::VertexAndConstantBuffer:
+		return D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+	case ResourceState::IndirectArgument:
+		return D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+	case ResourceState::UnorderedAccess:
+		return D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+	case ResourceState::Common:
+	default:
+		return D3D12_RESOURCE_STATE_COMMON;
+	}
+}
+
+inline D3D12_PRIMITIVE_TOPOLOGY ToD3D12PrimitiveTopology(PrimitiveTopology topology)
+{
+	return topology == PrimitiveTopology::TriangleStrip ? D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP : D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+}
+
+inline DXGI_FORMAT ToDXGIFormat(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::R8G8B8A8_UNORM:
+	default:
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+inline D3D12_RESOURCE_DESC ToD3D12ResourceDesc(const TextureDesc& desc)
+{
+	D3D12_RESOURCE_DESC textureDesc = {};
+	textureDesc.MipLevels = 1;
+	textureDesc.Format = ToDXGIFormat(desc.format);
+	textureDesc.Width = desc.width;
+	textureDesc.Height = desc.height;
+	textureDesc.Flags = desc.allowUnorderedAccess ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE;
+	textureDesc.DepthOrArraySize = static_cast<UINT16>(desc.arraySize);
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	return textureDesc;
+}
+
+static_assert(TEXTURE_DATA_PLACEMENT_ALIGNMENT == D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, "Texture placement alignment does not match D3D12.");
+static_assert(sizeof(IndirectDrawCommand) == sizeof(UINT) + sizeof(D3D12_DRAW_ARGUMENTS), "IndirectDrawCommand does not match the D3D12 argument layout.");
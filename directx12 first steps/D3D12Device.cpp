@@ -7,8 +7,18 @@
 #include "d3dx12.h"
 
 #include "Helper.h"
+#include "D3D12CommandList.h"
+#include "D3D12Conversion.h"
+#include "D3D12Fence.h"
+#include "PlacedTextureAllocator.h"
 
-D3D12Device::D3D12Device(Window& window) : activeSwapChainBufferIndex(0), vsync(false)
+D3D12Device::D3D12Device(Window& window, unsigned int numBackbuffers) :
+	activeSwapChainBufferIndex(0),
+	backbufferWidth(window.GetWidth()),
+	backbufferHeight(window.GetHeight()),
+	backbufferRenderTargets(numBackbuffers < MIN_BACKBUFFERS ? MIN_BACKBUFFERS : (numBackbuffers > MAX_BACKBUFFERS ? MAX_BACKBUFFERS : numBackbuffers)),
+	frameLatencyWaitableObject(nullptr),
+	vsync(false)
 {
 #ifdef D3DDEBUG
 	// Enable the D3D12 debug layer.
@@ -38,6 +48,15 @@ D3D12Device::D3D12Device(Window& window) : activeSwapChainBufferIndex(0), vsync(
 			CRITICAL_ERROR("Failed to create D3D12 commandqueue");
 	}
 
+	// Copy queue for uploads that run in parallel to rendering.
+	{
+		D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+		queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+		if (FAILED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&copyCommandQueue))))
+			CRITICAL_ERROR("Failed to create D3D12 copy commandqueue");
+	}
+
 	// Describe and create the swap chain.
 	{
 		ComPtr<IDXGIFactory4> factory;
@@ -45,7 +64,7 @@ D3D12Device::D3D12Device(Window& window) : activeSwapChainBufferIndex(0), vsync(
 			CRITICAL_ERROR("Failed to create DXGI factory");
 
 		DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
-		swapChainDesc.BufferCount = SWAPCHAINBUFFERCOUNT;
+		swapChainDesc.BufferCount = static_cast<UINT>(backbufferRenderTargets.size());
 		swapChainDesc.BufferDesc.Width = window.GetWidth();
 		swapChainDesc.BufferDesc.Height = window.GetHeight();
 		swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -54,6 +73,8 @@ D3D12Device::D3D12Device(Window& window) : activeSwapChainBufferIndex(0), vsync(
 		swapChainDesc.OutputWindow = window.GetHandle();
 		swapChainDesc.SampleDesc.Count = 1;
 		swapChainDesc.Windowed = TRUE;
+		// Lets the CPU wait until the swap chain accepts another frame instead of blocking in Present, see FramePacingMode::Latency.
+		swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
 
 		ComPtr<IDXGISwapChain> localSwapChain;
 		if (FAILED(factory->CreateSwapChain(
@@ -66,13 +87,17 @@ D3D12Device::D3D12Device(Window& window) : activeSwapChainBufferIndex(0), vsync(
 		}
 
 		activeSwapChainBufferIndex = swapChain->GetCurrentBackBufferIndex();
+
+		if (FAILED(swapChain->SetMaximumFrameLatency(MAX_FRAMES_INFLIGHT)))
+			CRITICAL_ERROR("Failed to set maximum frame latency");
+		frameLatencyWaitableObject = swapChain->GetFrameLatencyWaitableObject();
 	}
 
 	// Create descriptor heap for backbuffer.
 	{
 		// Describe and create a render target view (RTV) descriptor heap.
 		D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-		rtvHeapDesc.NumDescriptors = SWAPCHAINBUFFERCOUNT;
+		rtvHeapDesc.NumDescriptors = static_cast<UINT>(backbufferRenderTargets.size());
 		rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
 		rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 		if(FAILED(device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&backbufferDescriptorHeap))))
@@ -84,7 +109,7 @@ D3D12Device::D3D12Device(Window& window) : activeSwapChainBufferIndex(0), vsync(
 		CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(backbufferDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
 
 		// Create a RTV for each frame.
-		for (int i = 0; i < SWAPCHAINBUFFERCOUNT; ++i)
+		for (UINT i = 0; i < static_cast<UINT>(backbufferRenderTargets.size()); ++i)
 		{
 			if (FAILED(swapChain->GetBuffer(i, IID_PPV_ARGS(&backbufferRenderTargets[i]))))
 				CRITICAL_ERROR("Failed to retrieve ID3D12Resource from swapchain buffer.");
@@ -96,73 +121,407 @@ D3D12Device::D3D12Device(Window& window) : activeSwapChainBufferIndex(0), vsync(
 
 	// Create Fence
 	{
-		frameFenceValue = 0;
-		if (FAILED(device->CreateFence(frameFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&frameFence))))
+		frameFence.reset(new D3D12Fence());
+		if (!frameFence->Create(device.Get(), commandQueue.Get()))
 			CRITICAL_ERROR("Failed to create frameFence!");
+		frameTimeline.reset(new FenceTimeline(*frameFence, MAX_FRAMES_INFLIGHT));
 
-		// Create an event handle to use for frame synchronization.
-		fenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
-		if (fenceEvent == nullptr)
-		{
-			CRITICAL_ERROR("Failed to create event " << HRESULT_FROM_WIN32(GetLastError()));
-		}
+		copyFence.reset(new D3D12Fence());
+		if (!copyFence->Create(device.Get(), copyCommandQueue.Get()))
+			CRITICAL_ERROR("Failed to create copyFence!");
+		copyTimeline.reset(new FenceTimeline(*copyFence, 1));
 	}
+
+	frameSync.reset(new SwapChainSync(frameLatencyWaitableObject));
+	framePacer.reset(new FramePacer(*frameTimeline, *frameSync, FramePacingMode::Throughput, MAX_FRAMES_INFLIGHT));
+
+	uploadRing.reset(new UploadRing(device.Get(), UPLOAD_RING_SIZE));
+	copyUploadRing.reset(new UploadRing(device.Get(), COPY_UPLOAD_RING_SIZE));
+	textureAllocator.reset(new PlacedTextureAllocator(device.Get(), TEXTURE_HEAP_SIZE));
 }
 
 D3D12Device::~D3D12Device()
 {
 	WaitForIdleGPU();
-	CloseHandle(fenceEvent);
+	deferredReleaseQueue.ReleaseAll();
+	if (frameLatencyWaitableObject)
+		CloseHandle(frameLatencyWaitableObject);
+}
+
+void D3D12Device::SwapChainSync::WaitForSwapChain()
+{
+	// Time out instead of hanging if the swap chain does not retire frames (e.g. while the window is occluded).
+	if (frameLatencyWaitableObject)
+		WaitForSingleObjectEx(frameLatencyWaitableObject, 1000, TRUE);
+}
+
+void D3D12Device::BeginFrame()
+{
+	framePacer->BeginFrame();
+	ReclaimCompleted();
+
+	activeSwapChainBufferIndex = swapChain->GetCurrentBackBufferIndex();
 }
 
 void D3D12Device::Present()
 {
 	swapChain->Present(vsync ? 1 : 0, 0);
-	SignalFrameFence();
+	SignalFrameTimeline(true);
+	framePacer->Present();
 }
 
 unsigned int D3D12Device::GetNumFramesInFlight()
 {
-	return static_cast<unsigned int>(frameFenceValue - frameFence->GetCompletedValue());
+	return frameTimeline->GetNumFramesInFlight();
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE D3D12Device::GetCurrentSwapChainBufferRTVDesc()
+void D3D12Device::ReclaimCompleted()
 {
-	return CD3DX12_CPU_DESCRIPTOR_HANDLE(backbufferDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), activeSwapChainBufferIndex, descriptorSize[D3D12_DESCRIPTOR_HEAP_TYPE_RTV]);
+	UINT64 completedValue = frameTimeline->GetCompletedValue();
+	uploadRing->Reclaim(completedValue);
+	deferredReleaseQueue.Reclaim(completedValue);
+	copyUploadRing->Reclaim(copyTimeline->GetCompletedValue());
 }
 
-void D3D12Device::SignalFrameFence()
+UINT64 D3D12Device::SignalFrameTimeline(bool endOfFrame)
 {
-	// Signal and increment the frameFence value.
-	frameFenceValue++;
-	if (FAILED(commandQueue->Signal(frameFence.Get(), frameFenceValue)))
-		CRITICAL_ERROR("Failed to signal command queue.");
+	UINT64 value = endOfFrame ? frameTimeline->SignalFrame() : frameTimeline->Signal();
+
+	// All upload memory handed out so far is used by commands that were submitted before this signal.
+	uploadRing->FinishAllocations(value);
+	return value;
 }
 
 void D3D12Device::WaitForFreeInflightFrame()
 {
-	if (GetNumFramesInFlight() >= MAX_FRAMES_INFLIGHT)
-	{
-		if (FAILED(frameFence->SetEventOnCompletion(frameFenceValue - MAX_FRAMES_INFLIGHT + 1, fenceEvent)))
-			CRITICAL_ERROR("Failed to set event for WaitForFreeInflightFrame.");
-		WaitForSingleObject(fenceEvent, INFINITE);
-	}
+	framePacer->EndFrame();
+	ReclaimCompleted();
 
 	activeSwapChainBufferIndex = swapChain->GetCurrentBackBufferIndex();
 }
 
+void D3D12Device::SetMaxFramesInFlight(unsigned int numFrames)
+{
+	framePacer->SetMaxFramesInFlight(numFrames > MAX_FRAMES_INFLIGHT ? MAX_FRAMES_INFLIGHT : numFrames);
+	if (FAILED(swapChain->SetMaximumFrameLatency(framePacer->GetMaxFramesInFlight())))
+		CRITICAL_ERROR("Failed to set maximum frame latency");
+}
+
 void D3D12Device::WaitForIdleGPU()
 {
 	// Adds a signal to the frame-fence to ensure that all operations so fare are completed.
-	SignalFrameFence();
+	// It does not belong to a frame, so it does not delay reusing any frame slot.
+	UINT64 value = SignalFrameTimeline(false);
+
+	// Wait until all inflight frames and copies are finished.
+	FenceTimeline* timelines[] = { frameTimeline.get(), copyTimeline.get() };
+	uint64_t values[] = { value, copyTimeline->GetLastSignaledValue() };
+	FenceTimeline::WaitForAll(timelines, values, 2);
+	ReclaimCompleted();
+
+	activeSwapChainBufferIndex = swapChain->GetCurrentBackBufferIndex();
+}
+
+bool D3D12Device::AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	return AllocateFromUploadRing(*uploadRing, *frameTimeline, size, alignment, outAllocation);
+}
+
+bool D3D12Device::AllocateCopyUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	return AllocateFromUploadRing(*copyUploadRing, *copyTimeline, size, alignment, outAllocation);
+}
+
+bool D3D12Device::AllocateFromUploadRing(UploadRing& ring, FenceTimeline& timeline, uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	ring.Reclaim(timeline.GetCompletedValue());
 
-	// Wait until all inflight frames are finished.
-	if (frameFence->GetCompletedValue() < frameFenceValue)
+	UploadRing::Allocation allocation;
+	while (!ring.Allocate(size, alignment, allocation))
 	{
-		if (FAILED(frameFence->SetEventOnCompletion(frameFenceValue, fenceEvent)))
-			CRITICAL_ERROR("Failed to set event for WaitForIdleGPU.");
-		WaitForSingleObject(fenceEvent, INFINITE);
+		// Ring is full, wait for the oldest pending chunk to complete.
+		// If there is none, the allocations that are not yet submitted take up all the space.
+		UINT64 oldestFenceValue;
+		if (!ring.GetOldestPendingFenceValue(oldestFenceValue))
+			return false;
+		timeline.Wait(oldestFenceValue);
+		ring.Reclaim(timeline.GetCompletedValue());
 	}
 
-	activeSwapChainBufferIndex = swapChain->GetCurrentBackBufferIndex();
+	outAllocation.buffer = ToRenderHandle(allocation.resource);
+	outAllocation.offset = allocation.offset;
+	outAllocation.cpuAddress = allocation.cpuAddress;
+	return true;
+}
+
+std::unique_ptr<RenderCommandList> D3D12Device::CreateCommandList()
+{
+	std::unique_ptr<D3D12CommandList> commandList(new D3D12CommandList());
+	if (!commandList->Create(device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT))
+	{
+		std::cerr << "Failed to create command list." << std::endl;
+		return nullptr;
+	}
+	return std::move(commandList);
+}
+
+std::unique_ptr<RenderCommandList> D3D12Device::CreateCopyCommandList()
+{
+	std::unique_ptr<D3D12CommandList> commandList(new D3D12CommandList());
+	if (!commandList->Create(device.Get(), D3D12_COMMAND_LIST_TYPE_COPY))
+	{
+		std::cerr << "Failed to create copy command list." << std::endl;
+		return nullptr;
+	}
+	return std::move(commandList);
+}
+
+void D3D12Device::ExecuteCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists)
+{
+	const unsigned int batchSize = 16;
+	ID3D12CommandList* ppCommandLists[batchSize];
+	for (unsigned int batchBegin = 0; batchBegin < numCommandLists; batchBegin += batchSize)
+	{
+		unsigned int numBatchLists = numCommandLists - batchBegin < batchSize ? numCommandLists - batchBegin : batchSize;
+		for (unsigned int i = 0; i < numBatchLists; ++i)
+			ppCommandLists[i] = static_cast<D3D12CommandList*>(commandLists[batchBegin + i])->GetD3D12CommandList();
+		commandQueue->ExecuteCommandLists(numBatchLists, ppCommandLists);
+	}
+}
+
+uint64_t D3D12Device::ExecuteCopyCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists)
+{
+	const unsigned int batchSize = 16;
+	ID3D12CommandList* ppCommandLists[batchSize];
+	for (unsigned int batchBegin = 0; batchBegin < numCommandLists; batchBegin += batchSize)
+	{
+		unsigned int numBatchLists = numCommandLists - batchBegin < batchSize ? numCommandLists - batchBegin : batchSize;
+		for (unsigned int i = 0; i < numBatchLists; ++i)
+			ppCommandLists[i] = static_cast<D3D12CommandList*>(commandLists[batchBegin + i])->GetD3D12CommandList();
+		copyCommandQueue->ExecuteCommandLists(numBatchLists, ppCommandLists);
+	}
+
+	// All copy upload memory handed out so far is read by the lists that were just submitted.
+	UINT64 value = copyTimeline->Signal();
+	copyUploadRing->FinishAllocations(value);
+	return value;
+}
+
+RenderHandle D3D12Device::GetCurrentBackbuffer()
+{
+	return ToRenderHandle(backbufferRenderTargets[activeSwapChainBufferIndex].Get());
+}
+
+RenderHandle D3D12Device::GetCurrentBackbufferRenderTargetView()
+{
+	return ToRenderHandle(CD3DX12_CPU_DESCRIPTOR_HANDLE(backbufferDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), activeSwapChainBufferIndex, descriptorSize[D3D12_DESCRIPTOR_HEAP_TYPE_RTV]));
+}
+
+RenderHandle D3D12Device::AddObject(ID3D12Object* object, uint64_t sizeInBytes)
+{
+	RenderHandle handle = ToRenderHandle(object);
+	Object& entry = objects[handle];
+	entry.object = object;
+	entry.sizeInBytes = sizeInBytes;
+	return handle;
+}
+
+void D3D12Device::ReleaseObject(RenderHandle handle)
+{
+	auto object = objects.find(handle);
+	if (object == objects.end())
+	{
+		std::cerr << "ReleaseObject: Unknown or already released object." << std::endl;
+		return;
+	}
+	auto textureAllocation = textureAllocations.find(handle);
+	if (textureAllocation != textureAllocations.end())
+	{
+		// The texture's range in its heap is given back once the GPU is done with the texture, the heap possibly with it.
+		ComPtr<ID3D12Object> texture = std::move(object->second.object);
+		HeapPacker::Allocation allocation = textureAllocation->second;
+		deferredReleaseQueue.Enqueue(frameTimeline->GetLastSignaledValue() + 1, object->second.sizeInBytes, [this, texture, allocation]() mutable {
+			texture.Reset();
+			textureAllocator->Free(allocation);
+		});
+		textureAllocations.erase(textureAllocation);
+	}
+	else
+		DeferRelease(std::move(object->second.object), object->second.sizeInBytes);
+	objects.erase(object);
+}
+
+void D3D12Device::DeferRelease(ComPtr<ID3D12Object> object, uint64_t sizeInBytes)
+{
+	// Commands that are submitted before the next signal may still use the object.
+	deferredReleaseQueue.Enqueue(frameTimeline->GetLastSignaledValue() + 1, sizeInBytes, [object]() mutable { object.Reset(); });
+}
+
+RenderHandle D3D12Device::CreateBuffer(uint64_t size, ResourceState initialState)
+{
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	ComPtr<ID3D12Resource> buffer;
+	if (FAILED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, ToD3D12ResourceState(initialState), nullptr, IID_PPV_ARGS(&buffer))))
+		return INVALID_RENDER_HANDLE;
+	return AddObject(buffer.Get(), size);
+}
+
+RenderHandle D3D12Device::CreateReadbackBuffer(uint64_t size)
+{
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_READBACK);
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	ComPtr<ID3D12Resource> buffer;
+	if (FAILED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&buffer))))
+		return INVALID_RENDER_HANDLE;
+	return AddObject(buffer.Get(), size);
+}
+
+const void* D3D12Device::MapReadbackBuffer(RenderHandle buffer, uint64_t readBegin, uint64_t readEnd)
+{
+	D3D12_RANGE readRange = { static_cast<SIZE_T>(readBegin), static_cast<SIZE_T>(readEnd) };
+	void* mappedData;
+	if (FAILED(FromRenderHandle<ID3D12Resource>(buffer)->Map(0, &readRange, &mappedData)))
+		return nullptr;
+	return mappedData;
+}
+
+void D3D12Device::UnmapReadbackBuffer(RenderHandle buffer)
+{
+	// Nothing was written.
+	D3D12_RANGE writtenRange = { 0, 0 };
+	FromRenderHandle<ID3D12Resource>(buffer)->Unmap(0, &writtenRange);
+}
+
+RenderHandle D3D12Device::CreateTexture(const TextureDesc& desc, ResourceState initialState)
+{
+	D3D12_RESOURCE_DESC textureDesc = ToD3D12ResourceDesc(desc);
+	ComPtr<ID3D12Resource> texture;
+	HeapPacker::Allocation allocation;
+	if (!textureAllocator->CreateTexture(textureDesc, ToD3D12ResourceState(initialState), texture, allocation))
+		return INVALID_RENDER_HANDLE;
+	RenderHandle handle = AddObject(texture.Get(), allocation.size);
+	textureAllocations[handle] = allocation;
+	return handle;
+}
+
+void D3D12Device::GetTextureFootprint(const TextureDesc& desc, TextureFootprint& outFootprint)
+{
+	D3D12_RESOURCE_DESC textureDesc = ToD3D12ResourceDesc(desc);
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT placedFootprint;
+	UINT numRows;
+	UINT64 rowSizeInBytes;
+	UINT64 totalSize;
+	device->GetCopyableFootprints(&textureDesc, 0, 1, 0, &placedFootprint, &numRows, &rowSizeInBytes, &totalSize);
+
+	outFootprint.offset = 0;
+	outFootprint.format = desc.format;
+	outFootprint.width = placedFootprint.Footprint.Width;
+	outFootprint.height = placedFootprint.Footprint.Height;
+	outFootprint.rowPitch = placedFootprint.Footprint.RowPitch;
+	outFootprint.numRows = numRows;
+	outFootprint.rowSizeInBytes = rowSizeInBytes;
+	outFootprint.totalSize = totalSize;
+}
+
+uint64_t D3D12Device::GetTextureMemoryCommitted() const
+{
+	return textureAllocator->GetCommittedSize();
+}
+
+uint64_t D3D12Device::GetTextureMemoryUsed() const
+{
+	return textureAllocator->GetUsedSize();
+}
+
+RenderHandle D3D12Device::CreateDescriptorHeap(unsigned int numDescriptors)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc;
+	descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	descriptorHeapDesc.NumDescriptors = numDescriptors;
+	descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	descriptorHeapDesc.NodeMask = 1;
+	ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+	if (FAILED(device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&descriptorHeap))))
+		return INVALID_RENDER_HANDLE;
+	return AddObject(descriptorHeap.Get(), static_cast<uint64_t>(numDescriptors) * descriptorSize[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]);
+}
+
+void D3D12Device::CreateTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc)
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = ToDXGIFormat(desc.format);
+	if (desc.arraySize > 1)
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MipLevels = 1;
+		srvDesc.Texture2DArray.FirstArraySlice = 0;
+		srvDesc.Texture2DArray.ArraySize = desc.arraySize;
+	}
+	else
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MipLevels = 1;
+	}
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE descriptor(FromRenderHandle<ID3D12DescriptorHeap>(descriptorHeap)->GetCPUDescriptorHandleForHeapStart(),
+											descriptorIndex, descriptorSize[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]);
+	device->CreateShaderResourceView(FromRenderHandle<ID3D12Resource>(texture), &srvDesc, descriptor);
+}
+
+void D3D12Device::CreateTextureUnorderedAccessView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc)
+{
+	// Texture2DArray views work for single textures as well, so that shaders do not need a variant per binding.
+	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.Format = ToDXGIFormat(desc.format);
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
+	uavDesc.Texture2DArray.MipSlice = 0;
+	uavDesc.Texture2DArray.FirstArraySlice = 0;
+	uavDesc.Texture2DArray.ArraySize = desc.arraySize;
+	uavDesc.Texture2DArray.PlaneSlice = 0;
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE descriptor(FromRenderHandle<ID3D12DescriptorHeap>(descriptorHeap)->GetCPUDescriptorHandleForHeapStart(),
+											descriptorIndex, descriptorSize[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]);
+	device->CreateUnorderedAccessView(FromRenderHandle<ID3D12Resource>(texture), nullptr, &uavDesc, descriptor);
+}
+
+RenderHandle D3D12Device::CreateIndirectDrawSignature(RenderHandle rootSignature, unsigned int drawIDRootParameterIndex)
+{
+	// Each command sets the DrawID root constant and draws.
+	D3D12_INDIRECT_ARGUMENT_DESC argumentDescs[2] = {};
+	argumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+	argumentDescs[0].Constant.RootParameterIndex = drawIDRootParameterIndex;
+	argumentDescs[0].Constant.DestOffsetIn32BitValues = 0;
+	argumentDescs[0].Constant.Num32BitValuesToSet = 1;
+	argumentDescs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+	D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {};
+	commandSignatureDesc.ByteStride = sizeof(IndirectDrawCommand);
+	commandSignatureDesc.NumArgumentDescs = _countof(argumentDescs);
+	commandSignatureDesc.pArgumentDescs = argumentDescs;
+	// Root signature is required since the command signature changes root arguments.
+	ComPtr<ID3D12CommandSignature> commandSignature;
+	if (FAILED(device->CreateCommandSignature(&commandSignatureDesc, FromRenderHandle<ID3D12RootSignature>(rootSignature), IID_PPV_ARGS(&commandSignature))))
+		return INVALID_RENDER_HANDLE;
+	return AddObject(commandSignature.Get(), 0);
+}
+
+RenderHandle D3D12Device::CreateTimestampQueryHeap(unsigned int numQueries)
+{
+	D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = numQueries;
+	ComPtr<ID3D12QueryHeap> queryHeap;
+	if (FAILED(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&queryHeap))))
+		return INVALID_RENDER_HANDLE;
+	return AddObject(queryHeap.Get(), static_cast<uint64_t>(numQueries) * sizeof(uint64_t));
+}
+
+uint64_t D3D12Device::GetTimestampFrequency()
+{
+	UINT64 frequency = 0;
+	if (FAILED(commandQueue->GetTimestampFrequency(&frequency)))
+		return 0;
+	return frequency;
 }
\ No newline at end of file
@@ -3,78 +3,198 @@
 #include <wrl.h>
 #include <d3d12.h>
 #include <dxgi1_4.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "UploadRing.h"
+#include "FramePacer.h"
+#include "FenceTimeline.h"
+#include "HeapPacker.h"
 
 using namespace Microsoft::WRL;
 
 class Window;
+class PlacedTextureAllocator;
+class D3D12Fence;
 
 #ifdef _DEBUG
 	#define D3DDEBUG
 #endif
 
-class D3D12Device
+/// RenderDevice on top of D3D12 with a swap chain for a window.
+///
+/// Frames are paced by a FramePacer on the frame fence and the swap chain's frame latency waitable object.
+/// Copy lists run on a separate D3D12_COMMAND_LIST_TYPE_COPY queue with its own fence and upload ring.
+class D3D12Device : public RenderDevice
 {
 public:
-	D3D12Device(Window& window);
+	/// numBackbuffers is clamped to [MIN_BACKBUFFERS, MAX_BACKBUFFERS].
+	D3D12Device(Window& window, unsigned int numBackbuffers);
 	~D3D12Device();
 
+	/// Waits for the swap chain and a free inflight frame in FramePacingMode::Latency.
+	void BeginFrame() override;
+
 	/// Swaps backbuffer. Might stall for activated V-Sync.
-	/// Signals the internal frameFence that is used to determine how many frames are inflight.
+	/// Signals the frame on the frameTimeline that is used to determine how many frames are inflight.
 	/// Does not call any additional wait function (like WaitForFreeInflightFrame)
-	void Present();
+	void Present() override;
 
 	/// Returns how many frames are currently in-flight.
 	/// This means how many frames the CPU has prepared but are not yet completed by the GPU.
-	unsigned int GetNumFramesInFlight();
+	unsigned int GetNumFramesInFlight() override;
+
+	/// Waits until only GetMaxFramesInFlight()-1 frames are inflight in FramePacingMode::Throughput.
+	void WaitForFreeInflightFrame() override;
+
+	/// Waits until all prepared frames are renderd and the GPU has no more tasks, including copies.
+	void WaitForIdleGPU() override;
+
+	/// Limits the number of frames in flight below MAX_FRAMES_INFLIGHT. Frame resources are still allocated for MAX_FRAMES_INFLIGHT frames.
+	/// Also used as the maximum frame latency of the swap chain.
+	void SetMaxFramesInFlight(unsigned int numFrames) override;
+	unsigned int GetMaxFramesInFlight() const override				{ return framePacer->GetMaxFramesInFlight(); }
+	void SetFramePacingMode(FramePacingMode mode) override			{ framePacer->SetMode(mode); }
+	FramePacingMode GetFramePacingMode() const override				{ return framePacer->GetMode(); }
+
+	/// Last value signaled on the frame timeline. Everything submitted so far is done once GetCompletedFenceValue reaches it.
+	uint64_t GetLastSignaledFenceValue() const override				{ return frameTimeline->GetLastSignaledValue(); }
+	uint64_t GetCompletedFenceValue() const override				{ return frameTimeline->GetCompletedValue(); }
+
+	std::unique_ptr<RenderCommandList> CreateCommandList() override;
+	void ExecuteCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists) override;
+
+	std::unique_ptr<RenderCommandList> CreateCopyCommandList() override;
+	/// Signals the copy timeline and ends the current chunk of the copy upload ring with the signaled value.
+	uint64_t ExecuteCopyCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists) override;
+	void QueueWaitForCopy(uint64_t copyFenceValue) override			{ frameTimeline->QueueWait(*copyTimeline, copyFenceValue); }
+	void WaitForCopy(uint64_t copyFenceValue) override				{ copyTimeline->Wait(copyFenceValue); }
+	uint64_t GetCompletedCopyFenceValue() const override			{ return copyTimeline->GetCompletedValue(); }
+
+	unsigned int GetBackbufferWidth() const override				{ return backbufferWidth; }
+	unsigned int GetBackbufferHeight() const override				{ return backbufferHeight; }
+	/// Returns the currently targeted swap chain buffer (= "backbuffer")
+	RenderHandle GetCurrentBackbuffer() override;
+	RenderHandle GetCurrentBackbufferRenderTargetView() override;
+
+	/// Allocates memory from the upload ring that stays valid until the next frame fence signal has been passed by the GPU.
+	/// Waits for the GPU if the ring is full. Returns false if the ring is too small for the requested allocation.
+	bool AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation) override;
+	/// Bytes of the upload ring that are waiting for the GPU or not yet submitted.
+	uint64_t GetUploadRingUsedSize() const override					{ return uploadRing->GetUsedSize(); }
+	bool AllocateCopyUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation) override;
+
+	RenderHandle CreateBuffer(uint64_t size, ResourceState initialState) override;
+	RenderHandle CreateReadbackBuffer(uint64_t size) override;
+	const void* MapReadbackBuffer(RenderHandle buffer, uint64_t readBegin, uint64_t readEnd) override;
+	void UnmapReadbackBuffer(RenderHandle buffer) override;
+
+	/// Textures are placed resources in large heaps, see PlacedTextureAllocator.
+	RenderHandle CreateTexture(const TextureDesc& desc, ResourceState initialState) override;
+	void GetTextureFootprint(const TextureDesc& desc, TextureFootprint& outFootprint) override;
+	uint64_t GetTextureMemoryCommitted() const override;
+	uint64_t GetTextureMemoryUsed() const override;
+
+	RenderHandle CreateDescriptorHeap(unsigned int numDescriptors) override;
+	void CreateTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc) override;
+	void CreateTextureUnorderedAccessView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc) override;
 
-	/// Waits until only MAX_FRAMES_INFLIGHT-1 frames are inflight so that a set of frame resources are available.
-	void WaitForFreeInflightFrame();
+	RenderHandle CreateIndirectDrawSignature(RenderHandle rootSignature, unsigned int drawIDRootParameterIndex) override;
 
-	/// Waits until all prepared frames are renderd and the GPU has no more tasks.
-	void WaitForIdleGPU();
+	RenderHandle CreateTimestampQueryHeap(unsigned int numQueries) override;
+	uint64_t GetTimestampFrequency() override;
+
+	void ReleaseObject(RenderHandle handle) override;
+	const DeferredReleaseQueue::Statistics& GetDeferredReleaseStatistics() const override	{ return deferredReleaseQueue.GetStatistics(); }
+	/// Like ReleaseObject, for objects that were not created via the RenderDevice interface, e.g. replaced pipeline states.
+	void DeferRelease(ComPtr<ID3D12Object> object, uint64_t sizeInBytes);
 
 
 	ID3D12Device* GetD3D12Device() const					{ return device.Get(); }
 	ID3D12CommandQueue* GetDirectCommandQueue() const		{ return commandQueue.Get(); }
+	ID3D12CommandQueue* GetCopyCommandQueue() const			{ return copyCommandQueue.Get(); }
+	/// Timeline of the direct queue.
+	FenceTimeline& GetFrameTimeline()						{ return *frameTimeline; }
 	unsigned int GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type) { return descriptorSize[type]; }
 
-	/// Returns the currently targeted swap chain buffer (= "backbuffer")
-	ID3D12Resource* GetCurrentSwapChainBuffer()				{ return backbufferRenderTargets[activeSwapChainBufferIndex].Get(); }
-	D3D12_CPU_DESCRIPTOR_HANDLE GetCurrentSwapChainBufferRTVDesc();
-
 
 
 	// There are two Syncs in the pipeline: CPU -> GPU and GPU -> Screen. 
 
-	/// How many backbuffers are there (important for GPU -> Screen synchronization).
-	/// The more, the more frames can the GPU prepare that will later be shown by the screen.
-	/// (Needs to be bigger than 0)
-	static const unsigned int SWAPCHAINBUFFERCOUNT = 3;
-	/// How many frames can be maximal in-flight (important from CPU -> GPU synchronization)
-	/// The more, the more command-queues can the CPU prepare that will executed / rendered to the next backbuffer.
-	/// (Needs to be bigger than 0)
-	static const unsigned int MAX_FRAMES_INFLIGHT = 3; 
+	// How many backbuffers there are (important for GPU -> Screen synchronization) is given at construction.
+	// The more, the more frames can the GPU prepare that will later be shown by the screen.
+	// How many frames can be maximal in-flight (important from CPU -> GPU synchronization) is given by RenderDevice::MAX_FRAMES_INFLIGHT.
+
+	/// Size of the persistently mapped upload ring in bytes.
+	static const UINT64 UPLOAD_RING_SIZE = 16 * 1024 * 1024;
+	/// Size of the upload ring of the copy queue in bytes.
+	static const UINT64 COPY_UPLOAD_RING_SIZE = 16 * 1024 * 1024;
+	/// Size of the heaps textures are placed in.
+	static const UINT64 TEXTURE_HEAP_SIZE = 4 * 1024 * 1024;
 
 private:
-	void SignalFrameFence();
+	/// Lets the FramePacer wait on the frame latency waitable object.
+	class SwapChainSync : public FramePacer::Sync
+	{
+	public:
+		SwapChainSync(HANDLE _frameLatencyWaitableObject) : frameLatencyWaitableObject(_frameLatencyWaitableObject) {}
+
+		void WaitForSwapChain() override;
+
+	private:
+		HANDLE frameLatencyWaitableObject;
+	};
+
+	/// Signals the frame timeline, ends the current chunk of the upload ring with the signaled value and returns it.
+	UINT64 SignalFrameTimeline(bool endOfFrame);
+
+	/// Allocates from ring, waiting on timeline for its oldest chunk while it is full.
+	static bool AllocateFromUploadRing(UploadRing& ring, FenceTimeline& timeline, uint64_t size, uint64_t alignment, UploadAllocation& outAllocation);
+
+	/// Keeps a created object alive until it is released and returns its handle. sizeInBytes is reported by the deferred release statistics.
+	RenderHandle AddObject(ID3D12Object* object, uint64_t sizeInBytes);
+	/// Reclaims upload memory and releases objects the GPU is done with.
+	void ReclaimCompleted();
 
 	unsigned int activeSwapChainBufferIndex; ///< The backbuffer/swapchainbuffer index on which the GPU currently works.
+	unsigned int backbufferWidth;
+	unsigned int backbufferHeight;
 
 	ComPtr<ID3D12Device> device;
 	ComPtr<IDXGISwapChain3> swapChain;
 	ComPtr<ID3D12CommandQueue> commandQueue;
 	ComPtr<ID3D12CommandAllocator> commandAllocator;
+	ComPtr<ID3D12CommandQueue> copyCommandQueue;
 
-	ComPtr<ID3D12Resource> backbufferRenderTargets[SWAPCHAINBUFFERCOUNT]; ///< Resource interface to swap chain resources.
+	std::vector<ComPtr<ID3D12Resource>> backbufferRenderTargets; ///< Resource interface to swap chain resources.
 	ComPtr<ID3D12DescriptorHeap> backbufferDescriptorHeap;
 	ComPtr<ID3D12RootSignature> rootSignature;
 	
 	unsigned int descriptorSize[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
-	ComPtr<ID3D12Fence> frameFence;
-	UINT64 frameFenceValue; ///< Value of the last signal given to the frameFence. This is not a frame counter since it is also used otherwise!
-	HANDLE fenceEvent;
+	std::unique_ptr<D3D12Fence> frameFence;
+	std::unique_ptr<FenceTimeline> frameTimeline; ///< Values of the frameFence. Frames and their slots are tracked separately from other signals.
+	HANDLE frameLatencyWaitableObject; ///< Signaled when the swap chain accepts another frame.
+
+	std::unique_ptr<D3D12Fence> copyFence;
+	std::unique_ptr<FenceTimeline> copyTimeline; ///< Values of the copyFence. The copy queue has no frames, it only uses plain signals.
+
+	std::unique_ptr<SwapChainSync> frameSync;
+	std::unique_ptr<FramePacer> framePacer;
+
+	std::unique_ptr<UploadRing> uploadRing;
+	std::unique_ptr<UploadRing> copyUploadRing;	///< Reclaimed on the copy timeline.
+	std::unique_ptr<PlacedTextureAllocator> textureAllocator;
+	struct Object
+	{
+		ComPtr<ID3D12Object> object;
+		uint64_t sizeInBytes;
+	};
+	std::unordered_map<RenderHandle, Object> objects;	///< All objects created via the RenderDevice interface that were not released.
+	std::unordered_map<RenderHandle, HeapPacker::Allocation> textureAllocations;	///< Where the textures in objects are placed in textureAllocator.
+	DeferredReleaseQueue deferredReleaseQueue;
 
 	bool vsync;
 };
-
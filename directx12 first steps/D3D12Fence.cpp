@@ -0,0 +1,48 @@
+#include "D3D12Fence.h"
+
+#include <iostream>
+
+D3D12Fence::D3D12Fence() :
+	event(nullptr)
+{
+}
+
+D3D12Fence::~D3D12Fence()
+{
+	if (event)
+		CloseHandle(event);
+}
+
+bool D3D12Fence::Create(ID3D12Device* device, ID3D12CommandQueue* _commandQueue)
+{
+	commandQueue = _commandQueue;
+	if (FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence))))
+		return false;
+
+	event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+	return event != nullptr;
+}
+
+void D3D12Fence::Signal(uint64_t value)
+{
+	if (FAILED(commandQueue->Signal(fence.Get(), value)))
+		std::cerr << "Failed to signal fence." << std::endl;
+}
+
+void D3D12Fence::WaitForValue(uint64_t value)
+{
+	if (fence->GetCompletedValue() >= value)
+		return;
+	if (FAILED(fence->SetEventOnCompletion(value, event)))
+	{
+		std::cerr << "Failed to set event for fence value " << value << std::endl;
+		return;
+	}
+	WaitForSingleObject(event, INFINITE);
+}
+
+void D3D12Fence::QueueWait(FenceTimeline::Fence& otherFence, uint64_t value)
+{
+	if (FAILED(commandQueue->Wait(static_cast<D3D12Fence&>(otherFence).GetD3D12Fence(), value)))
+		std::cerr << "Failed to let queue wait for fence value " << value << std::endl;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "FenceTimeline.h"
+
+using namespace Microsoft::WRL;
+
+/// FenceTimeline::Fence on top of an ID3D12Fence that is signaled by a single command queue.
+class D3D12Fence : public FenceTimeline::Fence
+{
+public:
+	D3D12Fence();
+	~D3D12Fence();
+
+	/// Returns false if the fence or its event could not be created. The fence starts at 0.
+	bool Create(ID3D12Device* device, ID3D12CommandQueue* commandQueue);
+
+	uint64_t GetCompletedValue() const override		{ return fence->GetCompletedValue(); }
+	void Signal(uint64_t value) override;
+	void WaitForValue(uint64_t value) override;
+	/// otherFence needs to be a D3D12Fence as well.
+	void QueueWait(FenceTimeline::Fence& otherFence, uint64_t value) override;
+
+	ID3D12Fence* GetD3D12Fence() const				{ return fence.Get(); }
+
+private:
+	ComPtr<ID3D12Fence> fence;
+	ComPtr<ID3D12CommandQueue> commandQueue;
+	HANDLE event;
+};
@@ -0,0 +1,65 @@
+#include "DeferredReleaseQueue.h"
+
+DeferredReleaseQueue::DeferredReleaseQueue() :
+	statistics()
+{
+}
+
+DeferredReleaseQueue::~DeferredReleaseQueue()
+{
+	ReleaseAll();
+}
+
+void DeferredReleaseQueue::Enqueue(uint64_t fenceValue, uint64_t sizeInBytes, std::function<void()> release)
+{
+	Entry entry;
+	entry.fenceValue = fenceValue;
+	entry.sizeInBytes = sizeInBytes;
+	entry.handOffTime = std::chrono::high_resolution_clock::now();
+	entry.release = std::move(release);
+	entries.push_back(std::move(entry));
+
+	++statistics.numPending;
+	statistics.pendingBytes += sizeInBytes;
+}
+
+unsigned int DeferredReleaseQueue::Reclaim(uint64_t completedFenceValue)
+{
+	if (entries.empty() || entries.front().fenceValue > completedFenceValue)
+		return 0;
+
+	auto now = std::chrono::high_resolution_clock::now();
+	unsigned int numReleased = 0;
+	while (!entries.empty() && entries.front().fenceValue <= completedFenceValue)
+	{
+		ReleaseFront(now);
+		++numReleased;
+	}
+	return numReleased;
+}
+
+void DeferredReleaseQueue::ReleaseAll()
+{
+	auto now = std::chrono::high_resolution_clock::now();
+	while (!entries.empty())
+		ReleaseFront(now);
+}
+
+void DeferredReleaseQueue::ReleaseFront(std::chrono::high_resolution_clock::time_point now)
+{
+	Entry& entry = entries.front();
+	if (entry.release)
+		entry.release();
+
+	double latencyMilliseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - entry.handOffTime).count() / 1000.0 / 1000.0;
+	--statistics.numPending;
+	statistics.pendingBytes -= entry.sizeInBytes;
+	++statistics.numReleased;
+	statistics.releasedBytes += entry.sizeInBytes;
+	statistics.lastReleaseLatencyMilliseconds = latencyMilliseconds;
+	if (latencyMilliseconds > statistics.maxReleaseLatencyMilliseconds)
+		statistics.maxReleaseLatencyMilliseconds = latencyMilliseconds;
+	statistics.totalReleaseLatencyMilliseconds += latencyMilliseconds;
+
+	entries.pop_front();
+}
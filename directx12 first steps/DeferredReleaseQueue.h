@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+/// Keeps objects that were handed off for destruction alive until the GPU passed the fence value that was current at hand-off.
+///
+/// The release callback is what actually destroys the object, typically by dropping the last reference. Since fence values of one queue
+/// only grow, entries are kept in hand-off order and released from the front, like the chunks of a RingAllocator.
+/// Independent of D3D12 and Windows.
+class DeferredReleaseQueue
+{
+public:
+	struct Statistics
+	{
+		uint64_t numPending;
+		uint64_t pendingBytes;					///< Memory of pending objects that is not yet available again.
+		uint64_t numReleased;
+		uint64_t releasedBytes;
+		double lastReleaseLatencyMilliseconds;	///< Time between hand-off and release of the last released object.
+		double maxReleaseLatencyMilliseconds;
+		double totalReleaseLatencyMilliseconds;	///< Divide by numReleased for the average.
+	};
+
+	DeferredReleaseQueue();
+	/// Releases everything that is still pending. Only safe if the GPU is idle.
+	~DeferredReleaseQueue();
+
+	/// release is called once Reclaim is called with a completed fence value of at least fenceValue.
+	/// fenceValue needs to be at least as large as the one of the previous hand-off.
+	void Enqueue(uint64_t fenceValue, uint64_t sizeInBytes, std::function<void()> release);
+
+	/// Releases everything whose fence value is smaller or equal than completedFenceValue. Returns the number of released objects.
+	unsigned int Reclaim(uint64_t completedFenceValue);
+	/// Releases everything regardless of the fence. Only safe if the GPU is idle.
+	void ReleaseAll();
+
+	const Statistics& GetStatistics() const		{ return statistics; }
+
+private:
+	struct Entry
+	{
+		uint64_t fenceValue;
+		uint64_t sizeInBytes;
+		std::chrono::high_resolution_clock::time_point handOffTime;
+		std::function<void()> release;
+	};
+
+	void ReleaseFront(std::chrono::high_resolution_clock::time_point now);
+
+	std::deque<Entry> entries;
+	Statistics statistics;
+};
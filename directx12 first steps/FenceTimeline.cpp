@@ -0,0 +1,82 @@
+#include "FenceTimeline.h"
+
+FenceTimeline::FenceTimeline(Fence& _fence, unsigned int numFrameSlots) :
+	fence(_fence),
+	lastSignaledValue(_fence.GetCompletedValue()),
+	completedValue(_fence.GetCompletedValue()),
+	numFrames(0),
+	frameSlotValues(numFrameSlots < 1 ? 1 : numFrameSlots, 0)
+{
+}
+
+uint64_t FenceTimeline::Signal()
+{
+	++lastSignaledValue;
+	fence.Signal(lastSignaledValue);
+	return lastSignaledValue;
+}
+
+uint64_t FenceTimeline::SignalFrame()
+{
+	uint64_t value = Signal();
+	frameSlotValues[GetCurrentFrameSlot()] = value;
+	++numFrames;
+	return value;
+}
+
+uint64_t FenceTimeline::GetCompletedValue() const
+{
+	uint64_t value = fence.GetCompletedValue();
+	// Fences only move forward, a smaller value would mean a removed device.
+	if (value > completedValue)
+		completedValue = value;
+	return completedValue;
+}
+
+bool FenceTimeline::IsComplete(uint64_t value) const
+{
+	return value <= completedValue || value <= GetCompletedValue();
+}
+
+void FenceTimeline::Wait(uint64_t value)
+{
+	if (IsComplete(value))
+		return;
+	fence.WaitForValue(value);
+	if (value > completedValue)
+		completedValue = value;
+}
+
+void FenceTimeline::WaitForAll(FenceTimeline* const* timelines, const uint64_t* values, unsigned int count)
+{
+	// All values have to be reached anyway, so waiting for them one after another blocks exactly as long as waiting for all at once.
+	for (unsigned int i = 0; i < count; ++i)
+		timelines[i]->Wait(values[i]);
+}
+
+void FenceTimeline::QueueWait(const FenceTimeline& otherTimeline, uint64_t value)
+{
+	if (otherTimeline.IsComplete(value))
+		return;
+	fence.QueueWait(otherTimeline.fence, value);
+}
+
+uint64_t FenceTimeline::GetFrameValue(unsigned int framesAgo) const
+{
+	if (framesAgo >= numFrames || framesAgo >= frameSlotValues.size())
+		return 0;
+	uint64_t frame = numFrames - 1 - framesAgo;
+	return frameSlotValues[static_cast<size_t>(frame % frameSlotValues.size())];
+}
+
+unsigned int FenceTimeline::GetNumFramesInFlight() const
+{
+	uint64_t completed = GetCompletedValue();
+	unsigned int numFramesInFlight = 0;
+	for (uint64_t value : frameSlotValues)
+	{
+		if (value > completed)
+			++numFramesInFlight;
+	}
+	return numFramesInFlight;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Monotonic fence values of one queue, plus the value every frame slot has to wait for before its resources are reused.
+///
+/// Every Signal hands out the next value. SignalFrame additionally records the value for the current frame slot and moves on to the next
+/// slot, so waits for frame resources target exactly the frame that last used them, no matter how many other signals (uploads, idle waits)
+/// happened in between. The actual fence is behind the Fence interface, so the timeline can run on a mock fence.
+/// Independent of D3D12 and Windows.
+class FenceTimeline
+{
+public:
+	/// Fence of a queue.
+	class Fence
+	{
+	public:
+		virtual ~Fence() {}
+
+		virtual uint64_t GetCompletedValue() const = 0;
+		/// Lets the queue set the fence to value once all previously submitted work is done.
+		virtual void Signal(uint64_t value) = 0;
+		/// Blocks the CPU until the fence reached value.
+		virtual void WaitForValue(uint64_t value) = 0;
+		/// Lets the queue wait (on the GPU, without blocking the CPU) until another fence reached value before it executes further work.
+		virtual void QueueWait(Fence& otherFence, uint64_t value) = 0;
+	};
+
+	/// numFrameSlots is the number of frames with separate resources, e.g. RenderDevice::MAX_FRAMES_INFLIGHT.
+	FenceTimeline(Fence& fence, unsigned int numFrameSlots);
+
+	/// Signals the next value and returns it.
+	uint64_t Signal();
+	/// Signals the next value, records it for the current frame slot and moves on to the next slot.
+	uint64_t SignalFrame();
+	uint64_t GetLastSignaledValue() const						{ return lastSignaledValue; }
+
+	/// Polls the fence, never blocks.
+	uint64_t GetCompletedValue() const;
+	bool IsComplete(uint64_t value) const;
+	/// Blocks until value is complete. Returns right away if it already is.
+	void Wait(uint64_t value);
+	/// Blocks until every timelines[i] completed values[i]. Values that are already complete are skipped without blocking.
+	static void WaitForAll(FenceTimeline* const* timelines, const uint64_t* values, unsigned int count);
+	/// Lets this timeline's queue wait on the GPU until otherTimeline completed value. Skipped if it already is.
+	void QueueWait(const FenceTimeline& otherTimeline, uint64_t value);
+
+	/// Slot the next frame uses. Its resources are free once GetFrameSlotValue of that slot is complete.
+	unsigned int GetCurrentFrameSlot() const					{ return static_cast<unsigned int>(numFrames % frameSlotValues.size()); }
+	unsigned int GetNumFrameSlots() const						{ return static_cast<unsigned int>(frameSlotValues.size()); }
+	/// Value signaled after the last frame that used the slot, 0 if none did.
+	uint64_t GetFrameSlotValue(unsigned int slot) const			{ return frameSlotValues[slot]; }
+	/// Blocks until the resources of the current frame slot are free.
+	void WaitForCurrentFrameSlot()								{ Wait(frameSlotValues[GetCurrentFrameSlot()]); }
+	/// Value of the frame that was signaled framesAgo frames before the last one (0 is the last one). 0 if there was none.
+	/// framesAgo needs to be smaller than GetNumFrameSlots().
+	uint64_t GetFrameValue(unsigned int framesAgo) const;
+	/// Frames signaled with SignalFrame that are not yet complete, at most GetNumFrameSlots(). Other signals are not counted.
+	unsigned int GetNumFramesInFlight() const;
+
+	Fence& GetFence() const										{ return fence; }
+
+private:
+	Fence& fence;
+	uint64_t lastSignaledValue;
+	mutable uint64_t completedValue;	///< Last polled value, so that IsComplete can skip polling for values that are known to be complete.
+
+	uint64_t numFrames;
+	std::vector<uint64_t> frameSlotValues;
+};
@@ -0,0 +1,35 @@
+#include "FileWatcher.h"
+
+void FileWatcher::AddFile(const std::string& path)
+{
+	WatchedFile file;
+	file.path = path;
+	file.lastWriteTime = GetLastWriteTime(path);
+	files.push_back(file);
+}
+
+bool FileWatcher::PollChanges()
+{
+	bool changed = false;
+	for (auto& file : files)
+	{
+		FILETIME lastWriteTime = GetLastWriteTime(file.path);
+		if (CompareFileTime(&lastWriteTime, &file.lastWriteTime) != 0)
+		{
+			file.lastWriteTime = lastWriteTime;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+FILETIME FileWatcher::GetLastWriteTime(const std::string& path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		FILETIME none = {};
+		return none;
+	}
+	return attributes.ftLastWriteTime;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <Windows.h>
+
+/// Detects changes of a set of files by polling their last write times.
+///
+/// Polling is cheap enough to be done a few times per second from the main loop and does not need a separate thread.
+class FileWatcher
+{
+public:
+	/// Starts watching a file. Its current state counts as unchanged.
+	void AddFile(const std::string& path);
+
+	/// Returns true if any watched file was written, created or deleted since the last call.
+	bool PollChanges();
+
+private:
+	struct WatchedFile
+	{
+		std::string path;
+		FILETIME lastWriteTime;	///< Zero if the file does not exist.
+	};
+
+	static FILETIME GetLastWriteTime(const std::string& path);
+
+	std::vector<WatchedFile> files;
+};
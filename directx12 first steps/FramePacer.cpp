@@ -0,0 +1,70 @@
+#include "FramePacer.h"
+#include "FenceTimeline.h"
+
+FramePacer::FramePacer(FenceTimeline& _timeline, Sync& _sync, FramePacingMode _mode, unsigned int _maxFramesInFlight) :
+	timeline(_timeline),
+	sync(_sync),
+	mode(_mode),
+	maxFramesInFlight(1),
+	state(State::BetweenFrames),
+	// The swap chain expects a wait before the very first frame as well.
+	waitPending(true),
+	statistics()
+{
+	SetMaxFramesInFlight(_maxFramesInFlight);
+}
+
+void FramePacer::SetMaxFramesInFlight(unsigned int numFrames)
+{
+	// The timeline only remembers the fence values of as many frames as it has slots.
+	maxFramesInFlight = numFrames < 1 ? 1 : (numFrames > timeline.GetNumFrameSlots() ? timeline.GetNumFrameSlots() : numFrames);
+}
+
+void FramePacer::BeginFrame()
+{
+	// Callers that skip EndFrame still get their wait.
+	if (state == State::Presented)
+		EndFrame();
+
+	if (mode == FramePacingMode::Latency && waitPending)
+		Wait();
+	state = State::Recording;
+}
+
+void FramePacer::Present()
+{
+	waitPending = true;
+	++statistics.numFrames;
+	state = State::Presented;
+}
+
+void FramePacer::EndFrame()
+{
+	if (state != State::Presented)
+		return;
+
+	if (mode == FramePacingMode::Throughput && waitPending)
+		Wait();
+	state = State::BetweenFrames;
+}
+
+unsigned int FramePacer::GetNumFramesInFlight() const
+{
+	return timeline.GetNumFramesInFlight();
+}
+
+void FramePacer::Wait()
+{
+	if (mode == FramePacingMode::Latency)
+		sync.WaitForSwapChain();
+
+	// At most maxFramesInFlight - 1 frames may stay in flight, so the frame before those needs to be done.
+	// Waiting for its recorded value instead of counting back from the last signal ignores signals that do not belong to frames.
+	uint64_t value = timeline.GetFrameValue(maxFramesInFlight - 1);
+	if (!timeline.IsComplete(value))
+	{
+		++statistics.numFenceWaits;
+		timeline.Wait(value);
+	}
+	waitPending = false;
+}
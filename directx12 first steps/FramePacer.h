@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+#include "RenderTypes.h"
+
+class FenceTimeline;
+
+/// Decides when the CPU waits for the GPU and the swap chain, so that no more than maxFramesInFlight frames are queued.
+///
+/// Every frame goes through BeginFrame (before recording), Present (after FenceTimeline::SignalFrame) and EndFrame (after presenting).
+/// There is exactly one wait per frame:
+/// - FramePacingMode::Throughput waits in EndFrame for a free in-flight frame only. The CPU runs ahead as far as the fence allows and
+///   Present blocks once the swap chain is full, so frames can queue up in front of the display.
+/// - FramePacingMode::Latency waits in BeginFrame, first until the swap chain accepts another frame and then for a free in-flight frame.
+///   Nothing queues up in front of the display and recording (and input sampling before it) starts as late as possible.
+///
+/// All waiting goes through the FenceTimeline and the Sync interface, so the state machine can be driven by a mock fence and a simulated vblank clock.
+/// Independent of D3D12 and Windows.
+class FramePacer
+{
+public:
+	/// What the pacer waits on besides the fence.
+	class Sync
+	{
+	public:
+		virtual ~Sync() {}
+
+		/// Blocks until the swap chain accepts another frame, e.g. on a frame latency waitable object. Returns right away if there is nothing to wait on.
+		/// Only used in latency mode.
+		virtual void WaitForSwapChain() = 0;
+	};
+
+	enum class State
+	{
+		BetweenFrames,
+		Recording,
+		Presented
+	};
+
+	struct Statistics
+	{
+		uint64_t numFrames;
+		uint64_t numFenceWaits;	///< Frames for which the CPU had to wait for the GPU.
+	};
+
+	/// Frames in flight are counted with the frames signaled on the timeline.
+	FramePacer(FenceTimeline& timeline, Sync& sync, FramePacingMode mode, unsigned int maxFramesInFlight);
+
+	/// Takes effect at the next wait. Switching never waits twice or skips the wait of a frame.
+	void SetMode(FramePacingMode _mode)					{ mode = _mode; }
+	FramePacingMode GetMode() const						{ return mode; }
+	/// Clamped to [1, number of frame slots of the timeline].
+	void SetMaxFramesInFlight(unsigned int numFrames);
+	unsigned int GetMaxFramesInFlight() const			{ return maxFramesInFlight; }
+
+	/// Call before recording a frame. Waits in latency mode.
+	void BeginFrame();
+	/// Call after presenting and signaling the frame on the timeline.
+	void Present();
+	/// Call after Present. Waits in throughput mode.
+	void EndFrame();
+
+	/// Presented frames the GPU has not yet finished.
+	unsigned int GetNumFramesInFlight() const;
+	State GetState() const								{ return state; }
+	const Statistics& GetStatistics() const				{ return statistics; }
+
+private:
+	void Wait();
+
+	FenceTimeline& timeline;
+	Sync& sync;
+	FramePacingMode mode;
+	unsigned int maxFramesInFlight;
+
+	State state;
+	bool waitPending;	///< The wait of the current frame cycle did not happen yet.
+	Statistics statistics;
+};
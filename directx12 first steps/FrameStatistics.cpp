@@ -0,0 +1,168 @@
+#include "FrameStatistics.h"
+
+#include <fstream>
+
+FrameStatistics::FrameStatistics(unsigned int _capacity, double _budgetMilliseconds, double _bucketWidthMilliseconds, unsigned int numBuckets) :
+	frameTimes(_capacity > 0 ? _capacity : 1, 0.0),
+	capacity(_capacity > 0 ? _capacity : 1),
+	nextFrame(0),
+	numFrames(0),
+	sumMilliseconds(0.0),
+	histogram((numBuckets > 0 ? numBuckets : 1) + 1, 0),
+	bucketWidthMilliseconds(_bucketWidthMilliseconds > 0.0 ? _bucketWidthMilliseconds : 0.1),
+	budgetMilliseconds(_budgetMilliseconds),
+	numFramesOverBudget(0),
+	numFramesTotal(0),
+	numFramesOverBudgetTotal(0)
+{
+}
+
+unsigned int FrameStatistics::GetBucket(double milliseconds) const
+{
+	if (milliseconds <= 0.0)
+		return 0;
+	double bucket = milliseconds / bucketWidthMilliseconds;
+	const unsigned int overflowBucket = static_cast<unsigned int>(histogram.size()) - 1;
+	return bucket >= overflowBucket ? overflowBucket : static_cast<unsigned int>(bucket);
+}
+
+void FrameStatistics::AddFrame(double milliseconds)
+{
+	// Once the ring is full, the oldest frame is replaced and removed from all running sums.
+	if (numFrames == capacity)
+	{
+		double oldest = frameTimes[nextFrame];
+		--histogram[GetBucket(oldest)];
+		sumMilliseconds -= oldest;
+		if (oldest > budgetMilliseconds)
+			--numFramesOverBudget;
+	}
+	else
+		++numFrames;
+
+	frameTimes[nextFrame] = milliseconds;
+	nextFrame = (nextFrame + 1) % capacity;
+	++histogram[GetBucket(milliseconds)];
+	sumMilliseconds += milliseconds;
+	++numFramesTotal;
+	if (milliseconds > budgetMilliseconds)
+	{
+		++numFramesOverBudget;
+		++numFramesOverBudgetTotal;
+	}
+}
+
+void FrameStatistics::SetBudget(double _budgetMilliseconds)
+{
+	budgetMilliseconds = _budgetMilliseconds;
+	numFramesOverBudget = 0;
+	for (unsigned int i = 0; i < numFrames; ++i)
+	{
+		if (frameTimes[GetRingIndex(i)] > budgetMilliseconds)
+			++numFramesOverBudget;
+	}
+}
+
+double FrameStatistics::GetPercentile(double percentile) const
+{
+	if (numFrames == 0)
+		return 0.0;
+
+	// Smallest bucket that covers the requested share of frames.
+	double rank = percentile / 100.0 * numFrames;
+	unsigned int numFramesBelow = 0;
+	for (unsigned int bucket = 0; bucket < histogram.size(); ++bucket)
+	{
+		numFramesBelow += histogram[bucket];
+		if (numFramesBelow >= rank && numFramesBelow > 0)
+		{
+			// The overflow bucket has no upper edge.
+			if (bucket == histogram.size() - 1)
+				return GetMax();
+			return (bucket + 1) * bucketWidthMilliseconds;
+		}
+	}
+	return GetMax();
+}
+
+double FrameStatistics::GetAverage() const
+{
+	return numFrames > 0 ? sumMilliseconds / numFrames : 0.0;
+}
+
+double FrameStatistics::GetMin() const
+{
+	if (numFrames == 0)
+		return 0.0;
+	double minMilliseconds = frameTimes[GetRingIndex(0)];
+	for (unsigned int i = 1; i < numFrames; ++i)
+	{
+		double milliseconds = frameTimes[GetRingIndex(i)];
+		if (milliseconds < minMilliseconds)
+			minMilliseconds = milliseconds;
+	}
+	return minMilliseconds;
+}
+
+double FrameStatistics::GetMax() const
+{
+	if (numFrames == 0)
+		return 0.0;
+	double maxMilliseconds = frameTimes[GetRingIndex(0)];
+	for (unsigned int i = 1; i < numFrames; ++i)
+	{
+		double milliseconds = frameTimes[GetRingIndex(i)];
+		if (milliseconds > maxMilliseconds)
+			maxMilliseconds = milliseconds;
+	}
+	return maxMilliseconds;
+}
+
+void FrameStatistics::WriteCsv(std::ostream& stream) const
+{
+	stream << "frame,milliseconds,overBudget\n";
+	const uint64_t firstFrame = numFramesTotal - numFrames;
+	for (unsigned int i = 0; i < numFrames; ++i)
+	{
+		double milliseconds = frameTimes[GetRingIndex(i)];
+		stream << firstFrame + i << ',' << milliseconds << ',' << (milliseconds > budgetMilliseconds ? 1 : 0) << '\n';
+	}
+}
+
+void FrameStatistics::WriteJson(std::ostream& stream) const
+{
+	stream << "{\n";
+	stream << "\t\"numFrames\": " << numFrames << ",\n";
+	stream << "\t\"numFramesTotal\": " << numFramesTotal << ",\n";
+	stream << "\t\"budgetMilliseconds\": " << budgetMilliseconds << ",\n";
+	stream << "\t\"numFramesOverBudget\": " << numFramesOverBudget << ",\n";
+	stream << "\t\"numFramesOverBudgetTotal\": " << numFramesOverBudgetTotal << ",\n";
+	stream << "\t\"minMilliseconds\": " << GetMin() << ",\n";
+	stream << "\t\"avgMilliseconds\": " << GetAverage() << ",\n";
+	stream << "\t\"maxMilliseconds\": " << GetMax() << ",\n";
+	stream << "\t\"p50Milliseconds\": " << GetPercentile(50.0) << ",\n";
+	stream << "\t\"p95Milliseconds\": " << GetPercentile(95.0) << ",\n";
+	stream << "\t\"p99Milliseconds\": " << GetPercentile(99.0) << ",\n";
+	stream << "\t\"frameTimesMilliseconds\": [";
+	for (unsigned int i = 0; i < numFrames; ++i)
+		stream << (i == 0 ? "" : ", ") << frameTimes[GetRingIndex(i)];
+	stream << "]\n}\n";
+}
+
+bool FrameStatistics::WriteCsv(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+	WriteCsv(file);
+	return static_cast<bool>(file);
+}
+
+bool FrameStatistics::WriteJson(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+	WriteJson(file);
+	return static_cast<bool>(file);
+}
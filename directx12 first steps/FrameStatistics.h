@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// Keeps the most recent frame times in a fixed-size ring and derives percentiles from a histogram that is updated along with the ring.
+///
+/// Adding a frame is O(1) and never allocates. Percentiles are accurate to the histogram's bucket width,
+/// frames longer than the histogram's range end up in an overflow bucket.
+///
+/// Independent of D3D12 and Windows.
+class FrameStatistics
+{
+public:
+	/// capacity is the number of most recent frames all statistics refer to, except for GetNumFramesTotal and GetNumFramesOverBudgetTotal.
+	FrameStatistics(unsigned int capacity = 1024, double budgetMilliseconds = 1000.0 / 60.0,
+					double bucketWidthMilliseconds = 0.1, unsigned int numBuckets = 1000);
+
+	void AddFrame(double milliseconds);
+
+	/// Frames that take longer than the budget are counted. Changing it recounts the frames in the ring.
+	void SetBudget(double budgetMilliseconds);
+	double GetBudget() const	{ return budgetMilliseconds; }
+
+	/// Upper edge of the histogram bucket that contains the given percentile (0-100). Returns 0 if there are no frames.
+	double GetPercentile(double percentile) const;
+	double GetAverage() const;
+	double GetMin() const;
+	double GetMax() const;
+
+	/// Frames in the ring.
+	unsigned int GetNumFrames() const				{ return numFrames; }
+	unsigned int GetNumFramesOverBudget() const		{ return numFramesOverBudget; }
+	/// Frames since creation.
+	uint64_t GetNumFramesTotal() const				{ return numFramesTotal; }
+	uint64_t GetNumFramesOverBudgetTotal() const	{ return numFramesOverBudgetTotal; }
+
+	/// One line per frame in the ring, oldest first.
+	void WriteCsv(std::ostream& stream) const;
+	/// Summary and all frames in the ring, oldest first.
+	void WriteJson(std::ostream& stream) const;
+	/// Returns false if the file could not be written.
+	bool WriteCsv(const std::string& path) const;
+	bool WriteJson(const std::string& path) const;
+
+private:
+	unsigned int GetBucket(double milliseconds) const;
+	/// Index in frameTimes of the i-th oldest frame.
+	unsigned int GetRingIndex(unsigned int i) const	{ return (nextFrame + capacity - numFrames + i) % capacity; }
+
+	std::vector<double> frameTimes;
+	unsigned int capacity;
+	unsigned int nextFrame;
+	unsigned int numFrames;
+	double sumMilliseconds;
+
+	std::vector<unsigned int> histogram;	///< Last bucket is the overflow bucket.
+	double bucketWidthMilliseconds;
+
+	double budgetMilliseconds;
+	unsigned int numFramesOverBudget;
+	uint64_t numFramesTotal;
+	uint64_t numFramesOverBudgetTotal;
+};
@@ -0,0 +1,133 @@
+#include "GpuProfiler.h"
+
+#include "RenderDevice.h"
+#include "RenderCommandList.h"
+#include "Helper.h"
+
+GpuProfiler::GpuProfiler(RenderDevice& _device, unsigned int numFramesInFlight) :
+	device(_device),
+	queryHeap(INVALID_RENDER_HANDLE),
+	readbackBuffer(INVALID_RENDER_HANDLE),
+	timestampFrequency(0),
+	frames(numFramesInFlight),
+	currentFrame(0)
+{
+	timestampFrequency = device.GetTimestampFrequency();
+	if (timestampFrequency == 0)
+		CRITICAL_ERROR("Failed to query the timestamp frequency.");
+
+	queryHeap = device.CreateTimestampQueryHeap(MAX_TIMESTAMPS_PER_FRAME * numFramesInFlight);
+	if (queryHeap == INVALID_RENDER_HANDLE)
+		CRITICAL_ERROR("Failed to create timestamp query heap.");
+
+	readbackBuffer = device.CreateReadbackBuffer(sizeof(uint64_t) * MAX_TIMESTAMPS_PER_FRAME * numFramesInFlight);
+	if (readbackBuffer == INVALID_RENDER_HANDLE)
+		CRITICAL_ERROR("Failed to create timestamp readback buffer.");
+
+	for (auto& frame : frames)
+	{
+		frame.scopes.reserve(MAX_TIMESTAMPS_PER_FRAME / 2);
+		frame.numTimestamps = 0;
+		frame.pendingReadback = false;
+	}
+
+	// Has its own allocator for every in-flight frame.
+	resolveCommandList = device.CreateCommandList();
+	if (!resolveCommandList)
+		CRITICAL_ERROR("Failed to create command list");
+}
+
+GpuProfiler::~GpuProfiler()
+{
+}
+
+void GpuProfiler::BeginFrame(unsigned int frameQueueIndex)
+{
+	currentFrame = frameQueueIndex;
+	Frame& frame = frames[currentFrame];
+	if (frame.pendingReadback)
+		ReadBack(frame, currentFrame);
+
+	frame.scopes.clear();
+	frame.numTimestamps = 0;
+	frame.pendingReadback = false;
+}
+
+void GpuProfiler::ReadBack(Frame& frame, unsigned int frameIndex)
+{
+	// Only the part of this frame is read.
+	const uint64_t frameOffset = sizeof(uint64_t) * MAX_TIMESTAMPS_PER_FRAME * frameIndex;
+	const void* mappedData = device.MapReadbackBuffer(readbackBuffer, frameOffset, frameOffset + sizeof(uint64_t) * frame.numTimestamps);
+	if (!mappedData)
+		return;
+
+	const uint64_t* timestamps = reinterpret_cast<const uint64_t*>(static_cast<const uint8_t*>(mappedData) + frameOffset);
+	statistics.AddFrame(frame.scopes, timestamps, timestampFrequency);
+
+	device.UnmapReadbackBuffer(readbackBuffer);
+}
+
+unsigned int GpuProfiler::BeginScope(RenderCommandList& list, const char* name)
+{
+	unsigned int beginTimestamp;
+	unsigned int scope;
+	{
+		std::lock_guard<std::mutex> lock(scopeMutex);
+		Frame& frame = frames[currentFrame];
+		if (frame.numTimestamps + 2 > MAX_TIMESTAMPS_PER_FRAME)
+			return INVALID_SCOPE;
+
+		// Both timestamps are reserved right away, so that scopes of a frame occupy a contiguous range of queries.
+		beginTimestamp = frame.numTimestamps;
+		frame.numTimestamps += 2;
+
+		GpuTimingStatistics::Scope newScope;
+		newScope.name = name;
+		newScope.beginTimestamp = beginTimestamp;
+		newScope.endTimestamp = beginTimestamp + 1;
+		scope = static_cast<unsigned int>(frame.scopes.size());
+		frame.scopes.push_back(newScope);
+	}
+
+	list.WriteTimestamp(queryHeap, MAX_TIMESTAMPS_PER_FRAME * currentFrame + beginTimestamp);
+	return scope;
+}
+
+void GpuProfiler::EndScope(RenderCommandList& list, unsigned int scope)
+{
+	if (scope == INVALID_SCOPE)
+		return;
+
+	unsigned int endTimestamp;
+	{
+		std::lock_guard<std::mutex> lock(scopeMutex);
+		endTimestamp = frames[currentFrame].scopes[scope].endTimestamp;
+	}
+	list.WriteTimestamp(queryHeap, MAX_TIMESTAMPS_PER_FRAME * currentFrame + endTimestamp);
+}
+
+RenderCommandList* GpuProfiler::EndFrame()
+{
+	Frame& frame = frames[currentFrame];
+
+	// The allocator was last used MAX_FRAMES_INFLIGHT frames ago, just like the query range.
+	if (!resolveCommandList->Reset(currentFrame, INVALID_RENDER_HANDLE))
+	{
+		std::cerr << "Failed to reset the profiler command list." << std::endl;
+		return nullptr;
+	}
+	if (frame.numTimestamps > 0)
+	{
+		resolveCommandList->ResolveTimestamps(queryHeap, MAX_TIMESTAMPS_PER_FRAME * currentFrame, frame.numTimestamps,
+											readbackBuffer, sizeof(uint64_t) * MAX_TIMESTAMPS_PER_FRAME * currentFrame);
+		frame.pendingReadback = true;
+	}
+	if (!resolveCommandList->Close())
+	{
+		std::cerr << "Failed to close the profiler command list." << std::endl;
+		frame.pendingReadback = false;
+		return nullptr;
+	}
+
+	return resolveCommandList.get();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "GpuTimingStatistics.h"
+#include "RenderTypes.h"
+
+class RenderDevice;
+class RenderCommandList;
+
+/// Measures GPU time of named scopes with timestamp queries.
+///
+/// Every in-flight frame has its own range in the query heap and the readback buffer. A frame's timestamps are read back when its slot is
+/// reused MAX_FRAMES_INFLIGHT frames later, at which point the GPU is guaranteed to be done with it. Reading results therefore never stalls.
+/// Scopes may be recorded into several command lists from several threads at once. Their timestamps are only meaningful if those lists
+/// are executed on the direct queue.
+class GpuProfiler
+{
+public:
+	static const unsigned int INVALID_SCOPE = ~0u;
+	/// Upper limit of timestamps per frame, two per scope. Scopes beyond that are silently dropped.
+	static const unsigned int MAX_TIMESTAMPS_PER_FRAME = 256;
+
+	GpuProfiler(RenderDevice& device, unsigned int numFramesInFlight);
+	~GpuProfiler();
+
+	/// Starts a new frame in the given slot and adds the results of the frame that used this slot before to the statistics.
+	/// The GPU needs to be done with that frame.
+	void BeginFrame(unsigned int frameQueueIndex);
+
+	/// Name needs to be a string that stays alive. Returns INVALID_SCOPE if the frame ran out of timestamps.
+	unsigned int BeginScope(RenderCommandList& list, const char* name);
+	void EndScope(RenderCommandList& list, unsigned int scope);
+
+	/// Records the copy of all timestamps of this frame to the readback buffer.
+	/// Returns a closed command list that needs to be executed after all lists that contain scopes of this frame, or nullptr on failure.
+	RenderCommandList* EndFrame();
+
+	const GpuTimingStatistics& GetStatistics() const	{ return statistics; }
+
+private:
+	struct Frame
+	{
+		std::vector<GpuTimingStatistics::Scope> scopes;
+		unsigned int numTimestamps;
+		bool pendingReadback;	///< True if timestamps were resolved for this frame and not read yet.
+	};
+
+	void ReadBack(Frame& frame, unsigned int frameIndex);
+
+	RenderDevice& device;
+	RenderHandle queryHeap;
+	RenderHandle readbackBuffer;	///< MAX_TIMESTAMPS_PER_FRAME uint64_t per in-flight frame.
+	std::unique_ptr<RenderCommandList> resolveCommandList;
+	uint64_t timestampFrequency;
+
+	std::vector<Frame> frames;
+	unsigned int currentFrame;
+	std::mutex scopeMutex;	///< Guards the current frame's scopes and timestamp count.
+
+	GpuTimingStatistics statistics;
+};
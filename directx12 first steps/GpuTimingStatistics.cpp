@@ -0,0 +1,65 @@
+#include "GpuTimingStatistics.h"
+
+GpuTimingStatistics::GpuTimingStatistics(unsigned int _windowSize) :
+	windowSize(_windowSize > 0 ? _windowSize : 1)
+{
+}
+
+void GpuTimingStatistics::AddFrame(const std::vector<Scope>& scopes, const uint64_t* timestamps, uint64_t timestampFrequency)
+{
+	if (timestampFrequency == 0)
+		return;
+
+	// Sum up scopes with the same name first, every scope name gets at most one sample per frame.
+	std::map<std::string, double> frameDurations;
+	for (const Scope& scope : scopes)
+	{
+		uint64_t begin = timestamps[scope.beginTimestamp];
+		uint64_t end = timestamps[scope.endTimestamp];
+		// Timestamps are not guaranteed to be monotonic, e.g. after power state changes.
+		uint64_t ticks = end > begin ? end - begin : 0;
+		frameDurations[scope.name] += static_cast<double>(ticks) * 1000.0 / static_cast<double>(timestampFrequency);
+	}
+
+	for (const auto& duration : frameDurations)
+	{
+		History& history = histories[duration.first];
+		if (history.samples.size() < windowSize)
+			history.samples.push_back(duration.second);
+		else
+			history.samples[history.next] = duration.second;
+		history.next = (history.next + 1) % windowSize;
+	}
+}
+
+bool GpuTimingStatistics::GetSummary(const std::string& name, Summary& outSummary) const
+{
+	auto history = histories.find(name);
+	if (history == histories.end() || history->second.samples.empty())
+		return false;
+
+	const std::vector<double>& samples = history->second.samples;
+	outSummary.minMilliseconds = samples[0];
+	outSummary.maxMilliseconds = samples[0];
+	double sum = 0.0;
+	for (double sample : samples)
+	{
+		if (sample < outSummary.minMilliseconds)
+			outSummary.minMilliseconds = sample;
+		if (sample > outSummary.maxMilliseconds)
+			outSummary.maxMilliseconds = sample;
+		sum += sample;
+	}
+	outSummary.avgMilliseconds = sum / samples.size();
+	outSummary.numSamples = static_cast<unsigned int>(samples.size());
+	return true;
+}
+
+std::vector<std::string> GpuTimingStatistics::GetScopeNames() const
+{
+	std::vector<std::string> names;
+	names.reserve(histories.size());
+	for (const auto& history : histories)
+		names.push_back(history.first);
+	return names;
+}
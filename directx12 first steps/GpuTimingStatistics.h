@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/// Turns raw GPU timestamps into per-scope durations and keeps rolling min/avg/max over the last frames.
+///
+/// Scopes with the same name within a frame are summed up, e.g. the draws of several command lists that execute one after another.
+/// Scopes that did not occur in a frame do not get a sample for this frame.
+///
+/// Independent of D3D12 and Windows.
+class GpuTimingStatistics
+{
+public:
+	/// A named range between two timestamps. Indices refer to the timestamp array passed to AddFrame.
+	struct Scope
+	{
+		std::string name;
+		unsigned int beginTimestamp;
+		unsigned int endTimestamp;
+	};
+
+	struct Summary
+	{
+		double minMilliseconds;
+		double avgMilliseconds;
+		double maxMilliseconds;
+		unsigned int numSamples;
+	};
+
+	/// windowSize is the number of frames the rolling statistics are computed over.
+	GpuTimingStatistics(unsigned int windowSize = 120);
+
+	/// Adds the durations of a frame's scopes. timestampFrequency is in ticks per second.
+	void AddFrame(const std::vector<Scope>& scopes, const uint64_t* timestamps, uint64_t timestampFrequency);
+
+	/// Returns false if there was never a scope with this name.
+	bool GetSummary(const std::string& name, Summary& outSummary) const;
+
+	/// Names of all scopes seen so far, sorted alphabetically.
+	std::vector<std::string> GetScopeNames() const;
+
+	void Clear()	{ histories.clear(); }
+
+private:
+	/// Ring of the last windowSize samples of a scope.
+	struct History
+	{
+		std::vector<double> samples;
+		unsigned int next;
+	};
+
+	unsigned int windowSize;
+	std::map<std::string, History> histories;
+};
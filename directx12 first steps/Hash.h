@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64bit FNV-1a hashing. Not suited against attacks, but fast and good enough to detect changed content.
+
+const uint64_t HASH_SEED = 14695981039346656037ull;
+
+/// Hashes a range of bytes. Pass the result of a previous call as hash to combine several ranges.
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = HASH_SEED)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/// Hashes the bytes of a value. Only use for types without padding, since padding bytes are undefined.
+template<typename T>
+inline uint64_t HashValue(const T& value, uint64_t hash = HASH_SEED)
+{
+	return HashBytes(&value, sizeof(T), hash);
+}
+
+/// Hashes a zero terminated string, including the terminator so that consecutive strings can not be confused. nullptr is hashed like an empty string.
+inline uint64_t HashString(const char* string, uint64_t hash = HASH_SEED)
+{
+	if (string)
+	{
+		for (; *string; ++string)
+			hash = HashValue(*string, hash);
+	}
+	return HashValue('\0', hash);
+}
@@ -0,0 +1,76 @@
+#include "HeapPacker.h"
+#include "Helper.h"
+
+HeapPacker::HeapPacker(uint64_t _heapSize) :
+	heapSize(_heapSize),
+	currentHeapIndex(INVALID_HEAP),
+	currentHeapOffset(0),
+	committedSize(0),
+	usedSize(0)
+{
+}
+
+uint32_t HeapPacker::AddHeap(uint64_t size)
+{
+	Heap heap;
+	heap.size = size;
+	heap.numAllocations = 0;
+
+	uint32_t heapIndex;
+	if (!freeHeapIndices.empty())
+	{
+		heapIndex = freeHeapIndices.back();
+		freeHeapIndices.pop_back();
+		heaps[heapIndex] = heap;
+	}
+	else
+	{
+		heapIndex = static_cast<uint32_t>(heaps.size());
+		heaps.push_back(heap);
+	}
+	committedSize += size;
+	return heapIndex;
+}
+
+void HeapPacker::Allocate(uint64_t size, uint64_t alignment, Allocation& outAllocation, uint64_t& outNewHeapSize)
+{
+	outNewHeapSize = 0;
+	outAllocation.size = size;
+	usedSize += size;
+
+	// Does not fit into any heap, the current one stays for the next allocations.
+	if (size > heapSize)
+	{
+		outNewHeapSize = AlignUp(size, alignment);
+		outAllocation.heapIndex = AddHeap(outNewHeapSize);
+		outAllocation.offset = 0;
+		++heaps[outAllocation.heapIndex].numAllocations;
+		return;
+	}
+
+	uint64_t offset = AlignUp(currentHeapOffset, alignment);
+	if (currentHeapIndex == INVALID_HEAP || offset + size > heapSize)
+	{
+		outNewHeapSize = heapSize;
+		currentHeapIndex = AddHeap(heapSize);
+		offset = 0;
+	}
+
+	outAllocation.heapIndex = currentHeapIndex;
+	outAllocation.offset = offset;
+	++heaps[currentHeapIndex].numAllocations;
+	currentHeapOffset = offset + size;
+}
+
+uint32_t HeapPacker::Free(const Allocation& allocation)
+{
+	usedSize -= allocation.size;
+	if (--heaps[allocation.heapIndex].numAllocations > 0)
+		return INVALID_HEAP;
+
+	if (allocation.heapIndex == currentHeapIndex)
+		currentHeapIndex = INVALID_HEAP;
+	committedSize -= heaps[allocation.heapIndex].size;
+	freeHeapIndices.push_back(allocation.heapIndex);
+	return allocation.heapIndex;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/// Packs allocations linearly into fixed-size heaps. Does not know anything about the memory it manages, it only hands out heap indices and offsets.
+///
+/// Individual ranges are not reused, but every heap counts its allocations: Once all allocations of a heap are freed, the heap is given back
+/// and its index may be handed out again for a new heap. This includes the heap that is currently allocated from, the next allocation then starts a new one.
+/// So freeing a set of allocations (e.g. a set of streamed textures) gives back all of its heaps except those it shares with live allocations.
+/// Allocations that are larger than the heap size get a dedicated heap of their own size.
+/// Independent of D3D12 and Windows.
+class HeapPacker
+{
+public:
+	static const uint32_t INVALID_HEAP = ~static_cast<uint32_t>(0);
+
+	struct Allocation
+	{
+		uint32_t heapIndex;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	HeapPacker(uint64_t heapSize);
+
+	/// Alignment needs to be a power of two.
+	/// If outNewHeapSize is not 0, a heap of this size needs to be created at outAllocation.heapIndex before the allocation is used.
+	void Allocate(uint64_t size, uint64_t alignment, Allocation& outAllocation, uint64_t& outNewHeapSize);
+	/// Returns the index of a heap that became empty and needs to be released, INVALID_HEAP if none.
+	/// Only free allocations once nothing uses them anymore, their heap may be released or reused right away.
+	uint32_t Free(const Allocation& allocation);
+
+	/// Memory of all heaps that are currently alive.
+	uint64_t GetCommittedSize() const	{ return committedSize; }
+	/// Memory actually occupied by allocations, excluding alignment padding and unused heap space.
+	uint64_t GetUsedSize() const		{ return usedSize; }
+
+private:
+	struct Heap
+	{
+		uint64_t size;
+		uint64_t numAllocations;
+	};
+
+	/// Returns the index of a new heap, reusing the index of a released heap if possible.
+	uint32_t AddHeap(uint64_t size);
+
+	uint64_t heapSize;
+	std::vector<Heap> heaps;	///< Indexed by heap index. Released heaps are in freeHeapIndices.
+	std::vector<uint32_t> freeHeapIndices;
+	uint32_t currentHeapIndex;	///< Heap that is allocated from, INVALID_HEAP if there is none.
+	uint64_t currentHeapOffset;	///< Offset of the next free byte in the current heap.
+	uint64_t committedSize;
+	uint64_t usedSize;
+};
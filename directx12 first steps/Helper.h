@@ -1,8 +1,44 @@
 #pragma once
 
 #include <iostream>
+#include <string>
+
+#ifdef _WIN32
+	#include <Windows.h>
+	/// Ends the message loop with an error code.
+	#define REQUEST_QUIT() PostQuitMessage(1)
+#else
+	// Headless builds have no message loop.
+	#include <cstdlib>
+	#include <unistd.h>
+	#define REQUEST_QUIT() std::exit(1)
+#endif
 
 #define CRITICAL_ERROR(x) do { \
  		std::cerr << x << std::endl; \
-		PostQuitMessage(1); \
-		return; } while(false)
\ No newline at end of file
+		REQUEST_QUIT(); \
+		return; } while(false)
+
+/// Rounds value up to the next multiple of alignment. Alignment needs to be a power of two.
+template<typename T>
+inline T AlignUp(T value, T alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/// Directory of the running executable, including the trailing separator.
+inline std::string GetExecutableDirectory()
+{
+#ifdef _WIN32
+	char executablePath[MAX_PATH];
+	DWORD length = GetModuleFileNameA(nullptr, executablePath, MAX_PATH);
+#else
+	char executablePath[4096];
+	ssize_t length = readlink("/proc/self/exe", executablePath, sizeof(executablePath));
+	if (length < 0)
+		length = 0;
+#endif
+	std::string directory(executablePath, static_cast<size_t>(length));
+	size_t lastSeparator = directory.find_last_of("\\/");
+	return lastSeparator == std::string::npos ? "" : directory.substr(0, lastSeparator + 1);
+}
@@ -0,0 +1,217 @@
+#include "JobSystem.h"
+
+namespace
+{
+	/// Index of the worker that runs on this thread. -1 for all threads that are not workers.
+	thread_local int currentWorkerIndex = -1;
+	/// The job system the current worker belongs to.
+	thread_local const JobSystem* currentJobSystem = nullptr;
+}
+
+JobSystem::JobSystem(unsigned int numWorkers) :
+	nextExternalQueue(0),
+	numQueuedJobs(0),
+	shutdown(false),
+	numExecutedJobs(0),
+	numStolenJobs(0)
+{
+	if (numWorkers == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < numWorkers; ++i)
+		queues.emplace_back(new WorkerQueue());
+	for (unsigned int i = 0; i < numWorkers; ++i)
+		workers.emplace_back(&JobSystem::WorkerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		shutdown = true;
+	}
+	sleepCondition.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+JobSystem::JobHandle JobSystem::Schedule(std::function<void()> function, std::initializer_list<JobHandle> dependencies)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->function = std::move(function);
+	job->finished = false;
+	job->numPendingDependencies = 1; // Keeps the job from being queued while the dependencies are still registered.
+
+	for (const JobHandle& dependency : dependencies)
+	{
+		if (!dependency)
+			continue;
+
+		std::lock_guard<std::mutex> lock(dependency->continuationMutex);
+		if (!dependency->finished)
+		{
+			++job->numPendingDependencies;
+			dependency->continuations.push_back(job);
+		}
+	}
+
+	if (--job->numPendingDependencies == 0)
+		Enqueue(job);
+
+	return job;
+}
+
+bool JobSystem::IsFinished(const JobHandle& job) const
+{
+	return job->finished;
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+	while (!job->finished)
+	{
+		if (!TryExecuteOneJob())
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::ParallelFor(unsigned int begin, unsigned int end, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& function)
+{
+	if (begin >= end)
+		return;
+	if (grainSize == 0)
+		grainSize = 1;
+
+	// The last chunk is executed directly on the calling thread.
+	std::vector<JobHandle> chunks;
+	chunks.reserve((end - begin) / grainSize + 1);
+	unsigned int chunkBegin = begin;
+	for (; end - chunkBegin > grainSize; chunkBegin += grainSize)
+	{
+		unsigned int chunkEnd = chunkBegin + grainSize;
+		chunks.push_back(Schedule([&function, chunkBegin, chunkEnd]() { function(chunkBegin, chunkEnd); }));
+	}
+	function(chunkBegin, end);
+
+	for (const JobHandle& chunk : chunks)
+		Wait(chunk);
+}
+
+void JobSystem::WorkerMain(unsigned int workerIndex)
+{
+	currentWorkerIndex = static_cast<int>(workerIndex);
+	currentJobSystem = this;
+
+	while (true)
+	{
+		JobHandle job = FindJob();
+		if (job)
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this]() { return shutdown || numQueuedJobs > 0; });
+		if (shutdown)
+			return;
+	}
+}
+
+void JobSystem::Enqueue(const JobHandle& job)
+{
+	// Workers push to their own queue, everyone else distributes over all queues.
+	unsigned int queueIndex;
+	if (currentJobSystem == this)
+		queueIndex = static_cast<unsigned int>(currentWorkerIndex);
+	else
+		queueIndex = nextExternalQueue++ % queues.size();
+
+	// Counted before the push, so that a concurrent pop never decrements below zero.
+	++numQueuedJobs;
+	{
+		std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+		queues[queueIndex]->jobs.push_back(job);
+	}
+
+	// Taking the mutex makes sure that no worker is between checking numQueuedJobs and going to sleep.
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	sleepCondition.notify_one();
+}
+
+JobSystem::JobHandle JobSystem::FindJob()
+{
+	if (numQueuedJobs == 0)
+		return nullptr;
+
+	// Own queue first, newest job first since its data is most likely still in cache.
+	// Threads that are not workers have no queue of their own, so taking a job is no steal for them.
+	const bool isWorker = currentJobSystem == this;
+	unsigned int ownQueue = 0;
+	if (isWorker)
+	{
+		ownQueue = static_cast<unsigned int>(currentWorkerIndex);
+		WorkerQueue& queue = *queues[ownQueue];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			JobHandle job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			--numQueuedJobs;
+			return job;
+		}
+	}
+
+	// Steal the oldest job from another queue.
+	for (unsigned int i = isWorker ? 1 : 0; i < queues.size(); ++i)
+	{
+		WorkerQueue& queue = *queues[(ownQueue + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			JobHandle job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			--numQueuedJobs;
+			if (isWorker)
+				++numStolenJobs;
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+void JobSystem::Execute(const JobHandle& job)
+{
+	job->function();
+	job->function = nullptr; // Release captured resources early.
+	++numExecutedJobs;
+
+	std::vector<JobHandle> continuations;
+	{
+		std::lock_guard<std::mutex> lock(job->continuationMutex);
+		job->finished = true;
+		continuations.swap(job->continuations);
+	}
+
+	for (const JobHandle& continuation : continuations)
+	{
+		if (--continuation->numPendingDependencies == 0)
+			Enqueue(continuation);
+	}
+}
+
+bool JobSystem::TryExecuteOneJob()
+{
+	JobHandle job = FindJob();
+	if (!job)
+		return false;
+	Execute(job);
+	return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Work-stealing task scheduler.
+///
+/// Every worker owns a deque of jobs. Workers take jobs from the back of their own deque and steal from the front of the others' if it is empty.
+/// Jobs may depend on other jobs and are only queued after all of their dependencies finished.
+/// Threads that wait for a job execute other jobs in the meantime, so waiting from within a job does not block a worker.
+///
+/// Independent of D3D12 and Windows.
+class JobSystem
+{
+public:
+	struct Job;
+	typedef std::shared_ptr<Job> JobHandle;
+
+	/// A numWorkers of 0 uses one worker per hardware thread, minus one for the thread that creates the job system.
+	JobSystem(unsigned int numWorkers = 0);
+	~JobSystem();
+
+	/// Schedules a function that is executed once all dependencies have finished.
+	JobHandle Schedule(std::function<void()> function, std::initializer_list<JobHandle> dependencies = {});
+
+	/// Returns true if the job has finished. Never blocks.
+	bool IsFinished(const JobHandle& job) const;
+
+	/// Returns once the job has finished. Executes other jobs while waiting.
+	void Wait(const JobHandle& job);
+
+	/// Splits [begin, end) into chunks of at most grainSize elements and calls function(chunkBegin, chunkEnd) for each of them in parallel.
+	/// Returns once all chunks have been processed.
+	void ParallelFor(unsigned int begin, unsigned int end, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& function);
+
+	unsigned int GetNumWorkers() const	{ return static_cast<unsigned int>(workers.size()); }
+
+	/// Counters since creation. Used to judge the scheduler's efficiency.
+	/// A steal is a worker taking a job from another worker's queue. Threads that are not workers take jobs without stealing.
+	unsigned long long GetNumExecutedJobs() const	{ return numExecutedJobs; }
+	unsigned long long GetNumStolenJobs() const		{ return numStolenJobs; }
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	void WorkerMain(unsigned int workerIndex);
+
+	/// Puts a job whose dependencies are all finished into a queue.
+	void Enqueue(const JobHandle& job);
+	/// Takes a job from the own queue or steals one from another queue. Returns nullptr if there is none.
+	JobHandle FindJob();
+	/// Executes a job and queues all jobs that waited only for this one.
+	void Execute(const JobHandle& job);
+	/// Executes a single queued job if there is one. Returns false if there was nothing to do.
+	bool TryExecuteOneJob();
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkerQueue>> queues;	///< One per worker.
+	std::atomic<unsigned int> nextExternalQueue;		///< Threads that are not workers distribute their jobs round-robin.
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<unsigned int> numQueuedJobs;
+	std::atomic<bool> shutdown;
+
+	std::atomic<unsigned long long> numExecutedJobs;
+	std::atomic<unsigned long long> numStolenJobs;
+};
+
+struct JobSystem::Job
+{
+	std::function<void()> function;
+
+	std::atomic<unsigned int> numPendingDependencies;
+	std::atomic<bool> finished;
+
+	std::mutex continuationMutex;
+	std::vector<JobHandle> continuations;	///< Jobs that depend on this one. Guarded by continuationMutex.
+};
@@ -1,8 +1,163 @@
-#include "Application.h"
+#ifdef _WIN32
+	#include "Application.h"
+#endif
+#include "Benchmark.h"
+#include "CommandStream.h"
 
-int main()
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv)
 {
-	Application application;
+	Renderer::Configuration configuration;
+	Benchmark::Settings benchmarkSettings;
+	bool benchmark = false;
+	for (int i = 1; i < argc; ++i)
+	{
+#ifdef _WIN32
+		// Build step, does not start the application.
+		if (strcmp(argv[i], "--build-shader-archive") == 0 && i + 1 < argc)
+			return Application::BuildShaderArchive(argv[i + 1]) ? 0 : 1;
+#endif
+		// Writes a captured command stream as text to the given file ("-" for stdout), does not start the application.
+		if (strcmp(argv[i], "--disassemble") == 0 && i + 2 < argc)
+		{
+			CommandStream stream;
+			if (!stream.Load(argv[i + 1]))
+			{
+				std::cerr << "Failed to load command stream " << argv[i + 1] << std::endl;
+				return 1;
+			}
+			if (strcmp(argv[i + 2], "-") == 0)
+				return stream.Disassemble(std::cout) ? 0 : 1;
+			std::ofstream file(argv[i + 2]);
+			return stream.Disassemble(file) && file ? 0 : 1;
+		}
+		if (strcmp(argv[i], "--texture-binding") == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp(argv[i], "table") == 0)
+				configuration.textureBinding = Renderer::TextureBinding::DescriptorTablePerDraw;
+			else if (strcmp(argv[i], "array") == 0)
+				configuration.textureBinding = Renderer::TextureBinding::TextureArray;
+			else if (strcmp(argv[i], "bindless") == 0)
+				configuration.textureBinding = Renderer::TextureBinding::Bindless;
+			else
+				std::cerr << "Unknown texture binding " << argv[i] << std::endl;
+		}
+		else if (strcmp(argv[i], "--draw-submission") == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp(argv[i], "perdraw") == 0)
+				configuration.drawSubmission = Renderer::DrawSubmission::DrawPerTexture;
+			else if (strcmp(argv[i], "instanced") == 0)
+				configuration.drawSubmission = Renderer::DrawSubmission::Instanced;
+			else if (strcmp(argv[i], "indirect") == 0)
+				configuration.drawSubmission = Renderer::DrawSubmission::ExecuteIndirect;
+			else
+				std::cerr << "Unknown draw submission " << argv[i] << std::endl;
+		}
+		else if (strcmp(argv[i], "--indirect-count") == 0)
+			configuration.indirectCountBuffer = true;
+		else if (strcmp(argv[i], "--recording-threads") == 0 && i + 1 < argc)
+			configuration.numRecordingThreads = static_cast<unsigned int>(atoi(argv[++i]));
+		else if (strcmp(argv[i], "--textures") == 0 && i + 1 < argc)
+			configuration.numTextures = static_cast<unsigned int>(atoi(argv[++i]));
+		else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc)
+			configuration.frameBudgetMilliseconds = atof(argv[++i]);
+		else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+			configuration.numFramesInFlight = static_cast<unsigned int>(atoi(argv[++i]));
+		else if (strcmp(argv[i], "--frame-pacing") == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp(argv[i], "throughput") == 0)
+				configuration.framePacing = FramePacingMode::Throughput;
+			else if (strcmp(argv[i], "latency") == 0)
+				configuration.framePacing = FramePacingMode::Latency;
+			else
+				std::cerr << "Unknown frame pacing " << argv[i] << std::endl;
+		}
+		else if (strcmp(argv[i], "--backbuffers") == 0 && i + 1 < argc)
+			configuration.numBackbuffers = static_cast<unsigned int>(atoi(argv[++i]));
+		// Uploads on the direct queue with the CPU waiting for them, instead of on the copy queue.
+		else if (strcmp(argv[i], "--direct-queue-uploads") == 0)
+			configuration.copyQueueUploads = false;
+		// Texture content is generated by a compute shader instead of being uploaded.
+		else if (strcmp(argv[i], "--gpu-texture-generation") == 0)
+			configuration.gpuTextureGeneration = true;
+		// Benchmark mode, runs a fixed number of frames and writes the results to the given JSON file ("-" for stdout).
+		else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+		{
+			benchmark = true;
+			++i;
+			benchmarkSettings.outputPath = strcmp(argv[i], "-") == 0 ? "" : argv[i];
+		}
+		else if (strcmp(argv[i], "--warmup-frames") == 0 && i + 1 < argc)
+			benchmarkSettings.numWarmupFrames = static_cast<unsigned int>(atoi(argv[++i]));
+		else if (strcmp(argv[i], "--measured-frames") == 0 && i + 1 < argc)
+			benchmarkSettings.numMeasuredFrames = static_cast<unsigned int>(atoi(argv[++i]));
+		// Streams in a new set of textures every given number of frames while benchmarking.
+		else if (strcmp(argv[i], "--stream-textures") == 0 && i + 1 < argc)
+			benchmarkSettings.streamTexturesInterval = static_cast<unsigned int>(atoi(argv[++i]));
+		// Benchmark on the NullDevice, without window and GPU.
+		else if (strcmp(argv[i], "--headless") == 0)
+			benchmarkSettings.headless = true;
+		// Captures the measured benchmark frames into the given command stream file.
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+			benchmarkSettings.capturePath = argv[++i];
+		// Benchmark that replays the given command stream file on the NullDevice instead of rendering.
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			benchmark = true;
+			benchmarkSettings.replayPath = argv[++i];
+		}
+		// Benchmark that renders with 1, 2, 4, 8 and 16 recording threads one after another.
+		else if (strcmp(argv[i], "--recording-threads-benchmark") == 0)
+		{
+			benchmark = true;
+			benchmarkSettings.mode = Benchmark::Mode::RecordingThreads;
+		}
+		// Benchmark of the CPU texture generators, without rendering.
+		else if (strcmp(argv[i], "--texture-generation-benchmark") == 0)
+		{
+			benchmark = true;
+			benchmarkSettings.mode = Benchmark::Mode::TextureGeneration;
+		}
+		// Benchmark of the JobSystem's scheduling and scaling, without rendering.
+		else if (strcmp(argv[i], "--job-system-benchmark") == 0)
+		{
+			benchmark = true;
+			benchmarkSettings.mode = Benchmark::Mode::JobSystem;
+		}
+		// Allows capturing with F4 when running interactively.
+		else if (strcmp(argv[i], "--enable-capture") == 0)
+			configuration.captureCommands = true;
+		else
+			std::cerr << "Unknown argument " << argv[i] << std::endl;
+	}
+
+	if (configuration.drawSubmission != Renderer::DrawSubmission::DrawPerTexture && configuration.textureBinding == Renderer::TextureBinding::DescriptorTablePerDraw)
+	{
+		std::cerr << "Instanced and indirect drawing need the array or bindless texture binding." << std::endl;
+		return 1;
+	}
+
+#ifndef _WIN32
+	// Without D3D12 there is nothing but the headless benchmark.
+	benchmark = true;
+#endif
+	if (benchmark)
+	{
+		benchmarkSettings.configuration = configuration;
+		Benchmark benchmarkRun(benchmarkSettings);
+		return benchmarkRun.Run() ? 0 : 1;
+	}
+
+#ifdef _WIN32
+	Application application(configuration);
 	application.Run();
+#endif
 	return 0;
 }
\ No newline at end of file
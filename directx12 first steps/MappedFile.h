@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <Windows.h>
+
+/// Read-only memory mapping of an entire file.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	/// Returns false if the file could not be opened or mapped.
+	bool Open(const std::string& path);
+	void Close();
+
+	const void* GetData() const		{ return data; }
+	size_t GetSize() const			{ return size; }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator = (const MappedFile&);
+
+	HANDLE file;
+	HANDLE mapping;
+	const void* data;
+	size_t size;
+};
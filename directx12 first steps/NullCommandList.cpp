@@ -0,0 +1,361 @@
+#include "NullCommandList.h"
+#include "NullDevice.h"
+
+#include <string>
+
+namespace
+{
+	bool IsCopyQueueState(ResourceState state)
+	{
+		return state == ResourceState::Common || state == ResourceState::CopyDest;
+	}
+}
+
+NullCommandList::NullCommandList(NullDevice& _device, bool _copyQueue) :
+	device(_device),
+	copyQueue(_copyQueue),
+	closed(true),
+	frameQueueIndex(0),
+	pipelineState(INVALID_RENDER_HANDLE),
+	rootSignature(INVALID_RENDER_HANDLE),
+	computeRootSignature(INVALID_RENDER_HANDLE),
+	renderTarget(INVALID_RENDER_HANDLE),
+	descriptorHeap(INVALID_RENDER_HANDLE),
+	vertexBufferSet(false),
+	pendingDraws(0),
+	statistics()
+{
+	for (auto& fenceValue : allocatorFenceValues)
+		fenceValue = 0;
+}
+
+bool NullCommandList::Reset(unsigned int _frameQueueIndex, RenderHandle _pipelineState)
+{
+	if (_frameQueueIndex >= RenderDevice::MAX_FRAMES_INFLIGHT)
+	{
+		device.ReportValidationError("Reset: frame queue index " + std::to_string(_frameQueueIndex) + " out of range.");
+		return false;
+	}
+	if (!closed)
+		device.ReportValidationError("Reset: command list is still recording.");
+	if (copyQueue && _pipelineState != INVALID_RENDER_HANDLE)
+		device.ReportValidationError("Reset: copy lists have no pipeline state.");
+	// Same as resetting an ID3D12CommandAllocator whose commands are still executed.
+	uint64_t completedFenceValue = copyQueue ? device.GetCompletedCopyFenceValue() : device.GetCompletedFenceValue();
+	if (allocatorFenceValues[_frameQueueIndex] > completedFenceValue)
+		device.ReportValidationError("Reset: allocator of frame " + std::to_string(_frameQueueIndex) + " is still in use by the GPU.");
+
+	closed = false;
+	frameQueueIndex = _frameQueueIndex;
+	pipelineState = _pipelineState;
+	rootSignature = INVALID_RENDER_HANDLE;
+	computeRootSignature = INVALID_RENDER_HANDLE;
+	renderTarget = INVALID_RENDER_HANDLE;
+	descriptorHeap = INVALID_RENDER_HANDLE;
+	vertexBufferSet = false;
+	pendingDraws = 0;
+	statistics = {};
+	deferredCommands.clear();
+	return true;
+}
+
+bool NullCommandList::Close()
+{
+	if (!CheckRecording("Close"))
+		return false;
+	FlushDraws();
+	closed = true;
+	return true;
+}
+
+bool NullCommandList::CheckRecording(const char* command)
+{
+	if (closed)
+	{
+		device.ReportValidationError(std::string(command) + ": command list is closed.");
+		return false;
+	}
+	return true;
+}
+
+bool NullCommandList::CheckDirectQueue(const char* command)
+{
+	if (!CheckRecording(command))
+		return false;
+	if (copyQueue)
+	{
+		device.ReportValidationError(std::string(command) + ": not supported by copy lists.");
+		return false;
+	}
+	return true;
+}
+
+void NullCommandList::CheckDrawState(const char* command)
+{
+	if (pipelineState == INVALID_RENDER_HANDLE)
+		device.ReportValidationError(std::string(command) + ": no pipeline state set.");
+	if (rootSignature == INVALID_RENDER_HANDLE)
+		device.ReportValidationError(std::string(command) + ": no root signature set.");
+	if (renderTarget == INVALID_RENDER_HANDLE)
+		device.ReportValidationError(std::string(command) + ": no render target set.");
+	if (!vertexBufferSet)
+		device.ReportValidationError(std::string(command) + ": no vertex buffer set.");
+}
+
+void NullCommandList::CheckDescriptorTable(const char* command, RenderHandle _descriptorHeap, unsigned int firstDescriptor)
+{
+	if (_descriptorHeap != descriptorHeap)
+		device.ReportValidationError(std::string(command) + ": descriptor heap is not set on the command list.");
+	else if (firstDescriptor >= device.GetNumDescriptors(_descriptorHeap))
+		device.ReportValidationError(std::string(command) + ": descriptor " + std::to_string(firstDescriptor) + " out of range.");
+}
+
+void NullCommandList::FlushDraws()
+{
+	if (pendingDraws == 0)
+		return;
+	DeferredCommand command = {};
+	command.type = DeferredCommand::Type::Draws;
+	command.numDraws = pendingDraws;
+	deferredCommands.push_back(command);
+	pendingDraws = 0;
+}
+
+void NullCommandList::AddCopy(RenderHandle destResource)
+{
+	FlushDraws();
+	DeferredCommand command = {};
+	command.type = DeferredCommand::Type::Copy;
+	command.destBuffer = destResource;
+	deferredCommands.push_back(command);
+}
+
+void NullCommandList::SetPipelineState(RenderHandle _pipelineState)
+{
+	if (!CheckDirectQueue("SetPipelineState"))
+		return;
+	if (device.GetObjectType(_pipelineState) != NullDevice::ObjectType::PipelineState)
+		device.ReportValidationError("SetPipelineState: invalid pipeline state.");
+	pipelineState = _pipelineState;
+}
+
+void NullCommandList::SetGraphicsRootSignature(RenderHandle _rootSignature)
+{
+	if (!CheckDirectQueue("SetGraphicsRootSignature"))
+		return;
+	if (device.GetObjectType(_rootSignature) != NullDevice::ObjectType::RootSignature)
+		device.ReportValidationError("SetGraphicsRootSignature: invalid root signature.");
+	rootSignature = _rootSignature;
+}
+
+void NullCommandList::SetViewport(const Viewport&)
+{
+	CheckDirectQueue("SetViewport");
+}
+
+void NullCommandList::SetScissorRect(const ScissorRect&)
+{
+	CheckDirectQueue("SetScissorRect");
+}
+
+void NullCommandList::ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers)
+{
+	if (!CheckRecording("ResourceBarriers"))
+		return;
+	// Before-states are checked on execution, together with the barriers of all lists executed before.
+	FlushDraws();
+	for (unsigned int i = 0; i < numBarriers; ++i)
+	{
+		if (copyQueue && (!IsCopyQueueState(barriers[i].before) || !IsCopyQueueState(barriers[i].after)))
+			device.ReportValidationError("ResourceBarriers: copy lists only support the common and copy states.");
+		DeferredCommand command = {};
+		command.type = DeferredCommand::Type::Barrier;
+		command.barrier = barriers[i];
+		deferredCommands.push_back(command);
+	}
+	statistics.numBarriers += numBarriers;
+}
+
+void NullCommandList::SetRenderTarget(RenderHandle renderTargetView)
+{
+	if (!CheckDirectQueue("SetRenderTarget"))
+		return;
+	if (device.GetObjectType(renderTargetView) != NullDevice::ObjectType::RenderTargetView)
+		device.ReportValidationError("SetRenderTarget: invalid render target view.");
+	renderTarget = renderTargetView;
+}
+
+void NullCommandList::ClearRenderTarget(RenderHandle renderTargetView, const float[4])
+{
+	if (!CheckDirectQueue("ClearRenderTarget"))
+		return;
+	if (device.GetObjectType(renderTargetView) != NullDevice::ObjectType::RenderTargetView)
+		device.ReportValidationError("ClearRenderTarget: invalid render target view.");
+}
+
+void NullCommandList::SetPrimitiveTopology(PrimitiveTopology)
+{
+	CheckDirectQueue("SetPrimitiveTopology");
+}
+
+void NullCommandList::SetVertexBuffer(const VertexBufferView& view)
+{
+	if (!CheckDirectQueue("SetVertexBuffer"))
+		return;
+	if (device.GetObjectType(view.buffer) != NullDevice::ObjectType::Buffer)
+		device.ReportValidationError("SetVertexBuffer: invalid buffer.");
+	vertexBufferSet = true;
+}
+
+void NullCommandList::SetDescriptorHeap(RenderHandle _descriptorHeap)
+{
+	if (!CheckDirectQueue("SetDescriptorHeap"))
+		return;
+	if (device.GetObjectType(_descriptorHeap) != NullDevice::ObjectType::DescriptorHeap)
+		device.ReportValidationError("SetDescriptorHeap: invalid descriptor heap.");
+	descriptorHeap = _descriptorHeap;
+}
+
+void NullCommandList::SetGraphicsRootDescriptorTable(unsigned int, RenderHandle _descriptorHeap, unsigned int firstDescriptor)
+{
+	if (!CheckDirectQueue("SetGraphicsRootDescriptorTable"))
+		return;
+	CheckDescriptorTable("SetGraphicsRootDescriptorTable", _descriptorHeap, firstDescriptor);
+	++statistics.numDescriptorTableBinds;
+}
+
+void NullCommandList::SetGraphicsRoot32BitConstant(unsigned int, uint32_t, unsigned int)
+{
+	CheckDirectQueue("SetGraphicsRoot32BitConstant");
+}
+
+void NullCommandList::DrawInstanced(uint32_t, uint32_t, uint32_t, uint32_t)
+{
+	if (!CheckDirectQueue("DrawInstanced"))
+		return;
+	CheckDrawState("DrawInstanced");
+	++statistics.numDrawCalls;
+	++pendingDraws;
+}
+
+void NullCommandList::ExecuteIndirect(RenderHandle commandSignature, uint32_t maxCommandCount, RenderHandle argumentBuffer, uint64_t,
+									RenderHandle countBuffer, uint64_t)
+{
+	if (!CheckDirectQueue("ExecuteIndirect"))
+		return;
+	CheckDrawState("ExecuteIndirect");
+	if (device.GetObjectType(commandSignature) != NullDevice::ObjectType::CommandSignature)
+		device.ReportValidationError("ExecuteIndirect: invalid command signature.");
+	if (device.GetObjectType(argumentBuffer) != NullDevice::ObjectType::Buffer)
+		device.ReportValidationError("ExecuteIndirect: invalid argument buffer.");
+	if (countBuffer != INVALID_RENDER_HANDLE && device.GetObjectType(countBuffer) != NullDevice::ObjectType::Buffer)
+		device.ReportValidationError("ExecuteIndirect: invalid count buffer.");
+	// The count buffer is not read, the maximum is assumed.
+	statistics.numIndirectDraws += maxCommandCount;
+	pendingDraws += maxCommandCount;
+}
+
+void NullCommandList::SetComputeRootSignature(RenderHandle _rootSignature)
+{
+	if (!CheckDirectQueue("SetComputeRootSignature"))
+		return;
+	if (device.GetObjectType(_rootSignature) != NullDevice::ObjectType::RootSignature)
+		device.ReportValidationError("SetComputeRootSignature: invalid root signature.");
+	computeRootSignature = _rootSignature;
+}
+
+void NullCommandList::SetComputeRootDescriptorTable(unsigned int, RenderHandle _descriptorHeap, unsigned int firstDescriptor)
+{
+	if (!CheckDirectQueue("SetComputeRootDescriptorTable"))
+		return;
+	CheckDescriptorTable("SetComputeRootDescriptorTable", _descriptorHeap, firstDescriptor);
+	++statistics.numDescriptorTableBinds;
+}
+
+void NullCommandList::SetComputeRoot32BitConstant(unsigned int, uint32_t, unsigned int)
+{
+	CheckDirectQueue("SetComputeRoot32BitConstant");
+}
+
+void NullCommandList::Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ)
+{
+	if (!CheckDirectQueue("Dispatch"))
+		return;
+	if (pipelineState == INVALID_RENDER_HANDLE)
+		device.ReportValidationError("Dispatch: no pipeline state set.");
+	if (computeRootSignature == INVALID_RENDER_HANDLE)
+		device.ReportValidationError("Dispatch: no compute root signature set.");
+	if (threadGroupCountX == 0 || threadGroupCountY == 0 || threadGroupCountZ == 0)
+		device.ReportValidationError("Dispatch: empty dispatch.");
+	++statistics.numDispatches;
+}
+
+void NullCommandList::CopyBufferRegion(RenderHandle destBuffer, uint64_t, RenderHandle sourceBuffer, uint64_t, uint64_t numBytes)
+{
+	if (!CheckRecording("CopyBufferRegion"))
+		return;
+	if (device.GetObjectType(destBuffer) != NullDevice::ObjectType::Buffer)
+		device.ReportValidationError("CopyBufferRegion: invalid destination buffer.");
+	if (device.GetObjectType(sourceBuffer) != NullDevice::ObjectType::UploadBuffer)
+		device.ReportValidationError("CopyBufferRegion: source is not upload memory.");
+	AddCopy(destBuffer);
+	++statistics.numCopies;
+	statistics.numBytesCopied += numBytes;
+}
+
+void NullCommandList::CopyBufferToTexture(RenderHandle destTexture, unsigned int, RenderHandle sourceBuffer, const TextureFootprint& sourceFootprint)
+{
+	if (!CheckRecording("CopyBufferToTexture"))
+		return;
+	if (device.GetObjectType(destTexture) != NullDevice::ObjectType::Texture)
+		device.ReportValidationError("CopyBufferToTexture: invalid destination texture.");
+	if (device.GetObjectType(sourceBuffer) != NullDevice::ObjectType::UploadBuffer)
+		device.ReportValidationError("CopyBufferToTexture: source is not upload memory.");
+	if (sourceFootprint.offset % TEXTURE_DATA_PLACEMENT_ALIGNMENT != 0)
+		device.ReportValidationError("CopyBufferToTexture: source offset is not aligned.");
+	AddCopy(destTexture);
+	++statistics.numCopies;
+	statistics.numBytesCopied += sourceFootprint.totalSize;
+}
+
+void NullCommandList::WriteTimestamp(RenderHandle queryHeap, unsigned int queryIndex)
+{
+	if (!CheckDirectQueue("WriteTimestamp"))
+		return;
+	if (queryIndex >= device.GetNumQueries(queryHeap))
+	{
+		device.ReportValidationError("WriteTimestamp: invalid query.");
+		return;
+	}
+	FlushDraws();
+	DeferredCommand command = {};
+	command.type = DeferredCommand::Type::Timestamp;
+	command.queryHeap = queryHeap;
+	command.firstQuery = queryIndex;
+	deferredCommands.push_back(command);
+}
+
+void NullCommandList::ResolveTimestamps(RenderHandle queryHeap, unsigned int firstQuery, unsigned int numQueries, RenderHandle destBuffer, uint64_t destOffset)
+{
+	if (!CheckRecording("ResolveTimestamps"))
+		return;
+	if (static_cast<uint64_t>(firstQuery) + numQueries > device.GetNumQueries(queryHeap))
+	{
+		device.ReportValidationError("ResolveTimestamps: invalid query range.");
+		return;
+	}
+	if (device.GetObjectType(destBuffer) != NullDevice::ObjectType::ReadbackBuffer)
+	{
+		device.ReportValidationError("ResolveTimestamps: destination is not a readback buffer.");
+		return;
+	}
+	FlushDraws();
+	DeferredCommand command = {};
+	command.type = DeferredCommand::Type::ResolveTimestamps;
+	command.queryHeap = queryHeap;
+	command.firstQuery = firstQuery;
+	command.numQueries = numQueries;
+	command.destBuffer = destBuffer;
+	command.destOffset = destOffset;
+	deferredCommands.push_back(command);
+}
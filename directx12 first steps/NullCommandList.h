@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+
+#include "RenderCommandList.h"
+#include "RenderDevice.h"
+
+class NullDevice;
+
+/// RenderCommandList of the NullDevice. Validates and counts commands instead of recording them for a GPU.
+///
+/// State dependent checks (e.g. drawing or dispatching without a pipeline state) happen while recording.
+/// Barriers, copies, timestamps and resolves are kept and replayed by NullDevice::ExecuteCommandLists, since only then the resource states are known.
+/// Lists of the copy queue report everything but copies and barriers between ResourceState::Common and ResourceState::CopyDest.
+/// Independent of D3D12 and Windows.
+class NullCommandList : public RenderCommandList
+{
+public:
+	/// Counters of everything recorded since the last Reset.
+	struct Statistics
+	{
+		uint64_t numDrawCalls;				///< DrawInstanced calls.
+		uint64_t numIndirectDraws;			///< Upper bound of draws issued by ExecuteIndirect.
+		uint64_t numDispatches;
+		uint64_t numBarriers;
+		uint64_t numDescriptorTableBinds;
+		uint64_t numCopies;
+		uint64_t numBytesCopied;
+	};
+
+	/// Recorded command that is replayed on execution.
+	struct DeferredCommand
+	{
+		enum class Type
+		{
+			Barrier,
+			Copy,				///< Destination buffer or texture in destBuffer.
+			Timestamp,
+			ResolveTimestamps,
+			Draws				///< Advances the simulated GPU clock.
+		};
+
+		Type type;
+		ResourceBarrier barrier;
+		RenderHandle queryHeap;
+		unsigned int firstQuery;
+		unsigned int numQueries;
+		RenderHandle destBuffer;
+		uint64_t destOffset;
+		uint64_t numDraws;
+	};
+
+	NullCommandList(NullDevice& device, bool copyQueue);
+
+	bool Reset(unsigned int frameQueueIndex, RenderHandle pipelineState) override;
+	bool Close() override;
+
+	void SetPipelineState(RenderHandle pipelineState) override;
+	void SetGraphicsRootSignature(RenderHandle rootSignature) override;
+	void SetViewport(const Viewport& viewport) override;
+	void SetScissorRect(const ScissorRect& scissorRect) override;
+	void ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers) override;
+	void SetRenderTarget(RenderHandle renderTargetView) override;
+	void ClearRenderTarget(RenderHandle renderTargetView, const float color[4]) override;
+
+	void SetPrimitiveTopology(PrimitiveTopology topology) override;
+	void SetVertexBuffer(const VertexBufferView& view) override;
+	void SetDescriptorHeap(RenderHandle descriptorHeap) override;
+	void SetGraphicsRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) override;
+	void SetGraphicsRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) override;
+
+	void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
+	void ExecuteIndirect(RenderHandle commandSignature, uint32_t maxCommandCount, RenderHandle argumentBuffer, uint64_t argumentBufferOffset,
+						RenderHandle countBuffer, uint64_t countBufferOffset) override;
+
+	void SetComputeRootSignature(RenderHandle rootSignature) override;
+	void SetComputeRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) override;
+	void SetComputeRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) override;
+	void Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) override;
+
+	void CopyBufferRegion(RenderHandle destBuffer, uint64_t destOffset, RenderHandle sourceBuffer, uint64_t sourceOffset, uint64_t numBytes) override;
+	void CopyBufferToTexture(RenderHandle destTexture, unsigned int destSubresource, RenderHandle sourceBuffer, const TextureFootprint& sourceFootprint) override;
+
+	void WriteTimestamp(RenderHandle queryHeap, unsigned int queryIndex) override;
+	void ResolveTimestamps(RenderHandle queryHeap, unsigned int firstQuery, unsigned int numQueries, RenderHandle destBuffer, uint64_t destOffset) override;
+
+
+	bool IsClosed() const												{ return closed; }
+	bool IsCopyQueue() const											{ return copyQueue; }
+	unsigned int GetFrameQueueIndex() const								{ return frameQueueIndex; }
+	const Statistics& GetStatistics() const								{ return statistics; }
+	const std::vector<DeferredCommand>& GetDeferredCommands() const	{ return deferredCommands; }
+
+	/// Called by the device on execution. The allocator of the recorded frame may be reset once the GPU passed fenceValue.
+	void SetSubmissionFenceValue(uint64_t fenceValue)					{ allocatorFenceValues[frameQueueIndex] = fenceValue; }
+
+private:
+	/// Reports an error if the list is closed. Returns false in this case.
+	bool CheckRecording(const char* command);
+	/// Like CheckRecording, but also reports an error if this is a copy list.
+	bool CheckDirectQueue(const char* command);
+	void CheckDrawState(const char* command);
+	/// Reports an error if the heap is not the one set on the list or the descriptor is out of its range.
+	void CheckDescriptorTable(const char* command, RenderHandle descriptorHeap, unsigned int firstDescriptor);
+	/// Adds the pending draw count to the deferred commands.
+	void FlushDraws();
+	/// Adds a deferred command for a copy into destResource.
+	void AddCopy(RenderHandle destResource);
+
+	NullDevice& device;
+	const bool copyQueue;
+
+	bool closed;
+	unsigned int frameQueueIndex;
+	uint64_t allocatorFenceValues[RenderDevice::MAX_FRAMES_INFLIGHT];	///< Fence value of the last submission that used each allocator.
+
+	RenderHandle pipelineState;
+	RenderHandle rootSignature;
+	RenderHandle computeRootSignature;
+	RenderHandle renderTarget;
+	RenderHandle descriptorHeap;
+	bool vertexBufferSet;
+	uint64_t pendingDraws;
+
+	Statistics statistics;
+	std::vector<DeferredCommand> deferredCommands;
+};
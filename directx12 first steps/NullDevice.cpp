@@ -0,0 +1,460 @@
+#include "NullDevice.h"
+#include "NullCommandList.h"
+
+#include "Helper.h"
+
+NullDevice::NullDevice(unsigned int _backbufferWidth, unsigned int _backbufferHeight, unsigned int numBackbuffers) :
+	backbufferWidth(_backbufferWidth),
+	backbufferHeight(_backbufferHeight),
+	backbuffers(numBackbuffers < MIN_BACKBUFFERS ? MIN_BACKBUFFERS : (numBackbuffers > MAX_BACKBUFFERS ? MAX_BACKBUFFERS : numBackbuffers)),
+	backbufferRenderTargetViews(backbuffers.size()),
+	activeBackbufferIndex(0),
+	frameTimeline(frameFence, MAX_FRAMES_INFLIGHT),
+	framePacer(frameTimeline, frameSync, FramePacingMode::Throughput, MAX_FRAMES_INFLIGHT),
+	timestampTicks(0),
+	uploadRing(UPLOAD_RING_SIZE),
+	uploadRingMemory(static_cast<size_t>(UPLOAD_RING_SIZE)),
+	copyTimeline(copyFence, 1),
+	copyUploadRing(COPY_UPLOAD_RING_SIZE),
+	copyUploadRingMemory(static_cast<size_t>(COPY_UPLOAD_RING_SIZE)),
+	directQueueCopyFenceValue(0),
+	textureHeaps(TEXTURE_HEAP_SIZE),
+	statistics()
+{
+	for (size_t i = 0; i < backbuffers.size(); ++i)
+	{
+		backbuffers[i] = AddObject(ObjectType::Backbuffer, ResourceState::Present, static_cast<uint64_t>(backbufferWidth) * backbufferHeight * 4);
+		backbufferRenderTargetViews[i] = AddObject(ObjectType::RenderTargetView, ResourceState::Common, 0);
+	}
+	uploadRingBuffer = AddObject(ObjectType::UploadBuffer, ResourceState::Common, UPLOAD_RING_SIZE);
+	copyUploadRingBuffer = AddObject(ObjectType::UploadBuffer, ResourceState::Common, COPY_UPLOAD_RING_SIZE);
+}
+
+NullDevice::~NullDevice()
+{
+}
+
+RenderHandle NullDevice::AddObject(ObjectType type, ResourceState state, uint64_t size)
+{
+	Object object;
+	object.type = type;
+	object.state = state;
+	object.size = size;
+	object.releasePending = false;
+	object.copyFenceValue = 0;
+	object.allowUnorderedAccess = false;
+	objects.push_back(std::move(object));
+	return static_cast<RenderHandle>(objects.size());
+}
+
+NullDevice::Object* NullDevice::FindObject(RenderHandle handle, ObjectType type)
+{
+	if (handle == INVALID_RENDER_HANDLE || handle > objects.size() || objects[handle - 1].type != type)
+		return nullptr;
+	return &objects[handle - 1];
+}
+
+const NullDevice::Object* NullDevice::FindObject(RenderHandle handle, ObjectType type) const
+{
+	if (handle == INVALID_RENDER_HANDLE || handle > objects.size() || objects[handle - 1].type != type)
+		return nullptr;
+	return &objects[handle - 1];
+}
+
+NullDevice::ObjectType NullDevice::GetObjectType(RenderHandle handle) const
+{
+	if (handle == INVALID_RENDER_HANDLE || handle > objects.size())
+		return ObjectType::Invalid;
+	return objects[handle - 1].type;
+}
+
+unsigned int NullDevice::GetNumDescriptors(RenderHandle descriptorHeap) const
+{
+	const Object* heap = FindObject(descriptorHeap, ObjectType::DescriptorHeap);
+	return heap ? static_cast<unsigned int>(heap->size) : 0;
+}
+
+unsigned int NullDevice::GetNumQueries(RenderHandle queryHeap) const
+{
+	const Object* heap = FindObject(queryHeap, ObjectType::QueryHeap);
+	return heap ? static_cast<unsigned int>(heap->size) : 0;
+}
+
+void NullDevice::ReportValidationError(const std::string& message)
+{
+	std::lock_guard<std::mutex> lock(validationMutex);
+	++statistics.numValidationErrors;
+	lastValidationError = message;
+	std::cerr << "NullDevice validation error: " << message << std::endl;
+}
+
+std::string NullDevice::GetLastValidationError() const
+{
+	std::lock_guard<std::mutex> lock(validationMutex);
+	return lastValidationError;
+}
+
+void NullDevice::ReclaimCompleted()
+{
+	uint64_t completedValue = frameTimeline.GetCompletedValue();
+	uploadRing.Reclaim(completedValue);
+	deferredReleaseQueue.Reclaim(completedValue);
+	copyUploadRing.Reclaim(copyTimeline.GetCompletedValue());
+}
+
+uint64_t NullDevice::SignalFrameTimeline(bool endOfFrame)
+{
+	// The fence is passed right away, but allocations are still tagged so that the ring behaves like on a GPU.
+	uint64_t value = endOfFrame ? frameTimeline.SignalFrame() : frameTimeline.Signal();
+	uploadRing.FinishAllocations(value);
+	return value;
+}
+
+void NullDevice::BeginFrame()
+{
+	framePacer.BeginFrame();
+	ReclaimCompleted();
+}
+
+void NullDevice::Present()
+{
+	if (objects[backbuffers[activeBackbufferIndex] - 1].state != ResourceState::Present)
+		ReportValidationError("Present: back buffer is not in the present state.");
+	++statistics.numPresents;
+	SignalFrameTimeline(true);
+	framePacer.Present();
+	activeBackbufferIndex = (activeBackbufferIndex + 1) % static_cast<unsigned int>(backbuffers.size());
+}
+
+void NullDevice::WaitForFreeInflightFrame()
+{
+	framePacer.EndFrame();
+	ReclaimCompleted();
+}
+
+void NullDevice::WaitForIdleGPU()
+{
+	frameTimeline.Wait(SignalFrameTimeline(false));
+	WaitForCopy(copyTimeline.GetLastSignaledValue());
+	ReclaimCompleted();
+}
+
+void NullDevice::SetMaxFramesInFlight(unsigned int numFrames)
+{
+	framePacer.SetMaxFramesInFlight(numFrames > MAX_FRAMES_INFLIGHT ? MAX_FRAMES_INFLIGHT : numFrames);
+}
+
+std::unique_ptr<RenderCommandList> NullDevice::CreateCommandList()
+{
+	return std::unique_ptr<RenderCommandList>(new NullCommandList(*this, false));
+}
+
+void NullDevice::ExecuteCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists)
+{
+	for (unsigned int i = 0; i < numCommandLists; ++i)
+	{
+		NullCommandList* commandList = static_cast<NullCommandList*>(commandLists[i]);
+		if (!commandList->IsClosed())
+		{
+			ReportValidationError("ExecuteCommandLists: command list " + std::to_string(i) + " is not closed.");
+			continue;
+		}
+		if (commandList->IsCopyQueue())
+		{
+			ReportValidationError("ExecuteCommandLists: command list " + std::to_string(i) + " is a copy list.");
+			continue;
+		}
+
+		ExecuteDeferredCommands(*commandList);
+
+		// The list's allocator is in use until the next fence signal.
+		commandList->SetSubmissionFenceValue(frameTimeline.GetLastSignaledValue() + 1);
+
+		const NullCommandList::Statistics& listStatistics = commandList->GetStatistics();
+		statistics.numDrawCalls += listStatistics.numDrawCalls;
+		statistics.numIndirectDraws += listStatistics.numIndirectDraws;
+		statistics.numDispatches += listStatistics.numDispatches;
+		statistics.numBarriers += listStatistics.numBarriers;
+		statistics.numDescriptorTableBinds += listStatistics.numDescriptorTableBinds;
+		statistics.numCopies += listStatistics.numCopies;
+		statistics.numBytesCopied += listStatistics.numBytesCopied;
+		++statistics.numExecutedCommandLists;
+	}
+}
+
+std::unique_ptr<RenderCommandList> NullDevice::CreateCopyCommandList()
+{
+	return std::unique_ptr<RenderCommandList>(new NullCommandList(*this, true));
+}
+
+uint64_t NullDevice::ExecuteCopyCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists)
+{
+	for (unsigned int i = 0; i < numCommandLists; ++i)
+	{
+		NullCommandList* commandList = static_cast<NullCommandList*>(commandLists[i]);
+		if (!commandList->IsClosed() || !commandList->IsCopyQueue())
+		{
+			ReportValidationError("ExecuteCopyCommandLists: command list " + std::to_string(i) + " is not a closed copy list.");
+			continue;
+		}
+
+		ExecuteDeferredCommands(*commandList);
+		commandList->SetSubmissionFenceValue(copyTimeline.GetLastSignaledValue() + 1);
+
+		const NullCommandList::Statistics& listStatistics = commandList->GetStatistics();
+		statistics.numBarriers += listStatistics.numBarriers;
+		statistics.numCopies += listStatistics.numCopies;
+		statistics.numBytesCopied += listStatistics.numBytesCopied;
+		++statistics.numExecutedCopyCommandLists;
+	}
+
+	uint64_t value = copyTimeline.Signal();
+	copyUploadRing.FinishAllocations(value);
+	return value;
+}
+
+void NullDevice::QueueWaitForCopy(uint64_t copyFenceValue)
+{
+	if (copyFenceValue > copyTimeline.GetLastSignaledValue())
+		ReportValidationError("QueueWaitForCopy: copy fence value was not signaled yet.");
+	if (copyFenceValue > directQueueCopyFenceValue)
+		directQueueCopyFenceValue = copyFenceValue;
+}
+
+void NullDevice::WaitForCopy(uint64_t copyFenceValue)
+{
+	copyTimeline.Wait(copyFenceValue);
+	if (copyFenceValue > directQueueCopyFenceValue)
+		directQueueCopyFenceValue = copyFenceValue;
+}
+
+void NullDevice::ExecuteDeferredCommands(const NullCommandList& commandList)
+{
+	for (const NullCommandList::DeferredCommand& command : commandList.GetDeferredCommands())
+	{
+		switch (command.type)
+		{
+		case NullCommandList::DeferredCommand::Type::Barrier:
+		{
+			RenderHandle handle = command.barrier.resource;
+			if (handle == INVALID_RENDER_HANDLE || handle > objects.size())
+			{
+				ReportValidationError("ResourceBarriers: invalid resource.");
+				break;
+			}
+			Object& resource = objects[handle - 1];
+			if (resource.state != command.barrier.before)
+				ReportValidationError("ResourceBarriers: before-state of resource " + std::to_string(handle) + " does not match its current state.");
+			if (!commandList.IsCopyQueue() && resource.copyFenceValue > directQueueCopyFenceValue)
+				ReportValidationError("ResourceBarriers: resource " + std::to_string(handle) + " is written by the copy queue, but the direct queue did not wait for it.");
+			resource.state = command.barrier.after;
+			break;
+		}
+
+		case NullCommandList::DeferredCommand::Type::Copy:
+		{
+			if (!commandList.IsCopyQueue())
+				break;
+			// Copy queue writes need the common state, which is implicitly promoted to the copy destination state and decays back once the copy is done.
+			Object& resource = objects[command.destBuffer - 1];
+			if (resource.state != ResourceState::Common)
+				ReportValidationError("Copy: destination " + std::to_string(command.destBuffer) + " of a copy list is not in the common state.");
+			resource.copyFenceValue = copyTimeline.GetLastSignaledValue() + 1;
+			break;
+		}
+
+		case NullCommandList::DeferredCommand::Type::Timestamp:
+			objects[command.queryHeap - 1].data[command.firstQuery] = timestampTicks;
+			break;
+
+		case NullCommandList::DeferredCommand::Type::ResolveTimestamps:
+		{
+			const Object& queryHeap = objects[command.queryHeap - 1];
+			Object& destBuffer = objects[command.destBuffer - 1];
+			if (command.destOffset % sizeof(uint64_t) != 0 || command.destOffset + command.numQueries * sizeof(uint64_t) > destBuffer.size)
+			{
+				ReportValidationError("ResolveTimestamps: destination range out of bounds.");
+				break;
+			}
+			for (unsigned int query = 0; query < command.numQueries; ++query)
+				destBuffer.data[command.destOffset / sizeof(uint64_t) + query] = queryHeap.data[command.firstQuery + query];
+			break;
+		}
+
+		case NullCommandList::DeferredCommand::Type::Draws:
+			timestampTicks += command.numDraws;
+			break;
+		}
+	}
+}
+
+bool NullDevice::AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	uploadRing.Reclaim(frameTimeline.GetCompletedValue());
+	return AllocateFromUploadRing(uploadRing, uploadRingMemory, uploadRingBuffer, size, alignment, outAllocation);
+}
+
+bool NullDevice::AllocateCopyUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	copyUploadRing.Reclaim(copyTimeline.GetCompletedValue());
+	return AllocateFromUploadRing(copyUploadRing, copyUploadRingMemory, copyUploadRingBuffer, size, alignment, outAllocation);
+}
+
+bool NullDevice::AllocateFromUploadRing(RingAllocator& ring, std::vector<uint8_t>& memory, RenderHandle buffer, uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	uint64_t offset = ring.Allocate(size, alignment);
+	if (offset == RingAllocator::INVALID_OFFSET)
+		return false;
+
+	outAllocation.buffer = buffer;
+	outAllocation.offset = offset;
+	outAllocation.cpuAddress = memory.data() + offset;
+	statistics.numBytesUploaded += size;
+	return true;
+}
+
+RenderHandle NullDevice::CreateBuffer(uint64_t size, ResourceState initialState)
+{
+	return AddObject(ObjectType::Buffer, initialState, size);
+}
+
+RenderHandle NullDevice::CreateReadbackBuffer(uint64_t size)
+{
+	RenderHandle handle = AddObject(ObjectType::ReadbackBuffer, ResourceState::CopyDest, size);
+	objects[handle - 1].data.resize(static_cast<size_t>((size + sizeof(uint64_t) - 1) / sizeof(uint64_t)));
+	return handle;
+}
+
+const void* NullDevice::MapReadbackBuffer(RenderHandle buffer, uint64_t readBegin, uint64_t readEnd)
+{
+	Object* readbackBuffer = FindObject(buffer, ObjectType::ReadbackBuffer);
+	if (!readbackBuffer || readBegin > readEnd || readEnd > readbackBuffer->size)
+	{
+		ReportValidationError("MapReadbackBuffer: invalid buffer or range.");
+		return nullptr;
+	}
+	return readbackBuffer->data.data();
+}
+
+void NullDevice::UnmapReadbackBuffer(RenderHandle buffer)
+{
+	if (!FindObject(buffer, ObjectType::ReadbackBuffer))
+		ReportValidationError("UnmapReadbackBuffer: invalid buffer.");
+}
+
+RenderHandle NullDevice::CreateTexture(const TextureDesc& desc, ResourceState initialState)
+{
+	// Only an approximation of what GetResourceAllocationInfo reports, the actual layout is up to the driver.
+	// Texels are tiled without row pitch padding, every array slice takes whole 4KB tiles. Like in D3D12, only resources of at most 64KB
+	// in total may use the small placement alignment (D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT), all others need 64KB.
+	// All supported formats have 4 bytes per pixel.
+	const uint64_t smallAlignment = 4 * 1024;
+	const uint64_t defaultAlignment = 64 * 1024;
+	uint64_t sliceSize = AlignUp(static_cast<uint64_t>(desc.width) * desc.height * 4, smallAlignment);
+	uint64_t size = sliceSize * desc.arraySize;
+	uint64_t alignment = size <= defaultAlignment ? smallAlignment : defaultAlignment;
+	size = AlignUp(size, alignment);
+
+	HeapPacker::Allocation allocation;
+	uint64_t newHeapSize;
+	textureHeaps.Allocate(size, alignment, allocation, newHeapSize);
+	RenderHandle texture = AddObject(ObjectType::Texture, initialState, size);
+	objects[texture - 1].allowUnorderedAccess = desc.allowUnorderedAccess;
+	objects[texture - 1].textureAllocation = allocation;
+	return texture;
+}
+
+void NullDevice::GetTextureFootprint(const TextureDesc& desc, TextureFootprint& outFootprint)
+{
+	// All supported formats have 4 bytes per pixel.
+	const uint32_t rowPitchAlignment = 256; // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+	outFootprint.offset = 0;
+	outFootprint.format = desc.format;
+	outFootprint.width = desc.width;
+	outFootprint.height = desc.height;
+	outFootprint.rowSizeInBytes = static_cast<uint64_t>(desc.width) * 4;
+	outFootprint.rowPitch = AlignUp(static_cast<uint32_t>(outFootprint.rowSizeInBytes), rowPitchAlignment);
+	outFootprint.numRows = desc.height;
+	outFootprint.totalSize = static_cast<uint64_t>(outFootprint.rowPitch) * (desc.height - 1) + outFootprint.rowSizeInBytes;
+}
+
+RenderHandle NullDevice::CreateDescriptorHeap(unsigned int numDescriptors)
+{
+	return AddObject(ObjectType::DescriptorHeap, ResourceState::Common, numDescriptors);
+}
+
+void NullDevice::CreateTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc&)
+{
+	if (descriptorIndex >= GetNumDescriptors(descriptorHeap))
+		ReportValidationError("CreateTextureView: invalid descriptor heap or index.");
+	if (!FindObject(texture, ObjectType::Texture))
+		ReportValidationError("CreateTextureView: invalid texture.");
+	++statistics.numDescriptorWrites;
+}
+
+void NullDevice::CreateTextureUnorderedAccessView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc&)
+{
+	if (descriptorIndex >= GetNumDescriptors(descriptorHeap))
+		ReportValidationError("CreateTextureUnorderedAccessView: invalid descriptor heap or index.");
+	const Object* object = FindObject(texture, ObjectType::Texture);
+	if (!object)
+		ReportValidationError("CreateTextureUnorderedAccessView: invalid texture.");
+	else if (!object->allowUnorderedAccess)
+		ReportValidationError("CreateTextureUnorderedAccessView: texture does not allow unordered access.");
+	++statistics.numDescriptorWrites;
+}
+
+RenderHandle NullDevice::CreateIndirectDrawSignature(RenderHandle rootSignature, unsigned int)
+{
+	if (!FindObject(rootSignature, ObjectType::RootSignature))
+	{
+		ReportValidationError("CreateIndirectDrawSignature: invalid root signature.");
+		return INVALID_RENDER_HANDLE;
+	}
+	return AddObject(ObjectType::CommandSignature, ResourceState::Common, 0);
+}
+
+RenderHandle NullDevice::CreateTimestampQueryHeap(unsigned int numQueries)
+{
+	RenderHandle handle = AddObject(ObjectType::QueryHeap, ResourceState::Common, numQueries);
+	objects[handle - 1].data.resize(numQueries);
+	return handle;
+}
+
+RenderHandle NullDevice::CreateRootSignature()
+{
+	return AddObject(ObjectType::RootSignature, ResourceState::Common, 0);
+}
+
+RenderHandle NullDevice::CreatePipelineState()
+{
+	return AddObject(ObjectType::PipelineState, ResourceState::Common, 0);
+}
+
+void NullDevice::ReleaseObject(RenderHandle handle)
+{
+	ObjectType type = GetObjectType(handle);
+	if (type == ObjectType::Invalid || objects[handle - 1].releasePending)
+	{
+		ReportValidationError("ReleaseObject: unknown or already released object.");
+		return;
+	}
+	if (type == ObjectType::Backbuffer || type == ObjectType::RenderTargetView || type == ObjectType::UploadBuffer)
+	{
+		ReportValidationError("ReleaseObject: back buffers and upload memory belong to the device.");
+		return;
+	}
+
+	Object& object = objects[handle - 1];
+	object.releasePending = true;
+	uint64_t sizeInBytes = type == ObjectType::Buffer || type == ObjectType::ReadbackBuffer || type == ObjectType::Texture ? object.size : 0;
+	// Commands that are submitted before the next signal may still use the object.
+	deferredReleaseQueue.Enqueue(frameTimeline.GetLastSignaledValue() + 1, sizeInBytes, [this, handle]() {
+		Object& releasedObject = objects[handle - 1];
+		if (releasedObject.type == ObjectType::Texture)
+			textureHeaps.Free(releasedObject.textureAllocation);
+		releasedObject.type = ObjectType::Invalid;
+		releasedObject.data.clear();
+		releasedObject.data.shrink_to_fit();
+	});
+}
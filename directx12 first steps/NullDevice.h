@@ -0,0 +1,233 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "RenderDevice.h"
+#include "RingAllocator.h"
+#include "FramePacer.h"
+#include "FenceTimeline.h"
+#include "HeapPacker.h"
+
+class NullCommandList;
+
+/// RenderDevice without a GPU. Runs the renderer headless for tests and CPU benchmarks.
+///
+/// Resources are plain CPU memory (only upload and readback buffers have storage) and the "GPU" finishes all work instantly on execution.
+/// Instead of rendering, the device validates API usage and counts what it was asked to do:
+/// recording into closed lists, drawing without the necessary state, executing open lists, barriers whose before-state does not
+/// match the tracked resource state and resetting an allocator the GPU may still use are reported as validation errors.
+/// The copy queue finishes instantly as well, but the device still tracks which copies the direct queue or the CPU waited for
+/// and reports barriers on resources whose copies nobody waited for.
+/// Timestamps count executed draws, so GPU profiler scopes measure draws instead of time.
+///
+/// Independent of D3D12 and Windows.
+class NullDevice : public RenderDevice
+{
+public:
+	/// Totals of all executed command lists and device calls.
+	struct Statistics
+	{
+		uint64_t numDrawCalls;
+		uint64_t numIndirectDraws;
+		uint64_t numDispatches;
+		uint64_t numBarriers;
+		uint64_t numDescriptorWrites;		///< CreateTextureView and CreateTextureUnorderedAccessView calls.
+		uint64_t numDescriptorTableBinds;
+		uint64_t numCopies;
+		uint64_t numBytesCopied;
+		uint64_t numBytesUploaded;			///< Bytes allocated from the upload ring.
+		uint64_t numExecutedCommandLists;
+		uint64_t numExecutedCopyCommandLists;
+		uint64_t numPresents;
+		uint64_t numValidationErrors;
+	};
+
+	static const uint64_t UPLOAD_RING_SIZE = 16 * 1024 * 1024;
+	static const uint64_t COPY_UPLOAD_RING_SIZE = 16 * 1024 * 1024;
+	/// Size of the simulated heaps textures are placed in, like D3D12Device::TEXTURE_HEAP_SIZE.
+	static const uint64_t TEXTURE_HEAP_SIZE = 4 * 1024 * 1024;
+	/// Simulated GPU clock, one tick per executed draw.
+	static const uint64_t TIMESTAMP_FREQUENCY = 1000 * 1000;
+
+	/// numBackbuffers is clamped to [MIN_BACKBUFFERS, MAX_BACKBUFFERS].
+	NullDevice(unsigned int backbufferWidth, unsigned int backbufferHeight, unsigned int numBackbuffers);
+	~NullDevice();
+
+	/// Runs the FramePacer, which never has to wait.
+	void BeginFrame() override;
+	void Present() override;
+	/// Always 0, the GPU finishes everything on submission.
+	unsigned int GetNumFramesInFlight() override					{ return 0; }
+	void WaitForFreeInflightFrame() override;
+	void WaitForIdleGPU() override;
+
+	void SetMaxFramesInFlight(unsigned int numFrames) override;
+	unsigned int GetMaxFramesInFlight() const override				{ return framePacer.GetMaxFramesInFlight(); }
+	void SetFramePacingMode(FramePacingMode mode) override			{ framePacer.SetMode(mode); }
+	FramePacingMode GetFramePacingMode() const override				{ return framePacer.GetMode(); }
+
+	uint64_t GetLastSignaledFenceValue() const override				{ return frameTimeline.GetLastSignaledValue(); }
+	/// The fence passes every signal right away.
+	uint64_t GetCompletedFenceValue() const override				{ return frameTimeline.GetCompletedValue(); }
+
+	std::unique_ptr<RenderCommandList> CreateCommandList() override;
+	/// Replays barriers, timestamps and resolves of the lists in order and adds their statistics.
+	void ExecuteCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists) override;
+
+	std::unique_ptr<RenderCommandList> CreateCopyCommandList() override;
+	uint64_t ExecuteCopyCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists) override;
+	void QueueWaitForCopy(uint64_t copyFenceValue) override;
+	void WaitForCopy(uint64_t copyFenceValue) override;
+	uint64_t GetCompletedCopyFenceValue() const override			{ return copyTimeline.GetCompletedValue(); }
+
+	unsigned int GetBackbufferWidth() const override				{ return backbufferWidth; }
+	unsigned int GetBackbufferHeight() const override				{ return backbufferHeight; }
+	RenderHandle GetCurrentBackbuffer() override					{ return backbuffers[activeBackbufferIndex]; }
+	RenderHandle GetCurrentBackbufferRenderTargetView() override	{ return backbufferRenderTargetViews[activeBackbufferIndex]; }
+
+	bool AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation) override;
+	uint64_t GetUploadRingUsedSize() const override					{ return uploadRing.GetUsedSize(); }
+	bool AllocateCopyUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation) override;
+
+	RenderHandle CreateBuffer(uint64_t size, ResourceState initialState) override;
+	RenderHandle CreateReadbackBuffer(uint64_t size) override;
+	const void* MapReadbackBuffer(RenderHandle buffer, uint64_t readBegin, uint64_t readEnd) override;
+	void UnmapReadbackBuffer(RenderHandle buffer) override;
+
+	RenderHandle CreateTexture(const TextureDesc& desc, ResourceState initialState) override;
+	/// Rows are padded to 256 bytes like on D3D12.
+	void GetTextureFootprint(const TextureDesc& desc, TextureFootprint& outFootprint) override;
+	/// Textures are packed into simulated heaps the same way D3D12Device places them, see HeapPacker.
+	uint64_t GetTextureMemoryCommitted() const override				{ return textureHeaps.GetCommittedSize(); }
+	uint64_t GetTextureMemoryUsed() const override					{ return textureHeaps.GetUsedSize(); }
+
+	RenderHandle CreateDescriptorHeap(unsigned int numDescriptors) override;
+	void CreateTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc) override;
+	void CreateTextureUnorderedAccessView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc) override;
+
+	RenderHandle CreateIndirectDrawSignature(RenderHandle rootSignature, unsigned int drawIDRootParameterIndex) override;
+
+	RenderHandle CreateTimestampQueryHeap(unsigned int numQueries) override;
+	uint64_t GetTimestampFrequency() override						{ return TIMESTAMP_FREQUENCY; }
+
+	/// Released objects become ObjectType::Invalid once the fence passed, so later use is reported as a validation error.
+	/// Handles are never reused.
+	void ReleaseObject(RenderHandle handle) override;
+	const DeferredReleaseQueue::Statistics& GetDeferredReleaseStatistics() const override	{ return deferredReleaseQueue.GetStatistics(); }
+
+	/// Placeholders for the objects that are created by the backend specific shader code on D3D12.
+	RenderHandle CreateRootSignature();
+	RenderHandle CreatePipelineState();
+
+	const Statistics& GetStatistics() const							{ return statistics; }
+	/// Message of the last validation error, empty if there was none.
+	std::string GetLastValidationError() const;
+
+	/// Counts and prints a validation error. Thread safe, command lists report while being recorded.
+	void ReportValidationError(const std::string& message);
+
+	enum class ObjectType
+	{
+		Invalid,
+		Buffer,
+		ReadbackBuffer,
+		UploadBuffer,
+		Texture,
+		Backbuffer,
+		RenderTargetView,
+		DescriptorHeap,
+		CommandSignature,
+		QueryHeap,
+		RootSignature,
+		PipelineState
+	};
+	/// Returns ObjectType::Invalid for unknown handles.
+	ObjectType GetObjectType(RenderHandle handle) const;
+	/// Number of descriptors of a descriptor heap, 0 for other objects.
+	unsigned int GetNumDescriptors(RenderHandle descriptorHeap) const;
+	/// Number of queries of a query heap, 0 for other objects.
+	unsigned int GetNumQueries(RenderHandle queryHeap) const;
+
+private:
+	struct Object
+	{
+		ObjectType type;
+		ResourceState state;			///< Tracked state of buffers and textures as of the last executed command.
+		uint64_t size;					///< Bytes of buffers and textures, descriptors of heaps, queries of query heaps.
+		std::vector<uint64_t> data;		///< Storage of readback buffers and query heaps.
+		bool releasePending;			///< Handed to ReleaseObject, but the fence did not pass yet.
+		uint64_t copyFenceValue;		///< Copy fence value of the last copy queue submission that wrote the resource, 0 if there was none.
+		bool allowUnorderedAccess;		///< Texture created with TextureDesc::allowUnorderedAccess.
+		HeapPacker::Allocation textureAllocation;	///< Where a texture is placed in textureHeaps.
+	};
+
+	RenderHandle AddObject(ObjectType type, ResourceState state, uint64_t size);
+	/// Returns nullptr if the handle does not refer to an object of the given type.
+	Object* FindObject(RenderHandle handle, ObjectType type);
+	const Object* FindObject(RenderHandle handle, ObjectType type) const;
+	/// Replays the deferred commands of an executed list.
+	void ExecuteDeferredCommands(const NullCommandList& commandList);
+	/// Allocates from ring, which is backed by memory and buffer. Everything submitted is done already, so only unsubmitted allocations can fill the ring.
+	bool AllocateFromUploadRing(RingAllocator& ring, std::vector<uint8_t>& memory, RenderHandle buffer, uint64_t size, uint64_t alignment, UploadAllocation& outAllocation);
+	/// Signals the frame timeline, ends the current chunk of the upload ring with the signaled value and returns it.
+	uint64_t SignalFrameTimeline(bool endOfFrame);
+	/// Reclaims upload memory and releases objects the fence passed.
+	void ReclaimCompleted();
+
+	/// Fence that passes every signal right away.
+	class ImmediateFence : public FenceTimeline::Fence
+	{
+	public:
+		ImmediateFence() : value(0) {}
+
+		uint64_t GetCompletedValue() const override							{ return value; }
+		void Signal(uint64_t _value) override								{ value = _value; }
+		void WaitForValue(uint64_t) override								{}
+		void QueueWait(FenceTimeline::Fence&, uint64_t) override			{}
+
+	private:
+		uint64_t value;
+	};
+
+	/// There is no display to wait for.
+	class NoSwapChainSync : public FramePacer::Sync
+	{
+	public:
+		void WaitForSwapChain() override	{}
+	};
+
+	unsigned int backbufferWidth;
+	unsigned int backbufferHeight;
+	std::vector<RenderHandle> backbuffers;
+	std::vector<RenderHandle> backbufferRenderTargetViews;
+	unsigned int activeBackbufferIndex;
+
+	ImmediateFence frameFence;
+	FenceTimeline frameTimeline;
+	NoSwapChainSync frameSync;
+	FramePacer framePacer;
+	uint64_t timestampTicks;		///< Simulated GPU clock.
+
+	RingAllocator uploadRing;
+	std::vector<uint8_t> uploadRingMemory;
+	RenderHandle uploadRingBuffer;
+
+	ImmediateFence copyFence;
+	FenceTimeline copyTimeline;
+	RingAllocator copyUploadRing;
+	std::vector<uint8_t> copyUploadRingMemory;
+	RenderHandle copyUploadRingBuffer;
+	/// Copies up to this value are visible to the direct queue, since it or the CPU waited for them.
+	uint64_t directQueueCopyFenceValue;
+
+	HeapPacker textureHeaps;
+
+	std::vector<Object> objects;	///< Handles are indices + 1.
+	DeferredReleaseQueue deferredReleaseQueue;
+
+	Statistics statistics;
+	mutable std::mutex validationMutex;	///< Guards the validation error counter and message.
+	std::string lastValidationError;
+};
@@ -0,0 +1,155 @@
+#include "PipelineCache.h"
+#include "PipelineDescHash.h"
+#include "Helper.h"
+
+#include <cwchar>
+
+namespace
+{
+	// Overloads for the type specific calls of PipelineCache::CreatePipelineState.
+	HRESULT LoadPipeline(ID3D12PipelineLibrary* library, const wchar_t* name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ComPtr<ID3D12PipelineState>& outPipelineState)
+	{
+		return library->LoadGraphicsPipeline(name, &desc, IID_PPV_ARGS(&outPipelineState));
+	}
+
+	HRESULT LoadPipeline(ID3D12PipelineLibrary* library, const wchar_t* name, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, ComPtr<ID3D12PipelineState>& outPipelineState)
+	{
+		return library->LoadComputePipeline(name, &desc, IID_PPV_ARGS(&outPipelineState));
+	}
+
+	HRESULT CreatePipeline(ID3D12Device* device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, ComPtr<ID3D12PipelineState>& outPipelineState)
+	{
+		return device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&outPipelineState));
+	}
+
+	HRESULT CreatePipeline(ID3D12Device* device, const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, ComPtr<ID3D12PipelineState>& outPipelineState)
+	{
+		return device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&outPipelineState));
+	}
+}
+
+PipelineCache::PipelineCache(ID3D12Device* _device, const std::string& _path) :
+	device(_device),
+	path(_path),
+	file(CacheFile::Format::PipelineLibrary),
+	dirty(false),
+	numHits(0),
+	numMisses(0)
+{
+	// Pipeline libraries are only available from ID3D12Device1 on.
+	if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&device1))))
+	{
+		if (file.Load(path) && file.Find(0))
+			pipelineLibraryData = *file.Find(0);
+
+		// Fails if the library was written by a different driver or device.
+		if (pipelineLibraryData.empty() ||
+			FAILED(device1->CreatePipelineLibrary(pipelineLibraryData.data(), pipelineLibraryData.size(), IID_PPV_ARGS(&pipelineLibrary))))
+		{
+			pipelineLibraryData.clear();
+			dirty = true;
+			if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&pipelineLibrary))))
+				pipelineLibrary.Reset();
+		}
+	}
+
+	if (!pipelineLibrary)
+	{
+		file = CacheFile(CacheFile::Format::CachedBlobs);
+		file.Load(path);
+	}
+}
+
+PipelineCache::~PipelineCache()
+{
+	Save();
+}
+
+bool PipelineCache::CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const void* rootSignatureBlob, size_t rootSignatureBlobSize, ComPtr<ID3D12PipelineState>& outPipelineState)
+{
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC uncachedDesc = desc;
+	uncachedDesc.CachedPSO.pCachedBlob = nullptr;
+	uncachedDesc.CachedPSO.CachedBlobSizeInBytes = 0;
+
+	return CreatePipelineState(uncachedDesc, HashGraphicsPipelineDesc(uncachedDesc, rootSignatureBlob, rootSignatureBlobSize), outPipelineState);
+}
+
+bool PipelineCache::CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const void* rootSignatureBlob, size_t rootSignatureBlobSize, ComPtr<ID3D12PipelineState>& outPipelineState)
+{
+	D3D12_COMPUTE_PIPELINE_STATE_DESC uncachedDesc = desc;
+	uncachedDesc.CachedPSO.pCachedBlob = nullptr;
+	uncachedDesc.CachedPSO.CachedBlobSizeInBytes = 0;
+	return CreatePipelineState(uncachedDesc, HashComputePipelineDesc(uncachedDesc, rootSignatureBlob, rootSignatureBlobSize), outPipelineState);
+}
+
+template<typename PipelineStateDesc>
+bool PipelineCache::CreatePipelineState(const PipelineStateDesc& uncachedDesc, uint64_t key, ComPtr<ID3D12PipelineState>& outPipelineState)
+{
+	if (pipelineLibrary)
+	{
+		wchar_t name[17];
+		swprintf(name, _countof(name), L"%016llx", static_cast<unsigned long long>(key));
+
+		if (SUCCEEDED(LoadPipeline(pipelineLibrary.Get(), name, uncachedDesc, outPipelineState)))
+		{
+			++numHits;
+			return true;
+		}
+
+		++numMisses;
+		if (FAILED(CreatePipeline(device, uncachedDesc, outPipelineState)))
+			return false;
+		if (SUCCEEDED(pipelineLibrary->StorePipeline(name, outPipelineState.Get())))
+			dirty = true;
+		return true;
+	}
+
+	const std::vector<uint8_t>* cachedBlob = file.Find(key);
+	if (cachedBlob)
+	{
+		PipelineStateDesc cachedDesc = uncachedDesc;
+		cachedDesc.CachedPSO.pCachedBlob = cachedBlob->data();
+		cachedDesc.CachedPSO.CachedBlobSizeInBytes = cachedBlob->size();
+		if (SUCCEEDED(CreatePipeline(device, cachedDesc, outPipelineState)))
+		{
+			++numHits;
+			return true;
+		}
+		// Otherwise the blob does not fit to the current driver or device anymore and gets replaced below.
+	}
+
+	++numMisses;
+	if (FAILED(CreatePipeline(device, uncachedDesc, outPipelineState)))
+		return false;
+
+	ComPtr<ID3DBlob> newCachedBlob;
+	if (SUCCEEDED(outPipelineState->GetCachedBlob(&newCachedBlob)))
+	{
+		file.Store(key, newCachedBlob->GetBufferPointer(), newCachedBlob->GetBufferSize());
+		dirty = true;
+	}
+	return true;
+}
+
+void PipelineCache::Save()
+{
+	if (!dirty)
+		return;
+
+	if (pipelineLibrary)
+	{
+		std::vector<uint8_t> serializedLibrary(pipelineLibrary->GetSerializedSize());
+		if (FAILED(pipelineLibrary->Serialize(serializedLibrary.data(), serializedLibrary.size())))
+			return;
+		file.Clear();
+		file.Store(0, serializedLibrary.data(), serializedLibrary.size());
+	}
+
+	if (file.Save(path))
+		dirty = false;
+}
+
+std::string PipelineCache::GetDefaultPath()
+{
+	return GetExecutableDirectory() + "pipelinecache.bin";
+}
\ No newline at end of file
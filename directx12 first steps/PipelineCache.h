@@ -0,0 +1,55 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <string>
+#include <vector>
+
+#include "CacheFile.h"
+
+using namespace Microsoft::WRL;
+
+/// Persistent cache for pipeline state objects so that warm starts skip the driver's shader compilation.
+///
+/// Pipelines are identified by a hash over the shader bytecode, the root signature and the entire pipeline description.
+/// Uses an ID3D12PipelineLibrary if the device supports it and falls back to the pipelines' cached blobs otherwise.
+/// If the driver rejects the cached data (e.g. after a driver update), the pipeline is built from scratch and the cache is rewritten.
+class PipelineCache
+{
+public:
+	PipelineCache(ID3D12Device* device, const std::string& path);
+	~PipelineCache();
+
+	/// Creates a pipeline state, using the cache if possible. desc.CachedPSO is ignored.
+	/// The serialized root signature is needed since the pipeline description only references the root signature object.
+	bool CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const void* rootSignatureBlob, size_t rootSignatureBlobSize, ComPtr<ID3D12PipelineState>& outPipelineState);
+	/// Same as CreateGraphicsPipelineState for compute pipelines.
+	bool CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const void* rootSignatureBlob, size_t rootSignatureBlobSize, ComPtr<ID3D12PipelineState>& outPipelineState);
+
+	/// Writes the cache to disk if there were any changes since the last save.
+	void Save();
+
+	unsigned int GetNumHits() const		{ return numHits; }
+	unsigned int GetNumMisses() const	{ return numMisses; }
+
+	/// Cache file next to the executable.
+	static std::string GetDefaultPath();
+
+private:
+	/// Shared implementation for graphics and compute pipelines. key identifies the uncached desc.
+	template<typename PipelineStateDesc>
+	bool CreatePipelineState(const PipelineStateDesc& uncachedDesc, uint64_t key, ComPtr<ID3D12PipelineState>& outPipelineState);
+
+	ID3D12Device* device;
+	std::string path;
+
+	ComPtr<ID3D12Device1> device1;
+	ComPtr<ID3D12PipelineLibrary> pipelineLibrary;
+	std::vector<uint8_t> pipelineLibraryData; ///< Data the pipeline library was created from. Needs to stay alive as long as the library.
+
+	CacheFile file;
+	bool dirty;
+
+	unsigned int numHits;
+	unsigned int numMisses;
+};
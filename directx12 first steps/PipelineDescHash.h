@@ -0,0 +1,104 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "Hash.h"
+
+// Keys of the PipelineCache. Pure functions of the descriptions that never call into a device.
+// Needs the d3d12.h types, so unlike CacheFile this is Windows only and not part of the headless build and its unit tests.
+
+inline uint64_t HashShaderBytecode(const D3D12_SHADER_BYTECODE& shader, uint64_t hash)
+{
+	hash = HashValue(shader.BytecodeLength, hash);
+	return HashBytes(shader.pShaderBytecode, shader.BytecodeLength, hash);
+}
+
+/// Hashes everything in the description that influences the resulting pipeline.
+/// Structs with padding are hashed member by member since their padding bytes are undefined.
+inline uint64_t HashGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const void* rootSignatureBlob, size_t rootSignatureBlobSize)
+{
+	uint64_t hash = HashBytes(rootSignatureBlob, rootSignatureBlobSize);
+
+	hash = HashShaderBytecode(desc.VS, hash);
+	hash = HashShaderBytecode(desc.PS, hash);
+	hash = HashShaderBytecode(desc.DS, hash);
+	hash = HashShaderBytecode(desc.HS, hash);
+	hash = HashShaderBytecode(desc.GS, hash);
+
+	hash = HashValue(desc.StreamOutput.NumEntries, hash);
+	for (UINT i = 0; i < desc.StreamOutput.NumEntries; ++i)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& entry = desc.StreamOutput.pSODeclaration[i];
+		hash = HashValue(entry.Stream, hash);
+		hash = HashString(entry.SemanticName, hash);
+		hash = HashValue(entry.SemanticIndex, hash);
+		hash = HashValue(entry.StartComponent, hash);
+		hash = HashValue(entry.ComponentCount, hash);
+		hash = HashValue(entry.OutputSlot, hash);
+	}
+	hash = HashValue(desc.StreamOutput.NumStrides, hash);
+	hash = HashBytes(desc.StreamOutput.pBufferStrides, desc.StreamOutput.NumStrides * sizeof(UINT), hash);
+	hash = HashValue(desc.StreamOutput.RasterizedStream, hash);
+
+	hash = HashValue(desc.BlendState.AlphaToCoverageEnable, hash);
+	hash = HashValue(desc.BlendState.IndependentBlendEnable, hash);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : desc.BlendState.RenderTarget)
+	{
+		hash = HashValue(renderTarget.BlendEnable, hash);
+		hash = HashValue(renderTarget.LogicOpEnable, hash);
+		hash = HashValue(renderTarget.SrcBlend, hash);
+		hash = HashValue(renderTarget.DestBlend, hash);
+		hash = HashValue(renderTarget.BlendOp, hash);
+		hash = HashValue(renderTarget.SrcBlendAlpha, hash);
+		hash = HashValue(renderTarget.DestBlendAlpha, hash);
+		hash = HashValue(renderTarget.BlendOpAlpha, hash);
+		hash = HashValue(renderTarget.LogicOp, hash);
+		hash = HashValue(renderTarget.RenderTargetWriteMask, hash);
+	}
+	hash = HashValue(desc.SampleMask, hash);
+	hash = HashValue(desc.RasterizerState, hash);
+
+	hash = HashValue(desc.DepthStencilState.DepthEnable, hash);
+	hash = HashValue(desc.DepthStencilState.DepthWriteMask, hash);
+	hash = HashValue(desc.DepthStencilState.DepthFunc, hash);
+	hash = HashValue(desc.DepthStencilState.StencilEnable, hash);
+	hash = HashValue(desc.DepthStencilState.StencilReadMask, hash);
+	hash = HashValue(desc.DepthStencilState.StencilWriteMask, hash);
+	hash = HashValue(desc.DepthStencilState.FrontFace, hash);
+	hash = HashValue(desc.DepthStencilState.BackFace, hash);
+
+	hash = HashValue(desc.InputLayout.NumElements, hash);
+	for (UINT i = 0; i < desc.InputLayout.NumElements; ++i)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+		hash = HashString(element.SemanticName, hash);
+		hash = HashValue(element.SemanticIndex, hash);
+		hash = HashValue(element.Format, hash);
+		hash = HashValue(element.InputSlot, hash);
+		hash = HashValue(element.AlignedByteOffset, hash);
+		hash = HashValue(element.InputSlotClass, hash);
+		hash = HashValue(element.InstanceDataStepRate, hash);
+	}
+
+	hash = HashValue(desc.IBStripCutValue, hash);
+	hash = HashValue(desc.PrimitiveTopologyType, hash);
+	hash = HashValue(desc.NumRenderTargets, hash);
+	hash = HashValue(desc.RTVFormats, hash);
+	hash = HashValue(desc.DSVFormat, hash);
+	hash = HashValue(desc.SampleDesc, hash);
+	hash = HashValue(desc.NodeMask, hash);
+	hash = HashValue(desc.Flags, hash);
+
+	return hash;
+}
+
+inline uint64_t HashComputePipelineDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, const void* rootSignatureBlob, size_t rootSignatureBlobSize)
+{
+	uint64_t hash = HashBytes(rootSignatureBlob, rootSignatureBlobSize);
+	// Distinguishes compute from graphics pipelines with the same bytecode.
+	hash = HashString("compute", hash);
+	hash = HashShaderBytecode(desc.CS, hash);
+	hash = HashValue(desc.NodeMask, hash);
+	hash = HashValue(desc.Flags, hash);
+	return hash;
+}
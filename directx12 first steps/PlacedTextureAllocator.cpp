@@ -0,0 +1,57 @@
+#include "PlacedTextureAllocator.h"
+
+#include "d3dx12.h"
+
+PlacedTextureAllocator::PlacedTextureAllocator(ID3D12Device* _device, UINT64 _heapSize) :
+	device(_device),
+	packer(_heapSize)
+{
+}
+
+PlacedTextureAllocator::~PlacedTextureAllocator()
+{
+}
+
+bool PlacedTextureAllocator::CreateTexture(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState, ComPtr<ID3D12Resource>& outTexture, HeapPacker::Allocation& outAllocation)
+{
+	// Try small resource alignment first. If the texture is too large for it, GetResourceAllocationInfo reports a bigger alignment.
+	D3D12_RESOURCE_DESC placedDesc = desc;
+	placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device->GetResourceAllocationInfo(0, 1, &placedDesc);
+	if (allocationInfo.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+	{
+		placedDesc.Alignment = 0;
+		allocationInfo = device->GetResourceAllocationInfo(0, 1, &placedDesc);
+	}
+
+	HeapPacker::Allocation allocation;
+	UINT64 newHeapSize;
+	packer.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment, allocation, newHeapSize);
+	if (newHeapSize != 0)
+	{
+		CD3DX12_HEAP_DESC heapDesc(newHeapSize, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES); // Heaps that contain only non-RT/DS textures work on all resource heap tiers.
+		if (allocation.heapIndex >= heaps.size())
+			heaps.resize(allocation.heapIndex + 1);
+		if (FAILED(device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heaps[allocation.heapIndex]))))
+		{
+			packer.Free(allocation);
+			return false;
+		}
+	}
+
+	if (FAILED(device->CreatePlacedResource(heaps[allocation.heapIndex].Get(), allocation.offset, &placedDesc, initialState, nullptr, IID_PPV_ARGS(&outTexture))))
+	{
+		Free(allocation);
+		return false;
+	}
+
+	outAllocation = allocation;
+	return true;
+}
+
+void PlacedTextureAllocator::Free(const HeapPacker::Allocation& allocation)
+{
+	uint32_t emptyHeapIndex = packer.Free(allocation);
+	if (emptyHeapIndex != HeapPacker::INVALID_HEAP)
+		heaps[emptyHeapIndex].Reset();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+#include <vector>
+
+#include "HeapPacker.h"
+
+using namespace Microsoft::WRL;
+
+/// Packs textures as placed resources into large ID3D12Heaps instead of giving every texture its own committed allocation.
+///
+/// Uses the 4KB small resource alignment wherever GetResourceAllocationInfo permits it, otherwise the default 64KB.
+/// Allocation is linear, see HeapPacker: Freed textures give back their heap once all textures in it are freed.
+/// Textures that are larger than the heap size get a heap of their own.
+class PlacedTextureAllocator
+{
+public:
+	/// heapSize needs to be a multiple of D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT.
+	PlacedTextureAllocator(ID3D12Device* device, UINT64 heapSize);
+	~PlacedTextureAllocator();
+
+	/// Creates a texture in the default heap type. Returns false on failure.
+	/// outAllocation needs to be passed to Free once the texture is released and the GPU is done with it.
+	bool CreateTexture(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState, ComPtr<ID3D12Resource>& outTexture, HeapPacker::Allocation& outAllocation);
+	/// Releases the texture's heap if it was the last texture in it.
+	void Free(const HeapPacker::Allocation& allocation);
+
+	/// Memory of all heaps that are alive.
+	UINT64 GetCommittedSize() const	{ return packer.GetCommittedSize(); }
+	/// Memory actually occupied by textures, excluding alignment padding and unused heap space.
+	UINT64 GetUsedSize() const		{ return packer.GetUsedSize(); }
+
+private:
+	ID3D12Device* device;
+	HeapPacker packer;
+	std::vector<ComPtr<ID3D12Heap>> heaps;	///< Indexed by HeapPacker heap index, released heaps are null.
+};
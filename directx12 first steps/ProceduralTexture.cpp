@@ -0,0 +1,194 @@
+#include "ProceduralTexture.h"
+
+#include <cstddef>
+
+// SSE2 is part of every x64 CPU. Elsewhere only if the compiler was told to use it.
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define PROCEDURAL_TEXTURE_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const uint32_t OPAQUE_ALPHA = 0xFF000000u;
+
+	/// Bilinear interpolation of each 8bit channel, weights are in [0, CELL_SIZE].
+	uint32_t InterpolateChannels(uint32_t c00, uint32_t c10, uint32_t c01, uint32_t c11, uint32_t weightX, uint32_t weightY)
+	{
+		const uint32_t cellSize = ProceduralTexture::CELL_SIZE;
+		uint32_t result = 0;
+		for (uint32_t shift = 0; shift < 24; shift += 8)
+		{
+			uint32_t top = ((c00 >> shift) & 0xFF) * (cellSize - weightX) + ((c10 >> shift) & 0xFF) * weightX;
+			uint32_t bottom = ((c01 >> shift) & 0xFF) * (cellSize - weightX) + ((c11 >> shift) & 0xFF) * weightX;
+			result |= ((top * (cellSize - weightY) + bottom * weightY) / (cellSize * cellSize)) << shift;
+		}
+		return result;
+	}
+
+#ifdef PROCEDURAL_TEXTURE_SSE2
+	// The interpolation of the vectorized value noise works on 16bit channels.
+	static_assert(255 * ProceduralTexture::CELL_SIZE * ProceduralTexture::CELL_SIZE <= 0xFFFF, "Cells too large for 16bit interpolation.");
+	// Vectors of the checker pattern are filled with a single color.
+	static_assert(ProceduralTexture::CELL_SIZE >= 4, "Cells smaller than a vector.");
+
+	/// 32bit multiplication of all lanes. SSE2 can only multiply the even lanes (_mm_mullo_epi32 requires SSE4.1), so the odd lanes are shifted down and multiplied separately.
+	__m128i MultiplyLanes(__m128i a, __m128i b)
+	{
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	/// ProceduralTexture::Hash of all lanes.
+	__m128i HashLanes(__m128i value)
+	{
+		value = _mm_xor_si128(value, _mm_srli_epi32(value, 16));
+		value = MultiplyLanes(value, _mm_set1_epi32(0x7feb352d));
+		value = _mm_xor_si128(value, _mm_srli_epi32(value, 15));
+		value = MultiplyLanes(value, _mm_set1_epi32(static_cast<int>(0x846ca68bu)));
+		value = _mm_xor_si128(value, _mm_srli_epi32(value, 16));
+		return value;
+	}
+
+	/// Interpolates between the 16bit channels of two texels (a, b), weight is in [0, CELL_SIZE] per channel.
+	__m128i InterpolateLanes(__m128i a, __m128i b, __m128i weight)
+	{
+		__m128i inverseWeight = _mm_sub_epi16(_mm_set1_epi16(static_cast<short>(ProceduralTexture::CELL_SIZE)), weight);
+		return _mm_add_epi16(_mm_mullo_epi16(a, inverseWeight), _mm_mullo_epi16(b, weight));
+	}
+
+	/// InterpolateChannels for two texels, whose channels are 16bit each.
+	/// weightX has the x weight of each texel in all of its channels.
+	__m128i InterpolateTexelPair(__m128i c00, __m128i c10, __m128i c01, __m128i c11, __m128i weightX, __m128i weightY)
+	{
+		__m128i top = InterpolateLanes(c00, c10, weightX);
+		__m128i bottom = InterpolateLanes(c01, c11, weightX);
+		return _mm_srli_epi16(InterpolateLanes(top, bottom, weightY), 2 * ProceduralTexture::CELL_SIZE_LOG2);
+	}
+
+	/// Writes four texels of a row with value noise. x contains the coordinates of the texels.
+	/// rowTop and rowBottom are the lattice rows above and below, Hash(cellY ^ Hash(seed)) and Hash(cellY + 1 ^ Hash(seed)).
+	__m128i GenerateValueNoise(__m128i x, uint32_t rowTop, uint32_t rowBottom, uint32_t weightY)
+	{
+		__m128i cellX = _mm_srli_epi32(x, ProceduralTexture::CELL_SIZE_LOG2);
+		__m128i nextCellX = _mm_add_epi32(cellX, _mm_set1_epi32(1));
+		__m128i top = _mm_set1_epi32(static_cast<int>(rowTop));
+		__m128i bottom = _mm_set1_epi32(static_cast<int>(rowBottom));
+		__m128i c00 = HashLanes(_mm_xor_si128(cellX, top));
+		__m128i c10 = HashLanes(_mm_xor_si128(nextCellX, top));
+		__m128i c01 = HashLanes(_mm_xor_si128(cellX, bottom));
+		__m128i c11 = HashLanes(_mm_xor_si128(nextCellX, bottom));
+
+		// Widen the channels to 16bit, two texels per register, and repeat each texel's x weight for all of its channels.
+		__m128i zero = _mm_setzero_si128();
+		__m128i weightX = _mm_and_si128(x, _mm_set1_epi32(static_cast<int>(ProceduralTexture::CELL_SIZE - 1)));
+		weightX = _mm_packs_epi32(weightX, weightX);
+		weightX = _mm_unpacklo_epi16(weightX, weightX);
+		__m128i weightXLow = _mm_unpacklo_epi32(weightX, weightX);
+		__m128i weightXHigh = _mm_unpackhi_epi32(weightX, weightX);
+		__m128i weightYLanes = _mm_set1_epi16(static_cast<short>(weightY));
+		__m128i low = InterpolateTexelPair(_mm_unpacklo_epi8(c00, zero), _mm_unpacklo_epi8(c10, zero), _mm_unpacklo_epi8(c01, zero), _mm_unpacklo_epi8(c11, zero),
+											weightXLow, weightYLanes);
+		__m128i high = InterpolateTexelPair(_mm_unpackhi_epi8(c00, zero), _mm_unpackhi_epi8(c10, zero), _mm_unpackhi_epi8(c01, zero), _mm_unpackhi_epi8(c11, zero),
+											weightXHigh, weightYLanes);
+		return _mm_packus_epi16(low, high);
+	}
+#endif
+}
+
+uint32_t ProceduralTexture::GenerateTexel(uint32_t seed, uint32_t x, uint32_t y)
+{
+	switch (GetPattern(seed))
+	{
+	case Pattern::ValueNoise:
+	{
+		uint32_t cellX = x / CELL_SIZE;
+		uint32_t cellY = y / CELL_SIZE;
+		return InterpolateChannels(HashTexel(seed, cellX, cellY), HashTexel(seed, cellX + 1, cellY),
+								HashTexel(seed, cellX, cellY + 1), HashTexel(seed, cellX + 1, cellY + 1),
+								x % CELL_SIZE, y % CELL_SIZE) | OPAQUE_ALPHA;
+	}
+	case Pattern::Checker:
+	{
+		// The two colors are the first two numbers of the seed's stream.
+		uint32_t colorIndex = ((x / CELL_SIZE) ^ (y / CELL_SIZE)) & 1;
+		return Hash(Hash(seed) + colorIndex) | OPAQUE_ALPHA;
+	}
+	case Pattern::Random:
+	default:
+		return HashTexel(seed, x, y) | OPAQUE_ALPHA;
+	}
+}
+
+void ProceduralTexture::Generate(uint32_t seed, uint32_t width, uint32_t height, uint8_t* data, uint32_t rowPitch)
+{
+#ifdef PROCEDURAL_TEXTURE_SSE2
+	// Vectors of four texels, the same math as GenerateTexel but with everything that only depends on the row or seed hoisted.
+	// x86 is little endian, so the lanes' lowest bytes land at the lowest addresses, as R8G8B8A8 requires.
+	const Pattern pattern = GetPattern(seed);
+	const uint32_t seedHash = Hash(seed);
+	const uint32_t vectorWidth = width & ~3u;
+	const __m128i opaqueAlpha = _mm_set1_epi32(static_cast<int>(OPAQUE_ALPHA));
+	const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+	const __m128i checkerColors[2] = { _mm_set1_epi32(static_cast<int>(Hash(seedHash) | OPAQUE_ALPHA)), _mm_set1_epi32(static_cast<int>(Hash(seedHash + 1) | OPAQUE_ALPHA)) };
+
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		uint8_t* row = data + static_cast<size_t>(y) * rowPitch;
+		const uint32_t cellY = y / CELL_SIZE;
+		const uint32_t rowHash = Hash(y ^ seedHash);
+		const uint32_t rowTop = Hash(cellY ^ seedHash);
+		const uint32_t rowBottom = Hash((cellY + 1) ^ seedHash);
+
+		for (uint32_t x = 0; x < vectorWidth; x += 4)
+		{
+			__m128i texels;
+			switch (pattern)
+			{
+			case Pattern::ValueNoise:
+				texels = GenerateValueNoise(_mm_add_epi32(_mm_set1_epi32(static_cast<int>(x)), laneOffsets), rowTop, rowBottom, y % CELL_SIZE);
+				break;
+			case Pattern::Checker:
+				// The four texels start at a multiple of four and cells are at least four wide, so they always share a cell.
+				texels = checkerColors[((x / CELL_SIZE) ^ cellY) & 1];
+				break;
+			case Pattern::Random:
+			default:
+				texels = HashLanes(_mm_xor_si128(_mm_add_epi32(_mm_set1_epi32(static_cast<int>(x)), laneOffsets), _mm_set1_epi32(static_cast<int>(rowHash))));
+				break;
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + x * 4), _mm_or_si128(texels, opaqueAlpha));
+		}
+
+		// Rest of a row whose width is not a multiple of four.
+		for (uint32_t x = vectorWidth; x < width; ++x)
+		{
+			uint32_t texel = GenerateTexel(seed, x, y);
+			row[x * 4 + 0] = static_cast<uint8_t>(texel);
+			row[x * 4 + 1] = static_cast<uint8_t>(texel >> 8);
+			row[x * 4 + 2] = static_cast<uint8_t>(texel >> 16);
+			row[x * 4 + 3] = static_cast<uint8_t>(texel >> 24);
+		}
+	}
+#else
+	GenerateScalar(seed, width, height, data, rowPitch);
+#endif
+}
+
+void ProceduralTexture::GenerateScalar(uint32_t seed, uint32_t width, uint32_t height, uint8_t* data, uint32_t rowPitch)
+{
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		uint8_t* row = data + static_cast<size_t>(y) * rowPitch;
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			// Byte by byte, so that the memory layout matches R8G8B8A8 regardless of the CPU's byte order.
+			uint32_t texel = GenerateTexel(seed, x, y);
+			row[x * 4 + 0] = static_cast<uint8_t>(texel);
+			row[x * 4 + 1] = static_cast<uint8_t>(texel >> 8);
+			row[x * 4 + 2] = static_cast<uint8_t>(texel >> 16);
+			row[x * 4 + 3] = static_cast<uint8_t>(texel >> 24);
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+/// Texture content that is computed from a seed instead of being stored.
+///
+/// Every texel only depends on the seed and its coordinates, via a counter based hash, so texels can be generated in any order and in parallel.
+/// The compute shader in proceduraltexture.hlsl generates the same content on the GPU, this is its CPU reference.
+/// Both only use 32bit integer math, so that their results are bit identical. Keep the two in sync.
+/// Generate computes 4 texels at once with SSE2 where available, GenerateScalar is the plain per texel version it is checked against.
+/// Independent of D3D12 and Windows.
+class ProceduralTexture
+{
+public:
+	/// Chosen by the seed.
+	enum class Pattern : uint32_t
+	{
+		Random,		///< Every texel has a random color.
+		ValueNoise,	///< Random colors on a lattice of CELL_SIZE texels, bilinearly interpolated.
+		Checker		///< Two random colors in squares of CELL_SIZE texels.
+	};
+	static const uint32_t NUM_PATTERNS = 3;
+	static const uint32_t CELL_SIZE_LOG2 = 2;	///< Cells are a power of two, so that vectors can shift instead of divide.
+	static const uint32_t CELL_SIZE = 1u << CELL_SIZE_LOG2;
+
+	/// Integer hash with good avalanche behavior (lowbias32 by Chris Wellons). Hashing a counter gives a stream of random numbers.
+	static uint32_t Hash(uint32_t value)
+	{
+		value ^= value >> 16;
+		value *= 0x7feb352du;
+		value ^= value >> 15;
+		value *= 0x846ca68bu;
+		value ^= value >> 16;
+		return value;
+	}
+	/// Random number for a texel, the base of all patterns.
+	static uint32_t HashTexel(uint32_t seed, uint32_t x, uint32_t y)	{ return Hash(x ^ Hash(y ^ Hash(seed))); }
+
+	static Pattern GetPattern(uint32_t seed)							{ return static_cast<Pattern>(Hash(seed) % NUM_PATTERNS); }
+
+	/// R8G8B8A8 color of a texel, red in the lowest byte. Alpha is always 255.
+	static uint32_t GenerateTexel(uint32_t seed, uint32_t x, uint32_t y);
+	/// Writes width x height R8G8B8A8 texels, rows start rowPitch bytes apart. Vectorized, falls back to GenerateScalar on CPUs without SSE2.
+	/// Touches nothing but data, so different textures can be generated on different threads.
+	static void Generate(uint32_t seed, uint32_t width, uint32_t height, uint8_t* data, uint32_t rowPitch);
+	/// Same result as Generate, one texel at a time.
+	static void GenerateScalar(uint32_t seed, uint32_t width, uint32_t height, uint8_t* data, uint32_t rowPitch);
+};
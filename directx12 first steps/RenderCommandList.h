@@ -0,0 +1,55 @@
+#pragma once
+
+#include "RenderTypes.h"
+
+/// Command list of a RenderDevice. Mirrors the subset of ID3D12GraphicsCommandList that is used by the renderer.
+///
+/// Every list owns a command allocator for each in-flight frame, Reset picks the one of the given frame.
+/// Like in D3D12, a list may only be recorded by a single thread at a time, but different lists may be recorded in parallel.
+///
+/// Independent of D3D12 and Windows.
+class RenderCommandList
+{
+public:
+	virtual ~RenderCommandList() {}
+
+	/// Resets the allocator of the given frame and starts recording. The GPU needs to be done with everything previously recorded for this frame.
+	/// pipelineState may be INVALID_RENDER_HANDLE.
+	virtual bool Reset(unsigned int frameQueueIndex, RenderHandle pipelineState) = 0;
+	virtual bool Close() = 0;
+
+	virtual void SetPipelineState(RenderHandle pipelineState) = 0;
+	virtual void SetGraphicsRootSignature(RenderHandle rootSignature) = 0;
+	virtual void SetViewport(const Viewport& viewport) = 0;
+	virtual void SetScissorRect(const ScissorRect& scissorRect) = 0;
+	virtual void ResourceBarriers(const ResourceBarrier* barriers, unsigned int numBarriers) = 0;
+	virtual void SetRenderTarget(RenderHandle renderTargetView) = 0;
+	virtual void ClearRenderTarget(RenderHandle renderTargetView, const float color[4]) = 0;
+
+	virtual void SetPrimitiveTopology(PrimitiveTopology topology) = 0;
+	virtual void SetVertexBuffer(const VertexBufferView& view) = 0;
+	/// Shader visible descriptor heap, see RenderDevice::CreateDescriptorHeap.
+	virtual void SetDescriptorHeap(RenderHandle descriptorHeap) = 0;
+	/// Binds the descriptor table starting at the given descriptor of the currently set heap.
+	virtual void SetGraphicsRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) = 0;
+	virtual void SetGraphicsRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) = 0;
+
+	virtual void DrawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) = 0;
+	/// countBuffer may be INVALID_RENDER_HANDLE, maxCommandCount draws are executed then.
+	virtual void ExecuteIndirect(RenderHandle commandSignature, uint32_t maxCommandCount, RenderHandle argumentBuffer, uint64_t argumentBufferOffset,
+								RenderHandle countBuffer, uint64_t countBufferOffset) = 0;
+
+	/// Compute state is separate from the graphics state, except for the pipeline state and the descriptor heap.
+	virtual void SetComputeRootSignature(RenderHandle rootSignature) = 0;
+	virtual void SetComputeRootDescriptorTable(unsigned int rootParameterIndex, RenderHandle descriptorHeap, unsigned int firstDescriptor) = 0;
+	virtual void SetComputeRoot32BitConstant(unsigned int rootParameterIndex, uint32_t value, unsigned int destOffsetIn32BitValues) = 0;
+	/// Runs the compute shader of the current pipeline state.
+	virtual void Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ) = 0;
+
+	virtual void CopyBufferRegion(RenderHandle destBuffer, uint64_t destOffset, RenderHandle sourceBuffer, uint64_t sourceOffset, uint64_t numBytes) = 0;
+	virtual void CopyBufferToTexture(RenderHandle destTexture, unsigned int destSubresource, RenderHandle sourceBuffer, const TextureFootprint& sourceFootprint) = 0;
+
+	virtual void WriteTimestamp(RenderHandle queryHeap, unsigned int queryIndex) = 0;
+	/// Copies numQueries timestamps as uint64_t to a readback buffer.
+	virtual void ResolveTimestamps(RenderHandle queryHeap, unsigned int firstQuery, unsigned int numQueries, RenderHandle destBuffer, uint64_t destOffset) = 0;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <memory>
+
+#include "RenderTypes.h"
+#include "DeferredReleaseQueue.h"
+
+class RenderCommandList;
+
+/// Device, direct queue, copy queue and swap chain of a render backend.
+///
+/// The interface covers what the renderer needs to create its scene resources and to run its frame loop,
+/// so that the same code runs on D3D12 (D3D12Device) and headless without a GPU (NullDevice).
+/// Objects created by the device live as long as the device, unless they are handed to ReleaseObject.
+///
+/// Independent of D3D12 and Windows.
+class RenderDevice
+{
+public:
+	/// Upper limit for the frames in flight. Every command list has as many allocators.
+	static const unsigned int MAX_FRAMES_INFLIGHT = 3;
+	/// Range of swap chain buffer counts the devices accept at creation.
+	static const unsigned int MIN_BACKBUFFERS = 2;
+	static const unsigned int MAX_BACKBUFFERS = 16;
+
+	virtual ~RenderDevice() {}
+
+	/// Call before recording a frame. In FramePacingMode::Latency, waits until the swap chain accepts another frame and a set of frame resources is available.
+	virtual void BeginFrame() = 0;
+	/// Swaps the back buffer and signals the frame fence.
+	virtual void Present() = 0;
+	/// How many frames the CPU has submitted that are not yet completed by the GPU.
+	virtual unsigned int GetNumFramesInFlight() = 0;
+	/// Call after Present. In FramePacingMode::Throughput, waits until only GetMaxFramesInFlight()-1 frames are in flight so that a set of frame resources is available.
+	virtual void WaitForFreeInflightFrame() = 0;
+	/// Waits until the GPU finished everything that was submitted, on the direct and the copy queue.
+	virtual void WaitForIdleGPU() = 0;
+
+	/// Limits the number of frames in flight below MAX_FRAMES_INFLIGHT.
+	virtual void SetMaxFramesInFlight(unsigned int numFrames) = 0;
+	virtual unsigned int GetMaxFramesInFlight() const = 0;
+	/// Can be changed between frames.
+	virtual void SetFramePacingMode(FramePacingMode mode) = 0;
+	virtual FramePacingMode GetFramePacingMode() const = 0;
+
+	/// Fence value that was signaled after the last presented frame.
+	virtual uint64_t GetLastSignaledFenceValue() const = 0;
+	virtual uint64_t GetCompletedFenceValue() const = 0;
+
+	/// Creates a direct command list with one allocator per in-flight frame. The list is closed.
+	virtual std::unique_ptr<RenderCommandList> CreateCommandList() = 0;
+	/// All lists need to be closed. Executed in the given order.
+	virtual void ExecuteCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists) = 0;
+
+	/// Creates a command list for the copy queue with one allocator per in-flight frame. The list is closed.
+	/// Only copies may be recorded. Resources the copy queue writes need to be in ResourceState::Common, they return to it once the copy is done.
+	virtual std::unique_ptr<RenderCommandList> CreateCopyCommandList() = 0;
+	/// Executes closed copy lists on the copy queue, which runs independently of the direct queue, and signals the copy fence.
+	/// Returns the copy fence value that is reached once the lists are done.
+	virtual uint64_t ExecuteCopyCommandLists(RenderCommandList* const* commandLists, unsigned int numCommandLists) = 0;
+	/// Lets the direct queue wait on the GPU until the copy fence reached copyFenceValue before it executes anything submitted afterwards.
+	/// Never blocks the CPU. Call it for every copy the direct queue depends on, even if the copy is known to be done, it is skipped then.
+	virtual void QueueWaitForCopy(uint64_t copyFenceValue) = 0;
+	/// Blocks the CPU until the copy fence reached copyFenceValue.
+	virtual void WaitForCopy(uint64_t copyFenceValue) = 0;
+	virtual uint64_t GetCompletedCopyFenceValue() const = 0;
+
+	virtual unsigned int GetBackbufferWidth() const = 0;
+	virtual unsigned int GetBackbufferHeight() const = 0;
+	/// Back buffer the current frame renders to. Is in ResourceState::Present outside of a frame.
+	virtual RenderHandle GetCurrentBackbuffer() = 0;
+	virtual RenderHandle GetCurrentBackbufferRenderTargetView() = 0;
+
+	/// Allocates memory from the upload ring that stays valid until the next frame fence signal has been passed by the GPU.
+	/// Waits for the GPU if the ring is full. Returns false if the ring is too small for the requested allocation.
+	virtual bool AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation) = 0;
+	/// Bytes of the upload ring that are waiting for the GPU or not yet submitted.
+	virtual uint64_t GetUploadRingUsedSize() const = 0;
+	/// Upload memory for copy lists from a separate ring. Stays valid until the copy fence passed the value returned by the next ExecuteCopyCommandLists.
+	/// Waits for the copy queue if the ring is full. Returns false if the ring is too small for the requested allocation.
+	virtual bool AllocateCopyUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation) = 0;
+
+	/// Buffer in GPU memory.
+	virtual RenderHandle CreateBuffer(uint64_t size, ResourceState initialState) = 0;
+	/// Buffer that the GPU can copy to and the CPU can read from.
+	virtual RenderHandle CreateReadbackBuffer(uint64_t size) = 0;
+	/// Returns nullptr on failure. The range [readBegin, readEnd) is the part that will be read.
+	virtual const void* MapReadbackBuffer(RenderHandle buffer, uint64_t readBegin, uint64_t readEnd) = 0;
+	virtual void UnmapReadbackBuffer(RenderHandle buffer) = 0;
+
+	virtual RenderHandle CreateTexture(const TextureDesc& desc, ResourceState initialState) = 0;
+	/// Layout of a single subresource of textures with this desc in an upload buffer. The returned offset is 0.
+	virtual void GetTextureFootprint(const TextureDesc& desc, TextureFootprint& outFootprint) = 0;
+	/// Memory reserved for textures and memory actually occupied by them.
+	virtual uint64_t GetTextureMemoryCommitted() const = 0;
+	virtual uint64_t GetTextureMemoryUsed() const = 0;
+
+	/// Shader visible heap for shader resource and unordered access views.
+	virtual RenderHandle CreateDescriptorHeap(unsigned int numDescriptors) = 0;
+	/// Writes a shader resource view of the whole texture (Texture2D or Texture2DArray depending on the array size) into a descriptor heap.
+	virtual void CreateTextureView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc) = 0;
+	/// Writes an unordered access view of all slices of the texture (always a RWTexture2DArray) into a descriptor heap.
+	/// The texture needs to be created with TextureDesc::allowUnorderedAccess.
+	virtual void CreateTextureUnorderedAccessView(RenderHandle descriptorHeap, unsigned int descriptorIndex, RenderHandle texture, const TextureDesc& desc) = 0;
+
+	/// Signature for ExecuteIndirect with arguments laid out as IndirectDrawCommand. The draw ID is written to the given 32bit constant root parameter.
+	virtual RenderHandle CreateIndirectDrawSignature(RenderHandle rootSignature, unsigned int drawIDRootParameterIndex) = 0;
+
+	virtual RenderHandle CreateTimestampQueryHeap(unsigned int numQueries) = 0;
+	/// Ticks per second of timestamps written on the direct queue.
+	virtual uint64_t GetTimestampFrequency() = 0;
+
+	/// Destroys an object created by the device once the GPU finished everything that is submitted before the next fence signal,
+	/// i.e. it may still be used by command lists of the current frame. The handle must not be used by later frames.
+	/// Copies into the object need to be done before it is released.
+	/// Never waits for the GPU. Back buffers and upload memory can not be released.
+	virtual void ReleaseObject(RenderHandle handle) = 0;
+	virtual const DeferredReleaseQueue::Statistics& GetDeferredReleaseStatistics() const = 0;
+};
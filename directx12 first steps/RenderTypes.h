@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+// Backend independent types used by RenderDevice and RenderCommandList.
+// Independent of D3D12 and Windows.
+
+/// Opaque reference to an object of the render backend. Backends decide what it refers to, 0 is never a valid handle.
+typedef uint64_t RenderHandle;
+const RenderHandle INVALID_RENDER_HANDLE = 0;
+
+/// Subset of resource states that is used by the application. Map directly to D3D12_RESOURCE_STATES.
+enum class ResourceState
+{
+	Common,
+	Present,
+	RenderTarget,
+	CopyDest,
+	PixelShaderResource,
+	VertexAndConstantBuffer,
+	IndirectArgument,
+	UnorderedAccess
+};
+
+/// When the CPU waits for the GPU and the swap chain, see FramePacer.
+enum class FramePacingMode
+{
+	Throughput,	///< Waits for the GPU right after presenting, so that the next frame is recorded as early as possible.
+	Latency		///< Waits for the swap chain and the GPU right before recording, so that the recorded frame is as fresh as possible when it is shown.
+};
+
+enum class PrimitiveTopology
+{
+	TriangleList,
+	TriangleStrip
+};
+
+enum class TextureFormat
+{
+	R8G8B8A8_UNORM
+};
+
+/// 2D texture or texture array with a single mip level.
+struct TextureDesc
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t arraySize;
+	TextureFormat format;
+	bool allowUnorderedAccess;	///< Needed for RenderDevice::CreateTextureUnorderedAccessView.
+};
+
+/// Layout of a single texture subresource within a buffer, as needed for copies between buffers and textures.
+struct TextureFootprint
+{
+	uint64_t offset;		///< Offset of the subresource within the buffer. Needs to be aligned to TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+	TextureFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t rowPitch;		///< Distance between rows in bytes. Usually larger than rowSizeInBytes.
+	uint32_t numRows;
+	uint64_t rowSizeInBytes;
+	uint64_t totalSize;		///< Size of the subresource in the buffer including row padding.
+};
+/// Required alignment of TextureFootprint::offset.
+const uint64_t TEXTURE_DATA_PLACEMENT_ALIGNMENT = 512;
+
+struct Viewport
+{
+	float topLeftX;
+	float topLeftY;
+	float width;
+	float height;
+	float minDepth;
+	float maxDepth;
+};
+
+struct ScissorRect
+{
+	int32_t left;
+	int32_t top;
+	int32_t right;
+	int32_t bottom;
+};
+
+struct VertexBufferView
+{
+	RenderHandle buffer;
+	uint32_t sizeInBytes;
+	uint32_t strideInBytes;
+};
+
+/// Transition of a whole resource from one state to another.
+struct ResourceBarrier
+{
+	RenderHandle resource;
+	ResourceState before;
+	ResourceState after;
+};
+
+/// Range of CPU writable upload memory that stays valid until the GPU passed the next frame fence signal.
+struct UploadAllocation
+{
+	RenderHandle buffer;
+	uint64_t offset;		///< Offset within buffer.
+	uint8_t* cpuAddress;
+};
+
+/// Layout of a single command in an indirect argument buffer that is consumed with a signature from RenderDevice::CreateIndirectDrawSignature.
+/// Sets a single 32bit root constant and draws.
+struct IndirectDrawCommand
+{
+	uint32_t drawID;
+	uint32_t vertexCountPerInstance;
+	uint32_t instanceCount;
+	uint32_t startVertexLocation;
+	uint32_t startInstanceLocation;
+};
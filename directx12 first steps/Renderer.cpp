@@ -0,0 +1,682 @@
+#include "Renderer.h"
+#include "RenderCommandList.h"
+
+#include "Helper.h"
+#include "JobSystem.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "CapturingDevice.h"
+#include "ProceduralTexture.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+Renderer::Configuration::Configuration() :
+	numTextures(1000),
+	textureBinding(TextureBinding::DescriptorTablePerDraw),
+	drawSubmission(DrawSubmission::DrawPerTexture),
+	indirectCountBuffer(false),
+	numRecordingThreads(1),
+	frameBudgetMilliseconds(1000.0 / 60.0),
+	numFramesInFlight(RenderDevice::MAX_FRAMES_INFLIGHT),
+	framePacing(FramePacingMode::Throughput),
+	numBackbuffers(3),
+	captureCommands(false),
+	copyQueueUploads(true),
+	gpuTextureGeneration(false)
+{
+}
+
+Renderer::Renderer(const Configuration& _configuration, RenderDevice& _device, JobSystem& _jobSystem, RenderHandle _rootSignature, RenderHandle _pipelineState,
+					RenderHandle _generationRootSignature, RenderHandle _generationPipelineState) :
+	configuration(_configuration),
+	capturingDevice(_configuration.captureCommands ? new CapturingDevice(_device) : nullptr),
+	device(capturingDevice ? *capturingDevice : _device),
+	jobSystem(_jobSystem),
+	rootSignature(_rootSignature),
+	pipelineState(_pipelineState),
+	generationRootSignature(_generationRootSignature),
+	generationPipelineState(_generationPipelineState),
+	frameQueueIndex(0),
+	frameBegun(false),
+	beginFrameWaitMilliseconds(0.0),
+	vertexBufferView(),
+	textureDescriptorHeap(INVALID_RENDER_HANDLE),
+	nextTextureSeed(0),
+	commandSignature(INVALID_RENDER_HANDLE),
+	indirectArgumentBuffer(INVALID_RENDER_HANDLE),
+	indirectCountOffset(0),
+	copyListAllocator(0),
+	lastCopyFenceValue(0),
+	streamedTextureDescriptorHeap(INVALID_RENDER_HANDLE)
+{
+	lastFrameTimings = {};
+	for (auto& fenceValue : copyListFenceValues)
+		fenceValue = 0;
+	pendingUploads.copyFenceValue = 0;
+	streamedTextureUploads.copyFenceValue = 0;
+	device.SetMaxFramesInFlight(configuration.numFramesInFlight);
+	device.SetFramePacingMode(configuration.framePacing);
+
+	commandList = device.CreateCommandList();
+	if (!commandList)
+		CRITICAL_ERROR("Failed to create command list");
+
+	// Additional command lists for the worker threads.
+	if (configuration.numRecordingThreads > 1)
+		workerCommandLists.resize(configuration.numRecordingThreads - 1);
+	for (auto& workerCommandList : workerCommandLists)
+	{
+		workerCommandList = device.CreateCommandList();
+		if (!workerCommandList)
+			CRITICAL_ERROR("Failed to create command list");
+	}
+
+	if (configuration.copyQueueUploads)
+	{
+		copyCommandList = device.CreateCopyCommandList();
+		if (!copyCommandList)
+			CRITICAL_ERROR("Failed to create copy command list");
+	}
+
+	gpuProfiler.reset(new GpuProfiler(device, RenderDevice::MAX_FRAMES_INFLIGHT));
+
+	CreateVertexBuffer();
+
+	auto textureCreationBegin = std::chrono::high_resolution_clock::now();
+	CreateTextures(textures, textureDescriptorHeap, pendingUploads, pendingTextureGenerations);
+	auto textureCreationEnd = std::chrono::high_resolution_clock::now();
+
+	if (configuration.drawSubmission == DrawSubmission::ExecuteIndirect)
+		CreateIndirectArguments();
+
+	// Configure viewport and scissor rect.
+	viewport.topLeftX = 0.0f;
+	viewport.topLeftY = 0.0f;
+	viewport.width = static_cast<float>(device.GetBackbufferWidth());
+	viewport.height = static_cast<float>(device.GetBackbufferHeight());
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	scissorRect.left = 0;
+	scissorRect.top = 0;
+	scissorRect.right = static_cast<int32_t>(device.GetBackbufferWidth());
+	scissorRect.bottom = static_cast<int32_t>(device.GetBackbufferHeight());
+
+	std::cerr << "Created " << configuration.numTextures << " textures in " << std::chrono::duration_cast<std::chrono::microseconds>(textureCreationEnd - textureCreationBegin).count() / 1000.0 << " ms" << std::endl;
+	std::cerr << "Texture memory: " << device.GetTextureMemoryUsed() / 1024 << " KB used of " << device.GetTextureMemoryCommitted() / 1024 << " KB committed" << std::endl;
+}
+
+Renderer::~Renderer()
+{
+	// Command lists, the profiler's buffers and streamed textures may still be in use.
+	device.WaitForIdleGPU();
+
+	// The device destroys them once the GPU is done, which it already is.
+	for (RenderHandle texture : textures)
+		device.ReleaseObject(texture);
+	for (RenderHandle texture : streamedTextures)
+		device.ReleaseObject(texture);
+	if (streamedTextureDescriptorHeap != INVALID_RENDER_HANDLE)
+		device.ReleaseObject(streamedTextureDescriptorHeap);
+	device.ReleaseObject(vertexBufferView.buffer);
+	if (textureDescriptorHeap != INVALID_RENDER_HANDLE)
+		device.ReleaseObject(textureDescriptorHeap);
+	if (commandSignature != INVALID_RENDER_HANDLE)
+		device.ReleaseObject(commandSignature);
+	if (indirectArgumentBuffer != INVALID_RENDER_HANDLE)
+		device.ReleaseObject(indirectArgumentBuffer);
+}
+
+void Renderer::ExecuteAndWait()
+{
+	if (!commandList->Close())
+		CRITICAL_ERROR("Failed to close the command list.");
+	RenderCommandList* commandLists[] = { commandList.get() };
+	device.ExecuteCommandLists(commandLists, 1);
+	device.WaitForIdleGPU();
+}
+
+void Renderer::BeginUploads()
+{
+	if (configuration.copyQueueUploads)
+	{
+		// The copy queue needs to be done with the previous uploads of this allocator, usually it is long done.
+		device.WaitForCopy(copyListFenceValues[copyListAllocator]);
+		if (!copyCommandList->Reset(copyListAllocator, INVALID_RENDER_HANDLE))
+			CRITICAL_ERROR("Failed to reset the copy command list.");
+	}
+	else
+	{
+		// Frames in flight may still use the allocators of the main list.
+		device.WaitForIdleGPU();
+		if (!commandList->Reset(0, INVALID_RENDER_HANDLE))
+			CRITICAL_ERROR("Failed to reset the command list.");
+	}
+}
+
+bool Renderer::AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation)
+{
+	if (configuration.copyQueueUploads)
+		return device.AllocateCopyUploadMemory(size, alignment, outAllocation);
+	return device.AllocateUploadMemory(size, alignment, outAllocation);
+}
+
+void Renderer::SubmitUploads()
+{
+	if (!configuration.copyQueueUploads)
+	{
+		ExecuteAndWait();
+		return;
+	}
+
+	if (!copyCommandList->Close())
+		CRITICAL_ERROR("Failed to close the copy command list.");
+	RenderCommandList* commandLists[] = { copyCommandList.get() };
+	lastCopyFenceValue = device.ExecuteCopyCommandLists(commandLists, 1);
+	copyListFenceValues[copyListAllocator] = lastCopyFenceValue;
+	copyListAllocator = (copyListAllocator + 1) % RenderDevice::MAX_FRAMES_INFLIGHT;
+}
+
+void Renderer::EndUploads(const std::vector<ResourceBarrier>& barriers, CopyQueueUploads& uploads)
+{
+	if (!configuration.copyQueueUploads)
+	{
+		commandList->ResourceBarriers(barriers.data(), static_cast<unsigned int>(barriers.size()));
+		SubmitUploads();
+		return;
+	}
+
+	// Copy lists can not transition to the states the direct queue uses, so the direct queue does it after waiting for the copies.
+	SubmitUploads();
+	uploads.barriers.insert(uploads.barriers.end(), barriers.begin(), barriers.end());
+	uploads.copyFenceValue = lastCopyFenceValue;
+}
+
+void Renderer::CreateVertexBuffer()
+{
+	struct Vertex
+	{
+		float position[2];
+		float texcoord[2];
+	};
+
+	// Define the geometry for a quad.
+	float screenAspectRatio = static_cast<float>(device.GetBackbufferWidth()) / device.GetBackbufferHeight();
+	Vertex quadVertices[] =
+	{
+		{ { -0.25f, -0.25f * screenAspectRatio }, { 0.0f, 0.0f } },
+		{ { -0.25f, 0.25f * screenAspectRatio },{ 0.0f, 1.0f } },
+		{ { 0.25f, -0.25f * screenAspectRatio },{ 1.0f, 0.0f } },
+		{ { 0.25f, 0.25f * screenAspectRatio },{ 1.0f, 1.0f } }
+	};
+
+	const unsigned int vertexBufferSize = sizeof(quadVertices);
+
+	// Get upload memory for the vertex data.
+	UploadAllocation uploadMemory;
+	if (!AllocateUploadMemory(vertexBufferSize, sizeof(float), uploadMemory))
+		CRITICAL_ERROR("Failed to allocate upload memory for vertex buffer.");
+	memcpy(uploadMemory.cpuAddress, quadVertices, sizeof(quadVertices));
+
+	// Create vertex buffer.
+	RenderHandle vertexBuffer = device.CreateBuffer(vertexBufferSize, GetUploadState());
+	if (vertexBuffer == INVALID_RENDER_HANDLE)
+		CRITICAL_ERROR("Failed to create vertex buffer.");
+
+	// Copy over.
+	BeginUploads();
+	GetUploadCommandList().CopyBufferRegion(vertexBuffer, 0, uploadMemory.buffer, uploadMemory.offset, vertexBufferSize);
+	std::vector<ResourceBarrier> barriers = { { vertexBuffer, GetUploadState(), ResourceState::VertexAndConstantBuffer } };
+	EndUploads(barriers, pendingUploads);
+
+	// Initialize the vertex buffer view.
+	vertexBufferView.buffer = vertexBuffer;
+	vertexBufferView.strideInBytes = sizeof(Vertex);
+	vertexBufferView.sizeInBytes = vertexBufferSize;
+}
+
+void Renderer::CreateTextures(std::vector<RenderHandle>& outTextures, RenderHandle& outDescriptorHeap, CopyQueueUploads& uploads, std::vector<TextureGeneration>& generations)
+{
+	// Generated textures have a UAV each, after all SRVs.
+	const unsigned int numTextureResources = configuration.textureBinding == TextureBinding::TextureArray ? 1 : configuration.numTextures;
+	outDescriptorHeap = device.CreateDescriptorHeap(configuration.gpuTextureGeneration ? numTextureResources * 2 : numTextureResources);
+	if (outDescriptorHeap == INVALID_RENDER_HANDLE)
+		CRITICAL_ERROR("Failed to create texture descriptor heap.");
+
+	// Texture desc, used by all textures or all slices of the texture array.
+	TextureDesc textureDesc;
+	textureDesc.width = TEXTURE_SIZE;
+	textureDesc.height = TEXTURE_SIZE;
+	textureDesc.arraySize = 1;
+	textureDesc.format = TextureFormat::R8G8B8A8_UNORM;
+	textureDesc.allowUnorderedAccess = configuration.gpuTextureGeneration;
+	const ResourceState initialState = configuration.gpuTextureGeneration ? ResourceState::UnorderedAccess : GetUploadState();
+
+	// Since all textures share the same desc, they also share the same layout within the upload buffer.
+	// This is also true for the slices of the texture array, so the footprint is queried before setting the array size.
+	TextureFootprint textureFootprint;
+	device.GetTextureFootprint(textureDesc, textureFootprint);
+
+	// All textures either go into a single array with a single SRV or are separate resources with one SRV each.
+	if (configuration.textureBinding == TextureBinding::TextureArray)
+	{
+		const unsigned int maxTextureArraySize = 2048; // D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION
+		if (configuration.numTextures > maxTextureArraySize)
+			CRITICAL_ERROR("Too many textures for a texture array.");
+		textureDesc.arraySize = configuration.numTextures;
+		outTextures.resize(1);
+	}
+	else
+		outTextures.resize(configuration.numTextures);
+
+	if (!configuration.gpuTextureGeneration)
+		BeginUploads();
+
+	std::vector<ResourceBarrier> barriers;
+	barriers.reserve(outTextures.size());
+	// Upload memory is only filled before the copies are submitted, so that all textures of a submission are generated in parallel.
+	std::vector<TextureData> textureData;
+
+	// Create the textures.
+	for (unsigned int tex = 0; tex < configuration.numTextures; ++tex)
+	{
+		unsigned int resourceIndex = configuration.textureBinding == TextureBinding::TextureArray ? 0 : tex;
+		unsigned int subresource = configuration.textureBinding == TextureBinding::TextureArray ? tex : 0;
+
+		// Create texture
+		if (subresource == 0)
+		{
+			outTextures[resourceIndex] = device.CreateTexture(textureDesc, initialState);
+			if (outTextures[resourceIndex] == INVALID_RENDER_HANDLE)
+				CRITICAL_ERROR("Failed to create texture");
+
+			device.CreateTextureView(outDescriptorHeap, resourceIndex, outTextures[resourceIndex], textureDesc);
+
+			if (configuration.gpuTextureGeneration)
+			{
+				TextureGeneration generation = { outTextures[resourceIndex], outDescriptorHeap, numTextureResources + resourceIndex, nextTextureSeed, textureDesc };
+				device.CreateTextureUnorderedAccessView(outDescriptorHeap, generation.uavDescriptor, generation.texture, textureDesc);
+				generations.push_back(generation);
+			}
+			else
+			{
+				// The transitions are gathered and issued all at once after all copies.
+				ResourceBarrier barrier = { outTextures[resourceIndex], GetUploadState(), ResourceState::PixelShaderResource };
+				barriers.push_back(barrier);
+			}
+		}
+
+		// Slices of the texture array use consecutive seeds, like the generation shader.
+		uint32_t seed = nextTextureSeed++;
+		if (configuration.gpuTextureGeneration)
+			continue;
+
+		// Fill the texture's part of the upload ring directly, respecting the row pitch.
+		UploadAllocation uploadMemory;
+		if (!AllocateUploadMemory(textureFootprint.totalSize, TEXTURE_DATA_PLACEMENT_ALIGNMENT, uploadMemory))
+		{
+			// The upload ring is full of copies that were not submitted yet. Submit them so that the ring can be reused.
+			GenerateTextureData(textureData, textureFootprint);
+			SubmitUploads();
+			BeginUploads();
+
+			if (!AllocateUploadMemory(textureFootprint.totalSize, TEXTURE_DATA_PLACEMENT_ALIGNMENT, uploadMemory))
+				CRITICAL_ERROR("Failed to allocate upload memory for texture.");
+		}
+		TextureFootprint placedFootprint = textureFootprint;
+		placedFootprint.offset = uploadMemory.offset;
+		TextureData data = { seed, uploadMemory.cpuAddress };
+		textureData.push_back(data);
+
+		// Record copy, the data is generated before it is submitted.
+		GetUploadCommandList().CopyBufferToTexture(outTextures[resourceIndex], subresource, uploadMemory.buffer, placedFootprint);
+	}
+
+	// Submit all copies at once and wait at most a single time.
+	if (!configuration.gpuTextureGeneration)
+	{
+		GenerateTextureData(textureData, textureFootprint);
+		EndUploads(barriers, uploads);
+	}
+}
+
+void Renderer::GenerateTextureData(std::vector<TextureData>& textures, const TextureFootprint& footprint)
+{
+	// Every texture writes to its own upload memory.
+	jobSystem.ParallelFor(0, static_cast<unsigned int>(textures.size()), NUM_TEXTURES_PER_GENERATION_JOB, [&textures, &footprint](unsigned int begin, unsigned int end) {
+		for (unsigned int tex = begin; tex < end; ++tex)
+			ProceduralTexture::Generate(textures[tex].seed, footprint.width, footprint.height, textures[tex].cpuAddress, footprint.rowPitch);
+	});
+	textures.clear();
+}
+
+void Renderer::CreateIndirectArguments()
+{
+	// Each command sets the DrawID root constant and draws.
+	commandSignature = device.CreateIndirectDrawSignature(rootSignature, DRAW_ID_ROOT_PARAMETER);
+	if (commandSignature == INVALID_RENDER_HANDLE)
+		CRITICAL_ERROR("Failed to create command signature.");
+
+	// Fill arguments and count via upload memory.
+	indirectCountOffset = sizeof(IndirectDrawCommand) * configuration.numTextures;
+	const uint64_t argumentBufferSize = indirectCountOffset + sizeof(uint32_t);
+	UploadAllocation uploadMemory;
+	if (!AllocateUploadMemory(argumentBufferSize, sizeof(uint32_t), uploadMemory))
+		CRITICAL_ERROR("Failed to allocate upload memory for indirect arguments.");
+
+	IndirectDrawCommand* commands = reinterpret_cast<IndirectDrawCommand*>(uploadMemory.cpuAddress);
+	for (unsigned int i = 0; i < configuration.numTextures; ++i)
+	{
+		commands[i].drawID = i;
+		commands[i].vertexCountPerInstance = 4;
+		commands[i].instanceCount = 1;
+		commands[i].startVertexLocation = 0;
+		commands[i].startInstanceLocation = 0;
+	}
+	uint32_t drawCount = configuration.numTextures;
+	memcpy(uploadMemory.cpuAddress + indirectCountOffset, &drawCount, sizeof(drawCount));
+
+	// Create argument buffer.
+	indirectArgumentBuffer = device.CreateBuffer(argumentBufferSize, GetUploadState());
+	if (indirectArgumentBuffer == INVALID_RENDER_HANDLE)
+		CRITICAL_ERROR("Failed to create indirect argument buffer.");
+
+	// Copy over.
+	BeginUploads();
+	GetUploadCommandList().CopyBufferRegion(indirectArgumentBuffer, 0, uploadMemory.buffer, uploadMemory.offset, argumentBufferSize);
+	std::vector<ResourceBarrier> barriers = { { indirectArgumentBuffer, GetUploadState(), ResourceState::IndirectArgument } };
+	EndUploads(barriers, pendingUploads);
+}
+
+bool Renderer::StreamTextures()
+{
+	if (IsStreamingTextures())
+		return false;
+	CreateTextures(streamedTextures, streamedTextureDescriptorHeap, streamedTextureUploads, streamedTextureGenerations);
+	return true;
+}
+
+void Renderer::FinishTextureStreaming()
+{
+	if (!IsStreamingTextures() || device.GetCompletedCopyFenceValue() < streamedTextureUploads.copyFenceValue)
+		return;
+
+	// Frames that are still in flight use the current textures, the device destroys them once they are done.
+	for (RenderHandle texture : textures)
+		device.ReleaseObject(texture);
+	device.ReleaseObject(textureDescriptorHeap);
+	textures.swap(streamedTextures);
+	streamedTextures.clear();
+	textureDescriptorHeap = streamedTextureDescriptorHeap;
+	streamedTextureDescriptorHeap = INVALID_RENDER_HANDLE;
+
+	// The copies are done, so the wait of the direct queue is skipped.
+	pendingUploads.barriers.insert(pendingUploads.barriers.end(), streamedTextureUploads.barriers.begin(), streamedTextureUploads.barriers.end());
+	if (streamedTextureUploads.copyFenceValue > pendingUploads.copyFenceValue)
+		pendingUploads.copyFenceValue = streamedTextureUploads.copyFenceValue;
+	streamedTextureUploads.barriers.clear();
+	pendingTextureGenerations.insert(pendingTextureGenerations.end(), streamedTextureGenerations.begin(), streamedTextureGenerations.end());
+	streamedTextureGenerations.clear();
+}
+
+bool Renderer::PopulateCommandList()
+{
+	// The draws are distributed evenly over the main command list and all worker command lists.
+	// The draw count in the count buffer refers to all draws and can not be split, so in this case everything goes into the first list.
+	const unsigned int numCommandLists = static_cast<unsigned int>(workerCommandLists.size()) + 1;
+	gpuProfiler->BeginFrame(frameQueueIndex);
+	const bool splitDraws = !(configuration.drawSubmission == DrawSubmission::ExecuteIndirect && configuration.indirectCountBuffer);
+	const unsigned int numDrawsPerList = splitDraws ? (configuration.numTextures + numCommandLists - 1) / numCommandLists : configuration.numTextures;
+
+	// Worker lists are recorded as jobs while the main thread records the first list.
+	std::atomic<bool> recordingFailed(false);
+	std::vector<JobSystem::JobHandle> workerRecordings;
+	workerRecordings.reserve(workerCommandLists.size());
+	for (unsigned int list = 1; list < numCommandLists; ++list)
+	{
+		RenderCommandList& workerCommandList = *workerCommandLists[list - 1];
+		unsigned int firstDraw = list * numDrawsPerList;
+		unsigned int numDraws = 0;
+		if (splitDraws && firstDraw < configuration.numTextures)
+			numDraws = configuration.numTextures - firstDraw < numDrawsPerList ? configuration.numTextures - firstDraw : numDrawsPerList;
+		bool lastList = list == numCommandLists - 1;
+		workerRecordings.push_back(jobSystem.Schedule([=, &workerCommandList, &recordingFailed]() {
+			PROFILE_SCOPE("RecordCommandList");
+			if (!RecordCommandList(workerCommandList, firstDraw, numDraws, false, lastList))
+				recordingFailed = true;
+		}));
+	}
+
+	{
+		PROFILE_SCOPE("RecordCommandList");
+		if (!RecordCommandList(*commandList, 0, numDrawsPerList, true, numCommandLists == 1))
+			recordingFailed = true;
+	}
+
+	for (auto& recording : workerRecordings)
+		jobSystem.Wait(recording);
+	return !recordingFailed;
+}
+
+bool Renderer::RecordCommandList(RenderCommandList& list, unsigned int firstDraw, unsigned int numDraws, bool firstList, bool lastList)
+{
+	// Should be completely save now to reset the allocator of this frame.
+	// Restart command list with the new allocator (last frame a different was used)
+	if (!list.Reset(frameQueueIndex, pipelineState))
+	{
+		std::cerr << "Failed to reset the command list." << std::endl;
+		return false;
+	}
+
+	// Set necessary state. State is not inherited between command lists, so every list needs to set it.
+	list.SetGraphicsRootSignature(rootSignature);
+	list.SetViewport(viewport);
+	list.SetScissorRect(scissorRect);
+
+	// Indicate that the back buffer will be used as a render target.
+	if (firstList)
+	{
+		unsigned int barrierScope = gpuProfiler->BeginScope(list, "Barriers");
+		ResourceBarrier barrier = { device.GetCurrentBackbuffer(), ResourceState::Present, ResourceState::RenderTarget };
+		list.ResourceBarriers(&barrier, 1);
+		// Resources uploaded on the copy queue are used for the first time.
+		if (!pendingUploads.barriers.empty())
+			list.ResourceBarriers(pendingUploads.barriers.data(), static_cast<unsigned int>(pendingUploads.barriers.size()));
+		gpuProfiler->EndScope(list, barrierScope);
+	}
+	// Generated textures are filled before the first draw that samples them.
+	if (firstList && !pendingTextureGenerations.empty())
+	{
+		unsigned int generationScope = gpuProfiler->BeginScope(list, "TextureGeneration");
+		RecordTextureGenerations(list);
+		gpuProfiler->EndScope(list, generationScope);
+	}
+	RenderHandle renderTargetView = device.GetCurrentBackbufferRenderTargetView();
+	list.SetRenderTarget(renderTargetView);
+
+	// Record commands.
+	if (firstList)
+	{
+		unsigned int clearScope = gpuProfiler->BeginScope(list, "Clear");
+		const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+		list.ClearRenderTarget(renderTargetView, clearColor);
+		gpuProfiler->EndScope(list, clearScope);
+	}
+	list.SetPrimitiveTopology(PrimitiveTopology::TriangleStrip);
+	list.SetVertexBuffer(vertexBufferView);
+	list.SetDescriptorHeap(textureDescriptorHeap);
+
+	unsigned int drawScope = gpuProfiler->BeginScope(list, "Draws");
+	RecordDraws(list, firstDraw, numDraws);
+	gpuProfiler->EndScope(list, drawScope);
+
+	// Indicate that the back buffer will now be used to present.
+	if (lastList)
+	{
+		unsigned int barrierScope = gpuProfiler->BeginScope(list, "Barriers");
+		ResourceBarrier barrier = { device.GetCurrentBackbuffer(), ResourceState::RenderTarget, ResourceState::Present };
+		list.ResourceBarriers(&barrier, 1);
+		gpuProfiler->EndScope(list, barrierScope);
+	}
+
+	if (!list.Close())
+	{
+		std::cerr << "Failed to close the command list." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void Renderer::RecordDraws(RenderCommandList& list, unsigned int firstDraw, unsigned int numDraws)
+{
+	if (numDraws == 0)
+		return;
+
+	if (configuration.textureBinding != TextureBinding::DescriptorTablePerDraw)
+	{
+		// The table is bound only once, the shader picks the array slice or the SRV by DrawID.
+		list.SetGraphicsRootDescriptorTable(TEXTURE_TABLE_ROOT_PARAMETER, textureDescriptorHeap, 0);
+		if (configuration.drawSubmission == DrawSubmission::Instanced)
+		{
+			// DrawID is the base for SV_InstanceID.
+			list.SetGraphicsRoot32BitConstant(DRAW_ID_ROOT_PARAMETER, firstDraw, 0);
+			list.DrawInstanced(4, numDraws, 0, 0);
+		}
+		else if (configuration.drawSubmission == DrawSubmission::ExecuteIndirect)
+		{
+			// With a count buffer the GPU reads the actual number of draws, numTextures is then only an upper bound.
+			RenderHandle countBuffer = configuration.indirectCountBuffer ? indirectArgumentBuffer : INVALID_RENDER_HANDLE;
+			list.ExecuteIndirect(commandSignature, numDraws, indirectArgumentBuffer, firstDraw * sizeof(IndirectDrawCommand), countBuffer, indirectCountOffset);
+		}
+		else
+		{
+			for (unsigned int i = firstDraw; i < firstDraw + numDraws; ++i)
+			{
+				list.SetGraphicsRoot32BitConstant(DRAW_ID_ROOT_PARAMETER, i, 0);
+				list.DrawInstanced(4, 1, 0, 0);
+			}
+		}
+	}
+	else
+	{
+		for (unsigned int i = firstDraw; i < firstDraw + numDraws; ++i)
+		{
+			list.SetGraphicsRootDescriptorTable(TEXTURE_TABLE_ROOT_PARAMETER, textureDescriptorHeap, i);
+			list.SetGraphicsRoot32BitConstant(DRAW_ID_ROOT_PARAMETER, i, 0);
+			list.DrawInstanced(4, 1, 0, 0);
+		}
+	}
+}
+
+void Renderer::RecordTextureGenerations(RenderCommandList& list)
+{
+	list.SetPipelineState(generationPipelineState);
+	list.SetComputeRootSignature(generationRootSignature);
+
+	// The dispatches write different textures, so there are no barriers in between and they may overlap on the GPU.
+	std::vector<ResourceBarrier> barriers;
+	barriers.reserve(pendingTextureGenerations.size());
+	RenderHandle descriptorHeap = INVALID_RENDER_HANDLE;
+	for (const TextureGeneration& generation : pendingTextureGenerations)
+	{
+		// Streamed textures may have a different heap than the ones of the previous set.
+		if (generation.descriptorHeap != descriptorHeap)
+		{
+			descriptorHeap = generation.descriptorHeap;
+			list.SetDescriptorHeap(descriptorHeap);
+		}
+		list.SetComputeRootDescriptorTable(GENERATION_TABLE_ROOT_PARAMETER, descriptorHeap, generation.uavDescriptor);
+		list.SetComputeRoot32BitConstant(GENERATION_SEED_ROOT_PARAMETER, generation.firstSeed, 0);
+		list.Dispatch((generation.desc.width + GENERATION_THREAD_GROUP_SIZE - 1) / GENERATION_THREAD_GROUP_SIZE,
+					(generation.desc.height + GENERATION_THREAD_GROUP_SIZE - 1) / GENERATION_THREAD_GROUP_SIZE, generation.desc.arraySize);
+
+		ResourceBarrier barrier = { generation.texture, ResourceState::UnorderedAccess, ResourceState::PixelShaderResource };
+		barriers.push_back(barrier);
+	}
+	list.ResourceBarriers(barriers.data(), static_cast<unsigned int>(barriers.size()));
+
+	list.SetPipelineState(pipelineState);
+}
+
+void Renderer::BeginFrame()
+{
+	if (frameBegun)
+		return;
+
+	PROFILE_SCOPE("BeginFrame");
+	auto waitBegin = std::chrono::high_resolution_clock::now();
+	device.BeginFrame();
+	auto waitEnd = std::chrono::high_resolution_clock::now();
+	beginFrameWaitMilliseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(waitEnd - waitBegin).count() / 1000.0 / 1000.0;
+	frameBegun = true;
+}
+
+void Renderer::Render()
+{
+	BeginFrame();
+	FinishTextureStreaming();
+
+	// Record all the commands we need to render the scene into the command lists.
+	auto recordingBegin = std::chrono::high_resolution_clock::now();
+	{
+		PROFILE_SCOPE("PopulateCommandList");
+		// Nothing is submitted if a list failed to record.
+		if (!PopulateCommandList())
+			CRITICAL_ERROR("Failed to record the command lists.");
+	}
+	auto recordingEnd = std::chrono::high_resolution_clock::now();
+	lastFrameTimings.recordingMilliseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(recordingEnd - recordingBegin).count() / 1000.0 / 1000.0;
+
+	// Execute all command lists at once, in the order of their draw ranges.
+	std::vector<RenderCommandList*> commandLists;
+	commandLists.reserve(workerCommandLists.size() + 2);
+	commandLists.push_back(commandList.get());
+	for (auto& workerCommandList : workerCommandLists)
+		commandLists.push_back(workerCommandList.get());
+	// Timestamps are resolved after all lists that contain profiler scopes.
+	RenderCommandList* profilerCommandList = gpuProfiler->EndFrame();
+	if (profilerCommandList)
+		commandLists.push_back(profilerCommandList);
+	auto submitBegin = std::chrono::high_resolution_clock::now();
+	{
+		PROFILE_SCOPE("ExecuteCommandLists");
+		// Only the frame that uses uploaded resources first waits for their copies.
+		if (!pendingUploads.barriers.empty())
+		{
+			device.QueueWaitForCopy(pendingUploads.copyFenceValue);
+			pendingUploads.barriers.clear();
+		}
+		device.ExecuteCommandLists(commandLists.data(), static_cast<unsigned int>(commandLists.size()));
+		pendingTextureGenerations.clear();
+	}
+
+	// Present the frame.
+	{
+		PROFILE_SCOPE("Present");
+		device.Present();
+	}
+
+	auto submitEnd = std::chrono::high_resolution_clock::now();
+	lastFrameTimings.submitMilliseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(submitEnd - submitBegin).count() / 1000.0 / 1000.0;
+
+	{
+		PROFILE_SCOPE("WaitForFreeInflightFrame");
+		device.WaitForFreeInflightFrame();
+	}
+	auto waitEnd = std::chrono::high_resolution_clock::now();
+	lastFrameTimings.waitMilliseconds = beginFrameWaitMilliseconds + std::chrono::duration_cast<std::chrono::nanoseconds>(waitEnd - submitEnd).count() / 1000.0 / 1000.0;
+	frameBegun = false;
+	frameQueueIndex = (frameQueueIndex + 1) % RenderDevice::MAX_FRAMES_INFLIGHT;
+}
+
+Renderer::MemoryStatistics Renderer::GetMemoryStatistics() const
+{
+	MemoryStatistics statistics;
+	statistics.textureMemoryCommitted = device.GetTextureMemoryCommitted();
+	statistics.textureMemoryUsed = device.GetTextureMemoryUsed();
+	statistics.uploadRingUsed = device.GetUploadRingUsedSize();
+	statistics.pendingReleaseBytes = device.GetDeferredReleaseStatistics().pendingBytes;
+	statistics.maxReleaseLatencyMilliseconds = device.GetDeferredReleaseStatistics().maxReleaseLatencyMilliseconds;
+	return statistics;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "RenderTypes.h"
+#include "RenderDevice.h"
+
+class RenderCommandList;
+class JobSystem;
+class GpuProfiler;
+class CapturingDevice;
+
+/// Creates the scene (a textured quad per texture) and renders it with the chosen texture binding and draw submission.
+///
+/// Only talks to the RenderDevice interface, so the whole frame loop runs on D3D12 as well as headless on the NullDevice.
+/// Root signature and pipeline state are created by the caller, since shader compilation is backend specific.
+/// Independent of D3D12 and Windows.
+class Renderer
+{
+public:
+	/// How the textures are stored and bound to the pixel shader.
+	enum class TextureBinding
+	{
+		DescriptorTablePerDraw,	///< One texture and SRV per draw. The descriptor table is moved for every draw.
+		TextureArray,			///< All textures are slices of a single Texture2DArray with a single SRV.
+		Bindless				///< One texture and SRV per draw, but all SRVs are bound once as an unbounded table that the shader indexes by DrawID.
+	};
+
+	/// How the draws for all textures are submitted.
+	enum class DrawSubmission
+	{
+		DrawPerTexture,	///< One DrawInstanced call per texture with the DrawID as root constant.
+		Instanced,		///< A single DrawInstanced call for all textures, the shader derives the DrawID from SV_InstanceID. Does not work with DescriptorTablePerDraw.
+		ExecuteIndirect	///< DrawIDs and draw arguments come from a GPU argument buffer that is consumed by ExecuteIndirect. Does not work with DescriptorTablePerDraw.
+	};
+
+	/// Options that are chosen once at startup.
+	struct Configuration
+	{
+		Configuration();
+
+		unsigned int numTextures;
+		TextureBinding textureBinding;
+		DrawSubmission drawSubmission;
+		/// If true, ExecuteIndirect reads the number of draws from a count buffer on the GPU.
+		bool indirectCountBuffer;
+		/// Number of threads that record command lists in parallel, each into its own list.
+		unsigned int numRecordingThreads;
+		/// Frames that take longer are counted as over budget by the frame statistics.
+		double frameBudgetMilliseconds;
+		/// Maximum number of frames the CPU may be ahead of the GPU. Clamped to RenderDevice::MAX_FRAMES_INFLIGHT.
+		unsigned int numFramesInFlight;
+		/// Whether the CPU waits for the GPU after presenting or before recording. Can be changed later on the device.
+		FramePacingMode framePacing;
+		/// Swap chain buffers, clamped to [RenderDevice::MIN_BACKBUFFERS, RenderDevice::MAX_BACKBUFFERS]. Used by whoever creates the device.
+		unsigned int numBackbuffers;
+		/// If true, all commands go through a CapturingDevice, so that frames can be captured into a CommandStream.
+		bool captureCommands;
+		/// If true, uploads run on the copy queue and only the first frame that uses the uploaded resources waits for them, on the GPU.
+		/// Otherwise they run on the direct queue and the CPU waits for them.
+		bool copyQueueUploads;
+		/// If true, the content of the textures is generated by a compute shader at the start of the first frame that draws them.
+		/// Otherwise the CPU generates it (see ProceduralTexture) and uploads it. Both produce the same content.
+		bool gpuTextureGeneration;
+	};
+
+	/// CPU timings of the last frame.
+	struct FrameTimings
+	{
+		double recordingMilliseconds;	///< PopulateCommandList, including waiting for the recording jobs.
+		double submitMilliseconds;		///< ExecuteCommandLists and Present.
+		double waitMilliseconds;		///< Waiting for the swap chain and a free in-flight frame, before recording or after presenting depending on the FramePacingMode.
+	};
+
+	struct MemoryStatistics
+	{
+		uint64_t textureMemoryCommitted;
+		uint64_t textureMemoryUsed;
+		uint64_t uploadRingUsed;
+		uint64_t pendingReleaseBytes;			///< Released objects whose memory waits for the GPU.
+		double maxReleaseLatencyMilliseconds;	///< Longest time from release to destruction so far.
+	};
+
+	/// Root signature layout the shaders and the renderer agree on.
+	static const unsigned int TEXTURE_TABLE_ROOT_PARAMETER = 0;	///< Descriptor table with the texture SRV(s), pixel shader.
+	static const unsigned int DRAW_ID_ROOT_PARAMETER = 1;		///< Single 32bit constant, vertex shader.
+
+	/// Compute root signature layout of the texture generation shader (proceduraltexture.hlsl).
+	static const unsigned int GENERATION_TABLE_ROOT_PARAMETER = 0;	///< Descriptor table with the UAV of the texture.
+	static const unsigned int GENERATION_SEED_ROOT_PARAMETER = 1;	///< Single 32bit constant, seed of the first slice.
+	/// Threads per group of the texture generation shader in x and y, there is a group layer per slice.
+	static const unsigned int GENERATION_THREAD_GROUP_SIZE = 8;
+
+	/// Width and height of all textures.
+	static const unsigned int TEXTURE_SIZE = 16;
+	/// Textures whose content one job generates on the CPU. Several per job, since a single texture is generated faster than a job is scheduled.
+	static const unsigned int NUM_TEXTURES_PER_GENERATION_JOB = 64;
+
+	/// Creates all scene resources and uploads them, see Configuration::copyQueueUploads.
+	/// The generation root signature and pipeline state are only used with Configuration::gpuTextureGeneration and may be INVALID_RENDER_HANDLE otherwise.
+	Renderer(const Configuration& configuration, RenderDevice& device, JobSystem& jobSystem, RenderHandle rootSignature, RenderHandle pipelineState,
+			RenderHandle generationRootSignature, RenderHandle generationPipelineState);
+	~Renderer();
+
+	/// Waits until the frame can be recorded in FramePacingMode::Latency. Call it before sampling input, so that the frame reflects
+	/// the latest input. Render calls it if it was not called for the current frame.
+	void BeginFrame();
+	/// Records and submits a frame, presents it and waits until the next frame can be recorded in FramePacingMode::Throughput.
+	void Render();
+
+	/// Uploads a new set of textures with new content. It replaces the current set in the first frame after the copies are done,
+	/// so with Configuration::copyQueueUploads the direct queue never waits for them. With Configuration::gpuTextureGeneration,
+	/// the new set is generated by and used from the next frame on. Returns false while the previous set is still streaming.
+	bool StreamTextures();
+	bool IsStreamingTextures() const					{ return streamedTextureDescriptorHeap != INVALID_RENDER_HANDLE; }
+
+	/// Used by all frames rendered from now on. The caller needs to keep the previous pipeline state alive until the GPU is done with it.
+	void SetPipelineState(RenderHandle _pipelineState)	{ pipelineState = _pipelineState; }
+	/// Same for the texture generation pipeline state, see Configuration::gpuTextureGeneration.
+	void SetGenerationPipelineState(RenderHandle _generationPipelineState)	{ generationPipelineState = _generationPipelineState; }
+
+	const Configuration& GetConfiguration() const		{ return configuration; }
+	const FrameTimings& GetLastFrameTimings() const		{ return lastFrameTimings; }
+	MemoryStatistics GetMemoryStatistics() const;
+	const GpuProfiler& GetGpuProfiler() const			{ return *gpuProfiler; }
+	/// nullptr unless Configuration::captureCommands is set.
+	CapturingDevice* GetCapturingDevice()				{ return capturingDevice.get(); }
+
+private:
+	/// Resources written by uploads on the copy queue, with the transitions the direct queue records once it waited for the copies.
+	struct CopyQueueUploads
+	{
+		std::vector<ResourceBarrier> barriers;	///< From ResourceState::Common to the states the resources are used in.
+		uint64_t copyFenceValue;				///< Copy fence value after the last of the uploads.
+	};
+
+	/// Texture whose content is generated on the GPU, see Configuration::gpuTextureGeneration.
+	struct TextureGeneration
+	{
+		RenderHandle texture;		///< In ResourceState::UnorderedAccess until generated.
+		RenderHandle descriptorHeap;
+		unsigned int uavDescriptor;	///< Index of the texture's UAV in descriptorHeap.
+		uint32_t firstSeed;			///< Seed of the first slice, see ProceduralTexture.
+		TextureDesc desc;
+	};
+
+	/// Texture whose content the CPU generates into upload memory, see GenerateTextureData.
+	struct TextureData
+	{
+		uint32_t seed;			///< See ProceduralTexture.
+		uint8_t* cpuAddress;	///< Where the texture's footprint starts in upload memory.
+	};
+
+	void CreateVertexBuffer();
+	/// Uploaded textures are added to uploads, textures that are generated on the GPU to generations.
+	void CreateTextures(std::vector<RenderHandle>& outTextures, RenderHandle& outDescriptorHeap, CopyQueueUploads& uploads, std::vector<TextureGeneration>& generations);
+	/// Generates the content of all textures in parallel on the job system and clears the list. All textures have the given footprint.
+	void GenerateTextureData(std::vector<TextureData>& textures, const TextureFootprint& footprint);
+	void CreateIndirectArguments();
+	/// Executes the main command list and waits until the GPU is done. Used for uploads on the direct queue.
+	void ExecuteAndWait();
+
+	/// Starts recording uploads into GetUploadCommandList.
+	void BeginUploads();
+	/// The copy list with Configuration::copyQueueUploads, the main list otherwise.
+	RenderCommandList& GetUploadCommandList()			{ return configuration.copyQueueUploads ? *copyCommandList : *commandList; }
+	/// Upload memory for the upload command list.
+	bool AllocateUploadMemory(uint64_t size, uint64_t alignment, UploadAllocation& outAllocation);
+	/// State uploaded resources are created in and the before-state of the barriers given to EndUploads.
+	ResourceState GetUploadState() const				{ return configuration.copyQueueUploads ? ResourceState::Common : ResourceState::CopyDest; }
+	/// Submits the uploads recorded since BeginUploads. On the direct queue, waits until they are done.
+	void SubmitUploads();
+	/// Submits the uploads and transitions the resources. On the direct queue right away, on the copy queue the barriers are added to uploads.
+	void EndUploads(const std::vector<ResourceBarrier>& barriers, CopyQueueUploads& uploads);
+	/// Replaces the textures with the streamed ones if their copies are done.
+	void FinishTextureStreaming();
+
+	/// Returns false if any of the command lists failed to record.
+	bool PopulateCommandList();
+	/// Records the draws [firstDraw, firstDraw + numDraws) into the given list. Only the first list clears and only the last list transitions to present.
+	/// Runs on worker threads, so failures are returned instead of quitting: CRITICAL_ERROR only reaches the message loop from the main thread.
+	bool RecordCommandList(RenderCommandList& list, unsigned int firstDraw, unsigned int numDraws, bool firstList, bool lastList);
+	void RecordDraws(RenderCommandList& list, unsigned int firstDraw, unsigned int numDraws);
+	/// Dispatches the generation of pendingTextureGenerations and transitions the textures for drawing. Restores the graphics pipeline state.
+	void RecordTextureGenerations(RenderCommandList& list);
+
+	const Configuration configuration;
+	std::unique_ptr<CapturingDevice> capturingDevice;	///< Wraps the device given to the constructor if captureCommands is set.
+	RenderDevice& device;								///< Either capturingDevice or the device given to the constructor.
+	JobSystem& jobSystem;
+
+	RenderHandle rootSignature;
+	RenderHandle pipelineState;
+	RenderHandle generationRootSignature;
+	RenderHandle generationPipelineState;
+
+	Viewport viewport;
+	ScissorRect scissorRect;
+
+	unsigned int frameQueueIndex;
+	bool frameBegun;
+	double beginFrameWaitMilliseconds;	///< Time spent in BeginFrame for the current frame.
+	std::unique_ptr<RenderCommandList> commandList;
+	/// Lists of the recording worker threads.
+	std::vector<std::unique_ptr<RenderCommandList>> workerCommandLists;
+	FrameTimings lastFrameTimings;
+
+	std::unique_ptr<GpuProfiler> gpuProfiler;
+
+	VertexBufferView vertexBufferView;
+
+	std::vector<RenderHandle> textures;
+	RenderHandle textureDescriptorHeap;
+	uint32_t nextTextureSeed;	///< Every texture or slice gets its own seed, so that streamed textures have new content.
+	std::vector<TextureGeneration> pendingTextureGenerations;	///< Generated by the next frame.
+
+	RenderHandle commandSignature;
+	RenderHandle indirectArgumentBuffer;	///< Arguments for all draws, followed by the draw count.
+	uint64_t indirectCountOffset;			///< Offset of the draw count within indirectArgumentBuffer.
+
+	std::unique_ptr<RenderCommandList> copyCommandList;	///< Only with Configuration::copyQueueUploads.
+	unsigned int copyListAllocator;						///< Allocator of copyCommandList the next uploads use.
+	uint64_t copyListFenceValues[RenderDevice::MAX_FRAMES_INFLIGHT];	///< Copy fence value of the last uploads of each allocator.
+	uint64_t lastCopyFenceValue;						///< Copy fence value of the last submitted uploads.
+	CopyQueueUploads pendingUploads;					///< Uploads the next frame waits for and transitions.
+
+	std::vector<RenderHandle> streamedTextures;
+	RenderHandle streamedTextureDescriptorHeap;			///< INVALID_RENDER_HANDLE while no textures are streamed.
+	CopyQueueUploads streamedTextureUploads;
+	std::vector<TextureGeneration> streamedTextureGenerations;
+};
@@ -0,0 +1,99 @@
+#include "RingAllocator.h"
+
+namespace
+{
+	uint64_t AlignOffset(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+RingAllocator::RingAllocator(uint64_t _size) :
+	size(_size),
+	head(0),
+	tail(0),
+	usedSize(0),
+	currentChunkSize(0)
+{
+}
+
+uint64_t RingAllocator::Allocate(uint64_t allocationSize, uint64_t alignment)
+{
+	// Nothing in use, start again at the beginning to get the largest possible contiguous range.
+	if (usedSize == 0)
+	{
+		head = 0;
+		tail = 0;
+	}
+	else if (usedSize == size)
+		return INVALID_OFFSET;
+
+	uint64_t alignedHead = AlignOffset(head, alignment);
+
+	// Free space is [head, size) and [0, tail)
+	if (head >= tail)
+	{
+		if (alignedHead + allocationSize <= size)
+		{
+			uint64_t allocatedSize = alignedHead - head + allocationSize;
+			head = alignedHead + allocationSize;
+			if (head == size)
+				head = 0;
+			usedSize += allocatedSize;
+			currentChunkSize += allocatedSize;
+			return alignedHead;
+		}
+		// Skip the remaining space at the end and wrap around. Offset 0 satisfies every alignment.
+		else if (allocationSize <= tail)
+		{
+			uint64_t allocatedSize = size - head + allocationSize;
+			head = allocationSize;
+			usedSize += allocatedSize;
+			currentChunkSize += allocatedSize;
+			return 0;
+		}
+	}
+	// Free space is [head, tail)
+	else if (alignedHead + allocationSize <= tail)
+	{
+		uint64_t allocatedSize = alignedHead - head + allocationSize;
+		head = alignedHead + allocationSize;
+		usedSize += allocatedSize;
+		currentChunkSize += allocatedSize;
+		return alignedHead;
+	}
+
+	return INVALID_OFFSET;
+}
+
+void RingAllocator::FinishAllocations(uint64_t fenceValue)
+{
+	if (currentChunkSize == 0)
+		return;
+
+	Chunk chunk;
+	chunk.fenceValue = fenceValue;
+	chunk.size = currentChunkSize;
+	chunk.end = head;
+	pendingChunks.push_back(chunk);
+
+	currentChunkSize = 0;
+}
+
+void RingAllocator::Reclaim(uint64_t completedFenceValue)
+{
+	while (!pendingChunks.empty() && pendingChunks.front().fenceValue <= completedFenceValue)
+	{
+		tail = pendingChunks.front().end;
+		usedSize -= pendingChunks.front().size;
+		pendingChunks.pop_front();
+	}
+}
+
+bool RingAllocator::GetOldestPendingFenceValue(uint64_t& outFenceValue) const
+{
+	if (pendingChunks.empty())
+		return false;
+	outFenceValue = pendingChunks.front().fenceValue;
+	return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+/// Allocates ranges from a fixed-size ring. Does not know anything about the memory it manages, it only hands out offsets.
+///
+/// Allocations are grouped into chunks that get tagged with a fence value via FinishAllocations.
+/// A chunk is given back to the ring as soon as Reclaim is called with a completed fence value that passed the chunk's value.
+/// Since chunks are reclaimed in order, the fence values passed to FinishAllocations need to be monotonically increasing.
+class RingAllocator
+{
+public:
+	static const uint64_t INVALID_OFFSET = ~static_cast<uint64_t>(0);
+
+	RingAllocator(uint64_t size);
+
+	/// Returns the offset of the allocated range or INVALID_OFFSET if there is not enough contiguous space left.
+	/// Alignment needs to be a power of two.
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	/// Tags all allocations since the last call with the given fence value.
+	void FinishAllocations(uint64_t fenceValue);
+
+	/// Frees all chunks whose fence value is smaller or equal than completedFenceValue.
+	void Reclaim(uint64_t completedFenceValue);
+
+	/// Retrieves the fence value of the oldest chunk that was not yet reclaimed. Returns false if there is none.
+	bool GetOldestPendingFenceValue(uint64_t& outFenceValue) const;
+
+	uint64_t GetSize() const		{ return size; }
+	/// Bytes currently in use, including alignment padding.
+	uint64_t GetUsedSize() const	{ return usedSize; }
+
+private:
+	struct Chunk
+	{
+		uint64_t fenceValue;
+		uint64_t size;	///< Size of all allocations in this chunk including padding.
+		uint64_t end;	///< Head position after the last allocation of this chunk. Becomes the new tail on reclaim.
+	};
+
+	std::deque<Chunk> pendingChunks;
+
+	uint64_t size;
+	uint64_t head;				///< Position of the next allocation.
+	uint64_t tail;				///< Start of the oldest range that is still in use.
+	uint64_t usedSize;
+	uint64_t currentChunkSize;	///< Size of all allocations since the last FinishAllocations.
+};
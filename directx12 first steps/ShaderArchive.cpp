@@ -0,0 +1,232 @@
+#include "ShaderArchive.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+
+namespace
+{
+	/// Bytecode is placed at this alignment within the archive.
+	const size_t BYTECODE_ALIGNMENT = 16;
+
+	bool ReadFile(const std::string& filename, std::string& outContent)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		if (!file)
+			return false;
+		outContent.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return !file.bad();
+	}
+
+	/// Returns the names of all files in #include "..." or #include <...> lines, in order.
+	std::vector<std::string> FindIncludes(const std::string& source)
+	{
+		std::vector<std::string> includes;
+		size_t lineBegin = 0;
+		while (lineBegin < source.size())
+		{
+			size_t lineEnd = source.find('\n', lineBegin);
+			if (lineEnd == std::string::npos)
+				lineEnd = source.size();
+
+			size_t position = source.find_first_not_of(" \t", lineBegin);
+			if (position < lineEnd && source[position] == '#')
+			{
+				position = source.find_first_not_of(" \t", position + 1);
+				const char directive[] = "include";
+				if (position < lineEnd && source.compare(position, sizeof(directive) - 1, directive) == 0)
+				{
+					position = source.find_first_not_of(" \t", position + sizeof(directive) - 1);
+					if (position < lineEnd && (source[position] == '"' || source[position] == '<'))
+					{
+						char terminator = source[position] == '"' ? '"' : '>';
+						size_t nameEnd = source.find(terminator, position + 1);
+						if (nameEnd < lineEnd)
+							includes.push_back(source.substr(position + 1, nameEnd - position - 1));
+					}
+				}
+			}
+			lineBegin = lineEnd + 1;
+		}
+		return includes;
+	}
+
+	std::string GetDirectory(const std::string& filename)
+	{
+		size_t separator = filename.find_last_of("/\\");
+		return separator == std::string::npos ? std::string() : filename.substr(0, separator + 1);
+	}
+
+	void HashIncludes(const std::string& filename, const std::string& source, std::set<std::string>& visited, uint64_t& hash)
+	{
+		for (const std::string& include : FindIncludes(source))
+		{
+			std::string includeFilename = GetDirectory(filename) + include;
+			hash = HashString(includeFilename.c_str(), hash);
+			if (!visited.insert(includeFilename).second)
+				continue;
+
+			std::string includeSource;
+			if (!ReadFile(includeFilename, includeSource))
+				continue;
+			hash = HashValue(static_cast<uint64_t>(includeSource.size()), hash);
+			hash = HashBytes(includeSource.data(), includeSource.size(), hash);
+			HashIncludes(includeFilename, includeSource, visited, hash);
+		}
+	}
+}
+
+bool ComputeShaderContentKey(const std::string& filename, const std::string& variantName, uint32_t compileFlags, uint64_t& outKey)
+{
+	std::string source;
+	if (!ReadFile(filename, source))
+		return false;
+
+	uint64_t hash = HashString(variantName.c_str());
+	hash = HashValue(compileFlags, hash);
+	hash = HashValue(static_cast<uint64_t>(source.size()), hash);
+	hash = HashBytes(source.data(), source.size(), hash);
+	std::set<std::string> visited;
+	visited.insert(filename);
+	HashIncludes(filename, source, visited, hash);
+	outKey = hash;
+	return true;
+}
+
+void ShaderArchiveWriter::Add(const std::string& name, uint64_t contentKey, const void* bytecode, size_t size)
+{
+	Shader shader;
+	shader.name = name;
+	shader.contentKey = contentKey;
+	shader.bytecode.assign(static_cast<const uint8_t*>(bytecode), static_cast<const uint8_t*>(bytecode) + size);
+	shaders.push_back(std::move(shader));
+}
+
+std::vector<uint8_t> ShaderArchiveWriter::Serialize() const
+{
+	std::vector<ShaderArchiveReader::IndexEntry> index(shaders.size());
+
+	// Layout: header, index, names, bytecode.
+	size_t offset = sizeof(ShaderArchiveReader::Header) + sizeof(ShaderArchiveReader::IndexEntry) * shaders.size();
+	for (size_t i = 0; i < shaders.size(); ++i)
+	{
+		index[i].nameHash = HashBytes(shaders[i].name.data(), shaders[i].name.size());
+		index[i].nameOffset = offset;
+		index[i].nameLength = shaders[i].name.size();
+		index[i].contentKey = shaders[i].contentKey;
+		offset += shaders[i].name.size();
+	}
+	for (size_t i = 0; i < shaders.size(); ++i)
+	{
+		offset = (offset + BYTECODE_ALIGNMENT - 1) / BYTECODE_ALIGNMENT * BYTECODE_ALIGNMENT;
+		index[i].bytecodeOffset = offset;
+		index[i].bytecodeSize = shaders[i].bytecode.size();
+		offset += shaders[i].bytecode.size();
+	}
+
+	std::vector<uint8_t> archive(offset, 0);
+	for (size_t i = 0; i < shaders.size(); ++i)
+	{
+		memcpy(archive.data() + index[i].nameOffset, shaders[i].name.data(), shaders[i].name.size());
+		if (!shaders[i].bytecode.empty())
+			memcpy(archive.data() + index[i].bytecodeOffset, shaders[i].bytecode.data(), shaders[i].bytecode.size());
+	}
+
+	std::sort(index.begin(), index.end(), [](const ShaderArchiveReader::IndexEntry& a, const ShaderArchiveReader::IndexEntry& b) { return a.nameHash < b.nameHash; });
+
+	ShaderArchiveReader::Header header;
+	header.magic = ShaderArchiveReader::MAGIC;
+	header.version = ShaderArchiveReader::VERSION;
+	header.numShaders = static_cast<uint32_t>(shaders.size());
+	header.reserved = 0;
+	memcpy(archive.data(), &header, sizeof(header));
+	if (!index.empty())
+		memcpy(archive.data() + sizeof(header), index.data(), sizeof(ShaderArchiveReader::IndexEntry) * index.size());
+
+	return archive;
+}
+
+bool ShaderArchiveWriter::Save(const std::string& path) const
+{
+	std::vector<uint8_t> archive = Serialize();
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+	file.write(reinterpret_cast<const char*>(archive.data()), archive.size());
+	return static_cast<bool>(file);
+}
+
+ShaderArchiveReader::ShaderArchiveReader() :
+	data(nullptr),
+	index(nullptr),
+	numShaders(0)
+{
+}
+
+bool ShaderArchiveReader::Open(const void* archiveData, size_t size)
+{
+	data = nullptr;
+	index = nullptr;
+	numShaders = 0;
+
+	Header header;
+	if (!archiveData || size < sizeof(header))
+		return false;
+	memcpy(&header, archiveData, sizeof(header));
+	if (header.magic != MAGIC || header.version != VERSION)
+		return false;
+	if ((size - sizeof(header)) / sizeof(IndexEntry) < header.numShaders)
+		return false;
+
+	// Everything the index points to needs to be within the archive.
+	const uint8_t* bytes = static_cast<const uint8_t*>(archiveData);
+	const IndexEntry* entries = reinterpret_cast<const IndexEntry*>(bytes + sizeof(header));
+	for (uint32_t i = 0; i < header.numShaders; ++i)
+	{
+		if (entries[i].nameOffset > size || entries[i].nameLength > size - entries[i].nameOffset ||
+			entries[i].bytecodeOffset > size || entries[i].bytecodeSize > size - entries[i].bytecodeOffset)
+			return false;
+		if (i > 0 && entries[i - 1].nameHash > entries[i].nameHash)
+			return false;
+	}
+
+	data = bytes;
+	index = entries;
+	numShaders = header.numShaders;
+	return true;
+}
+
+bool ShaderArchiveReader::Find(const std::string& name, uint64_t contentKey, const void*& outBytecode, size_t& outSize) const
+{
+	return FindEntry(name, &contentKey, outBytecode, outSize);
+}
+
+bool ShaderArchiveReader::Find(const std::string& name, const void*& outBytecode, size_t& outSize) const
+{
+	return FindEntry(name, nullptr, outBytecode, outSize);
+}
+
+bool ShaderArchiveReader::FindEntry(const std::string& name, const uint64_t* contentKey, const void*& outBytecode, size_t& outSize) const
+{
+	if (!index)
+		return false;
+
+	uint64_t nameHash = HashBytes(name.data(), name.size());
+	const IndexEntry* entry = std::lower_bound(index, index + numShaders, nameHash, [](const IndexEntry& indexEntry, uint64_t hash) { return indexEntry.nameHash < hash; });
+	for (; entry != index + numShaders && entry->nameHash == nameHash; ++entry)
+	{
+		if (entry->nameLength == name.size() && memcmp(data + entry->nameOffset, name.data(), name.size()) == 0)
+		{
+			// Names are unique, a stale entry means the shader needs to be compiled.
+			if (contentKey && entry->contentKey != *contentKey)
+				return false;
+			outBytecode = data + entry->bytecodeOffset;
+			outSize = static_cast<size_t>(entry->bytecodeSize);
+			return true;
+		}
+	}
+	return false;
+}
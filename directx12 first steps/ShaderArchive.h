@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Packed shader archive: A single file with an index of named shaders, followed by their bytecode.
+// Written at build time, read at runtime straight from a memory mapped file, so the bytecode never needs to be copied.
+// Every shader is stored with the content key of its source (see ComputeShaderContentKey), so shaders that were edited after the archive was built are not taken from it.
+// Independent of D3D12 and Windows.
+
+/// Hashes the raw bytes of a shader source and of all files it includes, combined with the variant name and compile flags.
+/// Only plain file I/O, no preprocessor or compiler, so it is cheap enough to validate archive entries at startup.
+/// Includes are found by scanning for #include lines, relative to the including file. This also follows includes in disabled #if blocks,
+/// include files that can not be opened only contribute their name. Returns false if the source itself can not be read.
+bool ComputeShaderContentKey(const std::string& filename, const std::string& variantName, uint32_t compileFlags, uint64_t& outKey);
+
+/// Collects shaders and serializes them into the archive format.
+class ShaderArchiveWriter
+{
+public:
+	void Add(const std::string& name, uint64_t contentKey, const void* bytecode, size_t size);
+
+	std::vector<uint8_t> Serialize() const;
+	bool Save(const std::string& path) const;
+
+private:
+	struct Shader
+	{
+		std::string name;
+		uint64_t contentKey;
+		std::vector<uint8_t> bytecode;
+	};
+	std::vector<Shader> shaders;
+};
+
+/// Looks up shaders in archive data that is owned by someone else, typically a memory mapped file.
+class ShaderArchiveReader
+{
+public:
+	ShaderArchiveReader();
+
+	/// Validates the archive's header and index. Returns false and stays empty if the data is not a valid archive.
+	/// The data needs to stay alive as long as the reader and all bytecode pointers retrieved from it are used.
+	bool Open(const void* data, size_t size);
+
+	/// Returns false if there is no shader with this name, or if it was built from a source with a different content key. outBytecode points into the archive data.
+	bool Find(const std::string& name, uint64_t contentKey, const void*& outBytecode, size_t& outSize) const;
+	/// Same without checking the content key, for when the source is not available to compute one.
+	bool Find(const std::string& name, const void*& outBytecode, size_t& outSize) const;
+
+	bool IsOpen() const					{ return index != nullptr; }
+	uint32_t GetNumShaders() const		{ return numShaders; }
+
+	static const uint32_t MAGIC = 0x52415344; // "DSAR"
+	static const uint32_t VERSION = 2;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numShaders;
+		uint32_t reserved;
+	};
+	/// Index entries are sorted by nameHash.
+	struct IndexEntry
+	{
+		uint64_t nameHash;
+		uint64_t nameOffset;	///< Offset from the beginning of the archive. The name is not zero terminated.
+		uint64_t nameLength;
+		uint64_t contentKey;
+		uint64_t bytecodeOffset;	///< Offset from the beginning of the archive.
+		uint64_t bytecodeSize;
+	};
+
+private:
+	/// Checks the content key only if it is not nullptr.
+	bool FindEntry(const std::string& name, const uint64_t* contentKey, const void*& outBytecode, size_t& outSize) const;
+
+	const uint8_t* data;
+	const IndexEntry* index;
+	uint32_t numShaders;
+};
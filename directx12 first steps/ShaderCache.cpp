@@ -0,0 +1,176 @@
+#include "ShaderCache.h"
+#include "JobSystem.h"
+#include "Hash.h"
+#include "Helper.h"
+
+#include <d3dcompiler.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	/// Preprocessed source of a shader and everything else that determines its bytecode.
+	struct PreprocessedShader
+	{
+		ComPtr<ID3DBlob> source;
+		uint64_t key;
+	};
+
+	std::vector<D3D_SHADER_MACRO> GetShaderMacros(const ShaderCache::ShaderDesc& shader)
+	{
+		std::vector<D3D_SHADER_MACRO> macros;
+		for (const auto& define : shader.defines)
+			macros.push_back({ define.first.c_str(), define.second.c_str() });
+		macros.push_back({ nullptr, nullptr });
+		return macros;
+	}
+
+	void OutputCompilerMessages(const std::string& shaderName, ID3DBlob* messages)
+	{
+		if (messages)
+			std::cerr << shaderName << ": " << static_cast<const char*>(messages->GetBufferPointer()) << std::endl;
+	}
+
+	/// Preprocessing resolves includes and defines, so the preprocessed source is everything that needs to be hashed about the code.
+	bool PreprocessShader(const ShaderCache::ShaderDesc& shader, PreprocessedShader& outShader)
+	{
+		std::string shaderName = shader.filename + " (" + shader.entryPoint + ")";
+
+		std::ifstream sourceFile(shader.filename, std::ios::binary);
+		if (!sourceFile)
+		{
+			std::cerr << "Failed to open shader source " << shader.filename << std::endl;
+			return false;
+		}
+		std::stringstream sourceStream;
+		sourceStream << sourceFile.rdbuf();
+		std::string source = sourceStream.str();
+
+		std::vector<D3D_SHADER_MACRO> macros = GetShaderMacros(shader);
+		ComPtr<ID3DBlob> errorMessages;
+		if (FAILED(D3DPreprocess(source.data(), source.size(), shader.filename.c_str(), macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE,
+								&outShader.source, &errorMessages)))
+		{
+			OutputCompilerMessages(shaderName, errorMessages.Get());
+			return false;
+		}
+
+		uint64_t key = HashBytes(outShader.source->GetBufferPointer(), outShader.source->GetBufferSize());
+		for (const auto& define : shader.defines)
+		{
+			key = HashString(define.first.c_str(), key);
+			key = HashString(define.second.c_str(), key);
+		}
+		key = HashString(shader.entryPoint.c_str(), key);
+		key = HashString(shader.profile.c_str(), key);
+		key = HashValue(shader.compileFlags, key);
+		key = HashValue(D3D_COMPILER_VERSION, key);
+		outShader.key = key;
+		return true;
+	}
+}
+
+std::string ShaderCache::ShaderDesc::GetVariantName() const
+{
+	std::string name = filename + ":" + entryPoint + ":" + profile;
+	for (const auto& define : defines)
+		name += ":" + define.first + "=" + define.second;
+	return name;
+}
+
+ShaderCache::ShaderCache(const std::string& _path, JobSystem& _jobSystem) :
+	path(_path),
+	jobSystem(_jobSystem),
+	file(CacheFile::Format::ShaderBytecode),
+	dirty(false)
+{
+	statistics.numHits = 0;
+	statistics.numMisses = 0;
+	statistics.preprocessTimeInSeconds = 0.0;
+	statistics.compileTimeInSeconds = 0.0;
+
+	file.Load(path);
+}
+
+ShaderCache::~ShaderCache()
+{
+	Save();
+}
+
+bool ShaderCache::Compile(const std::vector<ShaderDesc>& shaders, std::vector<ComPtr<ID3DBlob>>& outBytecode)
+{
+	outBytecode.clear();
+	outBytecode.resize(shaders.size());
+
+	auto preprocessBegin = std::chrono::high_resolution_clock::now();
+	std::vector<PreprocessedShader> preprocessedShaders(shaders.size());
+	for (size_t i = 0; i < shaders.size(); ++i)
+	{
+		if (!PreprocessShader(shaders[i], preprocessedShaders[i]))
+			return false;
+	}
+	auto preprocessEnd = std::chrono::high_resolution_clock::now();
+	statistics.preprocessTimeInSeconds += std::chrono::duration_cast<std::chrono::nanoseconds>(preprocessEnd - preprocessBegin).count() / 1000.0 / 1000.0 / 1000.0;
+
+	// Take what is in the cache, compile everything else in parallel.
+	auto compileBegin = std::chrono::high_resolution_clock::now();
+	std::vector<JobSystem::JobHandle> compileJobs;
+	std::vector<size_t> compiledShaders;
+	std::vector<char> succeeded(shaders.size(), 1);
+	for (size_t i = 0; i < shaders.size(); ++i)
+	{
+		const std::vector<uint8_t>* cachedBytecode = file.Find(preprocessedShaders[i].key);
+		if (cachedBytecode && SUCCEEDED(D3DCreateBlob(cachedBytecode->size(), &outBytecode[i])))
+		{
+			memcpy(outBytecode[i]->GetBufferPointer(), cachedBytecode->data(), cachedBytecode->size());
+			++statistics.numHits;
+			continue;
+		}
+
+		++statistics.numMisses;
+		compiledShaders.push_back(i);
+		compileJobs.push_back(jobSystem.Schedule([&, i]() {
+			const ShaderDesc& shader = shaders[i];
+			ComPtr<ID3DBlob> errorMessages;
+			// Includes and defines are already resolved.
+			if (FAILED(D3DCompile(preprocessedShaders[i].source->GetBufferPointer(), preprocessedShaders[i].source->GetBufferSize(), shader.filename.c_str(),
+									nullptr, nullptr, shader.entryPoint.c_str(), shader.profile.c_str(), shader.compileFlags, 0, &outBytecode[i], &errorMessages)))
+			{
+				OutputCompilerMessages(shader.filename + " (" + shader.entryPoint + ")", errorMessages.Get());
+				succeeded[i] = 0;
+			}
+		}));
+	}
+
+	for (const auto& job : compileJobs)
+		jobSystem.Wait(job);
+	auto compileEnd = std::chrono::high_resolution_clock::now();
+	statistics.compileTimeInSeconds += std::chrono::duration_cast<std::chrono::nanoseconds>(compileEnd - compileBegin).count() / 1000.0 / 1000.0 / 1000.0;
+
+	bool allSucceeded = true;
+	for (size_t i : compiledShaders)
+	{
+		if (!succeeded[i])
+		{
+			allSucceeded = false;
+			continue;
+		}
+		file.Store(preprocessedShaders[i].key, outBytecode[i]->GetBufferPointer(), outBytecode[i]->GetBufferSize());
+		dirty = true;
+	}
+
+	return allSucceeded;
+}
+
+void ShaderCache::Save()
+{
+	if (dirty && file.Save(path))
+		dirty = false;
+}
+
+std::string ShaderCache::GetDefaultPath()
+{
+	return GetExecutableDirectory() + "shadercache.bin";
+}
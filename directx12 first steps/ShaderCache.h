@@ -0,0 +1,66 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3dcommon.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CacheFile.h"
+
+using namespace Microsoft::WRL;
+
+class JobSystem;
+
+/// Persistent cache for compiled shader bytecode.
+///
+/// Shaders are identified by a hash over their preprocessed source (which covers include files and defines), entry point, profile and compile flags.
+/// Hits skip compilation entirely, all misses of a Compile call are compiled in parallel on the job system.
+class ShaderCache
+{
+public:
+	struct ShaderDesc
+	{
+		std::string filename;
+		std::string entryPoint;
+		std::string profile;
+		std::vector<std::pair<std::string, std::string>> defines;
+		unsigned int compileFlags;
+
+		/// Unique name of this shader variant, e.g. for looking it up in a shader archive. Does not include the compile flags.
+		std::string GetVariantName() const;
+	};
+
+	struct Statistics
+	{
+		unsigned int numHits;
+		unsigned int numMisses;
+		double preprocessTimeInSeconds;	///< Wall time for reading and preprocessing sources, needed for hits and misses.
+		double compileTimeInSeconds;	///< Wall time for compiling all misses.
+	};
+
+	ShaderCache(const std::string& path, JobSystem& jobSystem);
+	~ShaderCache();
+
+	/// Compiles all given shaders or takes them from the cache. outBytecode has the same order as shaders.
+	/// Returns false if any shader failed to compile, errors are written to std::cerr.
+	bool Compile(const std::vector<ShaderDesc>& shaders, std::vector<ComPtr<ID3DBlob>>& outBytecode);
+
+	/// Writes the cache to disk if there were any changes since the last save.
+	void Save();
+
+	const Statistics& GetStatistics() const	{ return statistics; }
+
+	/// Cache file next to the executable.
+	static std::string GetDefaultPath();
+
+private:
+	std::string path;
+	JobSystem& jobSystem;
+
+	CacheFile file;
+	bool dirty;
+
+	Statistics statistics;
+};
@@ -0,0 +1,120 @@
+#include "Test.h"
+#include "CacheFile.h"
+#include "Hash.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	// Layout of the file header: magic, version, format, numEntries, contentSize, checksum.
+	const size_t VERSION_OFFSET = 4;
+	const size_t FORMAT_OFFSET = 8;
+	const size_t CONTENT_SIZE_OFFSET = 16;
+	const size_t CHECKSUM_OFFSET = 24;
+	const size_t HEADER_SIZE = 32;
+
+	CacheFile CreateCacheFile()
+	{
+		const uint8_t first[] = { 1, 2, 3 };
+		const uint8_t second[] = { 4, 5, 6, 7, 8 };
+		CacheFile cacheFile(CacheFile::Format::ShaderBytecode);
+		cacheFile.Store(10, first, sizeof(first));
+		cacheFile.Store(20, second, sizeof(second));
+		cacheFile.Store(30, nullptr, 0);
+		return cacheFile;
+	}
+
+	/// Makes the checksum match the content again, so that only the validation behind the checksum sees the change.
+	void UpdateChecksum(std::vector<uint8_t>& data)
+	{
+		uint64_t checksum = HashBytes(data.data() + HEADER_SIZE, data.size() - HEADER_SIZE);
+		memcpy(data.data() + CHECKSUM_OFFSET, &checksum, sizeof(checksum));
+	}
+}
+
+TEST(CacheFileRoundTrip)
+{
+	CacheFile written = CreateCacheFile();
+	std::vector<uint8_t> data = written.Serialize();
+
+	CacheFile read(CacheFile::Format::ShaderBytecode);
+	CHECK(read.Deserialize(data.data(), data.size()));
+	CHECK(read.GetNumEntries() == 3);
+	for (uint64_t key : { 10, 20, 30 })
+		CHECK(read.Find(key) && *read.Find(key) == *written.Find(key));
+	CHECK(!read.Find(40));
+
+	CHECK(written.Save("CacheFileTest.bin"));
+	CacheFile loaded(CacheFile::Format::ShaderBytecode);
+	CHECK(loaded.Load("CacheFileTest.bin"));
+	CHECK(loaded.GetNumEntries() == 3 && loaded.Find(20) && *loaded.Find(20) == *written.Find(20));
+	std::remove("CacheFileTest.bin");
+
+	CHECK(!loaded.Load("CacheFileTestMissing.bin"));
+	CHECK(loaded.GetNumEntries() == 0);
+}
+
+TEST(CacheFileRejectsStaleHeader)
+{
+	std::vector<uint8_t> validData = CreateCacheFile().Serialize();
+	CacheFile cacheFile(CacheFile::Format::ShaderBytecode);
+
+	std::vector<uint8_t> data = validData;
+	data[0] ^= 0xFF;
+	CHECK(!cacheFile.Deserialize(data.data(), data.size()));
+
+	data = validData;
+	uint32_t version = CacheFile::VERSION + 1;
+	memcpy(data.data() + VERSION_OFFSET, &version, sizeof(version));
+	CHECK(!cacheFile.Deserialize(data.data(), data.size()));
+
+	data = validData;
+	uint32_t format = static_cast<uint32_t>(CacheFile::Format::PipelineLibrary);
+	memcpy(data.data() + FORMAT_OFFSET, &format, sizeof(format));
+	CHECK(!cacheFile.Deserialize(data.data(), data.size()));
+
+	// A valid file of a different format.
+	CacheFile pipelineLibrary(CacheFile::Format::PipelineLibrary);
+	CHECK(!pipelineLibrary.Deserialize(validData.data(), validData.size()));
+	CHECK(pipelineLibrary.GetNumEntries() == 0);
+
+	CHECK(!cacheFile.Deserialize(validData.data(), HEADER_SIZE - 1));
+}
+
+TEST(CacheFileRejectsCorruption)
+{
+	std::vector<uint8_t> data = CreateCacheFile().Serialize();
+	CacheFile cacheFile(CacheFile::Format::ShaderBytecode);
+
+	data.back() ^= 0xFF;
+	CHECK(!cacheFile.Deserialize(data.data(), data.size()));
+	CHECK(cacheFile.GetNumEntries() == 0);
+
+	// Truncated, so that the size in the header does not match anymore.
+	data = CreateCacheFile().Serialize();
+	CHECK(!cacheFile.Deserialize(data.data(), data.size() - 1));
+}
+
+TEST(CacheFileRejectsEntryOverrun)
+{
+	std::vector<uint8_t> validData = CreateCacheFile().Serialize();
+	CacheFile cacheFile(CacheFile::Format::ShaderBytecode);
+
+	// Entries are stored ordered by key, the first one has a size of 3 and is followed by two more entries.
+	std::vector<uint8_t> data = validData;
+	uint64_t entrySize = data.size();
+	memcpy(data.data() + HEADER_SIZE + sizeof(uint64_t), &entrySize, sizeof(entrySize));
+	UpdateChecksum(data);
+	CHECK(!cacheFile.Deserialize(data.data(), data.size()));
+	CHECK(cacheFile.GetNumEntries() == 0);
+
+	// Content ends in the middle of the last entry header.
+	data = validData;
+	data.resize(data.size() - sizeof(uint64_t));
+	uint64_t contentSize = data.size() - HEADER_SIZE;
+	memcpy(data.data() + CONTENT_SIZE_OFFSET, &contentSize, sizeof(contentSize));
+	UpdateChecksum(data);
+	CHECK(!cacheFile.Deserialize(data.data(), data.size()));
+	CHECK(cacheFile.GetNumEntries() == 0);
+}
@@ -0,0 +1,15 @@
+# Runs COMMAND (a ;-separated list) and fails unless its standard output is a single JSON document.
+# Diagnostics belong on standard error, so that the output of --benchmark - can be piped into other tools.
+execute_process(COMMAND ${COMMAND} OUTPUT_VARIABLE output RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "Command failed with ${result}")
+endif()
+if(NOT output MATCHES "^[ \t\r\n]*{" OR NOT output MATCHES "}[ \t\r\n]*$")
+	message(FATAL_ERROR "Standard output is not a single JSON object:\n${output}")
+endif()
+if(NOT CMAKE_VERSION VERSION_LESS 3.19)
+	string(JSON type ERROR_VARIABLE error TYPE "${output}")
+	if(error)
+		message(FATAL_ERROR "Standard output is not valid JSON: ${error}\n${output}")
+	endif()
+endif()
@@ -0,0 +1,122 @@
+#include "Test.h"
+#include "ManualFence.h"
+#include "FramePacer.h"
+
+namespace
+{
+	const unsigned int NUM_FRAME_SLOTS = 3;
+
+	class NoSync : public FramePacer::Sync
+	{
+	public:
+		void WaitForSwapChain() override	{}
+	};
+}
+
+TEST(FenceTimelineFrameSlots)
+{
+	ManualFence fence;
+	FenceTimeline timeline(fence, NUM_FRAME_SLOTS);
+	CHECK(timeline.GetCurrentFrameSlot() == 0);
+	CHECK(timeline.GetFrameValue(0) == 0);
+
+	// Frame values skip the signals in between, slots wrap around.
+	uint64_t firstFrame = timeline.SignalFrame();
+	CHECK(timeline.Signal() == firstFrame + 1);
+	uint64_t secondFrame = timeline.SignalFrame();
+	CHECK(secondFrame == firstFrame + 2);
+	CHECK(fence.signaledValues.size() == 3 && fence.signaledValues.back() == secondFrame);
+	CHECK(timeline.GetFrameSlotValue(0) == firstFrame && timeline.GetFrameSlotValue(1) == secondFrame && timeline.GetFrameSlotValue(2) == 0);
+	CHECK(timeline.GetFrameValue(0) == secondFrame && timeline.GetFrameValue(1) == firstFrame && timeline.GetFrameValue(2) == 0);
+	CHECK(timeline.GetNumFramesInFlight() == 2);
+
+	uint64_t thirdFrame = timeline.SignalFrame();
+	CHECK(timeline.GetCurrentFrameSlot() == 0);
+	fence.Complete(firstFrame + 1);
+	CHECK(timeline.GetNumFramesInFlight() == 2);
+	CHECK(timeline.IsComplete(firstFrame) && !timeline.IsComplete(secondFrame));
+
+	// Reusing slot 0 needs the first frame only, which is done.
+	timeline.WaitForCurrentFrameSlot();
+	CHECK(fence.waitedValues.empty());
+	timeline.SignalFrame();
+	timeline.WaitForCurrentFrameSlot();
+	CHECK(fence.waitedValues.size() == 1 && fence.waitedValues[0] == secondFrame);
+	CHECK(timeline.GetFrameValue(1) == thirdFrame);
+}
+
+TEST(FenceTimelineSlotReuseAfterMaxFramesInFlightChange)
+{
+	ManualFence fence;
+	FenceTimeline timeline(fence, NUM_FRAME_SLOTS);
+	NoSync sync;
+	FramePacer pacer(timeline, sync, FramePacingMode::Throughput, NUM_FRAME_SLOTS);
+
+	// Runs a frame like the devices do: wait for the slot's resources, record, signal, present.
+	auto runFrame = [&]()
+	{
+		pacer.BeginFrame();
+		timeline.WaitForCurrentFrameSlot();
+		uint64_t value = timeline.SignalFrame();
+		pacer.Present();
+		pacer.EndFrame();
+		return value;
+	};
+
+	std::vector<uint64_t> values;
+	for (unsigned int i = 0; i < NUM_FRAME_SLOTS; ++i)
+		values.push_back(runFrame());
+	CHECK(fence.waitedValues.size() == 1 && fence.waitedValues[0] == values[0]);
+
+	// With a single frame in flight, the pacer already waited for the frame that used the slot before, the slot wait is free.
+	pacer.SetMaxFramesInFlight(1);
+	values.push_back(runFrame());
+	CHECK(fence.waitedValues.size() == 2 && fence.waitedValues[1] == values[3]);
+	CHECK(timeline.GetNumFramesInFlight() == 0);
+
+	// Going back up lets frames queue up again. Slots are reused round robin, each waits for exactly the frame that used it last.
+	pacer.SetMaxFramesInFlight(NUM_FRAME_SLOTS);
+	for (unsigned int i = 0; i < NUM_FRAME_SLOTS; ++i)
+	{
+		unsigned int slot = timeline.GetCurrentFrameSlot();
+		CHECK(slot == values.size() % NUM_FRAME_SLOTS);
+		CHECK(timeline.GetFrameSlotValue(slot) == values[values.size() - NUM_FRAME_SLOTS]);
+		values.push_back(runFrame());
+	}
+	CHECK(fence.waitedValues.size() == 3 && fence.waitedValues[2] == values[values.size() - NUM_FRAME_SLOTS]);
+	CHECK(timeline.GetNumFramesInFlight() == NUM_FRAME_SLOTS - 1);
+}
+
+TEST(FenceTimelineQueueWait)
+{
+	ManualFence directFence;
+	ManualFence copyFence;
+	FenceTimeline directTimeline(directFence, NUM_FRAME_SLOTS);
+	FenceTimeline copyTimeline(copyFence, 1);
+
+	// The wait goes to the direct queue, on the copy fence.
+	uint64_t firstCopy = copyTimeline.Signal();
+	uint64_t secondCopy = copyTimeline.Signal();
+	directTimeline.QueueWait(copyTimeline, firstCopy);
+	CHECK(directFence.queueWaits.size() == 1);
+	CHECK(directFence.queueWaits[0].otherFence == &copyFence && directFence.queueWaits[0].value == firstCopy);
+	CHECK(copyFence.queueWaits.empty());
+	CHECK(directFence.waitedValues.empty() && copyFence.waitedValues.empty());
+	CHECK(directFence.signaledValues.empty());
+
+	// Completed copies need no GPU wait.
+	copyFence.Complete(firstCopy);
+	directTimeline.QueueWait(copyTimeline, firstCopy);
+	CHECK(directFence.queueWaits.size() == 1);
+	directTimeline.QueueWait(copyTimeline, secondCopy);
+	CHECK(directFence.queueWaits.size() == 2 && directFence.queueWaits[1].value == secondCopy);
+
+	// CPU waits on several queues only block on the incomplete values.
+	uint64_t frame = directTimeline.SignalFrame();
+	FenceTimeline* timelines[] = { &directTimeline, &copyTimeline };
+	uint64_t values[] = { frame, firstCopy };
+	FenceTimeline::WaitForAll(timelines, values, 2);
+	CHECK(directFence.waitedValues.size() == 1 && directFence.waitedValues[0] == frame);
+	CHECK(copyFence.waitedValues.empty());
+	CHECK(directTimeline.IsComplete(frame));
+}
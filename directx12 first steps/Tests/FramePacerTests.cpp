@@ -0,0 +1,147 @@
+#include "Test.h"
+#include "ManualFence.h"
+#include "FramePacer.h"
+
+namespace
+{
+	/// Counts swap chain waits and remembers how many fence waits happened before each of them.
+	class ManualSync : public FramePacer::Sync
+	{
+	public:
+		ManualSync(const ManualFence& _fence) : fence(_fence) {}
+
+		void WaitForSwapChain() override	{ numFenceWaitsBeforeSwapChainWaits.push_back(fence.waitedValues.size()); }
+
+		std::vector<size_t> numFenceWaitsBeforeSwapChainWaits;
+
+	private:
+		const ManualFence& fence;
+	};
+
+	const unsigned int NUM_FRAME_SLOTS = 3;
+
+	/// Records, signals and presents a frame like the devices do, but leaves EndFrame to the test.
+	uint64_t BeginAndPresentFrame(FramePacer& pacer, FenceTimeline& timeline)
+	{
+		pacer.BeginFrame();
+		uint64_t value = timeline.SignalFrame();
+		pacer.Present();
+		return value;
+	}
+}
+
+TEST(FramePacerThroughputWaitsInEndFrame)
+{
+	ManualFence fence;
+	FenceTimeline timeline(fence, NUM_FRAME_SLOTS);
+	ManualSync sync(fence);
+	FramePacer pacer(timeline, sync, FramePacingMode::Throughput, 2);
+
+	// The first frame has no frame before it to wait for.
+	uint64_t firstFrame = BeginAndPresentFrame(pacer, timeline);
+	pacer.EndFrame();
+	CHECK(fence.waitedValues.empty());
+
+	// With 2 frames in flight, the end of the second frame waits for the first one.
+	timeline.Signal();	// Signals that do not belong to frames are not waited for.
+	BeginAndPresentFrame(pacer, timeline);
+	CHECK(fence.waitedValues.empty());
+	CHECK(pacer.GetNumFramesInFlight() == 2);
+	pacer.EndFrame();
+	CHECK(fence.waitedValues.size() == 1 && fence.waitedValues[0] == firstFrame);
+	CHECK(pacer.GetNumFramesInFlight() == 1);
+
+	// No wait if the GPU is already done.
+	fence.Complete(timeline.GetLastSignaledValue());
+	BeginAndPresentFrame(pacer, timeline);
+	pacer.EndFrame();
+	CHECK(fence.waitedValues.size() == 1);
+
+	CHECK(sync.numFenceWaitsBeforeSwapChainWaits.empty());
+	CHECK(pacer.GetStatistics().numFrames == 3);
+	CHECK(pacer.GetStatistics().numFenceWaits == 1);
+}
+
+TEST(FramePacerLatencyWaitsInBeginFrame)
+{
+	ManualFence fence;
+	FenceTimeline timeline(fence, NUM_FRAME_SLOTS);
+	ManualSync sync(fence);
+	FramePacer pacer(timeline, sync, FramePacingMode::Latency, 2);
+
+	// Even the first frame waits for the swap chain.
+	uint64_t firstFrame = BeginAndPresentFrame(pacer, timeline);
+	pacer.EndFrame();
+	CHECK(sync.numFenceWaitsBeforeSwapChainWaits.size() == 1);
+	uint64_t secondFrame = BeginAndPresentFrame(pacer, timeline);
+	pacer.EndFrame();
+	CHECK(fence.waitedValues.empty());
+
+	// The third frame waits before recording, first for the swap chain, then for the first frame.
+	pacer.BeginFrame();
+	CHECK(sync.numFenceWaitsBeforeSwapChainWaits.size() == 3 && sync.numFenceWaitsBeforeSwapChainWaits[2] == 0);
+	CHECK(fence.waitedValues.size() == 1 && fence.waitedValues[0] == firstFrame);
+	CHECK(pacer.GetState() == FramePacer::State::Recording);
+	timeline.SignalFrame();
+	pacer.Present();
+	pacer.EndFrame();
+	CHECK(fence.waitedValues.size() == 1);
+
+	// A missing EndFrame does not skip or double the wait.
+	pacer.BeginFrame();
+	CHECK(fence.waitedValues.size() == 2 && fence.waitedValues[1] == secondFrame);
+	CHECK(sync.numFenceWaitsBeforeSwapChainWaits.size() == 4);
+}
+
+TEST(FramePacerModeSwitch)
+{
+	ManualFence fence;
+	FenceTimeline timeline(fence, NUM_FRAME_SLOTS);
+	ManualSync sync(fence);
+	FramePacer pacer(timeline, sync, FramePacingMode::Throughput, 1);
+
+	// Switching between Present and EndFrame moves the wait of this frame to the next BeginFrame, it happens exactly once.
+	uint64_t firstFrame = BeginAndPresentFrame(pacer, timeline);
+	pacer.SetMode(FramePacingMode::Latency);
+	pacer.EndFrame();
+	CHECK(fence.waitedValues.empty());
+	pacer.BeginFrame();
+	CHECK(fence.waitedValues.size() == 1 && fence.waitedValues[0] == firstFrame);
+	CHECK(sync.numFenceWaitsBeforeSwapChainWaits.size() == 1);
+
+	// Switching back after the wait in BeginFrame does not wait again in EndFrame.
+	timeline.SignalFrame();
+	pacer.SetMode(FramePacingMode::Throughput);
+	pacer.Present();
+	CHECK(fence.waitedValues.size() == 1);
+	pacer.EndFrame();
+	CHECK(fence.waitedValues.size() == 2 && fence.waitedValues[1] == timeline.GetLastSignaledValue());
+	CHECK(pacer.GetStatistics().numFenceWaits == 2);
+}
+
+TEST(FramePacerMaxFramesInFlight)
+{
+	ManualFence fence;
+	FenceTimeline timeline(fence, NUM_FRAME_SLOTS);
+	ManualSync sync(fence);
+	FramePacer pacer(timeline, sync, FramePacingMode::Throughput, 10);
+	CHECK(pacer.GetMaxFramesInFlight() == NUM_FRAME_SLOTS);
+	pacer.SetMaxFramesInFlight(0);
+	CHECK(pacer.GetMaxFramesInFlight() == 1);
+
+	// A single frame in flight waits for the frame that was just presented.
+	uint64_t value = BeginAndPresentFrame(pacer, timeline);
+	pacer.EndFrame();
+	CHECK(fence.waitedValues.size() == 1 && fence.waitedValues[0] == value);
+
+	// With all slots in use, the wait targets the frame NUM_FRAME_SLOTS - 1 frames back.
+	pacer.SetMaxFramesInFlight(NUM_FRAME_SLOTS);
+	std::vector<uint64_t> values;
+	for (unsigned int i = 0; i < NUM_FRAME_SLOTS; ++i)
+	{
+		values.push_back(BeginAndPresentFrame(pacer, timeline));
+		pacer.EndFrame();
+	}
+	CHECK(fence.waitedValues.size() == 2 && fence.waitedValues[1] == values[0]);
+	CHECK(pacer.GetNumFramesInFlight() == NUM_FRAME_SLOTS - 1);
+}
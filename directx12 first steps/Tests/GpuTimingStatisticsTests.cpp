@@ -0,0 +1,74 @@
+#include "Test.h"
+#include "GpuTimingStatistics.h"
+
+namespace
+{
+	/// One tick per millisecond, so durations in ticks are the expected milliseconds.
+	const uint64_t TIMESTAMP_FREQUENCY = 1000;
+
+	/// Frame with a single scope of the given duration.
+	void AddFrame(GpuTimingStatistics& statistics, const std::string& name, uint64_t ticks)
+	{
+		std::vector<GpuTimingStatistics::Scope> scopes = { { name, 0, 1 } };
+		uint64_t timestamps[] = { 5000, 5000 + ticks };
+		statistics.AddFrame(scopes, timestamps, TIMESTAMP_FREQUENCY);
+	}
+}
+
+TEST(GpuTimingStatisticsRollingWindow)
+{
+	GpuTimingStatistics statistics(3);
+	GpuTimingStatistics::Summary summary;
+	CHECK(!statistics.GetSummary("Frame", summary));
+
+	AddFrame(statistics, "Frame", 4);
+	AddFrame(statistics, "Frame", 1);
+	CHECK(statistics.GetSummary("Frame", summary));
+	CHECK(summary.numSamples == 2);
+	CHECK(summary.minMilliseconds == 1.0 && summary.avgMilliseconds == 2.5 && summary.maxMilliseconds == 4.0);
+
+	AddFrame(statistics, "Frame", 7);
+	CHECK(statistics.GetSummary("Frame", summary));
+	CHECK(summary.numSamples == 3);
+	CHECK(summary.minMilliseconds == 1.0 && summary.avgMilliseconds == 4.0 && summary.maxMilliseconds == 7.0);
+
+	// The window is full, the oldest samples drop out one after another.
+	AddFrame(statistics, "Frame", 2);
+	CHECK(statistics.GetSummary("Frame", summary));
+	CHECK(summary.numSamples == 3);
+	CHECK(summary.minMilliseconds == 1.0 && summary.avgMilliseconds == 10.0 / 3.0 && summary.maxMilliseconds == 7.0);
+	AddFrame(statistics, "Frame", 3);
+	AddFrame(statistics, "Frame", 3);
+	CHECK(statistics.GetSummary("Frame", summary));
+	CHECK(summary.minMilliseconds == 2.0 && summary.avgMilliseconds == 8.0 / 3.0 && summary.maxMilliseconds == 3.0);
+
+	statistics.Clear();
+	CHECK(!statistics.GetSummary("Frame", summary));
+}
+
+TEST(GpuTimingStatisticsScopes)
+{
+	GpuTimingStatistics statistics(10);
+
+	// Scopes of the same name are summed up into one sample, backwards timestamps count as zero.
+	std::vector<GpuTimingStatistics::Scope> scopes = { { "Draw", 0, 1 }, { "Draw", 2, 3 }, { "Copy", 4, 5 }, { "Present", 6, 7 } };
+	uint64_t timestamps[] = { 100, 102, 110, 113, 200, 250, 300, 299 };
+	statistics.AddFrame(scopes, timestamps, TIMESTAMP_FREQUENCY);
+
+	GpuTimingStatistics::Summary summary;
+	CHECK(statistics.GetSummary("Draw", summary) && summary.numSamples == 1 && summary.avgMilliseconds == 5.0);
+	CHECK(statistics.GetSummary("Copy", summary) && summary.avgMilliseconds == 50.0);
+	CHECK(statistics.GetSummary("Present", summary) && summary.avgMilliseconds == 0.0);
+
+	// Scopes that are missing from a frame do not get a sample.
+	AddFrame(statistics, "Draw", 7);
+	CHECK(statistics.GetSummary("Draw", summary) && summary.numSamples == 2 && summary.maxMilliseconds == 7.0);
+	CHECK(statistics.GetSummary("Copy", summary) && summary.numSamples == 1);
+
+	std::vector<std::string> names = statistics.GetScopeNames();
+	CHECK(names == std::vector<std::string>({ "Copy", "Draw", "Present" }));
+
+	// Frames without a timestamp frequency are ignored.
+	statistics.AddFrame(scopes, timestamps, 0);
+	CHECK(statistics.GetSummary("Copy", summary) && summary.numSamples == 1);
+}
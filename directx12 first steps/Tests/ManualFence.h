@@ -0,0 +1,34 @@
+#pragma once
+
+#include "FenceTimeline.h"
+
+#include <vector>
+
+/// Fence whose GPU progress is driven by the test with Complete.
+/// CPU waits can not block in a single threaded test, so they are recorded and complete the fence up to the waited value, as if the GPU caught up.
+class ManualFence : public FenceTimeline::Fence
+{
+public:
+	struct QueueWaitRecord
+	{
+		const FenceTimeline::Fence* otherFence;
+		uint64_t value;
+	};
+
+	ManualFence() : completedValue(0) {}
+
+	uint64_t GetCompletedValue() const override							{ return completedValue; }
+	void Signal(uint64_t value) override								{ signaledValues.push_back(value); }
+	void WaitForValue(uint64_t value) override							{ waitedValues.push_back(value); Complete(value); }
+	void QueueWait(FenceTimeline::Fence& otherFence, uint64_t value) override	{ queueWaits.push_back({ &otherFence, value }); }
+
+	/// Lets the GPU finish all work up to value.
+	void Complete(uint64_t value)										{ if (value > completedValue) completedValue = value; }
+
+	std::vector<uint64_t> signaledValues;
+	std::vector<uint64_t> waitedValues;	///< Values of all blocking CPU waits, in order.
+	std::vector<QueueWaitRecord> queueWaits;
+
+private:
+	uint64_t completedValue;
+};
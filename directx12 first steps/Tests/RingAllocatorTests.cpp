@@ -0,0 +1,81 @@
+#include "Test.h"
+#include "RingAllocator.h"
+
+TEST(RingAllocatorAlignment)
+{
+	RingAllocator ring(256);
+	CHECK(ring.Allocate(10, 1) == 0);
+	CHECK(ring.Allocate(16, 16) == 16);
+	// Padding counts as used until the chunk is reclaimed.
+	CHECK(ring.GetUsedSize() == 32);
+	CHECK(ring.Allocate(256, 1) == RingAllocator::INVALID_OFFSET);
+	CHECK(ring.GetUsedSize() == 32);
+}
+
+TEST(RingAllocatorWrapAround)
+{
+	RingAllocator ring(100);
+	CHECK(ring.Allocate(60, 1) == 0);
+	ring.FinishAllocations(1);
+	CHECK(ring.Allocate(30, 1) == 60);
+	ring.FinishAllocations(2);
+
+	// Neither the rest at the end nor the beginning have space until the first chunk is reclaimed.
+	CHECK(ring.Allocate(20, 1) == RingAllocator::INVALID_OFFSET);
+	ring.Reclaim(1);
+	CHECK(ring.GetUsedSize() == 30);
+
+	// Wraps around, the skipped 10 bytes at the end count as used.
+	CHECK(ring.Allocate(20, 1) == 0);
+	CHECK(ring.GetUsedSize() == 60);
+	ring.FinishAllocations(3);
+
+	// Between head and tail the alignment padding needs to fit as well.
+	CHECK(ring.Allocate(40, 8) == RingAllocator::INVALID_OFFSET);
+	// Fills the gap up to the tail exactly, then the ring is full.
+	CHECK(ring.Allocate(36, 8) == 24);
+	CHECK(ring.GetUsedSize() == 100);
+	CHECK(ring.Allocate(1, 1) == RingAllocator::INVALID_OFFSET);
+	ring.FinishAllocations(4);
+
+	// Reclaiming the chunk before the wrap frees the skipped end as well.
+	ring.Reclaim(3);
+	CHECK(ring.GetUsedSize() == 40);
+	CHECK(ring.Allocate(40, 1) == 60);
+}
+
+TEST(RingAllocatorReclaim)
+{
+	RingAllocator ring(100);
+	uint64_t fenceValue = 0;
+	CHECK(!ring.GetOldestPendingFenceValue(fenceValue));
+
+	// Chunks without allocations are not recorded.
+	ring.FinishAllocations(1);
+	CHECK(!ring.GetOldestPendingFenceValue(fenceValue));
+
+	ring.Allocate(50, 1);
+	ring.FinishAllocations(2);
+	ring.Allocate(30, 1);
+	ring.Allocate(10, 1);
+	ring.FinishAllocations(5);
+	CHECK(ring.GetOldestPendingFenceValue(fenceValue) && fenceValue == 2);
+
+	// Chunks come back in order, each with all of its allocations.
+	ring.Reclaim(1);
+	CHECK(ring.GetUsedSize() == 90);
+	ring.Reclaim(4);
+	CHECK(ring.GetUsedSize() == 40);
+	CHECK(ring.GetOldestPendingFenceValue(fenceValue) && fenceValue == 5);
+
+	// The freed range at the beginning is used once the end is exhausted.
+	CHECK(ring.Allocate(20, 1) == 0);
+	ring.FinishAllocations(6);
+	ring.Reclaim(6);
+	CHECK(ring.GetUsedSize() == 0);
+	CHECK(!ring.GetOldestPendingFenceValue(fenceValue));
+
+	// An empty ring starts over at the beginning, so the whole size is available again.
+	CHECK(ring.Allocate(100, 1) == 0);
+	CHECK(ring.GetUsedSize() == 100);
+}
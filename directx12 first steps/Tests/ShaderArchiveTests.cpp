@@ -0,0 +1,148 @@
+#include "Test.h"
+#include "ShaderArchive.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const uint8_t VERTEX_SHADER[] = { 1, 2, 3, 4, 5 };
+	const uint8_t PIXEL_SHADER[] = { 6, 7, 8 };
+
+	std::vector<uint8_t> CreateArchive()
+	{
+		ShaderArchiveWriter writer;
+		writer.Add("shaders.hlsl:VSMain:vs_5_0", 1, VERTEX_SHADER, sizeof(VERTEX_SHADER));
+		writer.Add("shaders.hlsl:PSMain:ps_5_0", 2, PIXEL_SHADER, sizeof(PIXEL_SHADER));
+		return writer.Serialize();
+	}
+
+	ShaderArchiveReader::IndexEntry GetIndexEntry(const std::vector<uint8_t>& archive, uint32_t i)
+	{
+		ShaderArchiveReader::IndexEntry entry;
+		memcpy(&entry, archive.data() + sizeof(ShaderArchiveReader::Header) + i * sizeof(entry), sizeof(entry));
+		return entry;
+	}
+
+	void SetIndexEntry(std::vector<uint8_t>& archive, uint32_t i, const ShaderArchiveReader::IndexEntry& entry)
+	{
+		memcpy(archive.data() + sizeof(ShaderArchiveReader::Header) + i * sizeof(entry), &entry, sizeof(entry));
+	}
+
+	void WriteFile(const std::string& filename, const std::string& content)
+	{
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file << content;
+	}
+}
+
+TEST(ShaderArchiveRoundTrip)
+{
+	std::vector<uint8_t> archive = CreateArchive();
+	ShaderArchiveReader reader;
+	CHECK(reader.Open(archive.data(), archive.size()));
+	CHECK(reader.GetNumShaders() == 2);
+
+	const void* bytecode = nullptr;
+	size_t size = 0;
+	CHECK(reader.Find("shaders.hlsl:VSMain:vs_5_0", 1, bytecode, size));
+	CHECK(size == sizeof(VERTEX_SHADER) && memcmp(bytecode, VERTEX_SHADER, size) == 0);
+	CHECK(reader.Find("shaders.hlsl:PSMain:ps_5_0", 2, bytecode, size));
+	CHECK(size == sizeof(PIXEL_SHADER) && memcmp(bytecode, PIXEL_SHADER, size) == 0);
+	// Bytecode is used in place, it needs to point into the archive.
+	CHECK(static_cast<const uint8_t*>(bytecode) >= archive.data() && static_cast<const uint8_t*>(bytecode) + size <= archive.data() + archive.size());
+	CHECK(!reader.Find("shaders.hlsl:CSMain:cs_5_0", 1, bytecode, size));
+}
+
+TEST(ShaderArchiveContentKeyMismatch)
+{
+	std::vector<uint8_t> archive = CreateArchive();
+	ShaderArchiveReader reader;
+	CHECK(reader.Open(archive.data(), archive.size()));
+
+	const void* bytecode = nullptr;
+	size_t size = 0;
+	CHECK(!reader.Find("shaders.hlsl:VSMain:vs_5_0", 2, bytecode, size));
+	// Without a key the entry is trusted.
+	CHECK(reader.Find("shaders.hlsl:VSMain:vs_5_0", bytecode, size));
+	CHECK(size == sizeof(VERTEX_SHADER));
+}
+
+TEST(ShaderArchiveRejectsTruncation)
+{
+	std::vector<uint8_t> archive = CreateArchive();
+	ShaderArchiveReader reader;
+	CHECK(!reader.Open(archive.data(), sizeof(ShaderArchiveReader::Header) - 1));
+	// Header without the complete index.
+	CHECK(!reader.Open(archive.data(), sizeof(ShaderArchiveReader::Header) + sizeof(ShaderArchiveReader::IndexEntry)));
+	// The last bytecode ends at the end of the archive.
+	CHECK(!reader.Open(archive.data(), archive.size() - 1));
+	CHECK(!reader.IsOpen());
+
+	const void* bytecode = nullptr;
+	size_t size = 0;
+	CHECK(!reader.Find("shaders.hlsl:VSMain:vs_5_0", 1, bytecode, size));
+}
+
+TEST(ShaderArchiveRejectsInvalidIndex)
+{
+	std::vector<uint8_t> validArchive = CreateArchive();
+	ShaderArchiveReader reader;
+
+	std::vector<uint8_t> archive = validArchive;
+	ShaderArchiveReader::IndexEntry entry = GetIndexEntry(archive, 0);
+	entry.bytecodeOffset = archive.size() - entry.bytecodeSize + 1;
+	SetIndexEntry(archive, 0, entry);
+	CHECK(!reader.Open(archive.data(), archive.size()));
+
+	archive = validArchive;
+	entry = GetIndexEntry(archive, 1);
+	entry.nameLength = ~0ull;
+	SetIndexEntry(archive, 1, entry);
+	CHECK(!reader.Open(archive.data(), archive.size()));
+
+	// Lookups rely on the index being sorted.
+	archive = validArchive;
+	ShaderArchiveReader::IndexEntry first = GetIndexEntry(archive, 0);
+	SetIndexEntry(archive, 0, GetIndexEntry(archive, 1));
+	SetIndexEntry(archive, 1, first);
+	CHECK(!reader.Open(archive.data(), archive.size()));
+
+	archive = validArchive;
+	uint32_t version = ShaderArchiveReader::VERSION + 1;
+	memcpy(archive.data() + offsetof(ShaderArchiveReader::Header, version), &version, sizeof(version));
+	CHECK(!reader.Open(archive.data(), archive.size()));
+
+	archive = validArchive;
+	archive[0] ^= 0xFF;
+	CHECK(!reader.Open(archive.data(), archive.size()));
+}
+
+TEST(ShaderContentKey)
+{
+	WriteFile("ShaderContentKeyTest.hlsl", "#include \"ShaderContentKeyTest.hlsli\"\nfloat4 main() : SV_Target { return Color; }\n");
+	WriteFile("ShaderContentKeyTest.hlsli", "static const float4 Color = 1;\n");
+
+	uint64_t key = 0;
+	CHECK(ComputeShaderContentKey("ShaderContentKeyTest.hlsl", "variant", 0, key));
+	uint64_t sameKey = 0;
+	CHECK(ComputeShaderContentKey("ShaderContentKeyTest.hlsl", "variant", 0, sameKey));
+	CHECK(key == sameKey);
+
+	uint64_t otherKey = 0;
+	CHECK(ComputeShaderContentKey("ShaderContentKeyTest.hlsl", "other variant", 0, otherKey));
+	CHECK(key != otherKey);
+	CHECK(ComputeShaderContentKey("ShaderContentKeyTest.hlsl", "variant", 1, otherKey));
+	CHECK(key != otherKey);
+
+	// Edits of an include file change the key as well.
+	WriteFile("ShaderContentKeyTest.hlsli", "static const float4 Color = 0;\n");
+	CHECK(ComputeShaderContentKey("ShaderContentKeyTest.hlsl", "variant", 0, otherKey));
+	CHECK(key != otherKey);
+
+	CHECK(!ComputeShaderContentKey("ShaderContentKeyTestMissing.hlsl", "variant", 0, otherKey));
+
+	std::remove("ShaderContentKeyTest.hlsl");
+	std::remove("ShaderContentKeyTest.hlsli");
+}
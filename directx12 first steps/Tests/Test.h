@@ -0,0 +1,35 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+// Minimal unit test harness for the headless build, see TestMain.cpp.
+// Independent of D3D12 and Windows.
+
+/// Test function registered under a name, so that every test can run as a separate ctest case.
+struct TestCase
+{
+	const char* name;
+	void (*function)();
+};
+
+std::vector<TestCase>& GetTestCases();
+/// Incremented by every failed CHECK.
+extern int numFailedChecks;
+
+struct TestRegistration
+{
+	TestRegistration(const char* name, void (*function)())	{ GetTestCases().push_back({ name, function }); }
+};
+
+/// Defines and registers a test. Names need to be unique across all test files.
+#define TEST(name) \
+	static void Test_##name(); \
+	static TestRegistration testRegistration_##name(#name, Test_##name); \
+	static void Test_##name()
+
+/// Reports a failed condition and continues with the test.
+#define CHECK(x) do { \
+		if (!(x)) { \
+			std::cerr << __FILE__ << "(" << __LINE__ << "): CHECK failed: " << #x << std::endl; \
+			++numFailedChecks; } } while(false)
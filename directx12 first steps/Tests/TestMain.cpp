@@ -0,0 +1,33 @@
+#include "Test.h"
+
+#include <cstring>
+
+int numFailedChecks = 0;
+
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+/// Runs the test with the given name, or all tests without an argument. Returns 1 if a check failed or the test does not exist.
+int main(int argc, char** argv)
+{
+	bool foundTest = false;
+	for (const TestCase& testCase : GetTestCases())
+	{
+		if (argc > 1 && strcmp(argv[1], testCase.name) != 0)
+			continue;
+		foundTest = true;
+		int numFailedChecksBefore = numFailedChecks;
+		testCase.function();
+		std::cerr << (numFailedChecks == numFailedChecksBefore ? "Passed: " : "Failed: ") << testCase.name << std::endl;
+	}
+
+	if (!foundTest)
+	{
+		std::cerr << "Unknown test " << (argc > 1 ? argv[1] : "") << std::endl;
+		return 1;
+	}
+	return numFailedChecks > 0 ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+#include "UploadRing.h"
+
+#include "d3dx12.h"
+#include "Helper.h"
+
+UploadRing::UploadRing(ID3D12Device* device, UINT64 size) :
+	ringAllocator(size),
+	mappedData(nullptr)
+{
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	if (FAILED(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+												D3D12_RESOURCE_STATE_GENERIC_READ, // D3D12_RESOURCE_STATE_GENERIC_READ is the only possible for D3D12_HEAP_TYPE_UPLOAD.
+												nullptr, IID_PPV_ARGS(&buffer))))
+	{
+		CRITICAL_ERROR("Failed to create upload ring buffer.");
+	}
+
+	// Upload heaps can stay mapped for their entire lifetime.
+	CD3DX12_RANGE readRange(0, 0); // We never read from this resource on the CPU.
+	if (FAILED(buffer->Map(0, &readRange, reinterpret_cast<void**>(&mappedData))))
+		CRITICAL_ERROR("Failed to map upload ring buffer.");
+}
+
+UploadRing::~UploadRing()
+{
+	if (mappedData)
+		buffer->Unmap(0, nullptr);
+}
+
+bool UploadRing::Allocate(UINT64 size, UINT64 alignment, Allocation& outAllocation)
+{
+	UINT64 offset = ringAllocator.Allocate(size, alignment);
+	if (offset == RingAllocator::INVALID_OFFSET)
+		return false;
+
+	outAllocation.resource = buffer.Get();
+	outAllocation.offset = offset;
+	outAllocation.cpuAddress = mappedData + offset;
+	outAllocation.gpuAddress = buffer->GetGPUVirtualAddress() + offset;
+	return true;
+}
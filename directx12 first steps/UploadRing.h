@@ -0,0 +1,44 @@
+#pragma once
+
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "RingAllocator.h"
+
+using namespace Microsoft::WRL;
+
+/// Persistently mapped upload buffer from which short-lived upload memory is sub-allocated.
+///
+/// Allocations are tagged with a fence value via FinishAllocations and reclaimed once this value has been completed.
+/// The actual ring logic lives in RingAllocator which is independent of D3D12.
+class UploadRing
+{
+public:
+	struct Allocation
+	{
+		ID3D12Resource* resource;
+		UINT64 offset;							///< Offset within resource.
+		UINT8* cpuAddress;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+	};
+
+	UploadRing(ID3D12Device* device, UINT64 size);
+	~UploadRing();
+
+	/// Returns false if there is not enough space left in the ring.
+	bool Allocate(UINT64 size, UINT64 alignment, Allocation& outAllocation);
+
+	/// Tags all allocations since the last call with the given fence value.
+	void FinishAllocations(UINT64 fenceValue)		{ ringAllocator.FinishAllocations(fenceValue); }
+	/// Makes all allocations available again that were tagged with a fence value smaller or equal to completedFenceValue.
+	void Reclaim(UINT64 completedFenceValue)		{ ringAllocator.Reclaim(completedFenceValue); }
+
+	bool GetOldestPendingFenceValue(UINT64& outFenceValue) const	{ return ringAllocator.GetOldestPendingFenceValue(outFenceValue); }
+	UINT64 GetUsedSize() const										{ return ringAllocator.GetUsedSize(); }
+
+private:
+	RingAllocator ringAllocator;
+
+	ComPtr<ID3D12Resource> buffer;
+	UINT8* mappedData;
+};
@@ -0,0 +1,76 @@
+// GPU generator of ProceduralTexture. Needs to match ProceduralTexture.h/.cpp exactly, the CPU version is the reference.
+
+cbuffer GenerationConstants : register(b0)
+{
+	uint FirstSeed;	// Seed of the first slice, every slice uses the next seed.
+};
+
+// Typed UAV loads are not needed, the shader only writes.
+RWTexture2DArray<unorm float4> outputTexture : register(u0);
+
+#define NUM_PATTERNS 3
+#define PATTERN_RANDOM 0
+#define PATTERN_VALUE_NOISE 1
+#define PATTERN_CHECKER 2
+#define CELL_SIZE 4
+#define OPAQUE_ALPHA 0xFF000000u
+
+uint Hash(uint value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352du;
+	value ^= value >> 15;
+	value *= 0x846ca68bu;
+	value ^= value >> 16;
+	return value;
+}
+
+uint HashTexel(uint seed, uint x, uint y)
+{
+	return Hash(x ^ Hash(y ^ Hash(seed)));
+}
+
+uint InterpolateChannels(uint c00, uint c10, uint c01, uint c11, uint weightX, uint weightY)
+{
+	uint result = 0;
+	[unroll] for (uint shift = 0; shift < 24; shift += 8)
+	{
+		uint top = ((c00 >> shift) & 0xFF) * (CELL_SIZE - weightX) + ((c10 >> shift) & 0xFF) * weightX;
+		uint bottom = ((c01 >> shift) & 0xFF) * (CELL_SIZE - weightX) + ((c11 >> shift) & 0xFF) * weightX;
+		result |= ((top * (CELL_SIZE - weightY) + bottom * weightY) / (CELL_SIZE * CELL_SIZE)) << shift;
+	}
+	return result;
+}
+
+uint GenerateTexel(uint seed, uint x, uint y)
+{
+	uint pattern = Hash(seed) % NUM_PATTERNS;
+	if (pattern == PATTERN_VALUE_NOISE)
+	{
+		uint cellX = x / CELL_SIZE;
+		uint cellY = y / CELL_SIZE;
+		return InterpolateChannels(HashTexel(seed, cellX, cellY), HashTexel(seed, cellX + 1, cellY),
+								HashTexel(seed, cellX, cellY + 1), HashTexel(seed, cellX + 1, cellY + 1),
+								x % CELL_SIZE, y % CELL_SIZE) | OPAQUE_ALPHA;
+	}
+	else if (pattern == PATTERN_CHECKER)
+	{
+		uint colorIndex = ((x / CELL_SIZE) ^ (y / CELL_SIZE)) & 1;
+		return Hash(Hash(seed) + colorIndex) | OPAQUE_ALPHA;
+	}
+	return HashTexel(seed, x, y) | OPAQUE_ALPHA;
+}
+
+// One thread per texel, one group layer per slice. Keep in sync with Renderer::GENERATION_THREAD_GROUP_SIZE.
+[numthreads(8, 8, 1)]
+void CSMain(uint3 texel : SV_DispatchThreadID)
+{
+	uint width, height, numSlices;
+	outputTexture.GetDimensions(width, height, numSlices);
+	if (texel.x >= width || texel.y >= height)
+		return;
+
+	uint color = GenerateTexel(FirstSeed + texel.z, texel.x, texel.y);
+	// Values that are multiples of 1/255 convert back to exactly the same 8bit values.
+	outputTexture[texel] = float4(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, color >> 24) / 255.0f;
+}
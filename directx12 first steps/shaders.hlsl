@@ -7,28 +7,46 @@ struct PSInput
 {
 	float4 position : SV_POSITION;
 	float2 texcoord : TEXCOORD;
+	nointerpolation uint drawID : DRAWID;
 };
 
-PSInput VSMain(float2 position : POSITION, float2 texcoord : TEXCOORD)
+PSInput VSMain(float2 position : POSITION, float2 texcoord : TEXCOORD, uint instanceID : SV_InstanceID)
 {
 	PSInput result;
 
+	// For instanced drawing DrawID is the id of the first instance.
+	uint drawID = DrawID + instanceID;
+
 	float2 displace = float2(-0.95f, -0.95f);
-	displace.x += (DrawID % 20) * 0.1f;
-	displace.y += (DrawID / 20) * 0.1f;
+	displace.x += (drawID % 20) * 0.1f;
+	displace.y += (drawID / 20) * 0.1f;
 
 	result.position.xy = position * 0.1 + displace;
 	result.position.zw = float2(0.0f, 1.0f);
 	result.texcoord = texcoord;
+	result.drawID = drawID;
 
 	return result;
 }
 
 
 SamplerState defaultSampler : register(s0);
+#if defined(TEXTURE_ARRAY)
+Texture2DArray colorTextures : register(t0);
+#elif defined(BINDLESS)
+Texture2D colorTextures[] : register(t0);
+#else
 Texture2D colorTexture : register(t0);
+#endif
 
 float4 PSMain(PSInput input) : SV_TARGET
 {
+#if defined(TEXTURE_ARRAY)
+	return colorTextures.Sample(defaultSampler, float3(input.texcoord, input.drawID));
+#elif defined(BINDLESS)
+	// Pixels of different draws may end up in the same wave.
+	return colorTextures[NonUniformResourceIndex(input.drawID)].Sample(defaultSampler, input.texcoord);
+#else
 	return colorTexture.Sample(defaultSampler, input.texcoord);
+#endif
 }